@@ -0,0 +1,167 @@
+#include "Ble_Sensor.h"
+#include "sdk_common.h"
+#include <string.h>
+
+static uint16_t const m_char_uuids[BLE_SENSOR_STREAMS] = // 16-bit UUID of every stream
+    {
+        [BLE_SENSOR_IMU] = BLE_UUID_SENSOR_IMU,
+        [BLE_SENSOR_QUATERNION] = BLE_UUID_SENSOR_QUATERNION,
+        [BLE_SENSOR_PROXIMITY] = BLE_UUID_SENSOR_PROXIMITY,
+        [BLE_SENSOR_LOAD_CELL] = BLE_UUID_SENSOR_LOAD_CELL};
+
+/**
+ * @brief Records a subscription change and reports it.
+ *
+ * @param p_sensor Service instance.
+ * @param stream Stream.
+ * @param enabled true if the notifications are enabled.
+ */
+static void subscription_set(ble_sensor_t *p_sensor, ble_sensor_stream_t stream, bool enabled) {
+  uint8_t mask = (uint8_t)(1 << stream);
+
+  if (enabled == ((p_sensor->subscribed & mask) != 0)) {
+    return;
+  }
+  if (enabled) {
+    p_sensor->subscribed |= mask;
+  } else {
+    p_sensor->subscribed &= (uint8_t)~mask;
+  }
+  if (p_sensor->subscription_handler != NULL) {
+    p_sensor->subscription_handler(stream, enabled);
+  }
+}
+
+/**
+ * @brief Adds the service and its characteristics to the attribute table.
+ *
+ * @param p_sensor Service instance.
+ * @param subscription_handler Reports subscription changes, may be NULL.
+ * @return NRF_SUCCESS, or the error of the SoftDevice call that failed.
+ */
+ret_code_t ble_sensor_init(ble_sensor_t *p_sensor, ble_sensor_subscription_handler_t subscription_handler) {
+  ble_uuid128_t base_uuid = BLE_SENSOR_BASE_UUID;
+  ble_uuid_t ble_uuid;
+  ret_code_t err_code;
+
+  memset(p_sensor, 0, sizeof(*p_sensor));
+  p_sensor->conn_handle = BLE_CONN_HANDLE_INVALID;
+  p_sensor->subscription_handler = subscription_handler;
+
+  err_code = sd_ble_uuid_vs_add(&base_uuid, &p_sensor->uuid_type);
+  VERIFY_SUCCESS(err_code);
+
+  ble_uuid.type = p_sensor->uuid_type;
+  ble_uuid.uuid = BLE_UUID_SENSOR_SERVICE;
+  err_code = sd_ble_gatts_service_add(BLE_GATTS_SRVC_TYPE_PRIMARY, &ble_uuid, &p_sensor->service_handle);
+  VERIFY_SUCCESS(err_code);
+
+  for (uint8_t i = 0; i < BLE_SENSOR_STREAMS; i++) {
+    ble_add_char_params_t add_char_params;
+
+    memset(&add_char_params, 0, sizeof(add_char_params));
+    add_char_params.uuid = m_char_uuids[i];
+    add_char_params.uuid_type = p_sensor->uuid_type;
+    add_char_params.max_len = BLE_SENSOR_MAX_DATA_LEN;
+    add_char_params.init_len = 0;
+    add_char_params.is_var_len = true;
+    add_char_params.char_props.notify = 1;
+    add_char_params.read_access = SEC_OPEN;
+    add_char_params.cccd_write_access = SEC_OPEN;
+
+    err_code = characteristic_add(p_sensor->service_handle, &add_char_params, &p_sensor->char_handles[i]);
+    VERIFY_SUCCESS(err_code);
+  }
+  return NRF_SUCCESS;
+}
+
+/**
+ * @brief Handles the BLE events of the service, registered by BLE_SENSOR_DEF.
+ *
+ * @param p_ble_evt BLE event.
+ * @param p_context Service instance (ble_sensor_t).
+ */
+void ble_sensor_on_ble_evt(ble_evt_t const *p_ble_evt, void *p_context) {
+  ble_sensor_t *p_sensor = (ble_sensor_t *)p_context;
+
+  switch (p_ble_evt->header.evt_id) {
+  case BLE_GAP_EVT_CONNECTED:
+    p_sensor->conn_handle = p_ble_evt->evt.gap_evt.conn_handle;
+    p_sensor->subscribed = 0; // CCCDs are not stored without bonding
+    break;
+
+  case BLE_GAP_EVT_DISCONNECTED:
+    p_sensor->conn_handle = BLE_CONN_HANDLE_INVALID;
+    p_sensor->subscribed = 0; // Not reported, the connection is gone
+    break;
+
+  case BLE_GATTS_EVT_WRITE: {
+    ble_gatts_evt_write_t const *p_write = &p_ble_evt->evt.gatts_evt.params.write;
+
+    if (p_write->len != 2) {
+      break; // Not a CCCD write
+    }
+    for (uint8_t i = 0; i < BLE_SENSOR_STREAMS; i++) {
+      if (p_write->handle == p_sensor->char_handles[i].cccd_handle) {
+        subscription_set(p_sensor, (ble_sensor_stream_t)i, ble_srv_is_notification_enabled(p_write->data));
+      }
+    }
+  } break;
+
+  default:
+    break;
+  }
+}
+
+/**
+ * @brief Checks whether the central receives a stream.
+ *
+ * @param p_sensor Service instance.
+ * @param stream Stream.
+ * @return true if connected and the notifications of the stream are enabled.
+ */
+bool ble_sensor_is_subscribed(ble_sensor_t const *p_sensor, ble_sensor_stream_t stream) {
+  return (p_sensor->conn_handle != BLE_CONN_HANDLE_INVALID) && ((p_sensor->subscribed & (1 << stream)) != 0);
+}
+
+/**
+ * @brief Checks whether the central receives any stream.
+ *
+ * @param p_sensor Service instance.
+ * @return true if the notifications of at least one stream are enabled.
+ */
+bool ble_sensor_any_subscribed(ble_sensor_t const *p_sensor) {
+  return (p_sensor->conn_handle != BLE_CONN_HANDLE_INVALID) && (p_sensor->subscribed != 0);
+}
+
+/**
+ * @brief Sends a notification on the characteristic of a stream.
+ *
+ * @param p_sensor Service instance.
+ * @param stream Stream.
+ * @param p_data Data to send.
+ * @param length Number of bytes, at most the negotiated ATT MTU minus 3.
+ * @return NRF_SUCCESS, NRF_ERROR_NOT_FOUND if not connected, NRF_ERROR_INVALID_STATE if the
+ *         stream is not subscribed, NRF_ERROR_INVALID_PARAM if too long, or the error of
+ *         sd_ble_gatts_hvx (NRF_ERROR_RESOURCES if the SoftDevice has no free buffer).
+ */
+ret_code_t ble_sensor_notify(ble_sensor_t *p_sensor, ble_sensor_stream_t stream, uint8_t *p_data, uint16_t length) {
+  ble_gatts_hvx_params_t hvx_params;
+
+  if (p_sensor->conn_handle == BLE_CONN_HANDLE_INVALID) {
+    return NRF_ERROR_NOT_FOUND;
+  }
+  if (!ble_sensor_is_subscribed(p_sensor, stream)) {
+    return NRF_ERROR_INVALID_STATE;
+  }
+  if (length > BLE_SENSOR_MAX_DATA_LEN) {
+    return NRF_ERROR_INVALID_PARAM;
+  }
+
+  memset(&hvx_params, 0, sizeof(hvx_params));
+  hvx_params.handle = p_sensor->char_handles[stream].value_handle;
+  hvx_params.p_data = p_data;
+  hvx_params.p_len = &length;
+  hvx_params.type = BLE_GATT_HVX_NOTIFICATION;
+  return sd_ble_gatts_hvx(p_sensor->conn_handle, &hvx_params);
+}
@@ -0,0 +1,128 @@
+#ifndef _BLE_SENSOR_H_
+#define _BLE_SENSOR_H_
+
+#include "ble.h"
+#include "ble_srv_common.h"
+#include "nrf_sdh_ble.h"
+#include "sdk_errors.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @file Ble_Sensor.h
+ * @brief Sensor GATT service: one notify characteristic per sample stream.
+ *
+ * The service sits next to the Nordic UART Service and carries the sample frames of
+ * Sample_Frame.h, one stream (ble_sensor_stream_t) per characteristic. Every characteristic has
+ * its own CCCD, so a central subscribes only to the streams it needs; the subscription handler
+ * reports every change, which lets the application stop producing a stream nobody receives.
+ * Subscriptions start disabled on every connection (no bonding); a disconnection clears them
+ * without calling the handler, the application resets its own state on BLE_GAP_EVT_DISCONNECTED.
+ *
+ * The UUIDs are BLE_SENSOR_BASE_UUID with bytes 12 and 13 replaced by the 16-bit values below.
+ * Requires one more vendor specific UUID (NRF_SDH_BLE_VS_UUID_COUNT) and room for the
+ * characteristic values in the attribute table (NRF_SDH_BLE_GATTS_ATTR_TAB_SIZE).
+ */
+
+#define BLE_SENSOR_BASE_UUID {{0x2B, 0x7E, 0x41, 0x93, 0xC6, 0x0D, 0x4F, 0x58, 0x8A, 0x21, 0x6E, 0xB4, 0x00, 0x00, 0x52, 0x50}} ///< Vendor specific base UUID, little-endian
+
+#define BLE_UUID_SENSOR_SERVICE 0x0001    ///< 16-bit UUID of the service
+#define BLE_UUID_SENSOR_IMU 0x0002        ///< 16-bit UUID of the BLE_SENSOR_IMU characteristic
+#define BLE_UUID_SENSOR_QUATERNION 0x0003 ///< 16-bit UUID of the BLE_SENSOR_QUATERNION characteristic
+#define BLE_UUID_SENSOR_PROXIMITY 0x0004  ///< 16-bit UUID of the BLE_SENSOR_PROXIMITY characteristic
+#define BLE_UUID_SENSOR_LOAD_CELL 0x0005  ///< 16-bit UUID of the BLE_SENSOR_LOAD_CELL characteristic
+
+#ifndef BLE_SENSOR_BLE_OBSERVER_PRIO
+#define BLE_SENSOR_BLE_OBSERVER_PRIO 2 ///< Priority of the BLE event observer, the same as the NUS one
+#endif
+
+#define BLE_SENSOR_MAX_DATA_LEN (NRF_SDH_BLE_GATT_MAX_MTU_SIZE - 3) ///< Longest notification: ATT MTU minus opcode and handle
+
+/**
+ * @brief Sample streams, one characteristic each.
+ */
+typedef enum {
+  BLE_SENSOR_IMU,        /**< Batches of SAMPLE_FRAME_ACCEL_GYRO frames */
+  BLE_SENSOR_QUATERNION, /**< Batches of SAMPLE_FRAME_QUATERNION frames */
+  BLE_SENSOR_PROXIMITY,  /**< SAMPLE_FRAME_PROXIMITY frames, one per change of the proximity state */
+  BLE_SENSOR_LOAD_CELL,  /**< SAMPLE_FRAME_LOAD_CELL frames */
+  BLE_SENSOR_STREAMS     /**< Number of streams */
+} ble_sensor_stream_t;
+
+/**
+ * @brief Called when the central enables or disables the notifications of a stream.
+ *
+ * @param stream Stream.
+ * @param enabled true if the central subscribed.
+ */
+typedef void (*ble_sensor_subscription_handler_t)(ble_sensor_stream_t stream, bool enabled);
+
+/**
+ * @brief Service state. Treat as opaque, use the functions below.
+ */
+typedef struct {
+  uint8_t uuid_type;                                         /**< UUID type of BLE_SENSOR_BASE_UUID */
+  uint16_t service_handle;                                   /**< Handle of the service */
+  ble_gatts_char_handles_t char_handles[BLE_SENSOR_STREAMS]; /**< Handles of the characteristics */
+  uint16_t conn_handle;                                      /**< Handle of the current connection */
+  uint8_t subscribed;                                        /**< Bit per stream whose notifications are enabled */
+  ble_sensor_subscription_handler_t subscription_handler;    /**< Reports subscription changes */
+} ble_sensor_t;
+
+/**
+ * @brief Defines a service instance and registers it for BLE events.
+ *
+ * @param _name Name of the instance.
+ */
+#define BLE_SENSOR_DEF(_name) \
+  static ble_sensor_t _name;  \
+  NRF_SDH_BLE_OBSERVER(_name##_obs, BLE_SENSOR_BLE_OBSERVER_PRIO, ble_sensor_on_ble_evt, &_name)
+
+/**
+ * @brief Adds the service and its characteristics to the attribute table.
+ *
+ * @param p_sensor Service instance.
+ * @param subscription_handler Reports subscription changes, may be NULL.
+ * @return NRF_SUCCESS, or the error of the SoftDevice call that failed.
+ */
+ret_code_t ble_sensor_init(ble_sensor_t *p_sensor, ble_sensor_subscription_handler_t subscription_handler);
+
+/**
+ * @brief Handles the BLE events of the service, registered by BLE_SENSOR_DEF.
+ *
+ * @param p_ble_evt BLE event.
+ * @param p_context Service instance (ble_sensor_t).
+ */
+void ble_sensor_on_ble_evt(ble_evt_t const *p_ble_evt, void *p_context);
+
+/**
+ * @brief Checks whether the central receives a stream.
+ *
+ * @param p_sensor Service instance.
+ * @param stream Stream.
+ * @return true if connected and the notifications of the stream are enabled.
+ */
+bool ble_sensor_is_subscribed(ble_sensor_t const *p_sensor, ble_sensor_stream_t stream);
+
+/**
+ * @brief Checks whether the central receives any stream.
+ *
+ * @param p_sensor Service instance.
+ * @return true if the notifications of at least one stream are enabled.
+ */
+bool ble_sensor_any_subscribed(ble_sensor_t const *p_sensor);
+
+/**
+ * @brief Sends a notification on the characteristic of a stream.
+ *
+ * @param p_sensor Service instance.
+ * @param stream Stream.
+ * @param p_data Data to send.
+ * @param length Number of bytes, at most the negotiated ATT MTU minus 3.
+ * @return NRF_SUCCESS, NRF_ERROR_NOT_FOUND if not connected, NRF_ERROR_INVALID_STATE if the
+ *         stream is not subscribed, NRF_ERROR_INVALID_PARAM if too long, or the error of
+ *         sd_ble_gatts_hvx (NRF_ERROR_RESOURCES if the SoftDevice has no free buffer).
+ */
+ret_code_t ble_sensor_notify(ble_sensor_t *p_sensor, ble_sensor_stream_t stream, uint8_t *p_data, uint16_t length);
+
+#endif // _BLE_SENSOR_H_
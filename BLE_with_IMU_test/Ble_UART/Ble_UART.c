@@ -1,12 +1,27 @@
 #include "Ble_UART.h"
+#include "Sample_Batch.h"
+#include "Sample_Codec.h"
+#include "Tx_Queue.h"
 
 BLE_NUS_DEF(m_nus, NRF_SDH_BLE_TOTAL_LINK_COUNT); /**< BLE NUS service instance. */
+BLE_SENSOR_DEF(m_sensor);                         /**< Sensor service instance. */
 NRF_BLE_GATT_DEF(m_gatt);                         /**< GATT module instance. */
 NRF_BLE_QWR_DEF(m_qwr);                           /**< Context for the Queued Write module.*/
 BLE_ADVERTISING_DEF(m_advertising);               /**< Advertising module instance. */
 
 static uint16_t m_conn_handle = BLE_CONN_HANDLE_INVALID;               /**< Handle of the current connection. */
 static uint16_t m_ble_nus_max_data_len = BLE_GATT_ATT_MTU_DEFAULT - 3; /**< Maximum length of data (in bytes) that can be transmitted to the peer by the Nordic UART service module. */
+static sample_batch_t m_batch;                                         /**< Sample frames waiting to fill a notification. */
+static sample_batch_t m_quaternion_batch;                              /**< Quaternion frames waiting to fill a notification. */
+static sample_codec_t m_codec;                                         /**< IMU samples being compressed into a block frame. */
+static tx_queue_t m_tx_queue;                                          /**< Notifications waiting for SoftDevice TX buffers. */
+static ble_profile_t m_profile = BLE_PROFILE_LOW_LATENCY;              /**< Profile last requested from the central, the preferred parameters at connection. */
+static bool m_notifying = false;                                       /**< The peer has enabled the NUS notifications. */
+static bool m_moving = true;                                           /**< Motion reported by the application. */
+static ble_gap_conn_params_t const m_profiles[] =                      /**< Connection parameters of every ble_profile_t. */
+    {
+        [BLE_PROFILE_LOW_LATENCY] = {MIN_CONN_INTERVAL, MAX_CONN_INTERVAL, SLAVE_LATENCY, CONN_SUP_TIMEOUT},
+        [BLE_PROFILE_LOW_POWER] = {IDLE_MIN_CONN_INTERVAL, IDLE_MAX_CONN_INTERVAL, IDLE_SLAVE_LATENCY, CONN_SUP_TIMEOUT}};
 static ble_uuid_t m_adv_uuids[] =                                      /**< Universally unique service identifier. */
     {
         {BLE_UUID_NUS_SERVICE, NUS_SERVICE_UUID_TYPE}};
@@ -82,6 +97,11 @@ static void nrf_qwr_error_handler(uint32_t nrf_error) {
 /**@snippet [Handling the data received over BLE] */
 static void nus_data_handler(ble_nus_evt_t *p_evt) {
 
+  if ((p_evt->type == BLE_NUS_EVT_COMM_STARTED) || (p_evt->type == BLE_NUS_EVT_COMM_STOPPED)) {
+    m_notifying = (p_evt->type == BLE_NUS_EVT_COMM_STARTED); // Streaming starts or stops
+    profile_update();
+  }
+
   if (p_evt->type == BLE_NUS_EVT_RX_DATA) {
     uint32_t err_code;
 
@@ -105,6 +125,74 @@ static void nus_data_handler(ble_nus_evt_t *p_evt) {
 }
 /**@snippet [Handling the data received over BLE] */
 
+/**@brief Function for handing a notification to the SoftDevice, the send function of m_tx_queue.
+ *
+ * @param[in] channel Sensor service stream (ble_sensor_stream_t), or BLE_CHANNEL_NUS.
+ * @param[in] p_data  Data to send.
+ * @param[in] length  Number of bytes.
+ *
+ * @return NRF_SUCCESS, NRF_ERROR_RESOURCES if the SoftDevice has no free buffer, or the error
+ *         for a missing connection or disabled notifications. Other errors are fatal.
+ */
+static ret_code_t notification_send(uint8_t channel, uint8_t *p_data, uint16_t length) {
+  uint16_t sent = length; // Length is updated by the SoftDevice
+  ret_code_t err_code;
+
+  if (channel == BLE_CHANNEL_NUS) {
+    err_code = ble_nus_data_send(&m_nus, p_data, &sent, m_conn_handle); // Send the data using the Nordic UART Service (NUS)
+  } else {
+    err_code = ble_sensor_notify(&m_sensor, (ble_sensor_stream_t)channel, p_data, length); // Send on the characteristic of the stream
+  }
+
+  if ((err_code != NRF_ERROR_INVALID_STATE) && // Check for specific error codes and handle them appropriately
+      (err_code != NRF_ERROR_RESOURCES) &&     //
+      (err_code != NRF_ERROR_NOT_FOUND)) {     //
+    APP_ERROR_CHECK(err_code);                 // If the error is not one of the expected ones, check the error code
+  }
+  return err_code;
+}
+
+/**@brief Function for selecting the characteristic carrying a stream.
+ *
+ * @details Centrals not using the sensor service receive the IMU and proximity frames on the
+ *          NUS TX characteristic, as before the service existed.
+ *
+ * @param[in] stream Stream.
+ *
+ * @return TX queue channel: the stream itself if subscribed, BLE_CHANNEL_NUS otherwise.
+ */
+static uint8_t stream_channel(ble_sensor_stream_t stream) {
+  return ble_sensor_is_subscribed(&m_sensor, stream) ? (uint8_t)stream : BLE_CHANNEL_NUS;
+}
+
+/**@brief Function for sending a batch of IMU frames, the send function of m_batch.
+ *
+ * @param[in] p_data Data to send.
+ * @param[in] length Number of bytes.
+ */
+static void imu_batch_send(uint8_t *p_data, uint16_t length) {
+  tx_queue_push(&m_tx_queue, stream_channel(BLE_SENSOR_IMU), p_data, length); // Never waits for the radio
+}
+
+/**@brief Function for sending a batch of quaternion frames, the send function of m_quaternion_batch.
+ *
+ * @param[in] p_data Data to send.
+ * @param[in] length Number of bytes.
+ */
+static void quaternion_batch_send(uint8_t *p_data, uint16_t length) {
+  tx_queue_push(&m_tx_queue, stream_channel(BLE_SENSOR_QUATERNION), p_data, length);
+}
+
+/**@brief Function for handling subscription changes of the sensor service.
+ *
+ * @param[in] stream  Stream.
+ * @param[in] enabled true if the central subscribed.
+ */
+static void sensor_subscription_handler(ble_sensor_stream_t stream, bool enabled) {
+  NRF_LOG_INFO("Sensor stream %d %s", stream, enabled ? "subscribed" : "unsubscribed");
+  profile_update(); // Streaming may have started or stopped
+}
+
 /**@brief Function for initializing services that will be used by the application.
  */
 static void services_init(void) {
@@ -125,6 +213,12 @@ static void services_init(void) {
 
   err_code = ble_nus_init(&m_nus, &nus_init);
   APP_ERROR_CHECK(err_code);
+
+  // Initialize the sensor service.
+  err_code = ble_sensor_init(&m_sensor, sensor_subscription_handler);
+  APP_ERROR_CHECK(err_code);
+
+  tx_queue_init(&m_tx_queue, notification_send, BLE_TX_QUEUE_POLICY);
 }
 
 /**@brief Function for handling an event from the Connection Parameters Module.
@@ -132,17 +226,49 @@ static void services_init(void) {
  * @details This function will be called for all events in the Connection Parameters Module
  *          which are passed to the application.
  *
- * @note All this function does is to disconnect. This could have been done by simply setting
- *       the disconnect_on_fail config parameter, but instead we use the event handler
- *       mechanism to demonstrate its use.
+ * @note A central refusing the parameters of a profile keeps its own; the connection is kept,
+ *       only the power or latency goal of the profile is missed.
  *
  * @param[in] p_evt  Event received from the Connection Parameters Module.
  */
 static void on_conn_params_evt(ble_conn_params_evt_t *p_evt) {
-  uint32_t err_code;
-
   if (p_evt->evt_type == BLE_CONN_PARAMS_EVT_FAILED) {
-    err_code = sd_ble_gap_disconnect(m_conn_handle, BLE_HCI_CONN_INTERVAL_UNACCEPTABLE);
+    NRF_LOG_WARNING("Central refused the connection parameters of profile %d", m_profile);
+  }
+  profile_update(); // The procedure ended, a request refused with NRF_ERROR_BUSY meanwhile is repeated
+}
+
+/**@brief Function for requesting the connection parameter profile fitting the current activity.
+ *
+ * @details The low-latency profile is used while the peer receives notifications (NUS or any
+ *          sensor service stream) and the application reports motion, the low-power profile
+ *          otherwise. It is evaluated at connection, on every change of these inputs and when
+ *          a parameter update procedure ends, so a request the Connection Parameters Module
+ *          could not start (a procedure was running) is repeated then.
+ */
+static void profile_update(void) {
+  uint16_t conn_handle;
+  ble_profile_t profile;
+  bool change;
+
+  CRITICAL_REGION_ENTER(); // Called from the main loop and the BLE event handler
+  bool streaming = m_notifying || ble_sensor_any_subscribed(&m_sensor);
+  profile = (streaming && m_moving) ? BLE_PROFILE_LOW_LATENCY : BLE_PROFILE_LOW_POWER;
+  conn_handle = m_conn_handle;
+  change = (conn_handle != BLE_CONN_HANDLE_INVALID) && (profile != m_profile);
+  CRITICAL_REGION_EXIT();
+
+  if (!change) {
+    return;
+  }
+  ble_gap_conn_params_t params = m_profiles[profile];
+  ret_code_t err_code = ble_conn_params_change_conn_params(conn_handle, &params); // Outside the critical region, calls the SoftDevice
+  if (err_code == NRF_SUCCESS) {
+    NRF_LOG_INFO("Connection profile %d requested", profile);
+    CRITICAL_REGION_ENTER();
+    m_profile = profile;
+    CRITICAL_REGION_EXIT();
+  } else if ((err_code != NRF_ERROR_BUSY) && (err_code != NRF_ERROR_INVALID_STATE)) {
     APP_ERROR_CHECK(err_code);
   }
 }
@@ -215,6 +341,25 @@ static void on_adv_evt(ble_adv_evt_t ble_adv_evt) {
   }
 }
 
+/**@brief Function for requesting the preferred PHY from the central.
+ *
+ * @details The central usually keeps the 1 Mbps PHY unless asked. Centrals not supporting the
+ *          2 Mbps PHY keep the 1 Mbps PHY and report it in BLE_GAP_EVT_PHY_UPDATE.
+ *
+ * @param[in]   conn_handle   Handle of the new connection.
+ */
+static void phy_request(uint16_t conn_handle) {
+  ble_gap_phys_t const phys =
+      {
+          .rx_phys = BLE_PREFERRED_PHYS,
+          .tx_phys = BLE_PREFERRED_PHYS,
+      };
+  ret_code_t err_code = sd_ble_gap_phy_update(conn_handle, &phys);
+  if (err_code != NRF_ERROR_INVALID_STATE) { // A procedure started by the central is running
+    APP_ERROR_CHECK(err_code);
+  }
+}
+
 /**@brief Function for handling BLE events.
  *
  * @param[in]   p_ble_evt   Bluetooth stack event.
@@ -231,12 +376,23 @@ static void ble_evt_handler(ble_evt_t const *p_ble_evt, void *p_context) {
     m_conn_handle = p_ble_evt->evt.gap_evt.conn_handle;
     err_code = nrf_ble_qwr_conn_handle_assign(&m_qwr, m_conn_handle);
     APP_ERROR_CHECK(err_code);
+    phy_request(m_conn_handle);
+    profile_update(); // A central that does not subscribe gets the low-power profile
     break;
 
   case BLE_GAP_EVT_DISCONNECTED:
     NRF_LOG_INFO("Disconnected");
     // LED indication will be changed when advertising starts.
     m_conn_handle = BLE_CONN_HANDLE_INVALID;
+    m_notifying = false;                                                    // The next connection starts with the preferred parameters
+    m_profile = BLE_PROFILE_LOW_LATENCY;                                    //
+    sample_batch_clear(&m_batch);                                           // Samples of the old connection are not sent
+    sample_batch_clear(&m_quaternion_batch);                                //
+    sample_codec_reset(&m_codec);                                           //
+    tx_queue_clear(&m_tx_queue);                                            //
+    m_ble_nus_max_data_len = BLE_GATT_ATT_MTU_DEFAULT - 3;                  // The next connection starts with the default MTU
+    sample_batch_capacity_set(&m_batch, m_ble_nus_max_data_len);            //
+    sample_batch_capacity_set(&m_quaternion_batch, m_ble_nus_max_data_len); //
     break;
 
   case BLE_GAP_EVT_PHY_UPDATE_REQUEST: {
@@ -250,6 +406,12 @@ static void ble_evt_handler(ble_evt_t const *p_ble_evt, void *p_context) {
     APP_ERROR_CHECK(err_code);
   } break;
 
+  case BLE_GAP_EVT_PHY_UPDATE:
+    NRF_LOG_INFO("PHY tx %d rx %d (1: 1 Mbps, 2: 2 Mbps)",
+        p_ble_evt->evt.gap_evt.params.phy_update.tx_phy,
+        p_ble_evt->evt.gap_evt.params.phy_update.rx_phy);
+    break;
+
   case BLE_GAP_EVT_SEC_PARAMS_REQUEST:
     // Pairing not supported
     err_code = sd_ble_gap_sec_params_reply(m_conn_handle, BLE_GAP_SEC_STATUS_PAIRING_NOT_SUPP, NULL, NULL);
@@ -269,6 +431,11 @@ static void ble_evt_handler(ble_evt_t const *p_ble_evt, void *p_context) {
     APP_ERROR_CHECK(err_code);
     break;
 
+  case BLE_GATTS_EVT_HVN_TX_COMPLETE:
+    // SoftDevice TX buffers were freed, continue with the waiting notifications.
+    tx_queue_pump(&m_tx_queue);
+    break;
+
   case BLE_GATTS_EVT_TIMEOUT:
     // Disconnect on GATT Server timeout event.
     err_code = sd_ble_gap_disconnect(p_ble_evt->evt.gatts_evt.conn_handle,
@@ -298,10 +465,25 @@ static void ble_stack_init(void) {
   err_code = nrf_sdh_ble_default_cfg_set(APP_BLE_CONN_CFG_TAG, &ram_start);
   APP_ERROR_CHECK(err_code);
 
+  // Let the SoftDevice hold several notifications, so a connection event carries more than one.
+  ble_cfg_t ble_cfg;
+  memset(&ble_cfg, 0, sizeof(ble_cfg));
+  ble_cfg.conn_cfg.conn_cfg_tag = APP_BLE_CONN_CFG_TAG;
+  ble_cfg.conn_cfg.params.gatts_conn_cfg.hvn_tx_queue_size = BLE_HVN_TX_QUEUE_SIZE;
+  err_code = sd_ble_cfg_set(BLE_CONN_CFG_GATTS, &ble_cfg, ram_start);
+  APP_ERROR_CHECK(err_code);
+
   // Enable BLE stack.
   err_code = nrf_sdh_ble_enable(&ram_start);
   APP_ERROR_CHECK(err_code);
 
+  // Extend connection events while data is pending.
+  ble_opt_t opt;
+  memset(&opt, 0, sizeof(opt));
+  opt.common_opt.conn_evt_ext.enable = BLE_CONN_EVT_EXTENSION;
+  err_code = sd_ble_opt_set(BLE_COMMON_OPT_CONN_EVT_EXT, &opt);
+  APP_ERROR_CHECK(err_code);
+
   // Register a handler for BLE events.
   NRF_SDH_BLE_OBSERVER(m_ble_observer, APP_BLE_OBSERVER_PRIO, ble_evt_handler, NULL);
 }
@@ -311,13 +493,15 @@ void gatt_evt_handler(nrf_ble_gatt_t *p_gatt, nrf_ble_gatt_evt_t const *p_evt) {
   if ((m_conn_handle == p_evt->conn_handle) && (p_evt->evt_id == NRF_BLE_GATT_EVT_ATT_MTU_UPDATED)) {
     m_ble_nus_max_data_len = p_evt->params.att_mtu_effective - OPCODE_LENGTH - HANDLE_LENGTH;
     NRF_LOG_INFO("Data len is set to 0x%X(%d)", m_ble_nus_max_data_len, m_ble_nus_max_data_len);
+    sample_batch_capacity_set(&m_batch, m_ble_nus_max_data_len);
+    sample_batch_capacity_set(&m_quaternion_batch, m_ble_nus_max_data_len);
   }
   NRF_LOG_DEBUG("ATT MTU exchange completed. central 0x%x peripheral 0x%x",
       p_gatt->att_mtu_desired_central,
       p_gatt->att_mtu_desired_periph);
 }
 
-/**@brief Function for initializing the GATT library. */
+/**@brief Function for initializing the GATT library and the sample batch following its data length. */
 void gatt_init(void) {
   ret_code_t err_code;
 
@@ -326,6 +510,9 @@ void gatt_init(void) {
 
   err_code = nrf_ble_gatt_att_mtu_periph_set(&m_gatt, NRF_SDH_BLE_GATT_MAX_MTU_SIZE);
   APP_ERROR_CHECK(err_code);
+
+  sample_batch_init(&m_batch, imu_batch_send, m_ble_nus_max_data_len); // Grows with the MTU in gatt_evt_handler
+  sample_batch_init(&m_quaternion_batch, quaternion_batch_send, m_ble_nus_max_data_len);
 }
 
 /**@brief Function for handling events from the BSP module.
@@ -519,22 +706,153 @@ void ble_uart_init(void) {
   advertising_start();             // Start advertising
 }
 
+/**@brief Function for sending the compressed IMU block, after the IMU frames batched before it.
+ */
+static void imu_block_send(void) {
+  uint8_t frame[SAMPLE_FRAME_MAX_SIZE];
+  uint16_t length = sample_codec_frame(&m_codec, frame);
+
+  if (length > 0) {
+    sample_batch_flush(&m_batch); // Keeps the samples in order
+    imu_batch_send(frame, length);
+  }
+}
+
 /**
- * @brief Transmits IMU data over BLE.
+ * @brief Transmits an IMU sample over BLE.
  *
- * This function sends the IMU data stored in the data_array over BLE using the Nordic UART Service (NUS).
- * It handles potential errors and ensures that the data is successfully sent, retrying if necessary.
+ * With BLE_IMU_COMPRESSION the sample is delta compressed into a SAMPLE_FRAME_ACCEL_GYRO_BLOCK
+ * frame (Sample_Codec.h) that grows up to the negotiated data length, two to three times as many
+ * samples per notification as plain frames. The block is sent on the IMU characteristic of the
+ * sensor service, or the Nordic UART Service (NUS) for centrals not using it, once the next
+ * sample no longer fits or the first sample has waited SAMPLE_BATCH_LATENCY_US (transmitPoll()).
+ * While the data length is too short for a block (default ATT MTU), and without
+ * BLE_IMU_COMPRESSION, the sample is sent as a SAMPLE_FRAME_ACCEL_GYRO frame through the sample
+ * batch (Sample_Batch.h).
+ *
+ * @param timestamp_us Time the sample was taken.
+ * @param accel Accelerometer X, Y, Z.
+ * @param gyro Gyroscope X, Y, Z.
+ * @param now_us Current time in microseconds, for the latency deadline.
  */
-void transmitIMUdata() {
-  uint32_t err_code;
+void transmitIMUdata(uint32_t timestamp_us, int16_t const accel[3], int16_t const gyro[3], uint32_t now_us) {
+  uint8_t frame[SAMPLE_FRAME_SIZE(SAMPLE_FRAME_ACCEL_GYRO_LEN)];
+
+#if BLE_IMU_COMPRESSION
+  if (m_ble_nus_max_data_len >= SAMPLE_FRAME_SIZE(1 + SAMPLE_CODEC_SAMPLE_MAX)) { // A block holds at least one sample
+    uint8_t max_payload = (uint8_t)MIN(m_ble_nus_max_data_len - SAMPLE_FRAME_SIZE(0), SAMPLE_FRAME_MAX_PAYLOAD);
+
+    if (!sample_codec_add(&m_codec, timestamp_us, accel, gyro, max_payload, now_us)) {
+      imu_block_send(); // Full, the sample starts the next block
+      sample_codec_add(&m_codec, timestamp_us, accel, gyro, max_payload, now_us);
+    }
+    return;
+  }
+#endif
+  imu_block_send(); // Not left behind by the plain frames
+  sample_batch_add(&m_batch, frame, sample_frame_accel_gyro(frame, timestamp_us, accel, gyro), now_us);
+}
+
+/**
+ * @brief Sends the IMU and quaternion data whose latency deadline passed.
+ *
+ * Call it on every loop iteration, also when no sample was taken (e.g. decimated while still).
+ *
+ * @param now_us Current time in microseconds.
+ */
+void transmitPoll(uint32_t now_us) {
+  if (sample_codec_age_us(&m_codec, now_us) >= SAMPLE_BATCH_LATENCY_US) { // On the clock of now_us, the sample timestamps may be later
+    imu_block_send();
+  }
+  sample_batch_poll(&m_batch, now_us);
+  sample_batch_poll(&m_quaternion_batch, now_us);
+}
+
+/**
+ * @brief Transmits the sample frames of a stream over BLE.
+ *
+ * IMU and quaternion frames are batched into notifications (Sample_Batch.h); proximity and
+ * load cell frames are rare and queued at once. Check ble_uart_stream_enabled() first, so no
+ * frames are produced for a stream nobody receives.
+ *
+ * @param stream Stream of the frames.
+ * @param p_data Sample frames (Sample_Frame.h).
+ * @param length Number of bytes.
+ * @param now_us Current time in microseconds, for the latency deadline.
+ */
+void transmitSensorData(ble_sensor_stream_t stream, uint8_t const *p_data, uint16_t length, uint32_t now_us) {
+  switch (stream) {
+  case BLE_SENSOR_IMU:
+    imu_block_send(); // Keeps the samples in order
+    sample_batch_add(&m_batch, p_data, length, now_us);
+    break;
+  case BLE_SENSOR_QUATERNION:
+    sample_batch_add(&m_quaternion_batch, p_data, length, now_us);
+    break;
+  default:
+    tx_queue_push(&m_tx_queue, stream_channel(stream), p_data, length);
+    break;
+  }
+}
+
+/**
+ * @brief Checks whether the central receives a stream.
+ *
+ * A central using the sensor service receives the streams it subscribed to. A central using only
+ * the NUS receives the IMU and proximity frames there while its notifications are enabled.
+ *
+ * @param stream Stream.
+ * @return true if frames of the stream should be produced.
+ */
+bool ble_uart_stream_enabled(ble_sensor_stream_t stream) {
+  if (ble_sensor_any_subscribed(&m_sensor)) {
+    return ble_sensor_is_subscribed(&m_sensor, stream);
+  }
+  return m_notifying && ((stream == BLE_SENSOR_IMU) || (stream == BLE_SENSOR_PROXIMITY));
+}
+
+/**
+ * @brief Transmits a buffer over BLE.
+ *
+ * This function copies length bytes into the TX queue (Tx_Queue.h) and returns at once. The queue
+ * sends them over BLE using the Nordic UART Service (NUS) as soon as the SoftDevice has a free
+ * buffer; when the queue is full, BLE_TX_QUEUE_POLICY decides which data is lost. Data longer
+ * than the negotiated NUS data length is split into several notifications.
+ *
+ * @param p_data Pointer to the data to send.
+ * @param length Number of bytes to send.
+ */
+void transmitData(uint8_t *p_data, uint16_t length) {
+  while (length > 0) {
+    uint16_t chunk = MIN(length, m_ble_nus_max_data_len);       // Longer notifications fail with NRF_ERROR_DATA_SIZE
+    tx_queue_push(&m_tx_queue, BLE_CHANNEL_NUS, p_data, chunk); // Never waits for the radio
+    p_data += chunk;
+    length -= chunk;
+  }
+}
+
+/**
+ * @brief Reports whether the device is moving, selecting the connection parameter profile.
+ *
+ * While notifications are enabled and the device moves, the low-latency profile is used;
+ * otherwise the central is asked for the low-power profile, whose long interval and slave
+ * latency let the radio sleep. Cheap to call on every loop iteration: the parameters are only
+ * renegotiated when the profile changes.
+ *
+ * @param moving true if the device moves.
+ */
+void ble_uart_motion_set(bool moving) {
+  m_moving = moving;
+  profile_update(); // Also retries a request the module was too busy for
+}
 
-  do {                                                                                   // Attempt to send the IMU data until resources are available
-    uint16_t length = strlen(data_array);                                                // Get the length of the data to be sent
-    err_code = ble_nus_data_send(&m_nus, (uint8_t *)data_array, &length, m_conn_handle); // Send the data using the Nordic UART Service (NUS)
-    if ((err_code != NRF_ERROR_INVALID_STATE) &&                                         // Check for specific error codes and handle them appropriately
-        (err_code != NRF_ERROR_RESOURCES) &&                                             //
-        (err_code != NRF_ERROR_NOT_FOUND)) {                                             //
-      APP_ERROR_CHECK(err_code);                                                         // If the error is not one of the expected ones, check the error code
-    }                                                                                    //
-  } while (err_code == NRF_ERROR_RESOURCES);                                             // Retry if resources are temporarily unavailable
+/**
+ * @brief Formats the counters of the BLE TX queue.
+ *
+ * @param p_buf Receives one line of text.
+ * @param size Size of p_buf.
+ * @return Length of the text.
+ */
+uint16_t transmitStatsFormat(char *p_buf, uint16_t size) {
+  return tx_queue_stats_format(&m_tx_queue, p_buf, size);
 }
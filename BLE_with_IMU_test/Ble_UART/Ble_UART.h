@@ -1,6 +1,7 @@
 #ifndef _Ble_UART_H_
 #define _Ble_UART_H_
 
+#include "Ble_Sensor.h"
 #include "app_error.h"
 #include "app_timer.h"
 #include "app_uart.h"
@@ -47,30 +48,58 @@ extern uint8_t ble_index;
 
 #define APP_ADV_DURATION 18000 /**< The advertising duration (180 seconds) in units of 10 milliseconds. */
 
-#define MIN_CONN_INTERVAL MSEC_TO_UNITS(20, UNIT_1_25_MS)    /**< Minimum acceptable connection interval (20 ms), Connection interval uses 1.25 ms units. */
-#define MAX_CONN_INTERVAL MSEC_TO_UNITS(75, UNIT_1_25_MS)    /**< Maximum acceptable connection interval (75 ms), Connection interval uses 1.25 ms units. */
-#define SLAVE_LATENCY 0                                      /**< Slave latency. */
-#define CONN_SUP_TIMEOUT MSEC_TO_UNITS(4000, UNIT_10_MS)     /**< Connection supervisory timeout (4 seconds), Supervision Timeout uses 10 ms units. */
-#define FIRST_CONN_PARAMS_UPDATE_DELAY APP_TIMER_TICKS(5000) /**< Time from initiating event (connect or start of notification) to first time sd_ble_gap_conn_param_update is called (5 seconds). */
-#define NEXT_CONN_PARAMS_UPDATE_DELAY APP_TIMER_TICKS(30000) /**< Time between each call to sd_ble_gap_conn_param_update after the first call (30 seconds). */
-#define MAX_CONN_PARAMS_UPDATE_COUNT 3                       /**< Number of attempts before giving up the connection parameter negotiation. */
+#define MIN_CONN_INTERVAL MSEC_TO_UNITS(7.5, UNIT_1_25_MS)      /**< Minimum acceptable connection interval (7.5 ms), Connection interval uses 1.25 ms units. */
+#define MAX_CONN_INTERVAL MSEC_TO_UNITS(15, UNIT_1_25_MS)       /**< Maximum acceptable connection interval (15 ms), Connection interval uses 1.25 ms units. */
+#define SLAVE_LATENCY 0                                         /**< Slave latency. */
+#define IDLE_MIN_CONN_INTERVAL MSEC_TO_UNITS(100, UNIT_1_25_MS) /**< Minimum connection interval of the low-power profile (100 ms). */
+#define IDLE_MAX_CONN_INTERVAL MSEC_TO_UNITS(200, UNIT_1_25_MS) /**< Maximum connection interval of the low-power profile (200 ms). */
+#define IDLE_SLAVE_LATENCY 4                                    /**< Slave latency of the low-power profile, events without data may be skipped (up to 1 s). */
+#define CONN_SUP_TIMEOUT MSEC_TO_UNITS(4000, UNIT_10_MS)        /**< Connection supervisory timeout (4 seconds), Supervision Timeout uses 10 ms units. */
+#define FIRST_CONN_PARAMS_UPDATE_DELAY APP_TIMER_TICKS(5000)    /**< Time from initiating event (connect or start of notification) to first time sd_ble_gap_conn_param_update is called (5 seconds). */
+#define NEXT_CONN_PARAMS_UPDATE_DELAY APP_TIMER_TICKS(30000)    /**< Time between each call to sd_ble_gap_conn_param_update after the first call (30 seconds). */
+#define MAX_CONN_PARAMS_UPDATE_COUNT 3                          /**< Number of attempts before giving up the connection parameter negotiation. */
+
+#define BLE_PREFERRED_PHYS BLE_GAP_PHY_2MBPS /**< PHY requested from the central after connecting, the 2 Mbps PHY halves the air time of every packet. */
+#define BLE_HVN_TX_QUEUE_SIZE 10             /**< Notifications the SoftDevice can hold, enough to fill a 15 ms connection event at 2 Mbps with 251 byte packets. */
+#define BLE_CONN_EVT_EXTENSION 1             /**< Lets a connection event run on while there is data, up to the next connection interval. */
+
+/**@brief Connection parameter profiles, see ble_uart_motion_set(). */
+typedef enum {
+  BLE_PROFILE_LOW_LATENCY, /**< MIN_CONN_INTERVAL .. MAX_CONN_INTERVAL, SLAVE_LATENCY: streaming. */
+  BLE_PROFILE_LOW_POWER    /**< IDLE_MIN_CONN_INTERVAL .. IDLE_MAX_CONN_INTERVAL, IDLE_SLAVE_LATENCY: idle. */
+} ble_profile_t;
 
 #define DEAD_BEEF 0xDEADBEEF /**< Value used as error code on stack dump, can be used to identify stack location on stack unwind. */
 
 #define UART_TX_BUF_SIZE 256 /**< UART TX buffer size. */
 #define UART_RX_BUF_SIZE 256 /**< UART RX buffer size. */
 
+#define BLE_TX_QUEUE_POLICY TX_QUEUE_OVERWRITE_OLDEST /**< Notifications lost when the TX queue is full: the oldest, so the peer gets the latest samples. */
+#define BLE_CHANNEL_NUS BLE_SENSOR_STREAMS            /**< TX queue channel of the NUS TX characteristic, the channels below are the sensor service streams. */
+
+#ifndef BLE_IMU_COMPRESSION
+#define BLE_IMU_COMPRESSION 1 /**< Sends IMU samples delta compressed in SAMPLE_FRAME_ACCEL_GYRO_BLOCK frames, 0 for one SAMPLE_FRAME_ACCEL_GYRO frame each. */
+#endif
+
 void assert_nrf_callback(uint16_t line_num, const uint8_t *p_file_name);
 static void timers_init(void);
 static void gap_params_init(void);
 static void nrf_qwr_error_handler(uint32_t nrf_error);
 static void nus_data_handler(ble_nus_evt_t *p_evt);
+static ret_code_t notification_send(uint8_t channel, uint8_t *p_data, uint16_t length);
+static uint8_t stream_channel(ble_sensor_stream_t stream);
+static void imu_batch_send(uint8_t *p_data, uint16_t length);
+static void quaternion_batch_send(uint8_t *p_data, uint16_t length);
+static void imu_block_send(void);
+static void sensor_subscription_handler(ble_sensor_stream_t stream, bool enabled);
 static void services_init(void);
 static void on_conn_params_evt(ble_conn_params_evt_t *p_evt);
 static void conn_params_error_handler(uint32_t nrf_error);
 static void conn_params_init(void);
+static void profile_update(void);
 static void sleep_mode_enter(void);
 static void on_adv_evt(ble_adv_evt_t ble_adv_evt);
+static void phy_request(uint16_t conn_handle);
 static void ble_evt_handler(ble_evt_t const *p_ble_evt, void *p_context);
 static void ble_stack_init(void);
 void gatt_evt_handler(nrf_ble_gatt_t *p_gatt, nrf_ble_gatt_evt_t const *p_evt);
@@ -85,6 +114,12 @@ static void power_management_init(void);
 static void idle_state_handle(void);
 static void advertising_start(void);
 void ble_uart_init(void);
-void transmitIMUdata(void);
+void transmitIMUdata(uint32_t timestamp_us, int16_t const accel[3], int16_t const gyro[3], uint32_t now_us);
+void transmitPoll(uint32_t now_us);
+void transmitSensorData(ble_sensor_stream_t stream, uint8_t const *p_data, uint16_t length, uint32_t now_us);
+bool ble_uart_stream_enabled(ble_sensor_stream_t stream);
+void transmitData(uint8_t *p_data, uint16_t length);
+uint16_t transmitStatsFormat(char *p_buf, uint16_t size);
+void ble_uart_motion_set(bool moving);
 
 #endif
\ No newline at end of file
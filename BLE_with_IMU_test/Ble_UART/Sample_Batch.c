@@ -0,0 +1,123 @@
+#include "Sample_Batch.h"
+#include <string.h>
+
+/**
+ * @brief Limits a notification length to the buffer.
+ *
+ * @param capacity Requested notification length.
+ * @return Usable notification length.
+ */
+static uint16_t batch_capacity_limit(uint16_t capacity) {
+  return (capacity < SAMPLE_BATCH_MAX_LEN) ? capacity : SAMPLE_BATCH_MAX_LEN;
+}
+
+/**
+ * @brief Initializes a batch.
+ *
+ * @param p_batch Batch to initialize.
+ * @param send Function sending a notification.
+ * @param capacity Notification length, limited to SAMPLE_BATCH_MAX_LEN.
+ */
+void sample_batch_init(sample_batch_t *p_batch, sample_batch_send_t send, uint16_t capacity) {
+  memset(p_batch, 0, sizeof(*p_batch));
+  p_batch->send = send;
+  p_batch->capacity = batch_capacity_limit(capacity);
+}
+
+/**
+ * @brief Changes the notification length, e.g. after an ATT MTU update.
+ *
+ * Waiting units are sent first if they no longer fit.
+ *
+ * @param p_batch Batch.
+ * @param capacity Notification length, limited to SAMPLE_BATCH_MAX_LEN.
+ */
+void sample_batch_capacity_set(sample_batch_t *p_batch, uint16_t capacity) {
+  capacity = batch_capacity_limit(capacity);
+  if (p_batch->fill > capacity) {
+    sample_batch_flush(p_batch);
+  }
+  p_batch->capacity = capacity;
+}
+
+/**
+ * @brief Adds a unit of frames, sending the batch as described in the file comment.
+ *
+ * @param p_batch Batch.
+ * @param p_data Frames to add.
+ * @param length Number of bytes.
+ * @param now_us Current time in microseconds (micros()).
+ */
+void sample_batch_add(sample_batch_t *p_batch, uint8_t const *p_data, uint16_t length, uint32_t now_us) {
+  sample_batch_poll(p_batch, now_us);
+  if (p_batch->fill + length > p_batch->capacity) {
+    sample_batch_flush(p_batch); // Does not fit behind the waiting units
+  }
+  p_batch->stats.units++;
+  if (length > p_batch->capacity) { // Longer than a notification, split like transmitData does
+    while (length > 0) {
+      uint16_t chunk = (length < p_batch->capacity) ? length : p_batch->capacity;
+      p_batch->stats.notifications++;
+      p_batch->stats.bytes += chunk;
+      p_batch->send((uint8_t *)p_data, chunk);
+      p_data += chunk;
+      length -= chunk;
+    }
+    return;
+  }
+  if (p_batch->fill == 0) {
+    p_batch->first_us = now_us;
+  }
+  memcpy(&p_batch->buffer[p_batch->fill], p_data, length);
+  p_batch->fill += length;
+  if (p_batch->capacity - p_batch->fill < length) {
+    sample_batch_flush(p_batch); // The next unit of this length would not fit
+  }
+}
+
+/**
+ * @brief Sends the batch if the oldest unit has waited SAMPLE_BATCH_LATENCY_US.
+ *
+ * @param p_batch Batch.
+ * @param now_us Current time in microseconds (micros()).
+ */
+void sample_batch_poll(sample_batch_t *p_batch, uint32_t now_us) {
+  if ((p_batch->fill > 0) && (now_us - p_batch->first_us >= SAMPLE_BATCH_LATENCY_US)) {
+    p_batch->stats.deadlines++;
+    sample_batch_flush(p_batch);
+  }
+}
+
+/**
+ * @brief Sends the waiting units now.
+ *
+ * @param p_batch Batch.
+ */
+void sample_batch_flush(sample_batch_t *p_batch) {
+  if (p_batch->fill == 0) {
+    return;
+  }
+  p_batch->stats.notifications++;
+  p_batch->stats.bytes += p_batch->fill;
+  p_batch->send(p_batch->buffer, p_batch->fill);
+  p_batch->fill = 0;
+}
+
+/**
+ * @brief Drops the waiting units, e.g. on disconnection.
+ *
+ * @param p_batch Batch.
+ */
+void sample_batch_clear(sample_batch_t *p_batch) {
+  p_batch->fill = 0;
+}
+
+/**
+ * @brief Returns the counters of a batch.
+ *
+ * @param p_batch Batch.
+ * @return Pointer to the counters.
+ */
+sample_batch_stats_t const *sample_batch_stats_get(sample_batch_t const *p_batch) {
+  return &p_batch->stats;
+}
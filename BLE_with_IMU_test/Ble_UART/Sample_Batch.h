@@ -0,0 +1,122 @@
+#ifndef _SAMPLE_BATCH_H_
+#define _SAMPLE_BATCH_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @file Sample_Batch.h
+ * @brief Packs sample frames into notifications as long as the negotiated data length.
+ *
+ * One notification per sample wastes the larger ATT MTU negotiated in gatt_evt_handler: the
+ * number of notifications per connection event is limited, not their length. The batch
+ * collects whole units (the frames produced by one loop iteration) and hands them to the send
+ * function as one notification when
+ * - the next unit of the same length would no longer fit into the capacity,
+ * - a unit does not fit into the remaining space (the batch is sent first), or
+ * - the oldest unit has waited SAMPLE_BATCH_LATENCY_US.
+ *
+ * Units that fit are never split, so their notifications start on a frame boundary. A unit
+ * longer than the capacity is sent at once, split into notifications of the capacity; the
+ * receiver reassembles its frames from the byte stream. The deadline is checked when a unit is
+ * added and by sample_batch_poll(); the module keeps no timer and can run in any single context.
+ */
+
+#ifndef SAMPLE_BATCH_MAX_LEN
+#define SAMPLE_BATCH_MAX_LEN 244 ///< Longest notification, BLE_NUS_MAX_DATA_LEN at NRF_SDH_BLE_GATT_MAX_MTU_SIZE 247
+#endif
+
+#ifndef SAMPLE_BATCH_LATENCY_US
+#define SAMPLE_BATCH_LATENCY_US 20000 ///< Longest time a sample waits in the batch
+#endif
+
+/**
+ * @brief Sends one notification.
+ *
+ * @param p_data Data to send.
+ * @param length Number of bytes.
+ */
+typedef void (*sample_batch_send_t)(uint8_t *p_data, uint16_t length);
+
+/**
+ * @brief Counters of a batch.
+ */
+typedef struct {
+  uint32_t notifications; /**< Notifications sent */
+  uint32_t units;         /**< Units added */
+  uint32_t bytes;         /**< Bytes sent */
+  uint32_t deadlines;     /**< Notifications sent because the latency deadline expired */
+} sample_batch_stats_t;
+
+/**
+ * @brief Batch state. Treat as opaque, use the functions below.
+ */
+typedef struct {
+  uint8_t buffer[SAMPLE_BATCH_MAX_LEN]; /**< Units waiting to be sent */
+  uint16_t fill;                        /**< Bytes in buffer */
+  uint16_t capacity;                    /**< Current notification length */
+  uint32_t first_us;                    /**< Time the oldest unit was added */
+  sample_batch_send_t send;             /**< Sends a notification */
+  sample_batch_stats_t stats;           /**< Counters */
+} sample_batch_t;
+
+/**
+ * @brief Initializes a batch.
+ *
+ * @param p_batch Batch to initialize.
+ * @param send Function sending a notification.
+ * @param capacity Notification length, limited to SAMPLE_BATCH_MAX_LEN.
+ */
+void sample_batch_init(sample_batch_t *p_batch, sample_batch_send_t send, uint16_t capacity);
+
+/**
+ * @brief Changes the notification length, e.g. after an ATT MTU update.
+ *
+ * Waiting units are sent first if they no longer fit.
+ *
+ * @param p_batch Batch.
+ * @param capacity Notification length, limited to SAMPLE_BATCH_MAX_LEN.
+ */
+void sample_batch_capacity_set(sample_batch_t *p_batch, uint16_t capacity);
+
+/**
+ * @brief Adds a unit of frames, sending the batch as described in the file comment.
+ *
+ * @param p_batch Batch.
+ * @param p_data Frames to add.
+ * @param length Number of bytes.
+ * @param now_us Current time in microseconds (micros()).
+ */
+void sample_batch_add(sample_batch_t *p_batch, uint8_t const *p_data, uint16_t length, uint32_t now_us);
+
+/**
+ * @brief Sends the batch if the oldest unit has waited SAMPLE_BATCH_LATENCY_US.
+ *
+ * @param p_batch Batch.
+ * @param now_us Current time in microseconds (micros()).
+ */
+void sample_batch_poll(sample_batch_t *p_batch, uint32_t now_us);
+
+/**
+ * @brief Sends the waiting units now.
+ *
+ * @param p_batch Batch.
+ */
+void sample_batch_flush(sample_batch_t *p_batch);
+
+/**
+ * @brief Drops the waiting units, e.g. on disconnection.
+ *
+ * @param p_batch Batch.
+ */
+void sample_batch_clear(sample_batch_t *p_batch);
+
+/**
+ * @brief Returns the counters of a batch.
+ *
+ * @param p_batch Batch.
+ * @return Pointer to the counters.
+ */
+sample_batch_stats_t const *sample_batch_stats_get(sample_batch_t const *p_batch);
+
+#endif // _SAMPLE_BATCH_H_
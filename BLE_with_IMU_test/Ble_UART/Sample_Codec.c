@@ -0,0 +1,133 @@
+#include "Sample_Codec.h"
+#include <string.h>
+
+/**
+ * @brief Stores a value as a varint.
+ *
+ * @param p_dst Destination, up to 5 bytes.
+ * @param value Value to store.
+ * @return Bytes written.
+ */
+static uint8_t codec_put_varint(uint8_t *p_dst, uint32_t value) {
+  uint8_t length = 0;
+
+  while (value >= 0x80) {
+    p_dst[length++] = (uint8_t)(value | 0x80);
+    value >>= 7;
+  }
+  p_dst[length++] = (uint8_t)value;
+  return length;
+}
+
+/**
+ * @brief Stores a signed 16-bit value as a zigzag varint.
+ *
+ * @param p_dst Destination, up to 3 bytes.
+ * @param value Value to store.
+ * @return Bytes written.
+ */
+static uint8_t codec_put_zigzag(uint8_t *p_dst, int16_t value) {
+  uint16_t zigzag = (uint16_t)(((uint16_t)value << 1) ^ (uint16_t)(value >> 15)); // Sign in bit 0
+
+  return codec_put_varint(p_dst, zigzag);
+}
+
+/**
+ * @brief Empties the block.
+ *
+ * @param p_codec Encoder state.
+ */
+void sample_codec_reset(sample_codec_t *p_codec) {
+  p_codec->length = 0;
+}
+
+/**
+ * @brief Appends a sample to the block.
+ *
+ * @param p_codec Encoder state.
+ * @param timestamp_us Time the sample was taken.
+ * @param accel Accelerometer X, Y, Z.
+ * @param gyro Gyroscope X, Y, Z.
+ * @param max_payload Payload length the block must not exceed, at most SAMPLE_FRAME_MAX_PAYLOAD.
+ * @param now_us Current time in microseconds, on the clock later passed to sample_codec_age_us().
+ * @return false if the sample does not fit; the block is unchanged, send it with
+ *         sample_codec_frame() and add the sample to the empty block.
+ */
+bool sample_codec_add(sample_codec_t *p_codec, uint32_t timestamp_us, int16_t const accel[3], int16_t const gyro[3], uint8_t max_payload, uint32_t now_us) {
+  uint8_t encoded[1 + SAMPLE_CODEC_SAMPLE_MAX];
+  int16_t sample[6] = {accel[0], accel[1], accel[2], gyro[0], gyro[1], gyro[2]};
+  bool first = (p_codec->length == 0);
+  uint8_t length = 0;
+
+  if (first) {
+    encoded[length++] = 0; // Sample count
+    memset(p_codec->last, 0, sizeof(p_codec->last));
+  } else {
+    length += codec_put_varint(&encoded[length], timestamp_us - p_codec->last_us);
+  }
+  for (uint8_t i = 0; i < 6; i++) {
+    length += codec_put_zigzag(&encoded[length], (int16_t)(uint16_t)(sample[i] - p_codec->last[i])); // Wraps, so every change fits 16 bits
+  }
+  if ((p_codec->length + length > max_payload) || (p_codec->length + length > SAMPLE_FRAME_MAX_PAYLOAD)) {
+    return false;
+  }
+
+  memcpy(&p_codec->payload[p_codec->length], encoded, length);
+  p_codec->length += length;
+  p_codec->payload[0]++;
+  memcpy(p_codec->last, sample, sizeof(sample));
+  if (first) {
+    p_codec->first_us = timestamp_us;
+    p_codec->started_us = now_us;
+  }
+  p_codec->last_us = timestamp_us;
+  return true;
+}
+
+/**
+ * @brief Returns the number of samples in the block.
+ *
+ * @param p_codec Encoder state.
+ * @return Samples added since the last reset.
+ */
+uint8_t sample_codec_count(sample_codec_t const *p_codec) {
+  return (p_codec->length == 0) ? 0 : p_codec->payload[0];
+}
+
+/**
+ * @brief Returns the timestamp of the first sample in the block.
+ *
+ * @param p_codec Encoder state.
+ * @return Timestamp, valid if the block is not empty.
+ */
+uint32_t sample_codec_first_us(sample_codec_t const *p_codec) {
+  return p_codec->first_us;
+}
+
+/**
+ * @brief Returns how long the first sample in the block has waited.
+ *
+ * @param p_codec Encoder state.
+ * @param now_us Current time in microseconds.
+ * @return Waiting time, 0 if the block is empty.
+ */
+uint32_t sample_codec_age_us(sample_codec_t const *p_codec, uint32_t now_us) {
+  return (p_codec->length == 0) ? 0 : now_us - p_codec->started_us;
+}
+
+/**
+ * @brief Builds the SAMPLE_FRAME_ACCEL_GYRO_BLOCK frame of the block and empties it.
+ *
+ * @param p_codec Encoder state.
+ * @param p_frame Receives the frame, at least SAMPLE_FRAME_MAX_SIZE bytes.
+ * @return Frame length, 0 if the block was empty.
+ */
+uint16_t sample_codec_frame(sample_codec_t *p_codec, uint8_t *p_frame) {
+  uint16_t length = 0;
+
+  if (p_codec->length > 0) {
+    length = sample_frame_encode(p_frame, SAMPLE_FRAME_ACCEL_GYRO_BLOCK, p_codec->first_us, p_codec->payload, p_codec->length);
+    p_codec->length = 0;
+  }
+  return length;
+}
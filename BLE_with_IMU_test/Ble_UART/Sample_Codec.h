@@ -0,0 +1,102 @@
+#ifndef _SAMPLE_CODEC_H_
+#define _SAMPLE_CODEC_H_
+
+#include "Sample_Frame.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @file Sample_Codec.h
+ * @brief Lossless delta compression of accelerometer and gyroscope samples into block frames.
+ *
+ * Consecutive ICM-20948 samples differ by a few counts, yet a SAMPLE_FRAME_ACCEL_GYRO frame
+ * spends 23 bytes on each. The codec collects samples into the payload of one
+ * SAMPLE_FRAME_ACCEL_GYRO_BLOCK frame:
+ *
+ *   count   1 byte, number of samples
+ *   sample  accel X, Y, Z, gyro X, Y, Z of the first sample, each a zigzag varint
+ *   sample  for every further sample: the time since the previous sample in microseconds as a
+ *           varint, then the change of every axis since the previous sample (16-bit wrapping
+ *           difference) as a zigzag varint
+ *
+ * The frame timestamp is the one of the first sample. A varint stores 7 bits per byte, least
+ * significant group first, with bit 7 set on all but the last byte; zigzag maps 0, -1, 1, -2 ..
+ * to 0, 1, 2, 3 .. so small changes of either sign take one byte. A sample at rest takes about
+ * 8 bytes instead of 23, at most 5 + 6 * 3 = 23. The payload is filled up to a limit given per
+ * sample, normally the negotiated data length minus the frame overhead, so one block is one
+ * notification.
+ */
+
+#define SAMPLE_CODEC_SAMPLE_MAX 23 ///< Longest encoding of one sample
+
+/**
+ * @brief Encoder state of one block. Treat as opaque, use the functions below.
+ */
+typedef struct {
+  uint8_t payload[SAMPLE_FRAME_MAX_PAYLOAD]; /**< Block being encoded */
+  uint8_t length;                            /**< Bytes in payload, 0 while empty */
+  uint32_t first_us;                         /**< Timestamp of the first sample */
+  uint32_t started_us;                       /**< Time the first sample was added, base of the latency deadline */
+  uint32_t last_us;                          /**< Timestamp of the previous sample */
+  int16_t last[6];                           /**< Previous sample, accel X, Y, Z, gyro X, Y, Z */
+} sample_codec_t;
+
+/**
+ * @brief Empties the block.
+ *
+ * @param p_codec Encoder state.
+ */
+void sample_codec_reset(sample_codec_t *p_codec);
+
+/**
+ * @brief Appends a sample to the block.
+ *
+ * @param p_codec Encoder state.
+ * @param timestamp_us Time the sample was taken.
+ * @param accel Accelerometer X, Y, Z.
+ * @param gyro Gyroscope X, Y, Z.
+ * @param max_payload Payload length the block must not exceed, at most SAMPLE_FRAME_MAX_PAYLOAD.
+ * @param now_us Current time in microseconds, on the clock later passed to sample_codec_age_us().
+ * @return false if the sample does not fit; the block is unchanged, send it with
+ *         sample_codec_frame() and add the sample to the empty block.
+ */
+bool sample_codec_add(sample_codec_t *p_codec, uint32_t timestamp_us, int16_t const accel[3], int16_t const gyro[3], uint8_t max_payload, uint32_t now_us);
+
+/**
+ * @brief Returns the number of samples in the block.
+ *
+ * @param p_codec Encoder state.
+ * @return Samples added since the last reset.
+ */
+uint8_t sample_codec_count(sample_codec_t const *p_codec);
+
+/**
+ * @brief Returns the timestamp of the first sample in the block.
+ *
+ * @param p_codec Encoder state.
+ * @return Timestamp, valid if the block is not empty.
+ */
+uint32_t sample_codec_first_us(sample_codec_t const *p_codec);
+
+/**
+ * @brief Returns how long the first sample in the block has waited.
+ *
+ * Measured from the now_us its sample_codec_add() was given, not from the sample timestamp,
+ * which may be taken after the caller's notion of now.
+ *
+ * @param p_codec Encoder state.
+ * @param now_us Current time in microseconds.
+ * @return Waiting time, 0 if the block is empty.
+ */
+uint32_t sample_codec_age_us(sample_codec_t const *p_codec, uint32_t now_us);
+
+/**
+ * @brief Builds the SAMPLE_FRAME_ACCEL_GYRO_BLOCK frame of the block and empties it.
+ *
+ * @param p_codec Encoder state.
+ * @param p_frame Receives the frame, at least SAMPLE_FRAME_MAX_SIZE bytes.
+ * @return Frame length, 0 if the block was empty.
+ */
+uint16_t sample_codec_frame(sample_codec_t *p_codec, uint8_t *p_frame);
+
+#endif // _SAMPLE_CODEC_H_
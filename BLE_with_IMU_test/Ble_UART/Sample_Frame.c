@@ -0,0 +1,113 @@
+#include "Sample_Frame.h"
+#include <string.h>
+
+static uint16_t m_sequence[SAMPLE_FRAME_TYPES]; // Sequence number of the next frame of every type
+
+/**
+ * @brief Stores a 16-bit value little-endian.
+ *
+ * @param p_dst Destination, 2 bytes.
+ * @param value Value to store.
+ */
+static void frame_put16(uint8_t *p_dst, uint16_t value) {
+  p_dst[0] = (uint8_t)value;
+  p_dst[1] = (uint8_t)(value >> 8);
+}
+
+/**
+ * @brief Builds a frame around a payload.
+ *
+ * @param p_frame Receives the frame, at least SAMPLE_FRAME_SIZE(length) bytes.
+ * @param type Sample type.
+ * @param timestamp_us Time the sample was taken.
+ * @param p_payload Payload, already in its little-endian layout.
+ * @param length Payload length, at most SAMPLE_FRAME_MAX_PAYLOAD.
+ * @return Frame length, 0 if the payload is too long or the type unknown.
+ */
+uint16_t sample_frame_encode(uint8_t *p_frame, sample_frame_type_t type, uint32_t timestamp_us, uint8_t const *p_payload, uint8_t length) {
+  uint16_t crc;
+
+  if ((length > SAMPLE_FRAME_MAX_PAYLOAD) || (type >= SAMPLE_FRAME_TYPES)) {
+    return 0;
+  }
+  p_frame[0] = SAMPLE_FRAME_SYNC;
+  p_frame[1] = (uint8_t)type;
+  p_frame[2] = length;
+  frame_put16(&p_frame[3], m_sequence[type]++);
+  frame_put16(&p_frame[5], (uint16_t)timestamp_us);
+  frame_put16(&p_frame[7], (uint16_t)(timestamp_us >> 16));
+  memcpy(&p_frame[SAMPLE_FRAME_HEADER_SIZE], p_payload, length);
+
+  crc = crc16_compute(p_frame, SAMPLE_FRAME_HEADER_SIZE + length, NULL);
+  frame_put16(&p_frame[SAMPLE_FRAME_HEADER_SIZE + length], crc);
+  return SAMPLE_FRAME_SIZE(length);
+}
+
+/**
+ * @brief Builds an accelerometer and gyroscope frame from readAccelGyroData output.
+ *
+ * @param p_frame Receives the frame, at least SAMPLE_FRAME_SIZE(SAMPLE_FRAME_ACCEL_GYRO_LEN) bytes.
+ * @param timestamp_us Time the sample was taken.
+ * @param accel Accelerometer X, Y, Z.
+ * @param gyro Gyroscope X, Y, Z.
+ * @return Frame length.
+ */
+uint16_t sample_frame_accel_gyro(uint8_t *p_frame, uint32_t timestamp_us, int16_t const accel[3], int16_t const gyro[3]) {
+  uint8_t payload[SAMPLE_FRAME_ACCEL_GYRO_LEN];
+
+  for (uint8_t i = 0; i < 3; i++) {
+    frame_put16(&payload[2 * i], (uint16_t)accel[i]);
+    frame_put16(&payload[6 + 2 * i], (uint16_t)gyro[i]);
+  }
+  return sample_frame_encode(p_frame, SAMPLE_FRAME_ACCEL_GYRO, timestamp_us, payload, sizeof(payload));
+}
+
+/**
+ * @brief Builds a proximity frame.
+ *
+ * @param p_frame Receives the frame, at least SAMPLE_FRAME_SIZE(SAMPLE_FRAME_PROXIMITY_LEN) bytes.
+ * @param timestamp_us Time the sample was taken.
+ * @param proximity Filtered proximity counts.
+ * @param close true if an object is close.
+ * @return Frame length.
+ */
+uint16_t sample_frame_proximity(uint8_t *p_frame, uint32_t timestamp_us, uint16_t proximity, bool close) {
+  uint8_t payload[SAMPLE_FRAME_PROXIMITY_LEN];
+
+  frame_put16(&payload[0], proximity);
+  payload[2] = close ? 1 : 0;
+  return sample_frame_encode(p_frame, SAMPLE_FRAME_PROXIMITY, timestamp_us, payload, sizeof(payload));
+}
+
+/**
+ * @brief Builds an orientation quaternion frame.
+ *
+ * @param p_frame Receives the frame, at least SAMPLE_FRAME_SIZE(SAMPLE_FRAME_QUATERNION_LEN) bytes.
+ * @param timestamp_us Time of the IMU sample the orientation was updated with.
+ * @param quaternion W, X, Y, Z, scaled by SAMPLE_FRAME_QUATERNION_ONE.
+ * @return Frame length.
+ */
+uint16_t sample_frame_quaternion(uint8_t *p_frame, uint32_t timestamp_us, int16_t const quaternion[4]) {
+  uint8_t payload[SAMPLE_FRAME_QUATERNION_LEN];
+
+  for (uint8_t i = 0; i < 4; i++) {
+    frame_put16(&payload[2 * i], (uint16_t)quaternion[i]);
+  }
+  return sample_frame_encode(p_frame, SAMPLE_FRAME_QUATERNION, timestamp_us, payload, sizeof(payload));
+}
+
+/**
+ * @brief Builds a load cell frame.
+ *
+ * @param p_frame Receives the frame, at least SAMPLE_FRAME_SIZE(SAMPLE_FRAME_LOAD_CELL_LEN) bytes.
+ * @param timestamp_us Time the sample was taken.
+ * @param counts Raw ADC counts.
+ * @return Frame length.
+ */
+uint16_t sample_frame_load_cell(uint8_t *p_frame, uint32_t timestamp_us, int32_t counts) {
+  uint8_t payload[SAMPLE_FRAME_LOAD_CELL_LEN];
+
+  frame_put16(&payload[0], (uint16_t)counts);
+  frame_put16(&payload[2], (uint16_t)((uint32_t)counts >> 16));
+  return sample_frame_encode(p_frame, SAMPLE_FRAME_LOAD_CELL, timestamp_us, payload, sizeof(payload));
+}
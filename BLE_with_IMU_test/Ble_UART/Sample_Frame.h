@@ -0,0 +1,112 @@
+#ifndef _SAMPLE_FRAME_H_
+#define _SAMPLE_FRAME_H_
+
+#include "crc16.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @file Sample_Frame.h
+ * @brief Packed binary frames carrying sensor samples over the BLE UART stream.
+ *
+ * Every sample is sent as one frame, all fields little-endian:
+ *
+ *   offset  size  field
+ *   0       1     SAMPLE_FRAME_SYNC
+ *   1       1     sample type (sample_frame_type_t)
+ *   2       1     payload length n
+ *   3       2     sequence number, incremented per frame of the same type
+ *   5       4     timestamp in microseconds (micros())
+ *   9       n     payload
+ *   9 + n   2     CRC-16/CCITT (crc16_compute, initial value 0xFFFF) of bytes 0 .. 8 + n
+ *
+ * An accelerometer and gyroscope sample takes 23 bytes instead of about 60 characters of
+ * text. Frames can be concatenated into one notification; a receiver finds the frame start
+ * through the sync byte and the CRC, so text interleaved on the same stream (e.g. the "stats"
+ * reply) is skipped. The sequence number shows lost frames; it counts per type, so a stream of
+ * one type (a characteristic of the sensor service, Ble_Sensor.h) has no gaps of its own. A
+ * SAMPLE_FRAME_ACCEL_GYRO_BLOCK frame carries many samples in one payload, see Sample_Codec.h.
+ * Requires CRC16_ENABLED in sdk_config.h.
+ */
+
+#define SAMPLE_FRAME_SYNC 0xA5       ///< First byte of every frame
+#define SAMPLE_FRAME_HEADER_SIZE 9   ///< Sync, type, length, sequence number and timestamp
+#define SAMPLE_FRAME_CRC_SIZE 2      ///< CRC following the payload
+#define SAMPLE_FRAME_MAX_PAYLOAD 233 ///< Longest payload, a frame of it fills a 244 byte notification
+#define SAMPLE_FRAME_MAX_SIZE (SAMPLE_FRAME_HEADER_SIZE + SAMPLE_FRAME_MAX_PAYLOAD + SAMPLE_FRAME_CRC_SIZE)
+#define SAMPLE_FRAME_SIZE(payload) (SAMPLE_FRAME_HEADER_SIZE + (payload) + SAMPLE_FRAME_CRC_SIZE) ///< Frame size for a payload length
+
+/**
+ * @brief Sample types and their payloads.
+ */
+typedef enum {
+  SAMPLE_FRAME_ACCEL_GYRO = 1,       /**< int16 accel X, Y, Z, int16 gyro X, Y, Z (raw counts), 12 bytes */
+  SAMPLE_FRAME_PROXIMITY = 2,        /**< uint16 filtered proximity counts, uint8 close (1) or away (0), 3 bytes */
+  SAMPLE_FRAME_QUATERNION = 3,       /**< int16 orientation quaternion W, X, Y, Z, SAMPLE_FRAME_QUATERNION_ONE is 1.0, 8 bytes */
+  SAMPLE_FRAME_LOAD_CELL = 4,        /**< int32 raw load cell counts, 4 bytes */
+  SAMPLE_FRAME_ACCEL_GYRO_BLOCK = 5  /**< Delta compressed SAMPLE_FRAME_ACCEL_GYRO samples (Sample_Codec.h), timestamp of the first */
+} sample_frame_type_t;
+
+#define SAMPLE_FRAME_TYPES 6 ///< One above the largest sample type
+
+#define SAMPLE_FRAME_ACCEL_GYRO_LEN 12    ///< Payload length of SAMPLE_FRAME_ACCEL_GYRO
+#define SAMPLE_FRAME_PROXIMITY_LEN 3      ///< Payload length of SAMPLE_FRAME_PROXIMITY
+#define SAMPLE_FRAME_QUATERNION_LEN 8     ///< Payload length of SAMPLE_FRAME_QUATERNION
+#define SAMPLE_FRAME_LOAD_CELL_LEN 4      ///< Payload length of SAMPLE_FRAME_LOAD_CELL
+#define SAMPLE_FRAME_QUATERNION_ONE 16384 ///< Quaternion component 1.0 (Q14)
+
+/**
+ * @brief Builds a frame around a payload.
+ *
+ * @param p_frame Receives the frame, at least SAMPLE_FRAME_SIZE(length) bytes.
+ * @param type Sample type.
+ * @param timestamp_us Time the sample was taken.
+ * @param p_payload Payload, already in its little-endian layout.
+ * @param length Payload length, at most SAMPLE_FRAME_MAX_PAYLOAD.
+ * @return Frame length, 0 if the payload is too long or the type unknown.
+ */
+uint16_t sample_frame_encode(uint8_t *p_frame, sample_frame_type_t type, uint32_t timestamp_us, uint8_t const *p_payload, uint8_t length);
+
+/**
+ * @brief Builds an accelerometer and gyroscope frame from readAccelGyroData output.
+ *
+ * @param p_frame Receives the frame, at least SAMPLE_FRAME_SIZE(SAMPLE_FRAME_ACCEL_GYRO_LEN) bytes.
+ * @param timestamp_us Time the sample was taken.
+ * @param accel Accelerometer X, Y, Z.
+ * @param gyro Gyroscope X, Y, Z.
+ * @return Frame length.
+ */
+uint16_t sample_frame_accel_gyro(uint8_t *p_frame, uint32_t timestamp_us, int16_t const accel[3], int16_t const gyro[3]);
+
+/**
+ * @brief Builds a proximity frame.
+ *
+ * @param p_frame Receives the frame, at least SAMPLE_FRAME_SIZE(SAMPLE_FRAME_PROXIMITY_LEN) bytes.
+ * @param timestamp_us Time the sample was taken.
+ * @param proximity Filtered proximity counts.
+ * @param close true if an object is close.
+ * @return Frame length.
+ */
+uint16_t sample_frame_proximity(uint8_t *p_frame, uint32_t timestamp_us, uint16_t proximity, bool close);
+
+/**
+ * @brief Builds an orientation quaternion frame.
+ *
+ * @param p_frame Receives the frame, at least SAMPLE_FRAME_SIZE(SAMPLE_FRAME_QUATERNION_LEN) bytes.
+ * @param timestamp_us Time of the IMU sample the orientation was updated with.
+ * @param quaternion W, X, Y, Z, scaled by SAMPLE_FRAME_QUATERNION_ONE.
+ * @return Frame length.
+ */
+uint16_t sample_frame_quaternion(uint8_t *p_frame, uint32_t timestamp_us, int16_t const quaternion[4]);
+
+/**
+ * @brief Builds a load cell frame.
+ *
+ * @param p_frame Receives the frame, at least SAMPLE_FRAME_SIZE(SAMPLE_FRAME_LOAD_CELL_LEN) bytes.
+ * @param timestamp_us Time the sample was taken.
+ * @param counts Raw ADC counts.
+ * @return Frame length.
+ */
+uint16_t sample_frame_load_cell(uint8_t *p_frame, uint32_t timestamp_us, int32_t counts);
+
+#endif // _SAMPLE_FRAME_H_
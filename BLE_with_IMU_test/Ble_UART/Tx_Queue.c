@@ -0,0 +1,190 @@
+#include "Tx_Queue.h"
+#include <stdio.h>
+#include <string.h>
+
+/**
+ * @brief Drops the notifications ready to be sent, the caller holds the critical region.
+ *
+ * Slots still being filled by an interrupted push are kept.
+ *
+ * @param p_queue Queue.
+ */
+static void queue_drop_ready(tx_queue_t *p_queue) {
+  p_queue->head = (p_queue->head + p_queue->ready) % TX_QUEUE_SLOTS;
+  p_queue->count -= p_queue->ready;
+  p_queue->ready = 0;
+  p_queue->clear_pending = false;
+}
+
+/**
+ * @brief Initializes a queue.
+ *
+ * @param p_queue Queue to initialize.
+ * @param send Function handing a notification to the SoftDevice.
+ * @param policy Behaviour when full.
+ */
+void tx_queue_init(tx_queue_t *p_queue, tx_queue_send_t send, tx_queue_policy_t policy) {
+  memset(p_queue, 0, sizeof(*p_queue));
+  p_queue->send = send;
+  p_queue->policy = policy;
+}
+
+/**
+ * @brief Copies a notification into the queue and starts sending.
+ *
+ * @param p_queue Queue.
+ * @param channel Passed to the send function with the notification.
+ * @param p_data Data to send.
+ * @param length Number of bytes, at most TX_QUEUE_SLOT_LEN.
+ * @return false if the notification was dropped.
+ */
+bool tx_queue_push(tx_queue_t *p_queue, uint8_t channel, uint8_t const *p_data, uint16_t length) {
+  bool queued = true;
+  uint8_t slot = 0;
+
+  CRITICAL_REGION_ENTER();
+  p_queue->stats.pushed++;
+  if ((length <= TX_QUEUE_SLOT_LEN) && (p_queue->count == TX_QUEUE_SLOTS) &&
+      (p_queue->policy == TX_QUEUE_OVERWRITE_OLDEST) && (p_queue->ready > 0) && !p_queue->pumping) {
+    p_queue->stats.overwritten++; // The slot of the oldest notification is reused
+    p_queue->head = (p_queue->head + 1) % TX_QUEUE_SLOTS;
+    p_queue->count--;
+    p_queue->ready--;
+  }
+  if ((length > TX_QUEUE_SLOT_LEN) || (p_queue->count == TX_QUEUE_SLOTS)) {
+    p_queue->stats.dropped++; // Also with TX_QUEUE_OVERWRITE_OLDEST while the oldest is being sent
+    queued = false;
+  } else {
+    slot = (p_queue->head + p_queue->count) % TX_QUEUE_SLOTS; // Reserved, not sent before it is filled
+    p_queue->count++;
+    p_queue->filling++;
+    p_queue->stats.max_depth = MAX(p_queue->stats.max_depth, p_queue->count);
+  }
+  CRITICAL_REGION_EXIT();
+  if (!queued) {
+    return false;
+  }
+
+  memcpy(p_queue->data[slot], p_data, length);
+  p_queue->length[slot] = length;
+  p_queue->channel[slot] = channel;
+
+  CRITICAL_REGION_ENTER();
+  p_queue->filling--;
+  if (p_queue->filling == 0) { // A push interrupting this one reserved a later slot, both become ready together
+    p_queue->ready = p_queue->count;
+  }
+  CRITICAL_REGION_EXIT();
+  tx_queue_pump(p_queue);
+  return true;
+}
+
+/**
+ * @brief Sends waiting notifications until the queue is empty or the SoftDevice is out of buffers.
+ *
+ * Call on BLE_GATTS_EVT_HVN_TX_COMPLETE.
+ *
+ * @param p_queue Queue.
+ */
+void tx_queue_pump(tx_queue_t *p_queue) {
+  bool again = true;
+
+  while (again) {
+    uint8_t slot = 0;
+    bool start = false;
+    ret_code_t err_code;
+
+    CRITICAL_REGION_ENTER();
+    if (p_queue->pumping) {
+      p_queue->pump_again = true; // Retried by the running pump if the SoftDevice had no buffer
+    } else if (p_queue->ready > 0) {
+      p_queue->pumping = true;
+      p_queue->pump_again = false;
+      slot = p_queue->head;
+      start = true;
+    }
+    CRITICAL_REGION_EXIT();
+    if (!start) {
+      return;
+    }
+
+    err_code = p_queue->send(p_queue->channel[slot], p_queue->data[slot], p_queue->length[slot]); // Interrupts stay enabled
+
+    CRITICAL_REGION_ENTER();
+    p_queue->pumping = false;
+    if (err_code == NRF_ERROR_RESOURCES) {
+      p_queue->stats.busy++;       // Resumed on BLE_GATTS_EVT_HVN_TX_COMPLETE
+      again = p_queue->pump_again; // Unless it arrived during the call
+    } else {
+      if (err_code == NRF_SUCCESS) {
+        p_queue->stats.sent++;
+      } else {
+        p_queue->stats.failed++;
+      }
+      p_queue->head = (slot + 1) % TX_QUEUE_SLOTS;
+      p_queue->count--;
+      p_queue->ready--;
+    }
+    if (p_queue->clear_pending) {
+      queue_drop_ready(p_queue);
+    }
+    CRITICAL_REGION_EXIT();
+  }
+}
+
+/**
+ * @brief Drops all waiting notifications, e.g. on disconnection.
+ *
+ * @param p_queue Queue.
+ */
+void tx_queue_clear(tx_queue_t *p_queue) {
+  CRITICAL_REGION_ENTER();
+  if (p_queue->pumping) {
+    p_queue->clear_pending = true; // The oldest one is being sent, the pump drops the rest after it
+  } else {
+    queue_drop_ready(p_queue);
+  }
+  CRITICAL_REGION_EXIT();
+}
+
+/**
+ * @brief Returns the number of waiting notifications.
+ *
+ * @param p_queue Queue.
+ * @return Notifications waiting.
+ */
+uint8_t tx_queue_depth(tx_queue_t const *p_queue) {
+  return p_queue->count;
+}
+
+/**
+ * @brief Formats the counters of a queue as one line of text.
+ *
+ * @param p_queue Queue.
+ * @param p_buf Receives the text.
+ * @param size Size of p_buf.
+ * @return Length of the text.
+ */
+uint16_t tx_queue_stats_format(tx_queue_t const *p_queue, char *p_buf, uint16_t size) {
+  tx_queue_stats_t stats;
+  int length;
+
+  CRITICAL_REGION_ENTER();
+  stats = p_queue->stats; // Consistent snapshot
+  CRITICAL_REGION_EXIT();
+
+  length = snprintf(p_buf, size, "tx n=%lu sent=%lu drop=%lu over=%lu fail=%lu busy=%lu depth=%u\n",
+      (unsigned long)stats.pushed, (unsigned long)stats.sent, (unsigned long)stats.dropped,
+      (unsigned long)stats.overwritten, (unsigned long)stats.failed, (unsigned long)stats.busy, stats.max_depth);
+  return (length < 0) ? 0 : MIN((uint16_t)length, size - 1);
+}
+
+/**
+ * @brief Returns the counters of a queue.
+ *
+ * @param p_queue Queue.
+ * @return Pointer to the counters.
+ */
+tx_queue_stats_t const *tx_queue_stats_get(tx_queue_t const *p_queue) {
+  return &p_queue->stats;
+}
@@ -0,0 +1,151 @@
+#ifndef _TX_QUEUE_H_
+#define _TX_QUEUE_H_
+
+#include "app_error.h"
+#include "app_util_platform.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @file Tx_Queue.h
+ * @brief Non-blocking queue of notifications waiting for SoftDevice TX buffers.
+ *
+ * Notifications are copied into a ring of TX_QUEUE_SLOTS slots and handed to the send function
+ * in order by tx_queue_pump(), which is called after every push and on
+ * BLE_GATTS_EVT_HVN_TX_COMPLETE. Each notification is sent on the channel (characteristic) it
+ * was pushed for. Pumping stops when the send function reports NRF_ERROR_RESOURCES and resumes
+ * once the SoftDevice has transmitted packets, so the caller never waits for the radio.
+ *
+ * When the ring is full, the policy decides which data is lost: TX_QUEUE_DROP_NEWEST keeps the
+ * queued notifications, TX_QUEUE_OVERWRITE_OLDEST replaces the oldest one so the peer gets the
+ * latest samples. Any other error of the send function (not connected, notifications disabled)
+ * discards the notification. Push and pump may be called from the main loop and the BLE event
+ * handler. The critical regions cover only the ring indices: a push reserves its slot and copies
+ * the data with interrupts enabled, and the send function runs outside them too. A pump started
+ * while another one is sending returns at once and the running one continues with the new
+ * notifications. While the oldest notification is being sent, it cannot be replaced, so a push
+ * into a full TX_QUEUE_OVERWRITE_OLDEST queue is dropped.
+ */
+
+#ifndef TX_QUEUE_SLOTS
+#define TX_QUEUE_SLOTS 8 ///< Notifications that can wait
+#endif
+
+#ifndef TX_QUEUE_SLOT_LEN
+#define TX_QUEUE_SLOT_LEN 244 ///< Longest notification, BLE_NUS_MAX_DATA_LEN at NRF_SDH_BLE_GATT_MAX_MTU_SIZE 247
+#endif
+
+/**
+ * @brief What happens to a notification pushed into a full queue.
+ */
+typedef enum {
+  TX_QUEUE_DROP_NEWEST,     /**< The new notification is dropped */
+  TX_QUEUE_OVERWRITE_OLDEST /**< The oldest waiting notification is dropped */
+} tx_queue_policy_t;
+
+/**
+ * @brief Hands a notification to the SoftDevice.
+ *
+ * @param channel Channel given to tx_queue_push, selects the characteristic.
+ * @param p_data Data to send.
+ * @param length Number of bytes.
+ * @return NRF_SUCCESS if queued by the SoftDevice, NRF_ERROR_RESOURCES if it has no free buffer,
+ *         any other error to discard the notification.
+ */
+typedef ret_code_t (*tx_queue_send_t)(uint8_t channel, uint8_t *p_data, uint16_t length);
+
+/**
+ * @brief Counters of a queue.
+ */
+typedef struct {
+  uint32_t pushed;      /**< Notifications pushed */
+  uint32_t sent;        /**< Notifications accepted by the send function */
+  uint32_t dropped;     /**< New notifications dropped because the queue was full or they were too long */
+  uint32_t overwritten; /**< Waiting notifications replaced by new ones */
+  uint32_t failed;      /**< Notifications discarded on a send error */
+  uint32_t busy;        /**< Pumps stopped by NRF_ERROR_RESOURCES */
+  uint8_t max_depth;    /**< Most notifications waiting at once */
+} tx_queue_stats_t;
+
+/**
+ * @brief Queue state. Treat as opaque, use the functions below.
+ */
+typedef struct {
+  uint8_t data[TX_QUEUE_SLOTS][TX_QUEUE_SLOT_LEN]; /**< Notification data */
+  uint16_t length[TX_QUEUE_SLOTS];                 /**< Notification lengths */
+  uint8_t channel[TX_QUEUE_SLOTS];                 /**< Notification channels */
+  uint8_t head;                                    /**< Slot of the oldest notification */
+  uint8_t count;                                   /**< Notifications waiting, including slots being filled */
+  uint8_t ready;                                   /**< Notifications from head on that may be sent */
+  uint8_t filling;                                 /**< Slots reserved by pushes still copying their data */
+  bool pumping;                                    /**< The send function is running for the slot at head */
+  bool pump_again;                                 /**< A pump was started while pumping */
+  bool clear_pending;                              /**< tx_queue_clear was called while pumping */
+  tx_queue_policy_t policy;                        /**< Behaviour when full */
+  tx_queue_send_t send;                            /**< Hands notifications to the SoftDevice */
+  tx_queue_stats_t stats;                          /**< Counters */
+} tx_queue_t;
+
+/**
+ * @brief Initializes a queue.
+ *
+ * @param p_queue Queue to initialize.
+ * @param send Function handing a notification to the SoftDevice.
+ * @param policy Behaviour when full.
+ */
+void tx_queue_init(tx_queue_t *p_queue, tx_queue_send_t send, tx_queue_policy_t policy);
+
+/**
+ * @brief Copies a notification into the queue and starts sending.
+ *
+ * @param p_queue Queue.
+ * @param channel Passed to the send function with the notification.
+ * @param p_data Data to send.
+ * @param length Number of bytes, at most TX_QUEUE_SLOT_LEN.
+ * @return false if the notification was dropped.
+ */
+bool tx_queue_push(tx_queue_t *p_queue, uint8_t channel, uint8_t const *p_data, uint16_t length);
+
+/**
+ * @brief Sends waiting notifications until the queue is empty or the SoftDevice is out of buffers.
+ *
+ * Call on BLE_GATTS_EVT_HVN_TX_COMPLETE.
+ *
+ * @param p_queue Queue.
+ */
+void tx_queue_pump(tx_queue_t *p_queue);
+
+/**
+ * @brief Drops all waiting notifications, e.g. on disconnection.
+ *
+ * @param p_queue Queue.
+ */
+void tx_queue_clear(tx_queue_t *p_queue);
+
+/**
+ * @brief Returns the number of waiting notifications.
+ *
+ * @param p_queue Queue.
+ * @return Notifications waiting.
+ */
+uint8_t tx_queue_depth(tx_queue_t const *p_queue);
+
+/**
+ * @brief Formats the counters of a queue as one line of text.
+ *
+ * @param p_queue Queue.
+ * @param p_buf Receives the text.
+ * @param size Size of p_buf.
+ * @return Length of the text.
+ */
+uint16_t tx_queue_stats_format(tx_queue_t const *p_queue, char *p_buf, uint16_t size);
+
+/**
+ * @brief Returns the counters of a queue.
+ *
+ * @param p_queue Queue.
+ * @return Pointer to the counters.
+ */
+tx_queue_stats_t const *tx_queue_stats_get(tx_queue_t const *p_queue);
+
+#endif // _TX_QUEUE_H_
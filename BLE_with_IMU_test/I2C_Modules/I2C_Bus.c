@@ -0,0 +1,723 @@
+#include "I2C_Bus.h"
+
+/**
+ * @brief Per-bus control block.
+ */
+typedef struct {
+  i2c_bus_transaction_t const *queue[I2C_BUS_QUEUE_SIZE]; // Pending transactions (ring buffer)
+  uint8_t queue_head;                                     // Index of the oldest pending transaction
+  uint8_t queue_count;                                    // Number of pending transactions
+  i2c_bus_transaction_t const *p_current;                 // Transaction being executed, NULL when idle
+  uint8_t xfer_index;                                     // Transfer of p_current being executed
+  bool held;                                              // Bus taken with i2c_bus_acquire
+#if I2C_BUS_STATS_ENABLED
+  uint32_t queued_us[I2C_BUS_QUEUE_SIZE];           // Time each pending transaction was scheduled
+  uint32_t start_us;                                // Time p_current was started
+  i2c_bus_dev_stats_t stats[I2C_BUS_STATS_DEVICES]; // Statistics of the devices seen on the bus
+  uint8_t stats_count;                              // Number of used entries in stats
+#endif
+} i2c_bus_cb_t;
+
+/**
+ * @brief State shared between a blocking call and its completion callback.
+ */
+typedef struct {
+  volatile bool done;         // Set when the transaction completed
+  volatile ret_code_t result; // Result passed to the callback
+  volatile uint32_t done_us;  // Time the callback ran
+} i2c_bus_wait_t;
+
+static const nrf_drv_twi_t m_twi[I2C_BUS_COUNT] = {NRF_DRV_TWI_INSTANCE(0), NRF_DRV_TWI_INSTANCE(1)}; // TWI instance of each bus
+static i2c_bus_cb_t m_bus[I2C_BUS_COUNT];                                                             // Control block of each bus
+#if I2C_BUS_STATS_ENABLED
+static i2c_bus_wait_stats_t m_wait_stats; // Statistics of the blocking helpers
+#endif
+
+static void bus_start_next(i2c_bus_id_t bus);
+
+#if I2C_BUS_STATS_ENABLED
+/**
+ * @brief Returns the statistics entry of a device, allocating one on first use.
+ *
+ * @param bus Bus the device is connected to.
+ * @param dev_addr 7-bit slave address.
+ * @return Pointer to the entry, or NULL if all entries of the bus are in use.
+ */
+static i2c_bus_dev_stats_t *stats_device(i2c_bus_id_t bus, uint8_t dev_addr) {
+  i2c_bus_cb_t *p_cb = &m_bus[bus];
+
+  for (uint8_t i = 0; i < p_cb->stats_count; i++) {
+    if (p_cb->stats[i].dev_addr == dev_addr) {
+      return &p_cb->stats[i];
+    }
+  }
+  if (p_cb->stats_count == I2C_BUS_STATS_DEVICES) {
+    return NULL;
+  }
+  memset(&p_cb->stats[p_cb->stats_count], 0, sizeof(i2c_bus_dev_stats_t));
+  p_cb->stats[p_cb->stats_count].dev_addr = dev_addr;
+  return &p_cb->stats[p_cb->stats_count++];
+}
+
+/**
+ * @brief Records the outcome of the current transaction of a bus.
+ *
+ * Called before p_current is cleared. The device is taken from the first transfer.
+ *
+ * @param bus Bus whose transaction ended.
+ * @param result Result of the transaction.
+ */
+static void stats_record(i2c_bus_id_t bus, ret_code_t result) {
+  i2c_bus_cb_t *p_cb = &m_bus[bus];
+  i2c_bus_transaction_t const *p_transaction = p_cb->p_current;
+  i2c_bus_dev_stats_t *p_stats;
+  uint32_t elapsed = i2c_bus_time_us() - p_cb->start_us;
+  uint8_t bin = 0;
+
+  if ((p_transaction == NULL) || (p_transaction->xfer_count == 0)) {
+    return;
+  }
+  p_stats = stats_device(bus, p_transaction->p_xfers[0].dev_addr);
+  if (p_stats == NULL) {
+    return;
+  }
+
+  p_stats->transactions++;
+  for (uint8_t i = 0; i < p_cb->xfer_index; i++) { // Transfers that completed
+    p_stats->bytes_tx += p_transaction->p_xfers[i].tx_len;
+    p_stats->bytes_rx += p_transaction->p_xfers[i].rx_len;
+  }
+  if ((result == NRF_ERROR_DRV_TWI_ERR_ANACK) || (result == NRF_ERROR_DRV_TWI_ERR_DNACK)) {
+    p_stats->nacks++;
+  } else if (result == NRF_ERROR_TIMEOUT) {
+    p_stats->timeouts++;
+  } else if (result != NRF_SUCCESS) {
+    p_stats->errors++;
+  }
+
+  p_stats->bus_us += elapsed;
+  if (elapsed > p_stats->max_us) {
+    p_stats->max_us = elapsed;
+  }
+  while ((bin < I2C_BUS_STATS_HIST_BINS - 1) && (elapsed >= ((uint32_t)I2C_BUS_STATS_HIST_FIRST_US << bin))) {
+    bin++;
+  }
+  p_stats->hist[bin]++;
+}
+#endif
+
+/**
+ * @brief Finishes the current transaction of a bus and starts the next one.
+ *
+ * @param bus Bus whose transaction finished.
+ * @param result Result passed to the transaction callback.
+ */
+static void bus_complete(i2c_bus_id_t bus, ret_code_t result) {
+  i2c_bus_transaction_t const *p_done = m_bus[bus].p_current;
+
+#if I2C_BUS_STATS_ENABLED
+  stats_record(bus, result);
+#endif
+  m_bus[bus].p_current = NULL;
+  bus_start_next(bus); // Keep the bus busy before running user code
+  if ((p_done != NULL) && (p_done->callback != NULL)) {
+    p_done->callback(result, p_done->p_context);
+  }
+}
+
+/**
+ * @brief Starts the current transfer of the active transaction.
+ *
+ * @param bus Bus to start the transfer on.
+ */
+static void bus_start_xfer(i2c_bus_id_t bus) {
+  i2c_bus_xfer_t const *p_xfer = &m_bus[bus].p_current->p_xfers[m_bus[bus].xfer_index];
+  nrf_drv_twi_xfer_desc_t desc;
+  ret_code_t err_code;
+
+  memset(&desc, 0, sizeof(desc));
+  desc.address = p_xfer->dev_addr;
+  if ((p_xfer->tx_len != 0) && (p_xfer->rx_len != 0)) { // Register address, repeated start, read
+    desc.type = NRF_DRV_TWI_XFER_TXRX;
+    desc.p_primary_buf = (uint8_t *)p_xfer->p_tx;
+    desc.primary_length = p_xfer->tx_len;
+    desc.p_secondary_buf = p_xfer->p_rx;
+    desc.secondary_length = p_xfer->rx_len;
+  } else if (p_xfer->tx_len != 0) { // Write only
+    desc.type = NRF_DRV_TWI_XFER_TX;
+    desc.p_primary_buf = (uint8_t *)p_xfer->p_tx;
+    desc.primary_length = p_xfer->tx_len;
+  } else { // Read only
+    desc.type = NRF_DRV_TWI_XFER_RX;
+    desc.p_primary_buf = p_xfer->p_rx;
+    desc.primary_length = p_xfer->rx_len;
+  }
+
+  err_code = nrf_drv_twi_xfer(&m_twi[bus], &desc, 0);
+  if (err_code != NRF_SUCCESS) {
+    bus_complete(bus, err_code);
+  }
+}
+
+/**
+ * @brief Takes the oldest queued transaction and starts it, if the bus is free.
+ *
+ * @param bus Bus to service.
+ */
+static void bus_start_next(i2c_bus_id_t bus) {
+  i2c_bus_cb_t *p_cb = &m_bus[bus];
+  bool start = false;
+
+  CRITICAL_REGION_ENTER();
+  if ((p_cb->p_current == NULL) && !p_cb->held && (p_cb->queue_count > 0)) {
+    p_cb->p_current = p_cb->queue[p_cb->queue_head];
+#if I2C_BUS_STATS_ENABLED
+    p_cb->start_us = i2c_bus_time_us();
+    i2c_bus_dev_stats_t *p_stats = (p_cb->p_current->xfer_count > 0) ? stats_device(bus, p_cb->p_current->p_xfers[0].dev_addr) : NULL;
+    if (p_stats != NULL) {
+      p_stats->queue_us += p_cb->start_us - p_cb->queued_us[p_cb->queue_head];
+    }
+#endif
+    p_cb->queue_head = (p_cb->queue_head + 1) % I2C_BUS_QUEUE_SIZE;
+    p_cb->queue_count--;
+    p_cb->xfer_index = 0;
+    start = true;
+  }
+  CRITICAL_REGION_EXIT();
+
+  if (start) {
+    if (p_cb->p_current->xfer_count == 0) {
+      bus_complete(bus, NRF_SUCCESS);
+    } else {
+      bus_start_xfer(bus);
+    }
+  }
+}
+
+/**
+ * @brief Removes a transaction from a bus after its caller gave up waiting.
+ *
+ * An active transfer is stopped by disabling and re-enabling the TWI peripheral.
+ *
+ * @param bus Bus the transaction was scheduled on.
+ * @param p_transaction Transaction to remove.
+ */
+static void bus_abort(i2c_bus_id_t bus, i2c_bus_transaction_t const *p_transaction) {
+  i2c_bus_cb_t *p_cb = &m_bus[bus];
+  bool was_current = false;
+
+  CRITICAL_REGION_ENTER();
+  if (p_cb->p_current == p_transaction) {
+#if I2C_BUS_STATS_ENABLED
+    stats_record(bus, NRF_ERROR_TIMEOUT);
+#endif
+    nrf_drv_twi_disable(&m_twi[bus]); // Resets the peripheral and the driver state
+    nrf_drv_twi_enable(&m_twi[bus]);
+    p_cb->p_current = NULL;
+    was_current = true;
+  } else {
+    for (uint8_t i = 0; i < p_cb->queue_count; i++) { // Drop it from the queue, keeping the order of the rest
+      uint8_t index = (p_cb->queue_head + i) % I2C_BUS_QUEUE_SIZE;
+      if (p_cb->queue[index] == p_transaction) {
+        for (uint8_t j = i; j + 1 < p_cb->queue_count; j++) {
+          p_cb->queue[(p_cb->queue_head + j) % I2C_BUS_QUEUE_SIZE] = p_cb->queue[(p_cb->queue_head + j + 1) % I2C_BUS_QUEUE_SIZE];
+#if I2C_BUS_STATS_ENABLED
+          p_cb->queued_us[(p_cb->queue_head + j) % I2C_BUS_QUEUE_SIZE] = p_cb->queued_us[(p_cb->queue_head + j + 1) % I2C_BUS_QUEUE_SIZE];
+#endif
+        }
+        p_cb->queue_count--;
+        break;
+      }
+    }
+  }
+  CRITICAL_REGION_EXIT();
+
+  if (was_current) {
+    bus_start_next(bus);
+  }
+}
+
+/**
+ * @brief TWI event handler shared by all buses.
+ *
+ * @param p_event Pointer to the TWI event structure.
+ * @param p_context Bus identifier.
+ */
+static void bus_twi_handler(nrf_drv_twi_evt_t const *p_event, void *p_context) {
+  i2c_bus_id_t bus = (i2c_bus_id_t)(uintptr_t)p_context;
+  i2c_bus_cb_t *p_cb = &m_bus[bus];
+
+  if (p_cb->p_current == NULL) { // Transaction was aborted meanwhile
+    return;
+  }
+
+  switch (p_event->type) {
+  case NRF_DRV_TWI_EVT_DONE:
+    if (++p_cb->xfer_index < p_cb->p_current->xfer_count) {
+      bus_start_xfer(bus); // Next transfer of the same transaction
+    } else {
+      bus_complete(bus, NRF_SUCCESS);
+    }
+    break;
+
+  case NRF_DRV_TWI_EVT_ADDRESS_NACK:
+    bus_complete(bus, NRF_ERROR_DRV_TWI_ERR_ANACK);
+    break;
+
+  case NRF_DRV_TWI_EVT_DATA_NACK:
+    bus_complete(bus, NRF_ERROR_DRV_TWI_ERR_DNACK);
+    break;
+
+  default:
+    bus_complete(bus, NRF_ERROR_INTERNAL);
+    break;
+  }
+}
+
+/**
+ * @brief Completion callback used by the blocking helpers.
+ *
+ * @param result Result of the transaction.
+ * @param p_context Pointer to the i2c_bus_wait_t of the waiting caller.
+ */
+static void bus_wait_callback(ret_code_t result, void *p_context) {
+  i2c_bus_wait_t *p_wait = (i2c_bus_wait_t *)p_context;
+  p_wait->result = result;
+  p_wait->done_us = i2c_bus_time_us();
+  p_wait->done = true;
+}
+
+/**
+ * @brief Initializes and enables a bus.
+ *
+ * @param bus Bus to initialize.
+ * @param scl_pin SCL pin number.
+ * @param sda_pin SDA pin number.
+ */
+void i2c_bus_init(i2c_bus_id_t bus, uint32_t scl_pin, uint32_t sda_pin) {
+  ret_code_t err_code;
+
+  const nrf_drv_twi_config_t twi_config = {
+      .scl = scl_pin,
+      .sda = sda_pin,
+      .frequency = NRF_DRV_TWI_FREQ_100K,
+      .interrupt_priority = APP_IRQ_PRIORITY_HIGH,
+      .clear_bus_init = false};
+
+  memset(&m_bus[bus], 0, sizeof(m_bus[bus]));
+  err_code = nrf_drv_twi_init(&m_twi[bus], &twi_config, bus_twi_handler, (void *)(uintptr_t)bus);
+  APP_ERROR_CHECK(err_code);
+  i2c_bus_enable(bus, true);
+}
+
+/**
+ * @brief Enables or disables the TWI peripheral of a bus.
+ *
+ * @param bus Bus to change.
+ * @param isEnabled true = enable, false = disable.
+ */
+void i2c_bus_enable(i2c_bus_id_t bus, bool isEnabled) {
+  if (isEnabled)
+    nrf_drv_twi_enable(&m_twi[bus]);
+  else
+    nrf_drv_twi_disable(&m_twi[bus]);
+}
+
+/**
+ * @brief Queues a transaction; it starts immediately if the bus is idle.
+ *
+ * @param bus Bus to use.
+ * @param p_transaction Transaction to execute, must stay valid until its callback.
+ * @return NRF_SUCCESS, or NRF_ERROR_NO_MEM if the queue is full.
+ */
+ret_code_t i2c_bus_schedule(i2c_bus_id_t bus, i2c_bus_transaction_t const *p_transaction) {
+  i2c_bus_cb_t *p_cb = &m_bus[bus];
+  ret_code_t err_code = NRF_SUCCESS;
+
+  CRITICAL_REGION_ENTER();
+  if (p_cb->queue_count < I2C_BUS_QUEUE_SIZE) {
+    p_cb->queue[(p_cb->queue_head + p_cb->queue_count) % I2C_BUS_QUEUE_SIZE] = p_transaction;
+#if I2C_BUS_STATS_ENABLED
+    p_cb->queued_us[(p_cb->queue_head + p_cb->queue_count) % I2C_BUS_QUEUE_SIZE] = i2c_bus_time_us();
+#endif
+    p_cb->queue_count++;
+  } else {
+    err_code = NRF_ERROR_NO_MEM;
+  }
+  CRITICAL_REGION_EXIT();
+
+  if (err_code == NRF_SUCCESS) {
+    bus_start_next(bus);
+  }
+  return err_code;
+}
+
+/**
+ * @brief Removes a scheduled transaction without calling its callback.
+ *
+ * An active transfer is stopped by disabling and re-enabling the TWI peripheral; a transaction
+ * that already completed or was never scheduled is ignored.
+ *
+ * @param bus Bus the transaction was scheduled on.
+ * @param p_transaction Transaction to remove.
+ */
+void i2c_bus_cancel(i2c_bus_id_t bus, i2c_bus_transaction_t const *p_transaction) {
+  bus_abort(bus, p_transaction);
+}
+
+/**
+ * @brief Executes transfers and waits for them to complete.
+ *
+ * @param bus Bus to use.
+ * @param p_xfers Transfers to execute in order.
+ * @param xfer_count Number of transfers.
+ * @param timeout_ms Timeout in milliseconds, 0 waits forever.
+ * @return Result of the transaction, or NRF_ERROR_TIMEOUT.
+ */
+ret_code_t i2c_bus_perform(i2c_bus_id_t bus, i2c_bus_xfer_t const *p_xfers, uint8_t xfer_count, uint16_t timeout_ms) {
+  i2c_bus_wait_t wait = {.done = false, .result = NRF_SUCCESS, .done_us = 0};
+  i2c_bus_transaction_t transaction = {
+      .p_xfers = p_xfers,
+      .xfer_count = xfer_count,
+      .callback = bus_wait_callback,
+      .p_context = &wait};
+  ret_code_t err_code;
+
+  err_code = i2c_bus_schedule(bus, &transaction);
+  if (err_code != NRF_SUCCESS) {
+    return err_code;
+  }
+
+  uint32_t start = i2c_bus_time_us();
+#if I2C_BUS_STATS_ENABLED
+  bool waited = !wait.done;
+#endif
+  while (!wait.done) { // Sleep until the TWI interrupt has run the transaction to completion
+    if ((timeout_ms != 0) && ((i2c_bus_time_us() - start) >= (uint32_t)timeout_ms * 1000)) {
+      bus_abort(bus, &transaction);
+      if (!wait.done) {
+        return NRF_ERROR_TIMEOUT;
+      }
+    }
+    i2c_bus_wait_for_event(start, timeout_ms);
+  }
+#if I2C_BUS_STATS_ENABLED
+  if (waited) {
+    uint32_t wake_us = i2c_bus_time_us() - wait.done_us;
+    m_wait_stats.waits++;
+    m_wait_stats.wake_us += wake_us;
+    m_wait_stats.wake_max_us = MAX(m_wait_stats.wake_max_us, wake_us);
+  }
+#endif
+  return wait.result;
+}
+
+/**
+ * @brief Reads consecutive bytes starting at a device register.
+ *
+ * @param bus Bus to use.
+ * @param devAddr I2C slave device address.
+ * @param regAddr First register to read.
+ * @param p_data Buffer for the read bytes.
+ * @param length Number of bytes to read.
+ * @param timeout_ms Timeout in milliseconds, 0 waits forever.
+ * @return NRF_SUCCESS or an error code.
+ */
+ret_code_t i2c_bus_read(i2c_bus_id_t bus, uint8_t devAddr, uint8_t regAddr, uint8_t *p_data, uint8_t length, uint16_t timeout_ms) {
+  i2c_bus_xfer_t xfer = {
+      .dev_addr = devAddr,
+      .p_tx = &regAddr,
+      .tx_len = 1,
+      .p_rx = p_data,
+      .rx_len = length};
+  return i2c_bus_perform(bus, &xfer, 1, timeout_ms);
+}
+
+/**
+ * @brief Writes consecutive bytes starting at a device register and waits for the STOP.
+ *
+ * @param bus Bus to use.
+ * @param devAddr I2C slave device address.
+ * @param regAddr First register to write.
+ * @param p_data Bytes to write.
+ * @param length Number of bytes to write (at most I2C_BUS_MAX_WRITE_LEN).
+ * @param timeout_ms Timeout in milliseconds, 0 waits forever.
+ * @return NRF_SUCCESS, NRF_ERROR_INVALID_LENGTH or an error code.
+ */
+ret_code_t i2c_bus_write(i2c_bus_id_t bus, uint8_t devAddr, uint8_t regAddr, uint8_t const *p_data, uint8_t length, uint16_t timeout_ms) {
+  uint8_t tx_buf[I2C_BUS_MAX_WRITE_LEN + 1]; // Register address + data
+
+  if (length > I2C_BUS_MAX_WRITE_LEN) {
+    return NRF_ERROR_INVALID_LENGTH;
+  }
+  tx_buf[0] = regAddr;
+  memcpy(tx_buf + 1, p_data, length);
+
+  i2c_bus_xfer_t xfer = {
+      .dev_addr = devAddr,
+      .p_tx = tx_buf,
+      .tx_len = length + 1,
+      .p_rx = NULL,
+      .rx_len = 0};
+  return i2c_bus_perform(bus, &xfer, 1, timeout_ms);
+}
+
+/**
+ * @brief Waits until all transactions queued on a bus have completed.
+ *
+ * @param bus Bus to wait for.
+ * @param timeout_ms Timeout in milliseconds, 0 waits forever.
+ * @return NRF_SUCCESS, or NRF_ERROR_TIMEOUT.
+ */
+ret_code_t i2c_bus_wait_idle(i2c_bus_id_t bus, uint16_t timeout_ms) {
+  uint32_t start = i2c_bus_time_us();
+#if I2C_BUS_STATS_ENABLED
+  if (!i2c_bus_is_idle(bus)) {
+    m_wait_stats.waits++;
+  }
+#endif
+  while (!i2c_bus_is_idle(bus)) {
+    if ((timeout_ms != 0) && ((i2c_bus_time_us() - start) >= (uint32_t)timeout_ms * 1000)) {
+      return NRF_ERROR_TIMEOUT;
+    }
+    i2c_bus_wait_for_event(start, timeout_ms);
+  }
+  return NRF_SUCCESS;
+}
+
+/**
+ * @brief Disables the TIMER1 compare wake-up armed by i2c_bus_wait_for_event.
+ */
+static void bus_wake_disarm(void) {
+  NRF_TIMER1->INTENCLR = TIMER_INTENSET_COMPARE0_Msk << I2C_BUS_WAKE_CC;
+  NRF_TIMER1->EVENTS_COMPARE[I2C_BUS_WAKE_CC] = 0;
+  (void)NRF_TIMER1->EVENTS_COMPARE[I2C_BUS_WAKE_CC]; // Make sure the event is cleared before the interrupt is
+  NVIC_ClearPendingIRQ(TIMER1_IRQn);                 // Otherwise the next sleep returns immediately
+}
+
+/**
+ * @brief Waits for the next event while a blocking call is pending.
+ *
+ * The TIMER1 interrupt is never enabled in the NVIC: with SEVONPEND set, its compare event
+ * only becomes pending and wakes the CPU. sd_app_evt_wait returns for such pending
+ * interrupts as well, as long as their pending flag is cleared before the next call.
+ *
+ * @param start_us Time the wait started (i2c_bus_time_us).
+ * @param timeout_ms Timeout of the wait in milliseconds, 0 waits forever.
+ */
+void i2c_bus_wait_for_event(uint32_t start_us, uint16_t timeout_ms) {
+#if I2C_BUS_WAIT_SLEEP
+  if (__get_IPSR() != 0) { // In an interrupt, the SoftDevice cannot be called: keep polling
+#if I2C_BUS_STATS_ENABLED
+    m_wait_stats.spins++;
+#endif
+    return;
+  }
+
+  if (timeout_ms != 0) { // Wake up at the end of the timeout if the TWI interrupt never comes
+    NRF_TIMER1->EVENTS_COMPARE[I2C_BUS_WAKE_CC] = 0;
+    NRF_TIMER1->CC[I2C_BUS_WAKE_CC] = start_us + (uint32_t)timeout_ms * 1000;
+    NRF_TIMER1->INTENSET = TIMER_INTENSET_COMPARE0_Msk << I2C_BUS_WAKE_CC;
+    if ((i2c_bus_time_us() - start_us) >= (uint32_t)timeout_ms * 1000) { // Deadline passed while arming
+      bus_wake_disarm();
+      return;
+    }
+  }
+
+  SCB->SCR |= SCB_SCR_SEVONPEND_Msk; // Pending interrupts wake the CPU even if they are disabled
+#ifdef SOFTDEVICE_PRESENT
+  if (nrf_sdh_is_enabled()) {
+    (void)sd_app_evt_wait();
+  } else
+#endif
+  {
+    __WFE(); // Sleep, or consume an event that is already set
+    __SEV(); // Make sure the event register is set ...
+    __WFE(); // ... and cleared again, so the next call sleeps
+  }
+#if I2C_BUS_STATS_ENABLED
+  m_wait_stats.sleeps++;
+#endif
+
+  if (timeout_ms != 0) {
+    bus_wake_disarm();
+  }
+#elif I2C_BUS_STATS_ENABLED
+  m_wait_stats.spins++;
+#endif
+}
+
+/**
+ * @brief Checks whether a bus has no active or queued transaction.
+ *
+ * @param bus Bus to check.
+ * @return true if the bus is idle.
+ */
+bool i2c_bus_is_idle(i2c_bus_id_t bus) {
+  return (m_bus[bus].p_current == NULL) && (m_bus[bus].queue_count == 0);
+}
+
+/**
+ * @brief Takes exclusive ownership of an idle bus.
+ *
+ * @param bus Bus to take.
+ * @return NRF_SUCCESS, or NRF_ERROR_BUSY if a transaction is active or queued.
+ */
+ret_code_t i2c_bus_acquire(i2c_bus_id_t bus) {
+  ret_code_t err_code = NRF_ERROR_BUSY;
+
+  CRITICAL_REGION_ENTER();
+  if (!m_bus[bus].held && i2c_bus_is_idle(bus)) {
+    m_bus[bus].held = true;
+    err_code = NRF_SUCCESS;
+  }
+  CRITICAL_REGION_EXIT();
+  return err_code;
+}
+
+/**
+ * @brief Releases a bus taken with i2c_bus_acquire and starts queued transactions.
+ *
+ * @param bus Bus to release.
+ */
+void i2c_bus_release(i2c_bus_id_t bus) {
+  m_bus[bus].held = false;
+  bus_start_next(bus);
+}
+
+/**
+ * @brief Returns the TWI driver instance of a bus.
+ *
+ * @param bus Bus to query.
+ * @return Pointer to the driver instance.
+ */
+nrf_drv_twi_t const *i2c_bus_twi_get(i2c_bus_id_t bus) {
+  return &m_twi[bus];
+}
+
+/**
+ * @brief Returns the current time of the free-running 1 MHz TIMER1 (see timer1_init in main.c).
+ *
+ * Uses its own capture channel so it can be called from interrupts without disturbing micros().
+ *
+ * @return Time in microseconds.
+ */
+uint32_t i2c_bus_time_us(void) {
+  NRF_TIMER1->TASKS_CAPTURE[I2C_BUS_TIMER_CC] = 1;
+  return NRF_TIMER1->CC[I2C_BUS_TIMER_CC];
+}
+
+#if I2C_BUS_STATS_ENABLED
+/**
+ * @brief Returns the statistics of a device seen on a bus.
+ *
+ * @param bus Bus to query.
+ * @param index Device index, starting at 0 in order of first use.
+ * @return Pointer to the statistics, or NULL if fewer devices were seen.
+ */
+i2c_bus_dev_stats_t const *i2c_bus_stats_get(i2c_bus_id_t bus, uint8_t index) {
+  return (index < m_bus[bus].stats_count) ? &m_bus[bus].stats[index] : NULL;
+}
+
+/**
+ * @brief Clears the statistics of all buses and of the blocking helpers.
+ */
+void i2c_bus_stats_reset(void) {
+  CRITICAL_REGION_ENTER();
+  for (uint8_t bus = 0; bus < I2C_BUS_COUNT; bus++) {
+    m_bus[bus].stats_count = 0;
+  }
+  memset(&m_wait_stats, 0, sizeof(m_wait_stats));
+  CRITICAL_REGION_EXIT();
+}
+
+/**
+ * @brief Formats the statistics of a device as text, one line for the counters and one for the histogram.
+ *
+ * Example: "I2C1 0x60 n=120 tx=240 rx=240 nak=0 to=0 err=0 avg=412 max=530 q=35 us\nh: 0 0 0 118 2 0 0 0 0 0\n"
+ *
+ * @param bus Bus to query.
+ * @param index Device index, see i2c_bus_stats_get.
+ * @param p_buf Buffer for the zero terminated text.
+ * @param size Size of the buffer.
+ * @return Length of the text, or 0 if there is no such device.
+ */
+uint16_t i2c_bus_stats_format(i2c_bus_id_t bus, uint8_t index, char *p_buf, uint16_t size) {
+  i2c_bus_dev_stats_t stats;
+  int length;
+
+  if (index >= m_bus[bus].stats_count) {
+    return 0;
+  }
+  CRITICAL_REGION_ENTER();
+  stats = m_bus[bus].stats[index]; // Consistent snapshot
+  CRITICAL_REGION_EXIT();
+
+  uint32_t n = (stats.transactions > 0) ? stats.transactions : 1;
+  length = snprintf(p_buf, size, "I2C%u 0x%02X n=%lu tx=%lu rx=%lu nak=%lu to=%lu err=%lu avg=%lu max=%lu q=%lu us\nh:",
+      bus, stats.dev_addr, (unsigned long)stats.transactions, (unsigned long)stats.bytes_tx, (unsigned long)stats.bytes_rx,
+      (unsigned long)stats.nacks, (unsigned long)stats.timeouts, (unsigned long)stats.errors,
+      (unsigned long)(stats.bus_us / n), (unsigned long)stats.max_us, (unsigned long)(stats.queue_us / n));
+  for (uint8_t i = 0; (i < I2C_BUS_STATS_HIST_BINS) && (length > 0) && (length < size); i++) {
+    length += snprintf(p_buf + length, size - length, " %lu", (unsigned long)stats.hist[i]);
+  }
+  if ((length > 0) && (length < size)) {
+    length += snprintf(p_buf + length, size - length, "\n");
+  }
+  return (length < 0) ? 0 : MIN((uint16_t)length, size - 1);
+}
+
+/**
+ * @brief Returns the statistics of the blocking helpers.
+ *
+ * @return Pointer to the statistics.
+ */
+i2c_bus_wait_stats_t const *i2c_bus_wait_stats_get(void) {
+  return &m_wait_stats;
+}
+
+/**
+ * @brief Formats the statistics of the blocking helpers as one line of text.
+ *
+ * Example: "wait n=120 sleep=131 spin=0 wake avg=14 max=31 us\n"
+ *
+ * @param p_buf Buffer for the zero terminated text.
+ * @param size Size of the buffer.
+ * @return Length of the text.
+ */
+uint16_t i2c_bus_wait_stats_format(char *p_buf, uint16_t size) {
+  i2c_bus_wait_stats_t stats;
+  int length;
+
+  CRITICAL_REGION_ENTER();
+  stats = m_wait_stats;
+  CRITICAL_REGION_EXIT();
+
+  length = snprintf(p_buf, size, "wait n=%lu sleep=%lu spin=%lu wake avg=%lu max=%lu us\n",
+      (unsigned long)stats.waits, (unsigned long)stats.sleeps, (unsigned long)stats.spins,
+      (unsigned long)(stats.wake_us / MAX(stats.waits, 1)), (unsigned long)stats.wake_max_us);
+  return (length < 0) ? 0 : MIN((uint16_t)length, size - 1);
+}
+
+/**
+ * @brief Writes the statistics of all devices to the log (RTT).
+ */
+void i2c_bus_stats_log(void) {
+  for (uint8_t bus = 0; bus < I2C_BUS_COUNT; bus++) {
+    for (uint8_t i = 0; i < m_bus[bus].stats_count; i++) {
+      i2c_bus_dev_stats_t const *p_stats = &m_bus[bus].stats[i];
+      NRF_LOG_INFO("I2C%d 0x%02X n=%d tx=%d rx=%d", bus, p_stats->dev_addr, p_stats->transactions, p_stats->bytes_tx, p_stats->bytes_rx);
+      NRF_LOG_INFO("  nak=%d to=%d err=%d", p_stats->nacks, p_stats->timeouts, p_stats->errors);
+      NRF_LOG_INFO("  avg=%d max=%d queue=%d us", p_stats->bus_us / MAX(p_stats->transactions, 1), p_stats->max_us, p_stats->queue_us / MAX(p_stats->transactions, 1));
+      for (uint8_t bin = 0; bin < I2C_BUS_STATS_HIST_BINS; bin++) {
+        if (p_stats->hist[bin] != 0) {
+          NRF_LOG_INFO("  >= %d us: %d", (bin == 0) ? 0 : (I2C_BUS_STATS_HIST_FIRST_US << (bin - 1)), p_stats->hist[bin]);
+        }
+      }
+    }
+  }
+  NRF_LOG_INFO("wait n=%d sleep=%d spin=%d", m_wait_stats.waits, m_wait_stats.sleeps, m_wait_stats.spins);
+  NRF_LOG_INFO("  wake avg=%d max=%d us", m_wait_stats.wake_us / MAX(m_wait_stats.waits, 1), m_wait_stats.wake_max_us);
+  NRF_LOG_FLUSH();
+}
+#endif
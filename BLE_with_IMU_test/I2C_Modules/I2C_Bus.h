@@ -0,0 +1,316 @@
+#ifndef _I2C_BUS_H_
+#define _I2C_BUS_H_
+
+#include "app_error.h"
+#include "app_util_platform.h"
+#include "nrf.h"
+#include "nrf_drv_twi.h"
+#include "nrf_log.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#ifdef SOFTDEVICE_PRESENT
+#include "nrf_sdh.h"
+#include "nrf_soc.h"
+#endif
+
+/**
+ * @file I2C_Bus.h
+ * @brief Multi-instance I2C bus layer shared by all sensor drivers.
+ *
+ * Every TWI instance gets its own control block and transaction queue, driven by the same
+ * code. Transactions scheduled on different buses run in parallel; transactions on the
+ * same bus are executed in order from the TWI interrupt without CPU polling.
+ *
+ * Blocking helpers (i2c_bus_perform, i2c_bus_read, i2c_bus_write) are built on top of the
+ * queue, so synchronous and asynchronous users can share a bus. While they wait, the CPU
+ * sleeps (sd_app_evt_wait, or WFE before the SoftDevice is enabled) and is woken by the TWI
+ * interrupt or, at the end of the timeout, by a TIMER1 compare event.
+ */
+
+/**
+ * @brief Available buses, numbered after the TWI instance they use.
+ */
+typedef enum {
+  I2C_BUS_TWI0 = 0, /**< TWI0, ICM-20948 on the PCB */
+  I2C_BUS_TWI1,     /**< TWI1, VCNL4040 on the PCB */
+  I2C_BUS_COUNT     /**< Number of buses */
+} i2c_bus_id_t;
+
+#define I2C_BUS_QUEUE_SIZE 8     ///< Transactions that can be pending on one bus
+#define I2C_BUS_MAX_WRITE_LEN 32 ///< Largest payload accepted by i2c_bus_write (excluding register address)
+#define I2C_BUS_TIMER_CC 1       ///< TIMER1 capture channel used for timeouts (CC[0] belongs to micros())
+#define I2C_BUS_WAKE_CC 2        ///< TIMER1 compare channel waking a sleeping caller when its timeout expires
+
+#ifndef I2C_BUS_WAIT_SLEEP
+#define I2C_BUS_WAIT_SLEEP 1 ///< Sleep instead of polling while a blocking helper waits for the bus
+#endif
+
+#ifndef I2C_BUS_STATS_ENABLED
+#define I2C_BUS_STATS_ENABLED 1 ///< Record per-device transaction statistics
+#endif
+#define I2C_BUS_STATS_DEVICES 4        ///< Devices tracked per bus
+#define I2C_BUS_STATS_HIST_BINS 10     ///< Latency histogram bins
+#define I2C_BUS_STATS_HIST_FIRST_US 64 ///< Upper bound of the first bin; every further bin doubles it, the last bin is open ended
+
+/**
+ * @brief A single I2C transfer.
+ *
+ * tx bytes (usually the register address) are written first; if rx_len is not zero the bus
+ * issues a repeated start and reads rx_len bytes. Either part may be empty. With EasyDMA
+ * both buffers must be located in RAM.
+ */
+typedef struct {
+  uint8_t dev_addr;    /**< 7-bit slave address */
+  uint8_t const *p_tx; /**< Bytes to write, may be NULL if tx_len is 0 */
+  uint8_t tx_len;      /**< Number of bytes to write */
+  uint8_t *p_rx;       /**< Buffer for read bytes, may be NULL if rx_len is 0 */
+  uint8_t rx_len;      /**< Number of bytes to read */
+} i2c_bus_xfer_t;
+
+/**
+ * @brief Completion callback of a transaction.
+ *
+ * Called from the TWI interrupt (or from the caller when the first transfer cannot be started).
+ *
+ * @param result NRF_SUCCESS, NRF_ERROR_DRV_TWI_ERR_ANACK/DNACK or the driver error that stopped the transaction.
+ * @param p_context User context given in the transaction.
+ */
+typedef void (*i2c_bus_callback_t)(ret_code_t result, void *p_context);
+
+/**
+ * @brief A sequence of transfers executed back to back with a single completion callback.
+ *
+ * The structure and everything it points to must stay valid until the callback was called.
+ */
+typedef struct {
+  i2c_bus_xfer_t const *p_xfers; /**< Transfers to execute in order */
+  uint8_t xfer_count;            /**< Number of transfers */
+  i2c_bus_callback_t callback;   /**< Called once all transfers are done or one failed, may be NULL */
+  void *p_context;               /**< Passed to the callback */
+} i2c_bus_transaction_t;
+
+/**
+ * @brief Transaction statistics of one device on one bus.
+ *
+ * Latencies are measured with TIMER1 from the moment a transaction is started on the bus
+ * until its completion; the time spent in the queue is accumulated separately.
+ */
+typedef struct {
+  uint8_t dev_addr;                       /**< 7-bit slave address */
+  uint32_t transactions;                  /**< Completed or failed transactions */
+  uint32_t bytes_tx;                      /**< Bytes written, including register addresses */
+  uint32_t bytes_rx;                      /**< Bytes read */
+  uint32_t nacks;                         /**< Transactions ended by an address or data NACK */
+  uint32_t timeouts;                      /**< Transactions aborted by a blocking caller */
+  uint32_t errors;                        /**< Transactions ended by other driver errors */
+  uint32_t bus_us;                        /**< Total time on the bus */
+  uint32_t queue_us;                      /**< Total time waiting in the queue */
+  uint32_t max_us;                        /**< Longest time on the bus */
+  uint32_t hist[I2C_BUS_STATS_HIST_BINS]; /**< Bus time histogram, bin n counts latencies below I2C_BUS_STATS_HIST_FIRST_US << n */
+} i2c_bus_dev_stats_t;
+
+/**
+ * @brief Statistics of the blocking helpers.
+ *
+ * The wake-up latency is the time from the completion callback in the TWI interrupt until
+ * the blocked caller of i2c_bus_perform resumes.
+ */
+typedef struct {
+  uint32_t waits;       /**< Blocking calls that had to wait for the bus */
+  uint32_t sleeps;      /**< Times the CPU was put to sleep while waiting */
+  uint32_t spins;       /**< Wait loop iterations without sleeping (called from an interrupt or sleeping disabled) */
+  uint32_t wake_us;     /**< Total wake-up latency */
+  uint32_t wake_max_us; /**< Longest wake-up latency */
+} i2c_bus_wait_stats_t;
+
+/**
+ * @brief Initializes and enables a bus.
+ *
+ * @param bus Bus to initialize.
+ * @param scl_pin SCL pin number.
+ * @param sda_pin SDA pin number.
+ */
+void i2c_bus_init(i2c_bus_id_t bus, uint32_t scl_pin, uint32_t sda_pin);
+
+/**
+ * @brief Enables or disables the TWI peripheral of a bus.
+ *
+ * @param bus Bus to change.
+ * @param isEnabled true = enable, false = disable.
+ */
+void i2c_bus_enable(i2c_bus_id_t bus, bool isEnabled);
+
+/**
+ * @brief Queues a transaction; it starts immediately if the bus is idle.
+ *
+ * @param bus Bus to use.
+ * @param p_transaction Transaction to execute, must stay valid until its callback.
+ * @return NRF_SUCCESS, or NRF_ERROR_NO_MEM if the queue is full.
+ */
+ret_code_t i2c_bus_schedule(i2c_bus_id_t bus, i2c_bus_transaction_t const *p_transaction);
+
+/**
+ * @brief Removes a scheduled transaction without calling its callback.
+ *
+ * An active transfer is stopped by disabling and re-enabling the TWI peripheral; a transaction
+ * that already completed or was never scheduled is ignored.
+ *
+ * @param bus Bus the transaction was scheduled on.
+ * @param p_transaction Transaction to remove.
+ */
+void i2c_bus_cancel(i2c_bus_id_t bus, i2c_bus_transaction_t const *p_transaction);
+
+/**
+ * @brief Executes transfers and waits for them to complete.
+ *
+ * Must not be called from an interrupt with a priority equal to or higher than the TWI interrupt.
+ *
+ * @param bus Bus to use.
+ * @param p_xfers Transfers to execute in order.
+ * @param xfer_count Number of transfers.
+ * @param timeout_ms Timeout in milliseconds, 0 waits forever.
+ * @return Result of the transaction, or NRF_ERROR_TIMEOUT.
+ */
+ret_code_t i2c_bus_perform(i2c_bus_id_t bus, i2c_bus_xfer_t const *p_xfers, uint8_t xfer_count, uint16_t timeout_ms);
+
+/**
+ * @brief Reads consecutive bytes starting at a device register.
+ *
+ * @param bus Bus to use.
+ * @param devAddr I2C slave device address.
+ * @param regAddr First register to read.
+ * @param p_data Buffer for the read bytes.
+ * @param length Number of bytes to read.
+ * @param timeout_ms Timeout in milliseconds, 0 waits forever.
+ * @return NRF_SUCCESS or an error code.
+ */
+ret_code_t i2c_bus_read(i2c_bus_id_t bus, uint8_t devAddr, uint8_t regAddr, uint8_t *p_data, uint8_t length, uint16_t timeout_ms);
+
+/**
+ * @brief Writes consecutive bytes starting at a device register and waits for the STOP.
+ *
+ * @param bus Bus to use.
+ * @param devAddr I2C slave device address.
+ * @param regAddr First register to write.
+ * @param p_data Bytes to write.
+ * @param length Number of bytes to write (at most I2C_BUS_MAX_WRITE_LEN).
+ * @param timeout_ms Timeout in milliseconds, 0 waits forever.
+ * @return NRF_SUCCESS, NRF_ERROR_INVALID_LENGTH or an error code.
+ */
+ret_code_t i2c_bus_write(i2c_bus_id_t bus, uint8_t devAddr, uint8_t regAddr, uint8_t const *p_data, uint8_t length, uint16_t timeout_ms);
+
+/**
+ * @brief Waits until all transactions queued on a bus have completed.
+ *
+ * @param bus Bus to wait for.
+ * @param timeout_ms Timeout in milliseconds, 0 waits forever.
+ * @return NRF_SUCCESS, or NRF_ERROR_TIMEOUT.
+ */
+ret_code_t i2c_bus_wait_idle(i2c_bus_id_t bus, uint16_t timeout_ms);
+
+/**
+ * @brief Waits for the next event while a blocking call is pending.
+ *
+ * Puts the CPU to sleep until an interrupt occurs; if a timeout is given, a TIMER1 compare
+ * event at start_us + timeout_ms wakes it at the latest. Called from an interrupt, it
+ * returns immediately and the caller keeps polling. Callers loop until their condition
+ * is met, checking their timeout on every iteration.
+ *
+ * @param start_us Time the wait started (i2c_bus_time_us).
+ * @param timeout_ms Timeout of the wait in milliseconds, 0 waits forever.
+ */
+void i2c_bus_wait_for_event(uint32_t start_us, uint16_t timeout_ms);
+
+/**
+ * @brief Checks whether a bus has no active or queued transaction.
+ *
+ * @param bus Bus to check.
+ * @return true if the bus is idle.
+ */
+bool i2c_bus_is_idle(i2c_bus_id_t bus);
+
+/**
+ * @brief Takes exclusive ownership of an idle bus.
+ *
+ * Used by modules that drive the TWI peripheral through hardware tasks (PPI). Transactions
+ * scheduled while the bus is held stay queued until i2c_bus_release is called.
+ *
+ * @param bus Bus to take.
+ * @return NRF_SUCCESS, or NRF_ERROR_BUSY if a transaction is active or queued.
+ */
+ret_code_t i2c_bus_acquire(i2c_bus_id_t bus);
+
+/**
+ * @brief Releases a bus taken with i2c_bus_acquire and starts queued transactions.
+ *
+ * @param bus Bus to release.
+ */
+void i2c_bus_release(i2c_bus_id_t bus);
+
+/**
+ * @brief Returns the TWI driver instance of a bus.
+ *
+ * @param bus Bus to query.
+ * @return Pointer to the driver instance.
+ */
+nrf_drv_twi_t const *i2c_bus_twi_get(i2c_bus_id_t bus);
+
+/**
+ * @brief Returns the current time of the free-running 1 MHz TIMER1 used for bus timeouts.
+ *
+ * @return Time in microseconds.
+ */
+uint32_t i2c_bus_time_us(void);
+
+#if I2C_BUS_STATS_ENABLED
+/**
+ * @brief Returns the statistics of a device seen on a bus.
+ *
+ * @param bus Bus to query.
+ * @param index Device index, starting at 0 in order of first use.
+ * @return Pointer to the statistics, or NULL if fewer devices were seen.
+ */
+i2c_bus_dev_stats_t const *i2c_bus_stats_get(i2c_bus_id_t bus, uint8_t index);
+
+/**
+ * @brief Clears the statistics of all buses and of the blocking helpers.
+ */
+void i2c_bus_stats_reset(void);
+
+/**
+ * @brief Formats the statistics of a device as text, one line for the counters and one for the histogram.
+ *
+ * @param bus Bus to query.
+ * @param index Device index, see i2c_bus_stats_get.
+ * @param p_buf Buffer for the zero terminated text.
+ * @param size Size of the buffer.
+ * @return Length of the text, or 0 if there is no such device.
+ */
+uint16_t i2c_bus_stats_format(i2c_bus_id_t bus, uint8_t index, char *p_buf, uint16_t size);
+
+/**
+ * @brief Returns the statistics of the blocking helpers.
+ *
+ * @return Pointer to the statistics.
+ */
+i2c_bus_wait_stats_t const *i2c_bus_wait_stats_get(void);
+
+/**
+ * @brief Formats the statistics of the blocking helpers as one line of text.
+ *
+ * @param p_buf Buffer for the zero terminated text.
+ * @param size Size of the buffer.
+ * @return Length of the text.
+ */
+uint16_t i2c_bus_wait_stats_format(char *p_buf, uint16_t size);
+
+/**
+ * @brief Writes the statistics of all devices to the log (RTT).
+ */
+void i2c_bus_stats_log(void);
+#endif
+
+#endif /* _I2C_BUS_H_ */
@@ -0,0 +1,399 @@
+#include "I2C_Script.h"
+
+/**
+ * @brief What the transaction or timer of a running script is waiting for.
+ */
+typedef enum {
+  SCRIPT_WAIT_WRITE, // A batch of writes
+  SCRIPT_WAIT_READ,  // The read of an RMW or POLL8 operation
+  SCRIPT_WAIT_TIMER  // A delay or the interval between two polls
+} script_wait_t;
+
+/**
+ * @brief Per-bus script state.
+ */
+typedef struct {
+  i2c_script_op_t const *p_op;                // Operation being executed
+  uint8_t dev_addr;                           // Device the script talks to
+  i2c_bus_callback_t callback;                // User callback
+  void *p_context;                            // User context
+  uint8_t tx[I2C_SCRIPT_MAX_BATCH][3];        // Register address + up to 2 data bytes per write (must live in RAM for EasyDMA)
+  uint8_t rx[2];                              // Register value read by RMW and POLL8 operations
+  i2c_bus_xfer_t xfers[I2C_SCRIPT_MAX_BATCH]; // Transfers of the pending transaction
+  i2c_bus_transaction_t transaction;          // Pending transaction
+  script_wait_t wait;                         // What the script is waiting for
+  bool rmw_ready;                             // rx holds the register value of the current RMW operation
+  bool polling;                               // The current POLL8 operation has been started
+  uint8_t retries_left;                       // Remaining reads of the current POLL8 operation
+  uint8_t timer_tag;                          // Changed by each start of the delay timer, passed in its context
+  volatile bool running;                      // Set from i2c_script_run until the script finished
+} i2c_script_cb_t;
+
+/**
+ * @brief State shared between i2c_script_perform and its completion callback.
+ */
+typedef struct {
+  volatile bool done;         // Set when the script finished
+  volatile ret_code_t result; // Result of the script
+} i2c_script_wait_t;
+
+APP_TIMER_DEF(m_timer_twi0); // Delay timer of scripts on TWI0
+APP_TIMER_DEF(m_timer_twi1); // Delay timer of scripts on TWI1
+
+static i2c_script_cb_t m_script[I2C_BUS_COUNT]; // Script state of each bus
+static bool m_timers_created = false;           // Set once the delay timers have been created
+
+/**
+ * @brief Returns the delay timer of a bus.
+ *
+ * @param bus Bus to query.
+ * @return app_timer identifier.
+ */
+static app_timer_id_t script_timer(i2c_bus_id_t bus) {
+  return (bus == I2C_BUS_TWI0) ? m_timer_twi0 : m_timer_twi1;
+}
+
+/**
+ * @brief Ends the script of a bus and calls the user callback.
+ *
+ * @param bus Bus whose script finished.
+ * @param result Result passed to the callback.
+ */
+static void script_finish(i2c_bus_id_t bus, ret_code_t result) {
+  i2c_script_cb_t *p_cb = &m_script[bus];
+  i2c_bus_callback_t callback;
+  void *p_context;
+
+  CRITICAL_REGION_ENTER();
+  callback = p_cb->callback;
+  p_context = p_cb->p_context;
+  p_cb->running = false;
+  CRITICAL_REGION_EXIT();
+
+  if (callback != NULL) {
+    callback(result, p_context);
+  }
+}
+
+/**
+ * @brief Submits the prepared transfers of a bus's script.
+ *
+ * @param bus Bus to use.
+ * @param xfer_count Number of prepared transfers.
+ * @param wait What the transaction is for.
+ */
+static void script_submit(i2c_bus_id_t bus, uint8_t xfer_count, script_wait_t wait) {
+  i2c_script_cb_t *p_cb = &m_script[bus];
+  ret_code_t err_code;
+
+  p_cb->wait = wait;
+  p_cb->transaction.xfer_count = xfer_count;
+  err_code = i2c_bus_schedule(bus, &p_cb->transaction);
+  if (err_code != NRF_SUCCESS) {
+    script_finish(bus, err_code);
+  }
+}
+
+/**
+ * @brief Starts the script's delay timer of a bus.
+ *
+ * @param bus Bus to use.
+ * @param delay_ms Delay in milliseconds.
+ */
+static void script_delay(i2c_bus_id_t bus, uint16_t delay_ms) {
+  uint32_t ticks = APP_TIMER_TICKS(delay_ms);
+  ret_code_t err_code;
+
+  m_script[bus].wait = SCRIPT_WAIT_TIMER;
+  m_script[bus].timer_tag++;
+  err_code = app_timer_start(script_timer(bus), MAX(ticks, APP_TIMER_MIN_TIMEOUT_TICKS),
+                             (void *)(uintptr_t)(bus | ((uint32_t)m_script[bus].timer_tag << 8)));
+  if (err_code != NRF_SUCCESS) {
+    script_finish(bus, err_code);
+  }
+}
+
+/**
+ * @brief Prepares a register read for the current RMW or POLL8 operation and submits it.
+ *
+ * @param bus Bus to use.
+ * @param length Register width in bytes.
+ */
+static void script_read(i2c_bus_id_t bus, uint8_t length) {
+  i2c_script_cb_t *p_cb = &m_script[bus];
+
+  p_cb->tx[0][0] = p_cb->p_op->reg;
+  p_cb->xfers[0].dev_addr = p_cb->dev_addr;
+  p_cb->xfers[0].p_tx = p_cb->tx[0];
+  p_cb->xfers[0].tx_len = 1;
+  p_cb->xfers[0].p_rx = p_cb->rx;
+  p_cb->xfers[0].rx_len = length;
+  script_submit(bus, 1, SCRIPT_WAIT_READ);
+}
+
+/**
+ * @brief Collects consecutive writes (including the write-back of a completed RMW) into
+ *        one batch, advancing the operation pointer past them.
+ *
+ * @param bus Bus to use.
+ * @return Number of prepared transfers.
+ */
+static uint8_t script_batch_writes(i2c_bus_id_t bus) {
+  i2c_script_cb_t *p_cb = &m_script[bus];
+  uint8_t count = 0;
+
+  while (count < I2C_SCRIPT_MAX_BATCH) {
+    i2c_script_op_t const *p_op = p_cb->p_op;
+    uint8_t *p_tx = p_cb->tx[count];
+    uint16_t value;
+    uint8_t width;
+
+    if ((p_op->op == I2C_SCRIPT_OP_WRITE8) || (p_op->op == I2C_SCRIPT_OP_WRITE16)) {
+      value = p_op->value;
+      width = (p_op->op == I2C_SCRIPT_OP_WRITE8) ? 1 : 2;
+    } else if (((p_op->op == I2C_SCRIPT_OP_RMW8) || (p_op->op == I2C_SCRIPT_OP_RMW16)) && p_cb->rmw_ready) {
+      width = (p_op->op == I2C_SCRIPT_OP_RMW8) ? 1 : 2;
+      value = (width == 1) ? p_cb->rx[0] : ((p_cb->rx[1] << 8) | p_cb->rx[0]);
+      value = (value & ~p_op->mask) | (p_op->value & p_op->mask);
+      p_cb->rmw_ready = false;
+    } else {
+      break; // Needs a read, a timer or ends the script
+    }
+
+    p_tx[0] = p_op->reg;
+    p_tx[1] = value & 0xFF; // LSB
+    p_tx[2] = value >> 8;   // MSB, only sent for 16-bit registers
+    p_cb->xfers[count].dev_addr = p_cb->dev_addr;
+    p_cb->xfers[count].p_tx = p_tx;
+    p_cb->xfers[count].tx_len = 1 + width;
+    p_cb->xfers[count].p_rx = NULL;
+    p_cb->xfers[count].rx_len = 0;
+    count++;
+    p_cb->p_op++;
+  }
+  return count;
+}
+
+/**
+ * @brief Executes the script of a bus up to the next operation that has to wait.
+ *
+ * @param bus Bus to use.
+ */
+static void script_step(i2c_bus_id_t bus) {
+  i2c_script_cb_t *p_cb = &m_script[bus];
+  uint8_t count = script_batch_writes(bus);
+
+  if (count > 0) {
+    script_submit(bus, count, SCRIPT_WAIT_WRITE);
+    return;
+  }
+
+  switch (p_cb->p_op->op) {
+  case I2C_SCRIPT_OP_RMW8:
+    script_read(bus, 1);
+    break;
+
+  case I2C_SCRIPT_OP_RMW16:
+    script_read(bus, 2);
+    break;
+
+  case I2C_SCRIPT_OP_POLL8:
+    if (!p_cb->polling) {
+      p_cb->polling = true;
+      p_cb->retries_left = p_cb->p_op->retries;
+    }
+    script_read(bus, 1);
+    break;
+
+  case I2C_SCRIPT_OP_DELAY:
+    if (p_cb->p_op->value == 0) {
+      p_cb->p_op++;
+      script_step(bus);
+    } else {
+      script_delay(bus, p_cb->p_op->value);
+    }
+    break;
+
+  case I2C_SCRIPT_OP_END:
+    script_finish(bus, NRF_SUCCESS);
+    break;
+
+  default:
+    script_finish(bus, NRF_ERROR_INVALID_PARAM);
+    break;
+  }
+}
+
+/**
+ * @brief Completion callback of the script transactions.
+ *
+ * @param result Result of the transaction.
+ * @param p_context Bus identifier.
+ */
+static void script_bus_done(ret_code_t result, void *p_context) {
+  i2c_bus_id_t bus = (i2c_bus_id_t)(uintptr_t)p_context;
+  i2c_script_cb_t *p_cb = &m_script[bus];
+  i2c_script_op_t const *p_op = p_cb->p_op;
+
+  if (result != NRF_SUCCESS) {
+    script_finish(bus, result);
+    return;
+  }
+
+  if (p_cb->wait == SCRIPT_WAIT_READ) {
+    if (p_op->op == I2C_SCRIPT_OP_POLL8) {
+      if ((p_cb->rx[0] & p_op->mask) == (p_op->value & p_op->mask)) {
+        p_cb->polling = false;
+        p_cb->p_op++;
+      } else if (p_cb->retries_left > 0) {
+        p_cb->retries_left--;
+        script_delay(bus, I2C_SCRIPT_POLL_INTERVAL_MS);
+        return;
+      } else {
+        p_cb->polling = false;
+        script_finish(bus, NRF_ERROR_TIMEOUT);
+        return;
+      }
+    } else {
+      p_cb->rmw_ready = true; // The write-back is sent with the next batch
+    }
+  }
+  script_step(bus);
+}
+
+/**
+ * @brief app_timer handler ending a delay or a poll interval.
+ *
+ * A timeout that was already queued when i2c_script_perform stopped the timer may still
+ * arrive, after its script was abandoned or while another script waits on the bus. Such a
+ * timeout carries the tag of an earlier start and is ignored.
+ *
+ * @param p_context Bus identifier in bits 0-7, timer tag in bits 8-15.
+ */
+static void script_timer_handler(void *p_context) {
+  i2c_bus_id_t bus = (i2c_bus_id_t)((uintptr_t)p_context & 0xFF);
+  uint8_t tag = (uint8_t)((uintptr_t)p_context >> 8);
+  i2c_script_cb_t *p_cb = &m_script[bus];
+
+  if (!p_cb->running || (p_cb->wait != SCRIPT_WAIT_TIMER) || (tag != p_cb->timer_tag)) {
+    return; // Stale timeout of a stopped timer
+  }
+  if (p_cb->p_op->op == I2C_SCRIPT_OP_DELAY) {
+    p_cb->p_op++;
+  }
+  script_step(bus); // A POLL8 operation reads the register again
+}
+
+/**
+ * @brief Completion callback used by i2c_script_perform.
+ *
+ * @param result Result of the script.
+ * @param p_context Pointer to the i2c_script_wait_t of the waiting caller.
+ */
+static void script_wait_callback(ret_code_t result, void *p_context) {
+  i2c_script_wait_t *p_wait = (i2c_script_wait_t *)p_context;
+  p_wait->result = result;
+  p_wait->done = true;
+}
+
+/**
+ * @brief Starts a script in the background.
+ *
+ * @param bus Bus the device is connected to.
+ * @param dev_addr I2C slave device address.
+ * @param p_script Script to execute, must stay valid until the callback was called.
+ * @param callback Called once the script finished or an operation failed, may be NULL.
+ * @param p_context Passed to the callback.
+ * @return NRF_SUCCESS, NRF_ERROR_BUSY if a script is already running on the bus, or an error
+ *         code from the bus layer.
+ */
+ret_code_t i2c_script_run(i2c_bus_id_t bus, uint8_t dev_addr, i2c_script_op_t const *p_script, i2c_bus_callback_t callback, void *p_context) {
+  i2c_script_cb_t *p_cb = &m_script[bus];
+  ret_code_t err_code;
+  bool busy;
+
+  if (!m_timers_created) {
+    err_code = app_timer_create(&m_timer_twi0, APP_TIMER_MODE_SINGLE_SHOT, script_timer_handler);
+    if (err_code != NRF_SUCCESS) {
+      return err_code;
+    }
+    err_code = app_timer_create(&m_timer_twi1, APP_TIMER_MODE_SINGLE_SHOT, script_timer_handler);
+    if (err_code != NRF_SUCCESS) {
+      return err_code;
+    }
+    m_timers_created = true;
+  }
+
+  CRITICAL_REGION_ENTER();
+  busy = p_cb->running;
+  p_cb->running = true;
+  CRITICAL_REGION_EXIT();
+  if (busy) {
+    return NRF_ERROR_BUSY;
+  }
+
+  p_cb->p_op = p_script;
+  p_cb->dev_addr = dev_addr;
+  p_cb->callback = callback;
+  p_cb->p_context = p_context;
+  p_cb->rmw_ready = false;
+  p_cb->polling = false;
+  p_cb->transaction.p_xfers = p_cb->xfers;
+  p_cb->transaction.callback = script_bus_done;
+  p_cb->transaction.p_context = (void *)(uintptr_t)bus;
+
+  script_step(bus);
+  return NRF_SUCCESS;
+}
+
+/**
+ * @brief Executes a script and waits for it to finish.
+ *
+ * On timeout the script is aborted: its pending transaction is cancelled on the bus (a device
+ * holding the bus gets the TWI peripheral reset) and its delay timer is stopped, so the next
+ * script can start right away.
+ *
+ * @param bus Bus the device is connected to.
+ * @param dev_addr I2C slave device address.
+ * @param p_script Script to execute.
+ * @param timeout_ms Timeout in milliseconds for the whole script, 0 waits forever.
+ * @return Result of the script, or NRF_ERROR_TIMEOUT.
+ */
+ret_code_t i2c_script_perform(i2c_bus_id_t bus, uint8_t dev_addr, i2c_script_op_t const *p_script, uint16_t timeout_ms) {
+  i2c_script_wait_t wait = {.done = false, .result = NRF_SUCCESS};
+  ret_code_t err_code;
+
+  err_code = i2c_script_run(bus, dev_addr, p_script, script_wait_callback, &wait);
+  if (err_code != NRF_SUCCESS) {
+    return err_code;
+  }
+
+  uint32_t start = i2c_bus_time_us();
+  while (!wait.done) { // Sleep while the interrupts run the script to completion
+    if ((timeout_ms != 0) && ((i2c_bus_time_us() - start) >= (uint32_t)timeout_ms * 1000)) {
+      CRITICAL_REGION_ENTER();
+      if (!wait.done) {
+        m_script[bus].callback = NULL;                   // wait lives on this stack frame
+        app_timer_stop(script_timer(bus));               // Waiting for a delay or poll interval
+        i2c_bus_cancel(bus, &m_script[bus].transaction); // Waiting for the bus, possibly held by the device
+        m_script[bus].running = false;
+      }
+      CRITICAL_REGION_EXIT();
+      if (!wait.done) {
+        return NRF_ERROR_TIMEOUT;
+      }
+    }
+    i2c_bus_wait_for_event(start, timeout_ms);
+  }
+  return wait.result;
+}
+
+/**
+ * @brief Checks whether a script is running on a bus.
+ *
+ * @param bus Bus to check.
+ * @return true if a script is running.
+ */
+bool i2c_script_is_running(i2c_bus_id_t bus) {
+  return m_script[bus].running;
+}
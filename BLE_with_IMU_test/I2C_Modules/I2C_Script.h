@@ -0,0 +1,94 @@
+#ifndef _I2C_SCRIPT_H_
+#define _I2C_SCRIPT_H_
+
+#include "I2C_Bus.h"
+#include "app_timer.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @file I2C_Script.h
+ * @brief Register scripts executed as chained I2C bus transactions.
+ *
+ * A script is a constant array of operations (write, read-modify-write, delay, poll)
+ * terminated by I2C_SCRIPT_END(). It is submitted once and then executed from the TWI and
+ * app_timer interrupts: consecutive writes are combined into a single bus transaction,
+ * the reads needed by read-modify-write and poll operations are chained from the
+ * completion callbacks and delays use app_timer, so the CPU is free while a device is
+ * being configured.
+ *
+ * One script can run per bus at a time. app_timer must be initialized before a script
+ * containing delays or polls is started.
+ */
+
+/**
+ * @brief Script operations.
+ */
+typedef enum {
+  I2C_SCRIPT_OP_END = 0, /**< End of the script */
+  I2C_SCRIPT_OP_WRITE8,  /**< Write an 8-bit register */
+  I2C_SCRIPT_OP_WRITE16, /**< Write a 16-bit register, LSB first */
+  I2C_SCRIPT_OP_RMW8,    /**< Read an 8-bit register, replace the masked bits and write it back */
+  I2C_SCRIPT_OP_RMW16,   /**< Read a 16-bit register (LSB first), replace the masked bits and write it back */
+  I2C_SCRIPT_OP_DELAY,   /**< Wait for a number of milliseconds */
+  I2C_SCRIPT_OP_POLL8    /**< Read an 8-bit register until the masked bits match */
+} i2c_script_op_type_t;
+
+/**
+ * @brief A single script operation. Use the I2C_SCRIPT_* macros below to build scripts.
+ */
+typedef struct {
+  uint8_t op;      /**< Operation, see i2c_script_op_type_t */
+  uint8_t reg;     /**< Register address */
+  uint8_t retries; /**< POLL8: additional reads before the script fails with NRF_ERROR_TIMEOUT */
+  uint16_t mask;   /**< RMW/POLL8: bits to replace or compare */
+  uint16_t value;  /**< WRITE: data, RMW/POLL8: new or expected bits, DELAY: milliseconds */
+} i2c_script_op_t;
+
+#define I2C_SCRIPT_WRITE8(reg, val) {I2C_SCRIPT_OP_WRITE8, (reg), 0, 0, (val)}                           ///< reg = val
+#define I2C_SCRIPT_WRITE16(reg, val) {I2C_SCRIPT_OP_WRITE16, (reg), 0, 0, (val)}                         ///< reg = val (16-bit, LSB first)
+#define I2C_SCRIPT_RMW8(reg, mask, val) {I2C_SCRIPT_OP_RMW8, (reg), 0, (mask), (val)}                    ///< reg = (reg & ~mask) | (val & mask)
+#define I2C_SCRIPT_RMW16(reg, mask, val) {I2C_SCRIPT_OP_RMW16, (reg), 0, (mask), (val)}                  ///< Same as RMW8 for a 16-bit register
+#define I2C_SCRIPT_DELAY_MS(ms) {I2C_SCRIPT_OP_DELAY, 0, 0, 0, (ms)}                                     ///< Wait ms milliseconds
+#define I2C_SCRIPT_POLL8(reg, mask, val, retries) {I2C_SCRIPT_OP_POLL8, (reg), (retries), (mask), (val)} ///< Wait until (reg & mask) == val
+#define I2C_SCRIPT_END() {I2C_SCRIPT_OP_END, 0, 0, 0, 0}                                                 ///< End of the script
+
+#define I2C_SCRIPT_MAX_BATCH 8        ///< Consecutive writes combined into one bus transaction
+#define I2C_SCRIPT_POLL_INTERVAL_MS 1 ///< Time between two reads of a POLL8 operation
+
+/**
+ * @brief Starts a script in the background.
+ *
+ * @param bus Bus the device is connected to.
+ * @param dev_addr I2C slave device address.
+ * @param p_script Script to execute, must stay valid until the callback was called.
+ * @param callback Called once the script finished or an operation failed, may be NULL.
+ * @param p_context Passed to the callback.
+ * @return NRF_SUCCESS, NRF_ERROR_BUSY if a script is already running on the bus, or an error
+ *         code from the bus layer.
+ */
+ret_code_t i2c_script_run(i2c_bus_id_t bus, uint8_t dev_addr, i2c_script_op_t const *p_script, i2c_bus_callback_t callback, void *p_context);
+
+/**
+ * @brief Executes a script and waits for it to finish.
+ *
+ * Must be called from thread mode, the script is driven by the TWI and app_timer interrupts.
+ * On timeout the script's transaction is cancelled (i2c_bus_cancel) and its timer stopped.
+ *
+ * @param bus Bus the device is connected to.
+ * @param dev_addr I2C slave device address.
+ * @param p_script Script to execute.
+ * @param timeout_ms Timeout in milliseconds for the whole script, 0 waits forever.
+ * @return Result of the script, or NRF_ERROR_TIMEOUT.
+ */
+ret_code_t i2c_script_perform(i2c_bus_id_t bus, uint8_t dev_addr, i2c_script_op_t const *p_script, uint16_t timeout_ms);
+
+/**
+ * @brief Checks whether a script is running on a bus.
+ *
+ * @param bus Bus to check.
+ * @return true if a script is running.
+ */
+bool i2c_script_is_running(i2c_bus_id_t bus);
+
+#endif /* _I2C_SCRIPT_H_ */
@@ -3,51 +3,19 @@
 
 #include "I2Cdev.h"
 
-// TWI instance
-static const nrf_drv_twi_t m_twi = NRF_DRV_TWI_INSTANCE(TWI_INSTANCE_ID);
-static volatile bool m_xfer_done = false;
-
 uint16_t readTimeout = I2CDEV_DEFAULT_READ_TIMEOUT;
 
 /** Initialize I2C0
  */
-
-void twi_handler(nrf_drv_twi_evt_t const *p_event, void *p_context) {
-  // Check the event to see what type of event occurred
-  switch (p_event->type) {
-  // If data transmission or receiving is finished
-  case NRF_DRV_TWI_EVT_DONE:
-    m_xfer_done = true; // Set the flag
-    break;
-
-  default:
-    break;
-  }
-}
-
 void TWI_initialize(void) {
-  ret_code_t err_code;
-
-  const nrf_drv_twi_config_t twi_config = {
-      .scl = SCL_PIN,
-      .sda = SDA_PIN,
-      .frequency = NRF_DRV_TWI_FREQ_100K,
-      .interrupt_priority = APP_IRQ_PRIORITY_HIGH,
-      .clear_bus_init = false};
-
-  err_code = nrf_drv_twi_init(&m_twi, &twi_config, twi_handler, NULL);
-  APP_ERROR_CHECK(err_code);
-  enable(true);
+  i2c_bus_init(I2CDEV_BUS, SCL_PIN, SDA_PIN);
 }
 
 /** Enable or disable I2C
  * @param isEnabled true = enable, false = disable
  */
 void enable(bool isEnabled) {
-  if (isEnabled)
-    nrf_drv_twi_enable(&m_twi);
-  else
-    nrf_drv_twi_disable(&m_twi);
+  i2c_bus_enable(I2CDEV_BUS, isEnabled);
 }
 
 /** Read a single bit from an 8-bit device register.
@@ -110,46 +78,9 @@ int8_t readByte(uint8_t devAddr, uint8_t regAddr, uint8_t *data, uint16_t timeou
  * @return I2C_TransferReturn_TypeDef http://downloads.energymicro.com/documentation/doxygen/group__I2C.html
  */
 
-// int8_t readBytes(uint8_t devAddr, uint8_t regAddr, uint8_t length, uint8_t *data, uint16_t timeout) {
-//   ret_code_t r;
-
-//  // bool transfer_succeeded;
-//  nrf_drv_twi_tx(&m_twi, devAddr, &register_address, 1, true);
-//  //    transfer_succeeded  = twi_master_transfer(m_device_address, &register_address, 1, TWI_DONT_ISSUE_STOP);
-//  r = nrf_drv_twi_rx(&m_twi, devAddr, data, length);
-//  // transfer_succeeded &= twi_master_transfer(m_device_address|TWI_READ_BIT, destination, number_of_bytes, TWI_ISSUE_STOP);
-//  return r == NRF_SUCCESS;
-//}
 int8_t readBytes(uint8_t devAddr, uint8_t regAddr, uint8_t length, uint8_t *data, uint16_t timeout) {
-
-  ret_code_t err_code;
-  // Set the flag to false to show the receiving is not yet completed
-  m_xfer_done = false;
-  // Send the Register address where we want to write the data
-  uint8_t register_address = regAddr;
-  err_code = nrf_drv_twi_tx(&m_twi, devAddr, &register_address, 1, true);
-
-  // TODO Implement Timeout
-  // Wait for the transmission to get completed
-  while (m_xfer_done == false) {
-  }
-  // If transmission was not successful, exit the function with false as return value
-  if (NRF_SUCCESS != err_code) {
-    return false;
-  }
-
-  // set the flag again so that we can read data from the MPU6050's internal register
-  m_xfer_done = false;
-  // Receive the data from the MPU6050
-  err_code = nrf_drv_twi_rx(&m_twi, devAddr, data, length);
-  // wait until the transmission is completed
-  while (m_xfer_done == false) {
-  }
-  // if data was successfully read, return true else return false
-  if (NRF_SUCCESS != err_code) {
-    return false;
-  }
-  return true;
+  // Register address, repeated start and read, executed on the I2Cdev bus
+  return i2c_bus_read(I2CDEV_BUS, devAddr, regAddr, data, length, timeout) == NRF_SUCCESS;
 }
 
 /** write a single bit in an 8-bit device register.
@@ -202,32 +133,8 @@ bool writeBits(uint8_t devAddr, uint8_t regAddr, uint8_t bitStart, uint8_t lengt
  * @param data New byte value to write
  * @return Status of operation (true = success)
  */
-// bool writeByte(uint8_t devAddr, uint8_t regAddr, uint8_t data) {
-//   uint8_t w2_data[2];
-
-//  w2_data[0] = regAddr;
-//  w2_data[1] = data;
-//  return NRF_SUCCESS == nrf_drv_twi_tx(&m_twi, devAddr, w2_data, 2, false);
-//}
-
 bool writeByte(uint8_t devAddr, uint8_t regAddr, uint8_t data) {
-  ret_code_t err_code;
-  uint8_t w2_data[2];
-  // Write the register address and data into transmit buffer
-  w2_data[0] = regAddr;
-  w2_data[1] = data;
-  // Set the flag to false to show the transmission is not yet completed
-  m_xfer_done = false;
-  // Transmit the data over TWI Bus
-  err_code = nrf_drv_twi_tx(&m_twi, devAddr, w2_data, 2, false);
-  // Wait until the transmission of the data is finished
-  while (m_xfer_done == false) {
-  }
-  // if there is no error then return true else return false
-  if (NRF_SUCCESS != err_code) {
-    return false;
-  }
-  return true;
+  return writeBytes(devAddr, regAddr, 1, &data);
 }
 
 /** Write multiple bytes to an 8-bit device register.
@@ -239,13 +146,8 @@ bool writeByte(uint8_t devAddr, uint8_t regAddr, uint8_t data) {
  */
 
 bool writeBytes(uint8_t devAddr, uint8_t regAddr, uint8_t length, uint8_t *data) {
-  const uint8_t buf_len = length + 1; // Register address + number of bytes
-  uint8_t tx_buf[buf_len];
-
-  tx_buf[0] = regAddr;
-  memcpy(tx_buf + 1, data, length);
-
-  return NRF_SUCCESS == nrf_drv_twi_tx(&m_twi, devAddr, tx_buf, buf_len, true);
+  // Register address and data are sent in one transfer; returns once the STOP has been sent
+  return i2c_bus_write(I2CDEV_BUS, devAddr, regAddr, data, length, readTimeout) == NRF_SUCCESS;
 }
 
 /** Write single word to a 16-bit device register.
@@ -266,16 +168,14 @@ bool writeWord(uint8_t devAddr, uint8_t regAddr, uint16_t data) {
  * @return Status of operation (true = success)
  */
 bool writeWords(uint8_t devAddr, uint8_t regAddr, uint8_t length, uint16_t *data) {
-  if (NRF_SUCCESS != nrf_drv_twi_tx(&m_twi, devAddr, &regAddr, 1, true))
+  uint8_t buf[I2C_BUS_MAX_WRITE_LEN];
+
+  if (length > I2C_BUS_MAX_WRITE_LEN / 2)
     return false;
 
   for (int i = 0; i < length; i++) {
-    uint8_t d[2];
-    d[0] = data[i] >> 8;
-    d[1] = data[i] & 0xff;
-    bool pending = i < length - 1;
-    if (NRF_SUCCESS != nrf_drv_twi_tx(&m_twi, devAddr, d, 2, pending))
-      return false;
+    buf[2 * i] = data[i] >> 8;       // MSB first
+    buf[2 * i + 1] = data[i] & 0xff; //
   }
-  return true;
+  return writeBytes(devAddr, regAddr, length * 2, buf);
 }
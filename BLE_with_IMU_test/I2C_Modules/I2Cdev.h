@@ -1,6 +1,7 @@
 
 #ifndef _I2CDEV_H_
 #define _I2CDEV_H_
+#include "I2C_Bus.h"
 #include "compiler_abstraction.h"
 #include "nrf.h"
 #include "nrf_delay.h"
@@ -16,6 +17,7 @@
 #endif
 
 #define TWI_INSTANCE_ID 0
+#define I2CDEV_BUS ((i2c_bus_id_t)TWI_INSTANCE_ID) // Bus used by the I2Cdev helpers
 
 #define I2C_SDA_PORT gpioPortA
 #define I2C_SDA_PIN 0
@@ -49,7 +51,6 @@ bool writeByte(uint8_t devAddr, uint8_t regAddr, uint8_t data);
 bool writeWord(uint8_t devAddr, uint8_t regAddr, uint16_t data);
 bool writeBytes(uint8_t devAddr, uint8_t regAddr, uint8_t length, uint8_t *data);
 bool writeWords(uint8_t devAddr, uint8_t regAddr, uint8_t length, uint16_t *data);
-void twi_handler(nrf_drv_twi_evt_t const *p_event, void *p_context);
 extern uint16_t readTimeout;
 
 #endif /* _I2CDEV_H_ */
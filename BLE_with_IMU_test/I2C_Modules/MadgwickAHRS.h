@@ -6,7 +6,8 @@
 
 #define betaDef 0.1f // 2 * proportional gain
 
-extern float beta; // Algorithm gain
+extern float beta;          // Algorithm gain
+extern float invSampleFreq; // Time between updates in seconds, 1 / sample frequency
 
 // Declare global variables
 extern float q0, q1, q2, q3;   // Quaternion of sensor frame relative to auxiliary frame
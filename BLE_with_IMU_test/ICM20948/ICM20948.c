@@ -16,24 +16,26 @@ bool testConnection(void) {
   }
 }
 
+/**
+ * @brief Register script configuring the ICM-20948, executed by initializeIMU().
+ */
+static const i2c_script_op_t m_init_script[] = {
+    I2C_SCRIPT_WRITE8(0x06, 0x01), // Write to register 0x06
+    I2C_SCRIPT_WRITE8(0x14, 0x10), // Write to register 0x14
+    I2C_SCRIPT_WRITE8(0x15, 0x10), // Write to register 0x15
+    I2C_SCRIPT_END()};
+
 /**
  * @brief Initializes the ICM-20948 IMU.
  *
  * This function configures the ICM-20948 IMU by writing to specific configuration registers.
+ * The writes are submitted as one register script, so they go out back to back in a single
+ * bus transaction.
  *
  * @return True if initialization was successful, false otherwise.
  */
 bool initializeIMU(void) {
-  if (!writeByte(ICM20948_ADDRESS, 0x06, 0x01)) { // Write to register 0x06
-    return false;                                 // Return false if the write operation failed
-  }
-  if (!writeByte(ICM20948_ADDRESS, 0x14, 0x10)) { // Write to register 0x14
-    return false;                                 // Return false if the write operation failed
-  }
-  if (!writeByte(ICM20948_ADDRESS, 0x15, 0x10)) { // Write to register 0x15
-    return false;                                 // Return false if the write operation failed
-  }                                               //
-  return true;                                    // Return true if all write operations were successful
+  return i2c_script_perform(I2CDEV_BUS, ICM20948_ADDRESS, m_init_script, readTimeout) == NRF_SUCCESS; // Return true if all write operations were successful
 }
 
 /**
@@ -45,9 +47,23 @@ bool initializeIMU(void) {
  * @param gyroData Pointer to an array where gyroscope data will be stored.
  */
 void readAccelGyroData(int16_t *accelData, int16_t *gyroData) {
-  uint8_t rawData[12];                                          // Array to store raw data read from the sensor (6 bytes for accelerometer, 6 bytes for gyroscope)
-  readBytes(ICM20948_ADDRESS, ACCEL_XOUT_H, 12, rawData, 1000); // Read 12 bytes of data starting from ACCEL_XOUT_H register
+  uint8_t rawData[ACCEL_GYRO_DATA_LEN];                                          // Array to store raw data read from the sensor (6 bytes for accelerometer, 6 bytes for gyroscope)
+  readBytes(ICM20948_ADDRESS, ACCEL_XOUT_H, ACCEL_GYRO_DATA_LEN, rawData, 1000); // Read 12 bytes of data starting from ACCEL_XOUT_H register
+  decodeAccelGyroData(rawData, accelData, gyroData);                             // Convert the big-endian register dump into signed samples
+}
 
+/**
+ * @brief Decodes a raw accelerometer and gyroscope register dump.
+ *
+ * The ICM-20948 stores each axis as a big-endian 16-bit value starting at ACCEL_XOUT_H.
+ * This function converts such a 12 byte dump (as read by readAccelGyroData or the
+ * autonomous sampler) into signed accelerometer and gyroscope samples.
+ *
+ * @param rawData Pointer to ACCEL_GYRO_DATA_LEN bytes read from ACCEL_XOUT_H onwards.
+ * @param accelData Pointer to an array where accelerometer data will be stored.
+ * @param gyroData Pointer to an array where gyroscope data will be stored.
+ */
+void decodeAccelGyroData(uint8_t const *rawData, int16_t *accelData, int16_t *gyroData) {
   // Extract accelerometer data from rawData array
   accelData[0] = (int16_t)(((int16_t)rawData[0] << 8) | rawData[1]); // X-axis accelerometer data
   accelData[1] = (int16_t)(((int16_t)rawData[2] << 8) | rawData[3]); // Y-axis accelerometer data
@@ -1,10 +1,11 @@
 #ifndef _ICM20948_H_
 #define _ICM20948_H_
 
-#include "I2Cdev.h"  // Include the I2Cdev library for I2C communication
-#include "stdbool.h" // Include standard boolean type definitions
-#include <stdint.h>  // Include standard integer type definitions
-#include <string.h>  // Include string manipulation functions
+#include "I2C_Script.h" // Include register scripts for multi-register configuration
+#include "I2Cdev.h"     // Include the I2Cdev library for I2C communication
+#include "stdbool.h"    // Include standard boolean type definitions
+#include <stdint.h>     // Include standard integer type definitions
+#include <string.h>     // Include string manipulation functions
 
 // External declarations of accelerometer and gyroscope data arrays
 extern int16_t accelData[3], gyroData[3];
@@ -17,10 +18,12 @@ extern int16_t accelData[3], gyroData[3];
 #define WHO_AM_I_EXPECTED 0xEA // Expected value of the WHO_AM_I register
 #define ACCEL_XOUT_H 0x2D      // Accelerometer X-axis high byte register address
 #define GYRO_XOUT_H 0x33       // Gyroscope X-axis high byte register address
+#define ACCEL_GYRO_DATA_LEN 12 // Number of bytes from ACCEL_XOUT_H to GYRO_ZOUT_L
 
 // Function prototypes
-bool testConnection(void);                                     // Function to test the connection to the ICM-20948
-bool initializeIMU(void);                                      // Function to initialize the ICM-20948 IMU
-void readAccelGyroData(int16_t *accelData, int16_t *gyroData); // Function to read accelerometer and gyroscope data
+bool testConnection(void);                                                               // Function to test the connection to the ICM-20948
+bool initializeIMU(void);                                                                // Function to initialize the ICM-20948 IMU
+void readAccelGyroData(int16_t *accelData, int16_t *gyroData);                           // Function to read accelerometer and gyroscope data
+void decodeAccelGyroData(uint8_t const *rawData, int16_t *accelData, int16_t *gyroData); // Function to decode a raw accelerometer and gyroscope register dump
 
 #endif
@@ -0,0 +1,232 @@
+#include "ICM20948_Sampler.h"
+
+static const nrf_drv_timer_t m_trigger_timer = NRF_DRV_TIMER_INSTANCE(IMU_SAMPLER_TRIGGER_TIMER_ID); // Generates the sample clock
+static const nrf_drv_timer_t m_counter_timer = NRF_DRV_TIMER_INSTANCE(IMU_SAMPLER_COUNTER_TIMER_ID); // Counts completed TWIM transfers
+
+static nrf_ppi_channel_t m_ppi_trigger; // TIMER compare -> TWIM STARTTX, fork: counter TIMER CAPTURE2
+static nrf_ppi_channel_t m_ppi_count;   // TWIM STOPPED -> counter TIMER COUNT
+
+static uint8_t m_reg_addr = ACCEL_XOUT_H;                                          // Register address sent before every read (must live in RAM for EasyDMA)
+static uint8_t m_buffers[2][IMU_SAMPLER_BUFFER_SAMPLES * IMU_SAMPLER_SAMPLE_SIZE]; // Ping-pong sample buffers
+static uint8_t m_active_buffer;                                                    // Index of the buffer currently being filled by EasyDMA
+
+static imu_sampler_handler_t m_handler; // Application handler for full buffers
+static bool m_initialized = false;      // Set once the TIMER/PPI resources have been set up
+static volatile bool m_running = false; // Set while the sampler owns TWI0
+
+/**
+ * @brief Prepares TWIM to fill a buffer on every STARTTX task.
+ *
+ * The transfer is held (not started) and repeated: every PPI triggered STARTTX writes the
+ * register address and reads one sample, the RX ArrayList post-increment moving the EasyDMA
+ * pointer to the next sample slot.
+ *
+ * @param p_buffer Buffer receiving IMU_SAMPLER_BUFFER_SAMPLES samples.
+ * @return NRF_SUCCESS, or an error code from the TWI driver.
+ */
+static ret_code_t sampler_arm(uint8_t *p_buffer) {
+  nrf_drv_twi_xfer_desc_t xfer = NRF_DRV_TWI_XFER_DESC_TXRX(ICM20948_ADDRESS, &m_reg_addr, 1, p_buffer, IMU_SAMPLER_SAMPLE_SIZE);
+  uint32_t flags = NRF_DRV_TWI_FLAG_HOLD_XFER |          // Wait for STARTTX from PPI
+                   NRF_DRV_TWI_FLAG_RX_POSTINC |         // Advance RX pointer after each sample
+                   NRF_DRV_TWI_FLAG_REPEATED_XFER |      // Transfer is restarted by hardware
+                   NRF_DRV_TWI_FLAG_NO_XFER_EVT_HANDLER; // No interrupt per transfer
+  return nrf_drv_twi_xfer(i2c_bus_twi_get(I2CDEV_BUS), &xfer, flags);
+}
+
+/**
+ * @brief Checks whether a triggered transfer has not reached its STOPPED event yet.
+ *
+ * Every STARTTX captures the transfer count into CC2 of the counter TIMER and every STOPPED
+ * increments it, so a transfer is in flight while the count still equals that capture.
+ *
+ * @return true if a transfer is in flight.
+ */
+static bool sampler_transfer_active(void) {
+  return nrf_drv_timer_capture(&m_counter_timer, NRF_TIMER_CC_CHANNEL1) == nrf_drv_timer_capture_get(&m_counter_timer, NRF_TIMER_CC_CHANNEL2);
+}
+
+/**
+ * @brief Trigger TIMER handler.
+ *
+ * The trigger TIMER never interrupts (its compare event is consumed by PPI), but the
+ * TIMER driver requires a handler.
+ *
+ * @param event_type TIMER event that caused the interrupt.
+ * @param p_context Unused.
+ */
+static void sampler_trigger_handler(nrf_timer_event_t event_type, void *p_context) {
+}
+
+/**
+ * @brief Counter TIMER handler, called once per full buffer.
+ *
+ * Switches EasyDMA to the other buffer and passes the full one to the application.
+ *
+ * @param event_type TIMER event that caused the interrupt.
+ * @param p_context Unused.
+ */
+static void sampler_counter_handler(nrf_timer_event_t event_type, void *p_context) {
+  if (event_type != NRF_TIMER_EVENT_COMPARE0) {
+    return;
+  }
+  uint8_t full_buffer = m_active_buffer; // Buffer that has just been completed
+  m_active_buffer ^= 1;                  // Continue sampling into the other buffer
+  APP_ERROR_CHECK(sampler_arm(m_buffers[m_active_buffer]));
+  if (m_handler != NULL) {
+    m_handler(m_buffers[full_buffer], IMU_SAMPLER_BUFFER_SAMPLES);
+  }
+}
+
+/**
+ * @brief Initializes the TIMER and PPI resources used by the sampler.
+ *
+ * The trigger TIMER runs at 1 MHz and clears itself on compare, the counter TIMER counts
+ * TWIM STOPPED events and interrupts after IMU_SAMPLER_BUFFER_SAMPLES of them. Every trigger
+ * also captures the count into CC2, which lets imu_sampler_stop() detect a transfer in flight.
+ *
+ * @param period_us Sample period in microseconds (at least IMU_SAMPLER_MIN_PERIOD_US).
+ * @param handler Handler called for every full buffer.
+ * @return NRF_SUCCESS, or an error code from the TIMER/PPI drivers.
+ */
+ret_code_t imu_sampler_init(uint32_t period_us, imu_sampler_handler_t handler) {
+  ret_code_t err_code;
+  nrf_drv_twi_t const *p_twi = i2c_bus_twi_get(I2CDEV_BUS);
+
+  if (m_initialized) {
+    return NRF_ERROR_INVALID_STATE;
+  }
+  if (period_us < IMU_SAMPLER_MIN_PERIOD_US) {
+    return NRF_ERROR_INVALID_PARAM;
+  }
+  m_handler = handler;
+
+  nrf_drv_timer_config_t timer_config = NRF_DRV_TIMER_DEFAULT_CONFIG;
+  timer_config.frequency = NRF_TIMER_FREQ_1MHz;
+  timer_config.bit_width = NRF_TIMER_BIT_WIDTH_32;
+  err_code = nrf_drv_timer_init(&m_trigger_timer, &timer_config, sampler_trigger_handler); // Sample clock, compare interrupt stays disabled
+  if (err_code != NRF_SUCCESS) {
+    return err_code;
+  }
+  nrf_drv_timer_extended_compare(&m_trigger_timer, NRF_TIMER_CC_CHANNEL0,
+      nrf_drv_timer_us_to_ticks(&m_trigger_timer, period_us),
+      NRF_TIMER_SHORT_COMPARE0_CLEAR_MASK, false);
+
+  timer_config.mode = NRF_TIMER_MODE_COUNTER;
+  err_code = nrf_drv_timer_init(&m_counter_timer, &timer_config, sampler_counter_handler); // Transfer counter
+  if (err_code != NRF_SUCCESS) {
+    return err_code;
+  }
+  nrf_drv_timer_extended_compare(&m_counter_timer, NRF_TIMER_CC_CHANNEL0, IMU_SAMPLER_BUFFER_SAMPLES,
+      NRF_TIMER_SHORT_COMPARE0_CLEAR_MASK, true);
+
+  err_code = nrf_drv_ppi_init();
+  if ((err_code != NRF_SUCCESS) && (err_code != NRF_ERROR_MODULE_ALREADY_INITIALIZED)) {
+    return err_code;
+  }
+  err_code = nrf_drv_ppi_channel_alloc(&m_ppi_trigger);
+  if (err_code != NRF_SUCCESS) {
+    return err_code;
+  }
+  err_code = nrf_drv_ppi_channel_assign(m_ppi_trigger,
+      nrf_drv_timer_compare_event_address_get(&m_trigger_timer, NRF_TIMER_CC_CHANNEL0),
+      nrf_drv_twi_start_task_get(p_twi, NRF_DRV_TWI_XFER_TXRX));
+  if (err_code != NRF_SUCCESS) {
+    return err_code;
+  }
+  err_code = nrf_drv_ppi_channel_fork_assign(m_ppi_trigger,
+      nrf_drv_timer_capture_task_address_get(&m_counter_timer, NRF_TIMER_CC_CHANNEL2));
+  if (err_code != NRF_SUCCESS) {
+    return err_code;
+  }
+  err_code = nrf_drv_ppi_channel_alloc(&m_ppi_count);
+  if (err_code != NRF_SUCCESS) {
+    return err_code;
+  }
+  err_code = nrf_drv_ppi_channel_assign(m_ppi_count,
+      nrf_drv_twi_stopped_event_get(p_twi),
+      nrf_drv_timer_task_address_get(&m_counter_timer, NRF_TIMER_TASK_COUNT));
+  if (err_code != NRF_SUCCESS) {
+    return err_code;
+  }
+
+  m_initialized = true;
+  return NRF_SUCCESS;
+}
+
+/**
+ * @brief Starts autonomous sampling.
+ *
+ * @return NRF_SUCCESS, NRF_ERROR_INVALID_STATE if the sampler is not initialized or already running,
+ *         or NRF_ERROR_BUSY if TWI0 has pending transactions.
+ */
+ret_code_t imu_sampler_start(void) {
+  ret_code_t err_code;
+
+  if (!m_initialized || m_running) {
+    return NRF_ERROR_INVALID_STATE;
+  }
+  err_code = i2c_bus_acquire(I2CDEV_BUS); // Fails with NRF_ERROR_BUSY while I2Cdev transfers are pending
+  if (err_code != NRF_SUCCESS) {
+    return err_code;
+  }
+  m_active_buffer = 0;
+  err_code = sampler_arm(m_buffers[m_active_buffer]);
+  if (err_code != NRF_SUCCESS) {
+    i2c_bus_release(I2CDEV_BUS);
+    return err_code;
+  }
+  m_running = true;
+
+  nrf_drv_timer_clear(&m_counter_timer);
+  nrf_drv_timer_compare(&m_counter_timer, NRF_TIMER_CC_CHANNEL2, UINT32_MAX, false); // No transfer triggered yet
+  nrf_drv_timer_enable(&m_counter_timer);
+  APP_ERROR_CHECK(nrf_drv_ppi_channel_enable(m_ppi_count));
+  APP_ERROR_CHECK(nrf_drv_ppi_channel_enable(m_ppi_trigger));
+  nrf_drv_timer_clear(&m_trigger_timer);
+  nrf_drv_timer_enable(&m_trigger_timer); // From here on sampling runs without the CPU
+  return NRF_SUCCESS;
+}
+
+/**
+ * @brief Stops autonomous sampling and hands TWI0 back to the bus layer.
+ *
+ * Waits for the STOPPED event of a transfer in flight. A transfer still running after
+ * IMU_SAMPLER_STOP_TIMEOUT_US (a device holding the bus) is aborted by resetting TWIM.
+ * Samples collected in the current, partially filled buffer are passed to the handler.
+ */
+void imu_sampler_stop(void) {
+  uint32_t waited_us = 0;
+
+  if (!m_running) {
+    return;
+  }
+  APP_ERROR_CHECK(nrf_drv_ppi_channel_disable(m_ppi_trigger)); // No new transfers are triggered
+  nrf_drv_timer_disable(&m_trigger_timer);
+  while (sampler_transfer_active() && (waited_us < IMU_SAMPLER_STOP_TIMEOUT_US)) { // Let a transfer in flight reach STOPPED
+    nrf_delay_us(IMU_SAMPLER_STOP_POLL_US);
+    waited_us += IMU_SAMPLER_STOP_POLL_US;
+  }
+  if (sampler_transfer_active()) {
+    nrf_drv_twi_disable(i2c_bus_twi_get(I2CDEV_BUS)); // Resets TWIM, the partial sample is not counted
+    nrf_drv_twi_enable(i2c_bus_twi_get(I2CDEV_BUS));
+  }
+  APP_ERROR_CHECK(nrf_drv_ppi_channel_disable(m_ppi_count));
+
+  uint16_t pending = nrf_drv_timer_capture(&m_counter_timer, NRF_TIMER_CC_CHANNEL1); // Samples in the partial buffer
+  nrf_drv_timer_disable(&m_counter_timer);
+  m_running = false;
+  i2c_bus_release(I2CDEV_BUS); // Transfers queued meanwhile start now
+
+  if ((pending > 0) && (m_handler != NULL)) {
+    m_handler(m_buffers[m_active_buffer], pending);
+  }
+}
+
+/**
+ * @brief Checks whether the sampler currently owns the bus.
+ *
+ * @return true if sampling is active, otherwise false.
+ */
+bool imu_sampler_is_running(void) {
+  return m_running;
+}
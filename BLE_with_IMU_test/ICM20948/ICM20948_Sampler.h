@@ -0,0 +1,79 @@
+#ifndef _ICM20948_SAMPLER_H_
+#define _ICM20948_SAMPLER_H_
+
+#include "ICM20948.h"
+#include "nrf_drv_ppi.h"
+#include "nrf_drv_timer.h"
+#include "nrf_drv_twi.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @file ICM20948_Sampler.h
+ * @brief Autonomous (CPU-free) sampling of the ICM-20948 accelerometer and gyroscope.
+ *
+ * A TIMER compare event starts a TWIM write/read of ACCEL_XOUT_H..GYRO_ZOUT_L through PPI.
+ * The TWIM RX ArrayList feature advances the EasyDMA pointer after every sample and a second
+ * TIMER in counter mode counts the completed transfers, so the CPU is only interrupted once
+ * per IMU_SAMPLER_BUFFER_SAMPLES samples. Requires TWI0_USE_EASY_DMA, PPI_ENABLED and the
+ * two TIMER instances below to be enabled in sdk_config.h.
+ *
+ * While the sampler is running it holds TWI0 (i2c_bus_acquire): transactions scheduled on that
+ * bus, including the blocking I2Cdev helpers, wait until imu_sampler_stop() releases it.
+ */
+
+#define IMU_SAMPLER_SAMPLE_SIZE ACCEL_GYRO_DATA_LEN ///< Bytes transferred per sample
+#define IMU_SAMPLER_BUFFER_SAMPLES 32               ///< Samples collected before the CPU is interrupted
+#define IMU_SAMPLER_TRIGGER_TIMER_ID 2              ///< TIMER instance generating the sample clock
+#define IMU_SAMPLER_COUNTER_TIMER_ID 3              ///< TIMER instance counting completed transfers
+#define IMU_SAMPLER_STOP_TIMEOUT_US 5000            ///< Longest wait at stop for the transfer in flight (1 + 12 bytes take ~1.5 ms at 100 kHz)
+#define IMU_SAMPLER_STOP_POLL_US 50                 ///< Poll interval while waiting for that transfer
+#define IMU_SAMPLER_MIN_PERIOD_US 2000              ///< Shortest sample period leaving room to re-arm the buffer
+
+/**
+ * @brief Handler called when a sample buffer has been filled.
+ *
+ * Runs in the counter TIMER interrupt context. The buffer stays valid until the sampler
+ * has filled the other buffer, i.e. for IMU_SAMPLER_BUFFER_SAMPLES sample periods.
+ *
+ * @param p_raw Pointer to sample_count * IMU_SAMPLER_SAMPLE_SIZE raw bytes (see decodeAccelGyroData).
+ * @param sample_count Number of samples in the buffer.
+ */
+typedef void (*imu_sampler_handler_t)(uint8_t const *p_raw, uint16_t sample_count);
+
+/**
+ * @brief Initializes the TIMER and PPI resources used by the sampler.
+ *
+ * TWI_initialize() must have been called before.
+ *
+ * @param period_us Sample period in microseconds (at least IMU_SAMPLER_MIN_PERIOD_US).
+ * @param handler Handler called for every full buffer.
+ * @return NRF_SUCCESS, or an error code from the TIMER/PPI drivers.
+ */
+ret_code_t imu_sampler_init(uint32_t period_us, imu_sampler_handler_t handler);
+
+/**
+ * @brief Starts autonomous sampling.
+ *
+ * @return NRF_SUCCESS, NRF_ERROR_INVALID_STATE if the sampler is not initialized or already running,
+ *         or NRF_ERROR_BUSY if TWI0 has pending transactions.
+ */
+ret_code_t imu_sampler_start(void);
+
+/**
+ * @brief Stops autonomous sampling and hands TWI0 back to the bus layer.
+ *
+ * Waits for the STOPPED event of a transfer in flight. A transfer still running after
+ * IMU_SAMPLER_STOP_TIMEOUT_US (a device holding the bus) is aborted by resetting TWIM.
+ * Samples collected in the current, partially filled buffer are passed to the handler.
+ */
+void imu_sampler_stop(void);
+
+/**
+ * @brief Checks whether the sampler currently owns the bus.
+ *
+ * @return true if sampling is active, otherwise false.
+ */
+bool imu_sampler_is_running(void);
+
+#endif // _ICM20948_SAMPLER_H_
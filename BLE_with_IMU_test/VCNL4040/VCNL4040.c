@@ -1,150 +1,418 @@
 #include "VCNL4040.h"
 
-static const nrf_drv_twi_t m_twi = NRF_DRV_TWI_INSTANCE(1); // TWI (I2C) instance
-static volatile bool m_xfer_done = false;                   // Flag to indicate that a TWI transfer has completed
+static uint8_t m_ps_data_reg = VCNL4040_PS_DATA_REG; // Register address of the background read (must live in RAM for EasyDMA)
+static uint8_t m_ps_raw[2];                          // Raw PS_DATA bytes of the background read
+static volatile uint16_t m_proximity = 0xFFFF;       // Result of the last background read
+static i2c_bus_callback_t m_read_callback;           // User callback of the background read
+static volatile bool m_read_pending = false;         // Set while the background read is queued or running
+
+static const i2c_bus_xfer_t m_ps_read_xfer = {
+    .dev_addr = VCNL4040_ADDRESS,
+    .p_tx = &m_ps_data_reg,
+    .tx_len = 1,
+    .p_rx = m_ps_raw,
+    .rx_len = sizeof(m_ps_raw)};
+static i2c_bus_transaction_t m_ps_read_transaction = {
+    .p_xfers = &m_ps_read_xfer,
+    .xfer_count = 1};
+
+static uint8_t m_als_data_reg = VCNL4040_ALS_DATA_REG;    // Register address of the ALS part of the combined read
+static uint8_t m_sample_raw[4];                           // Raw PS_DATA and ALS_DATA bytes of the combined read
+static vcnl4040_sample_t m_sample;                        // Result of the last combined read
+static volatile bool m_sample_valid = false;              // Set if the last combined read succeeded
+static i2c_bus_callback_t m_sample_callback;              // User callback of the combined read
+static volatile bool m_sample_pending = false;            // Set while the combined read is queued or running
+static vcnl4040_als_it_t m_als_it = VCNL4040_ALS_IT_80MS; // ALS integration time set by vcnl4040_als_config
+
+static const i2c_bus_xfer_t m_sample_xfers[] = {
+    {.dev_addr = VCNL4040_ADDRESS, .p_tx = &m_ps_data_reg, .tx_len = 1, .p_rx = &m_sample_raw[0], .rx_len = 2},   // PS_DATA
+    {.dev_addr = VCNL4040_ADDRESS, .p_tx = &m_als_data_reg, .tx_len = 1, .p_rx = &m_sample_raw[2], .rx_len = 2}}; // ALS_DATA
+static i2c_bus_transaction_t m_sample_transaction = {
+    .p_xfers = m_sample_xfers,
+    .xfer_count = 2};
+
+static uint8_t m_int_flag_reg = VCNL4040_INT_FLAG_REG; // Register address of the interrupt flag read (must live in RAM for EasyDMA)
+static uint8_t m_int_raw[4];                           // Raw INT_FLAG and PS_DATA bytes of the interrupt read
+static uint16_t m_away_threshold;                      // PS_THDL programmed by vcnl4040_proximity_int_enable
+static uint16_t m_close_threshold;                     // PS_THDH programmed by vcnl4040_proximity_int_enable
+static vcnl4040_evt_handler_t m_evt_handler;           // Handler of proximity events
+static volatile bool m_close = false;                  // Proximity state tracked from the events
+static volatile bool m_int_pending = false;            // Set while the interrupt read is queued or running
+static volatile bool m_int_again = false;              // INT was asserted again while the read was pending
+static bool m_int_retry_created = false;               // Set once m_int_retry_timer has been created
+
+static const i2c_bus_xfer_t m_int_xfers[] = {
+    {.dev_addr = VCNL4040_ADDRESS, .p_tx = &m_int_flag_reg, .tx_len = 1, .p_rx = &m_int_raw[0], .rx_len = 2}, // INT_FLAG, releases INT
+    {.dev_addr = VCNL4040_ADDRESS, .p_tx = &m_ps_data_reg, .tx_len = 1, .p_rx = &m_int_raw[2], .rx_len = 2}}; // PS_DATA at the time of the event
+static void vcnl4040_int_done(ret_code_t result, void *p_context);
+static const i2c_bus_transaction_t m_int_transaction = {
+    .p_xfers = m_int_xfers,
+    .xfer_count = 2,
+    .callback = vcnl4040_int_done,
+    .p_context = NULL};
+APP_TIMER_DEF(m_int_retry_timer); // Retries an interrupt read the bus queue had no room for
+
+/**
+ * @brief Register script configuring the VCNL4040, executed by vcnl4040_init().
+ */
+static const i2c_script_op_t m_init_script[] = {
+    I2C_SCRIPT_WRITE16(VCNL4040_PS_CONF1_REG, 0x0080), // PS_Duty 1/160, PS_IT 1T, 12-bit, PS_SD cleared (VCNL4040_PS_CONFIG_DEFAULT)
+    I2C_SCRIPT_WRITE16(VCNL4040_PS_CONF3_REG, 0x0000), // Single pulse, 50 mA
+    I2C_SCRIPT_END()};
+
+/**
+ * @brief Reads a 16-bit command register of the VCNL4040 sensor.
+ *
+ * @param regAddr The command code (register address) to read from.
+ * @param p_data Pointer to store the register value.
+ * @return true if the read operation was successful, otherwise false.
+ */
+static bool vcnl4040_read_register(uint8_t regAddr, uint16_t *p_data) {
+  uint8_t data[2];
+  if (i2c_bus_read(VCNL4040_BUS, VCNL4040_ADDRESS, regAddr, data, sizeof(data), VCNL4040_TIMEOUT_MS) != NRF_SUCCESS) {
+    return false;
+  }
+  *p_data = (data[1] << 8) | data[0];
+  return true;
+}
 
 /**
- * @brief TWI handler for the VCNL4040 sensor.
+ * @brief Completion callback of the background proximity read.
  *
- * This function handles TWI (I2C) events for the VCNL4040 sensor.
+ * @param result Result of the bus transaction.
+ * @param p_context User context passed to the user callback.
+ */
+static void vcnl4040_read_done(ret_code_t result, void *p_context) {
+  m_proximity = (result == NRF_SUCCESS) ? ((m_ps_raw[1] << 8) | m_ps_raw[0]) : 0xFFFF;
+  m_read_pending = false;
+  if (m_read_callback != NULL) {
+    m_read_callback(result, p_context);
+  }
+}
+
+/**
+ * @brief Completion callback of the combined read.
  *
- * @param p_event Pointer to the TWI event structure.
- * @param p_context Pointer to the context.
+ * @param result Result of the bus transaction.
+ * @param p_context User context passed to the user callback.
  */
-void VCN4040_twi_handler(nrf_drv_twi_evt_t const *p_event, void *p_context) {
+static void vcnl4040_sample_done(ret_code_t result, void *p_context) {
+  if (result == NRF_SUCCESS) {
+    m_sample.timestamp_us = i2c_bus_time_us();
+    m_sample.proximity = (m_sample_raw[1] << 8) | m_sample_raw[0];
+    m_sample.ambient = (m_sample_raw[3] << 8) | m_sample_raw[2];
+  }
+  m_sample_valid = (result == NRF_SUCCESS);
+  m_sample_pending = false;
+  if (m_sample_callback != NULL) {
+    m_sample_callback(result, p_context);
+  }
+}
 
-  switch (p_event->type) { // Check the event to see what type of event occurred
+/**
+ * @brief Queues the interrupt read, unless it is already pending.
+ */
+static void vcnl4040_int_read(void) {
+  bool start;
 
-  case NRF_DRV_TWI_EVT_DONE: // If data transmission or receiving is finished
-    m_xfer_done = true;      // Set the flag
-    break;
+  CRITICAL_REGION_ENTER();
+  start = !m_int_pending;
+  m_int_pending = true;
+  m_int_again = !start;
+  CRITICAL_REGION_EXIT();
 
-  default:
-    break;
+  if (start && (i2c_bus_schedule(VCNL4040_BUS, &m_int_transaction) != NRF_SUCCESS)) {
+    m_int_pending = false; // Queue full, INT stays asserted without a new edge
+    ret_code_t err_code = app_timer_start(m_int_retry_timer, MAX(APP_TIMER_TICKS(VCNL4040_INT_RETRY_MS), APP_TIMER_MIN_TIMEOUT_TICKS), NULL);
+    APP_ERROR_CHECK(err_code);
   }
 }
 
 /**
- * @brief Initializes the TWI (I2C) interface for the VCNL4040 sensor.
+ * @brief app_timer handler retrying an interrupt read that could not be queued.
  *
- * This function sets up the TWI interface for communication with the VCNL4040 sensor.
+ * @param p_context Unused.
  */
-void VCN4040_TWI_initialize(void) {
-  ret_code_t err_code;
+static void vcnl4040_int_retry_handler(void *p_context) {
+  if (!nrf_drv_gpiote_in_is_set(VCNL4040_INT_PIN)) {
+    vcnl4040_int_read(); // Still asserted, the flags were not read yet
+  }
+}
 
-  // Configuration settings for the TWI interface
-  const nrf_drv_twi_config_t twi_config = {
-      .scl = 4,
-      .sda = 5,
-      .frequency = NRF_DRV_TWI_FREQ_100K,
-      .interrupt_priority = APP_IRQ_PRIORITY_HIGH,
-      .clear_bus_init = false};
+/**
+ * @brief Completion callback of the interrupt read: turns the flags into events.
+ *
+ * If both flags are set the object crossed both thresholds since the last read; the state
+ * is then taken from PS_DATA, read in the same transaction.
+ *
+ * @param result Result of the bus transaction.
+ * @param p_context Unused.
+ */
+static void vcnl4040_int_done(ret_code_t result, void *p_context) {
+  uint16_t flags = (m_int_raw[1] << 8) | m_int_raw[0];
+  uint16_t proximity = (m_int_raw[3] << 8) | m_int_raw[2];
+  bool close = m_close;
 
-  err_code = nrf_drv_twi_init(&m_twi, &twi_config, VCN4040_twi_handler, NULL); // Initialize the TWI interface
-  APP_ERROR_CHECK(err_code);                                                   // Check for the error code for debug
-  VCN4040_enable(true);                                                        // Enable the TWI interface
+  m_int_pending = false;
+  if (result == NRF_SUCCESS) {
+    m_proximity = proximity;
+    if ((flags & VCNL4040_INT_FLAG_PS_CLOSE) && (flags & VCNL4040_INT_FLAG_PS_AWAY)) {
+      close = proximity > (m_away_threshold + m_close_threshold) / 2;
+    } else if (flags & VCNL4040_INT_FLAG_PS_CLOSE) {
+      close = true;
+    } else if (flags & VCNL4040_INT_FLAG_PS_AWAY) {
+      close = false;
+    }
+    if (close != m_close) {
+      m_close = close;
+      if (m_evt_handler != NULL) {
+        m_evt_handler(close ? VCNL4040_EVT_CLOSE : VCNL4040_EVT_AWAY);
+      }
+    }
+  }
+  if (m_int_again || ((result != NRF_SUCCESS) && !nrf_drv_gpiote_in_is_set(VCNL4040_INT_PIN))) {
+    vcnl4040_int_read(); // Flags raised meanwhile, or the read failed and INT is still asserted
+  }
 }
 
 /**
- * @brief Enables or disables the VCNL4040 sensor.
- *
- * This function enables or disables the VCNL4040 sensor based on the isEnabled parameter.
+ * @brief GPIOTE handler of the INT pin.
  *
- * @param isEnabled Boolean value indicating whether to enable (true) or disable (false) the sensor.
+ * @param pin Pin that triggered the event.
+ * @param action Polarity of the event.
  */
-void VCN4040_enable(bool isEnabled) {
-  if (isEnabled)
-    nrf_drv_twi_enable(&m_twi);
-  else
-    nrf_drv_twi_disable(&m_twi);
+static void vcnl4040_int_handler(nrf_drv_gpiote_pin_t pin, nrf_gpiote_polarity_t action) {
+  vcnl4040_int_read();
 }
 
 /**
- * @brief Initializes the VCNL4040 sensor.
+ * @brief Applies a proximity sensor configuration and powers the proximity sensor up.
  *
- * This function initializes the VCNL4040 sensor by setting the PS_CONF1 register.
+ * @param p_config Configuration, e.g. one of the VCNL4040_PS_CONFIG_* presets.
+ * @return NRF_SUCCESS, or an error code from the bus layer.
  */
-void vcnl4040_init(void) {
-  VCN4040_writeByte(VCNL4040_ADDRESS, VCNL4040_PS_CONF1_REG, 0x0080); // Set PS_CONF1 register
+ret_code_t vcnl4040_ps_config(vcnl4040_ps_config_t const *p_config) {
+  uint16_t conf1 = (p_config->duty << VCNL4040_PS_DUTY_Pos) | (p_config->it << VCNL4040_PS_IT_Pos) |
+                   (p_config->high_resolution ? VCNL4040_PS_HD : 0);
+  uint16_t conf3 = (p_config->pulses << VCNL4040_PS_MPS_Pos) | (p_config->led_current << VCNL4040_PS_LED_I_Pos);
+  i2c_script_op_t const script[] = {
+      I2C_SCRIPT_RMW16(VCNL4040_PS_CONF1_REG, VCNL4040_PS_DUTY_Msk | VCNL4040_PS_IT_Msk | VCNL4040_PS_HD | VCNL4040_PS_SD, conf1),
+      I2C_SCRIPT_RMW16(VCNL4040_PS_CONF3_REG, VCNL4040_PS_MPS_Msk | VCNL4040_PS_LED_I_Msk, conf3),
+      I2C_SCRIPT_END()};
+  return i2c_script_perform(VCNL4040_BUS, VCNL4040_ADDRESS, script, VCNL4040_TIMEOUT_MS); // Blocking, the script lives on this stack frame
 }
 
 /**
- * @brief Reads the proximity value from the VCNL4040 sensor.
+ * @brief Configures and powers up the ambient light sensor.
  *
- * This function reads the proximity data from the VCNL4040 sensor and returns it.
+ * Only ALS_IT and ALS_SD are changed; the ALS interrupt configuration is kept.
  *
- * @return The proximity value or -1 if read failed.
+ * @param integration_time ALS integration time.
+ * @return NRF_SUCCESS, or an error code from the bus layer.
  */
-uint16_t read_proximity(void) {
-  uint8_t data[2];
-  uint16_t proximity;
-  if (VCN4040_readBytes(VCNL4040_ADDRESS, VCNL4040_PS_DATA_REG, 2, data, 1000)) {
-    proximity = (data[1] << 8) | data[0];
-    return proximity;
+ret_code_t vcnl4040_als_config(vcnl4040_als_it_t integration_time) {
+  i2c_script_op_t const script[] = {
+      I2C_SCRIPT_RMW16(VCNL4040_ALS_CONF_REG, VCNL4040_ALS_IT_Msk | VCNL4040_ALS_SD, integration_time << VCNL4040_ALS_IT_Pos),
+      I2C_SCRIPT_END()};
+  ret_code_t err_code = i2c_script_perform(VCNL4040_BUS, VCNL4040_ADDRESS, script, VCNL4040_TIMEOUT_MS);
+
+  if (err_code == NRF_SUCCESS) {
+    m_als_it = integration_time;
   }
-  return -1;
+  return err_code;
 }
 
 /**
- * @brief Writes a byte to a register of the VCNL4040 sensor.
+ * @brief Converts ALS_DATA counts into millilux for the configured integration time.
  *
- * This function writes a byte of data to the specified register of the VCNL4040 sensor.
+ * The resolution is 100 mlx per count at 80 ms and halves with every doubling of the
+ * integration time.
  *
- * @param devAddr The I2C address of the device.
- * @param regAddr The register address to write to.
- * @param data The data to write.
- * @return true if the write operation was successful, otherwise false.
+ * @param counts ALS_DATA counts.
+ * @return Illuminance in millilux.
  */
-bool VCN4040_writeByte(uint8_t devAddr, uint8_t regAddr, uint16_t data) {
+uint32_t vcnl4040_als_to_millilux(uint16_t counts) {
+  return ((uint32_t)counts * 800) >> (3 + m_als_it); // counts * 100 / 2^it, rounded down to whole millilux
+}
+
+/**
+ * @brief Starts a combined proximity and ambient light read in the background.
+ *
+ * @param callback Called from the TWI interrupt when the read finished, may be NULL.
+ * @param p_context Passed to the callback.
+ * @return NRF_SUCCESS, or NRF_ERROR_BUSY if the previous combined read is still running.
+ */
+ret_code_t vcnl4040_read_sample_start(i2c_bus_callback_t callback, void *p_context) {
   ret_code_t err_code;
-  uint8_t w2_data[3];
-  w2_data[0] = regAddr;
-  w2_data[1] = data;
-  w2_data[2] = data << 8;
 
-  m_xfer_done = false;
-  err_code = nrf_drv_twi_tx(&m_twi, devAddr, w2_data, sizeof(w2_data), false);
-  APP_ERROR_CHECK(err_code);
-  while (!m_xfer_done) {
+  if (m_sample_pending) {
+    return NRF_ERROR_BUSY;
   }
-  return err_code == NRF_SUCCESS;
+  m_sample_pending = true;
+  m_sample_callback = callback;
+  m_sample_transaction.callback = vcnl4040_sample_done;
+  m_sample_transaction.p_context = p_context;
+
+  err_code = i2c_bus_schedule(VCNL4040_BUS, &m_sample_transaction);
+  if (err_code != NRF_SUCCESS) {
+    m_sample_pending = false;
+  }
+  return err_code;
+}
+
+/**
+ * @brief Returns the result of the last combined read.
+ *
+ * @param p_sample Receives the record.
+ * @return true if the last combined read succeeded, otherwise false.
+ */
+bool vcnl4040_sample_get(vcnl4040_sample_t *p_sample) {
+  CRITICAL_REGION_ENTER();
+  *p_sample = m_sample; // Consistent copy, the TWI interrupt may be updating it
+  CRITICAL_REGION_EXIT();
+  return m_sample_valid;
 }
+
 /**
- * @brief Reads bytes from a register of the VCNL4040 sensor.
+ * @brief Enables interrupt driven proximity detection.
  *
- * This function reads multiple bytes of data from the specified register of the VCNL4040 sensor.
+ * P0.16 is BUTTON_4 in the pca10040 board definition and may already be sensed by the bsp,
+ * which has no action assigned to it; the driver takes the pin over in that case.
  *
- * @param devAddr The I2C address of the device.
- * @param regAddr The register address to read from.
- * @param length The number of bytes to read.
- * @param data Pointer to the buffer to store the read data.
- * @param timeout The timeout period for the read operation.
- * @return The number of bytes read, or a negative value if an error occurred.
+ * @param away_threshold PS_DATA below which the object is reported away.
+ * @param close_threshold PS_DATA above which the object is reported close, at least away_threshold.
+ * @param persistence Consecutive samples beyond a threshold before an event (1..4).
+ * @param handler Event handler, may be NULL.
+ * @return NRF_SUCCESS, NRF_ERROR_INVALID_PARAM, or an error code from the bus, app_timer or GPIOTE driver.
  */
-bool VCN4040_readBytes(uint8_t devAddr, uint8_t regAddr, uint8_t length, uint8_t *data, uint16_t timeout) {
+ret_code_t vcnl4040_proximity_int_enable(uint16_t away_threshold, uint16_t close_threshold, uint8_t persistence, vcnl4040_evt_handler_t handler) {
   ret_code_t err_code;
-  m_xfer_done = false;                // Set the flag to false to show the receiving is not yet completed
-  uint8_t register_address = regAddr; // Send the Register address where we want to write the data
+  uint16_t proximity;
 
-  err_code = nrf_drv_twi_tx(&m_twi, devAddr, &register_address, 1, true);
+  if ((away_threshold > close_threshold) || (persistence < 1) || (persistence > 4)) {
+    return NRF_ERROR_INVALID_PARAM;
+  }
+  i2c_script_op_t const script[] = {
+      I2C_SCRIPT_WRITE16(VCNL4040_PS_THDL_REG, away_threshold),
+      I2C_SCRIPT_WRITE16(VCNL4040_PS_THDH_REG, close_threshold),
+      I2C_SCRIPT_RMW16(VCNL4040_PS_CONF1_REG, VCNL4040_PS_PERS_Msk | VCNL4040_PS_INT_Msk,
+          ((persistence - 1) << VCNL4040_PS_PERS_Pos) | VCNL4040_PS_INT_CLOSE_AWAY),
+      I2C_SCRIPT_END()};
+  m_away_threshold = away_threshold;
+  m_close_threshold = close_threshold;
+  m_evt_handler = handler;
+  err_code = i2c_script_perform(VCNL4040_BUS, VCNL4040_ADDRESS, script, VCNL4040_TIMEOUT_MS); // Blocking, the script lives on this stack frame
+  if (err_code != NRF_SUCCESS) {
+    return err_code;
+  }
+  if (!vcnl4040_read_register(VCNL4040_PS_DATA_REG, &proximity)) {
+    return NRF_ERROR_INTERNAL;
+  }
+  m_close = proximity > close_threshold; // Events only report changes, start from the current state
 
-  // TODO: Implement Timeout
-  // Wait for the transmission to get completed
-  while (m_xfer_done == false) {
+  if (!m_int_retry_created) {
+    err_code = app_timer_create(&m_int_retry_timer, APP_TIMER_MODE_SINGLE_SHOT, vcnl4040_int_retry_handler);
+    if (err_code != NRF_SUCCESS) {
+      return err_code;
+    }
+    m_int_retry_created = true;
   }
-  // If transmission was not successful, exit the function with false as return value
-  if (NRF_SUCCESS != err_code) {
-    return false;
+  if (!nrf_drv_gpiote_is_init()) {
+    err_code = nrf_drv_gpiote_init();
+    if (err_code != NRF_SUCCESS) {
+      return err_code;
+    }
+  }
+  nrf_drv_gpiote_in_config_t config = GPIOTE_CONFIG_IN_SENSE_HITOLO(false); // PORT event, no high frequency clock needed
+  config.pull = NRF_GPIO_PIN_PULLUP;                                        // INT is open drain
+  err_code = nrf_drv_gpiote_in_init(VCNL4040_INT_PIN, &config, vcnl4040_int_handler);
+  if (err_code == NRF_ERROR_INVALID_STATE) { // Pin in use by the bsp buttons
+    nrf_drv_gpiote_in_uninit(VCNL4040_INT_PIN);
+    err_code = nrf_drv_gpiote_in_init(VCNL4040_INT_PIN, &config, vcnl4040_int_handler);
+  }
+  if (err_code != NRF_SUCCESS) {
+    return err_code;
+  }
+  nrf_drv_gpiote_in_event_enable(VCNL4040_INT_PIN, true);
+
+  vcnl4040_int_read(); // Release INT in case it was asserted before the GPIOTE event was enabled
+  return NRF_SUCCESS;
+}
+
+/**
+ * @brief Returns the proximity state tracked by the interrupt driven mode.
+ *
+ * @return true after a close event (or if the object was close when the mode was enabled).
+ */
+bool vcnl4040_is_close(void) {
+  return m_close;
+}
+
+/**
+ * @brief Initializes the TWI (I2C) interface for the VCNL4040 sensor.
+ *
+ * This function sets up the TWI interface for communication with the VCNL4040 sensor.
+ */
+void VCN4040_TWI_initialize(void) {
+  i2c_bus_init(VCNL4040_BUS, VCNL4040_SCL_PIN, VCNL4040_SDA_PIN); // Initialize and enable the TWI interface
+}
+
+/**
+ * @brief Initializes the VCNL4040 sensor.
+ *
+ * This function initializes the VCNL4040 sensor by setting the PS_CONF1 register.
+ *
+ * @return NRF_SUCCESS, or the error of the configuration script.
+ */
+ret_code_t vcnl4040_init(void) {
+  return i2c_script_perform(VCNL4040_BUS, VCNL4040_ADDRESS, m_init_script, VCNL4040_TIMEOUT_MS);
+}
+
+/**
+ * @brief Reads the proximity value from the VCNL4040 sensor.
+ *
+ * This function reads the proximity data from the VCNL4040 sensor and returns it.
+ *
+ * @return The proximity value or -1 if read failed.
+ */
+uint16_t read_proximity(void) {
+  uint16_t proximity;
+  if (vcnl4040_read_register(VCNL4040_PS_DATA_REG, &proximity)) {
+    return proximity;
   }
+  return -1;
+}
 
-  m_xfer_done = false;                                      // Set the flag again so that we can read data from the VCNL4040's internal register
-  err_code = nrf_drv_twi_rx(&m_twi, devAddr, data, length); // Receive the data from the VCNL4040
+/**
+ * @brief Starts a proximity read in the background.
+ *
+ * @param callback Called from the TWI interrupt when the read finished, may be NULL.
+ * @param p_context Passed to the callback.
+ * @return NRF_SUCCESS, or NRF_ERROR_BUSY if the previous background read is still running.
+ */
+ret_code_t vcnl4040_read_proximity_start(i2c_bus_callback_t callback, void *p_context) {
+  ret_code_t err_code;
 
-  while (m_xfer_done == false) { // Wait until the transmission is completed
+  if (m_read_pending) {
+    return NRF_ERROR_BUSY;
   }
-  if (NRF_SUCCESS != err_code) { // If data was successfully read, return true else return false
+  m_read_pending = true;
+  m_read_callback = callback;
+  m_ps_read_transaction.callback = vcnl4040_read_done;
+  m_ps_read_transaction.p_context = p_context;
 
-    return false;
+  err_code = i2c_bus_schedule(VCNL4040_BUS, &m_ps_read_transaction);
+  if (err_code != NRF_SUCCESS) {
+    m_read_pending = false;
   }
-  return true;
-}
\ No newline at end of file
+  return err_code;
+}
+
+/**
+ * @brief Returns the result of the last background proximity read.
+ *
+ * @return The proximity value or 0xFFFF if the read failed.
+ */
+uint16_t vcnl4040_proximity_get(void) {
+  return m_proximity;
+}
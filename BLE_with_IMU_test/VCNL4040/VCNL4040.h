@@ -1,10 +1,12 @@
 #ifndef _VCNL4040_H_
 #define _VCNL4040_H_
 
+#include "I2C_Bus.h"
+#include "I2C_Script.h"
 #include "app_error.h"
 #include "boards.h"
 #include "nrf_delay.h"
-#include "nrf_drv_twi.h"
+#include "nrf_drv_gpiote.h"
 
 /**
  * @file vcnl4040.h
@@ -20,20 +22,185 @@
 #define VCNL4040_ADDRESS 0x60
 
 /**
- * @brief Register addresses for the VCNL4040 sensor.
+ * @brief Bus and pins the VCNL4040 is connected to on the PCB.
  */
-#define VCNL4040_PS_CONF1_REG 0x03 /**< Configuration register 1 for proximity sensor */
-#define VCNL4040_PS_CONF2_REG 0x04 /**< Configuration register 2 for proximity sensor */
-#define VCNL4040_PS_CONF3_REG 0x05 /**< Configuration register 3 for proximity sensor */
-#define VCNL4040_PS_MS_REG 0x06    /**< Measurement signal register for proximity sensor */
+#define VCNL4040_BUS I2C_BUS_TWI1 /**< The sensor has its own bus so it can be read in parallel with the IMU */
+#define VCNL4040_SCL_PIN 4        /**< Prox_SCL */
+#define VCNL4040_SDA_PIN 5        /**< Prox_SDA */
+#define VCNL4040_INT_PIN 16       /**< Prox_INT, open drain, active low */
+#define VCNL4040_TIMEOUT_MS 1000  /**< Timeout for blocking register accesses */
+#define VCNL4040_INT_RETRY_MS 2   /**< Retry interval of an interrupt read the bus queue had no room for */
+
+/**
+ * @brief Register addresses (command codes) for the VCNL4040 sensor.
+ *
+ * Every command code addresses a 16-bit register transferred LSB first; some of them hold
+ * two 8-bit registers of the datasheet in their low and high byte.
+ */
+#define VCNL4040_ALS_CONF_REG 0x00 /**< ALS_CONF (low byte) */
+#define VCNL4040_PS_CONF1_REG 0x03 /**< PS_CONF1 (low byte) and PS_CONF2 (high byte) */
+#define VCNL4040_PS_CONF3_REG 0x04 /**< PS_CONF3 (low byte) and PS_MS (high byte) */
+#define VCNL4040_PS_THDL_REG 0x06  /**< Proximity "away" threshold */
+#define VCNL4040_PS_THDH_REG 0x07  /**< Proximity "close" threshold */
 #define VCNL4040_PS_DATA_REG 0x08  /**< Data register for proximity sensor */
+#define VCNL4040_ALS_DATA_REG 0x09 /**< Data register for ambient light sensor */
+#define VCNL4040_INT_FLAG_REG 0x0B /**< Interrupt flags (high byte), cleared by reading */
+
+/**
+ * @brief Bit fields of the PS_CONF1/PS_CONF2 register (command code 0x03).
+ */
+#define VCNL4040_PS_SD 0x0001                                   /**< Proximity sensor shut down */
+#define VCNL4040_PS_IT_Pos 1                                    /**< IRED pulse width (integration time) */
+#define VCNL4040_PS_IT_Msk (0x7 << VCNL4040_PS_IT_Pos)          /**< PS_IT field */
+#define VCNL4040_PS_DUTY_Pos 6                                  /**< IRED on/off duty ratio */
+#define VCNL4040_PS_DUTY_Msk (0x3 << VCNL4040_PS_DUTY_Pos)      /**< PS_Duty field */
+#define VCNL4040_PS_HD 0x0800                                   /**< 16-bit proximity output (PS_CONF2 bit 3) */
+#define VCNL4040_PS_PERS_Pos 4                                  /**< Interrupt persistence, 1 to 4 consecutive samples */
+#define VCNL4040_PS_PERS_Msk (0x3 << VCNL4040_PS_PERS_Pos)      /**< PS_PERS field */
+#define VCNL4040_PS_INT_Pos 8                                   /**< Interrupt mode */
+#define VCNL4040_PS_INT_Msk (0x3 << VCNL4040_PS_INT_Pos)        /**< PS_INT field (PS_CONF2 bits 1:0) */
+#define VCNL4040_PS_INT_CLOSE_AWAY (0x3 << VCNL4040_PS_INT_Pos) /**< Interrupt when crossing PS_THDH and PS_THDL */
+
+/**
+ * @brief Bit fields of the PS_CONF3/PS_MS register (command code 0x04).
+ */
+#define VCNL4040_PS_MPS_Pos 5                                /**< Number of IRED pulses per measurement */
+#define VCNL4040_PS_MPS_Msk (0x3 << VCNL4040_PS_MPS_Pos)     /**< PS_MPS field */
+#define VCNL4040_PS_LED_I_Pos 8                              /**< IRED current */
+#define VCNL4040_PS_LED_I_Msk (0x7 << VCNL4040_PS_LED_I_Pos) /**< LED_I field (PS_MS bits 2:0) */
+
+/**
+ * @brief Bit fields of the ALS_CONF register (command code 0x00).
+ */
+#define VCNL4040_ALS_SD 0x0001                           /**< Ambient light sensor shut down */
+#define VCNL4040_ALS_IT_Pos 6                            /**< Integration time */
+#define VCNL4040_ALS_IT_Msk (0x3 << VCNL4040_ALS_IT_Pos) /**< ALS_IT field */
+
+/**
+ * @brief Bits of the INT_FLAG register (command code 0x0B).
+ */
+#define VCNL4040_INT_FLAG_PS_AWAY 0x0100  /**< Proximity dropped below PS_THDL */
+#define VCNL4040_INT_FLAG_PS_CLOSE 0x0200 /**< Proximity rose above PS_THDH */
+
+/**
+ * @brief Proximity events delivered by the interrupt driven mode.
+ */
+typedef enum {
+  VCNL4040_EVT_CLOSE, /**< An object came closer than the close threshold */
+  VCNL4040_EVT_AWAY   /**< The object moved further away than the away threshold */
+} vcnl4040_evt_t;
+
+/**
+ * @brief Proximity IRED duty ratios. A lower ratio measures less often and draws less current.
+ */
+typedef enum {
+  VCNL4040_PS_DUTY_1_40 = 0, /**< Shortest measurement period */
+  VCNL4040_PS_DUTY_1_80,
+  VCNL4040_PS_DUTY_1_160,
+  VCNL4040_PS_DUTY_1_320 /**< Longest measurement period, lowest current */
+} vcnl4040_ps_duty_t;
+
+/**
+ * @brief Proximity integration times (IRED pulse width) in units of T.
+ */
+typedef enum {
+  VCNL4040_PS_IT_1T = 0,
+  VCNL4040_PS_IT_1_5T,
+  VCNL4040_PS_IT_2T,
+  VCNL4040_PS_IT_2_5T,
+  VCNL4040_PS_IT_3T,
+  VCNL4040_PS_IT_3_5T,
+  VCNL4040_PS_IT_4T,
+  VCNL4040_PS_IT_8T
+} vcnl4040_ps_it_t;
+
+/**
+ * @brief Number of IRED pulses per proximity measurement.
+ */
+typedef enum {
+  VCNL4040_PS_MPS_1 = 0,
+  VCNL4040_PS_MPS_2,
+  VCNL4040_PS_MPS_4,
+  VCNL4040_PS_MPS_8
+} vcnl4040_ps_mps_t;
+
+/**
+ * @brief IRED current.
+ */
+typedef enum {
+  VCNL4040_PS_LED_50MA = 0,
+  VCNL4040_PS_LED_75MA,
+  VCNL4040_PS_LED_100MA,
+  VCNL4040_PS_LED_120MA,
+  VCNL4040_PS_LED_140MA,
+  VCNL4040_PS_LED_160MA,
+  VCNL4040_PS_LED_180MA,
+  VCNL4040_PS_LED_200MA
+} vcnl4040_ps_led_t;
+
+/**
+ * @brief Proximity sensor configuration.
+ *
+ * The proximity counts scale with the integration time, the number of pulses and the LED
+ * current, so the interrupt thresholds have to be chosen for the configuration in use.
+ */
+typedef struct {
+  vcnl4040_ps_duty_t duty;       /**< Measurement duty ratio */
+  vcnl4040_ps_it_t it;           /**< Integration time */
+  bool high_resolution;          /**< 16-bit instead of 12-bit PS_DATA */
+  vcnl4040_ps_mps_t pulses;      /**< IRED pulses per measurement */
+  vcnl4040_ps_led_t led_current; /**< IRED current */
+} vcnl4040_ps_config_t;
+
+/**
+ * @brief Configuration written by vcnl4040_init().
+ */
+#define VCNL4040_PS_CONFIG_DEFAULT {VCNL4040_PS_DUTY_1_160, VCNL4040_PS_IT_1T, false, VCNL4040_PS_MPS_1, VCNL4040_PS_LED_50MA}
+
+/**
+ * @brief Lowest current: longest measurement period, single short pulse at the lowest current.
+ */
+#define VCNL4040_PS_CONFIG_LOW_POWER {VCNL4040_PS_DUTY_1_320, VCNL4040_PS_IT_1T, false, VCNL4040_PS_MPS_1, VCNL4040_PS_LED_50MA}
+
+/**
+ * @brief Fastest response: shortest measurement period, longer pulses and 16-bit output for range.
+ */
+#define VCNL4040_PS_CONFIG_HIGH_RESPONSE {VCNL4040_PS_DUTY_1_40, VCNL4040_PS_IT_2T, true, VCNL4040_PS_MPS_2, VCNL4040_PS_LED_100MA}
+
+/**
+ * @brief ALS integration times. Longer integration increases the resolution and lowers the range.
+ */
+typedef enum {
+  VCNL4040_ALS_IT_80MS = 0, /**< 0.1 lux per count, up to 6553 lux */
+  VCNL4040_ALS_IT_160MS,    /**< 0.05 lux per count, up to 3276 lux */
+  VCNL4040_ALS_IT_320MS,    /**< 0.025 lux per count, up to 1638 lux */
+  VCNL4040_ALS_IT_640MS     /**< 0.0125 lux per count, up to 819 lux */
+} vcnl4040_als_it_t;
+
+/**
+ * @brief Proximity and ambient light read in one transaction.
+ */
+typedef struct {
+  uint32_t timestamp_us; /**< Completion time of the read (i2c_bus_time_us) */
+  uint16_t proximity;    /**< PS_DATA counts */
+  uint16_t ambient;      /**< ALS_DATA counts, see vcnl4040_als_to_millilux */
+} vcnl4040_sample_t;
+
+/**
+ * @brief Handler of proximity events, called from the TWI interrupt.
+ *
+ * @param event Proximity event.
+ */
+typedef void (*vcnl4040_evt_handler_t)(vcnl4040_evt_t event);
 
 /**
  * @brief Initializes the VCNL4040 sensor.
  *
  * This function initializes the VCNL4040 sensor
+ *
+ * @return NRF_SUCCESS, or the error of the configuration script.
  */
-void vcnl4040_init(void);
+ret_code_t vcnl4040_init(void);
 
 /**
  * @brief Reads the proximity value from the VCNL4040 sensor.
@@ -45,55 +212,107 @@ void vcnl4040_init(void);
 uint16_t read_proximity(void);
 
 /**
- * @brief TWI handler for the VCNL4040 sensor.
+ * @brief Starts a proximity read in the background.
  *
- * This function handles TWI (I2C) events for the VCNL4040 sensor.
+ * The read is queued on the VCNL4040 bus and runs in parallel with transfers on other buses.
+ * Once the callback was called (or i2c_bus_wait_idle(VCNL4040_BUS, ...) returned) the value
+ * is available from vcnl4040_proximity_get().
  *
- * @param p_event Pointer to the TWI event structure.
- * @param p_context Pointer to the context.
+ * @param callback Called from the TWI interrupt when the read finished, may be NULL.
+ * @param p_context Passed to the callback.
+ * @return NRF_SUCCESS, or NRF_ERROR_BUSY if the previous background read is still running.
  */
-void VCN4040_twi_handler(nrf_drv_twi_evt_t const *p_event, void *p_context);
+ret_code_t vcnl4040_read_proximity_start(i2c_bus_callback_t callback, void *p_context);
 
 /**
- * @brief Initializes the TWI (I2C) interface for the VCNL4040 sensor.
+ * @brief Returns the result of the last background proximity read.
  *
- * This function sets up the TWI interface for communication with the VCNL4040 sensor.
+ * @return The proximity value or 0xFFFF if the read failed.
  */
-void VCN4040_TWI_initialize(void);
+uint16_t vcnl4040_proximity_get(void);
 
 /**
- * @brief Enables or disables the VCNL4040 sensor.
+ * @brief Applies a proximity sensor configuration and powers the proximity sensor up.
  *
- * This function enables or disables the VCNL4040 sensor based on the isEnabled parameter.
+ * Can be called at any time after vcnl4040_init(); the interrupt thresholds, persistence
+ * and interrupt mode are kept.
  *
- * @param isEnabled Boolean value indicating whether to enable (true) or disable (false) the sensor.
+ * @param p_config Configuration, e.g. one of the VCNL4040_PS_CONFIG_* presets.
+ * @return NRF_SUCCESS, or an error code from the bus layer.
  */
-void VCN4040_enable(bool isEnabled);
+ret_code_t vcnl4040_ps_config(vcnl4040_ps_config_t const *p_config);
 
 /**
- * @brief Writes a byte to a register of the VCNL4040 sensor.
+ * @brief Configures and powers up the ambient light sensor.
+ *
+ * The first valid ALS_DATA is available one integration time after this call.
  *
- * This function writes a byte of data to the specified register of the VCNL4040 sensor.
+ * @param integration_time ALS integration time.
+ * @return NRF_SUCCESS, or an error code from the bus layer.
+ */
+ret_code_t vcnl4040_als_config(vcnl4040_als_it_t integration_time);
+
+/**
+ * @brief Converts ALS_DATA counts into millilux for the configured integration time.
  *
- * @param devAddr The I2C address of the device.
- * @param regAddr The register address to write to.
- * @param data The data to write.
- * @return true if the write operation was successful, otherwise false.
+ * @param counts ALS_DATA counts.
+ * @return Illuminance in millilux.
  */
-bool VCN4040_writeByte(uint8_t devAddr, uint8_t regAddr, uint16_t data);
+uint32_t vcnl4040_als_to_millilux(uint16_t counts);
 
 /**
- * @brief Reads bytes from a register of the VCNL4040 sensor.
+ * @brief Starts a combined proximity and ambient light read in the background.
  *
- * This function reads multiple bytes of data from the specified register of the VCNL4040 sensor.
+ * PS_DATA and ALS_DATA are read as two transfers of a single bus transaction, so the
+ * ambient light costs no extra scheduling round trip. Once the callback was called (or
+ * i2c_bus_wait_idle(VCNL4040_BUS, ...) returned) the record is available from
+ * vcnl4040_sample_get(). vcnl4040_init() leaves the ALS shut down (ALS_SD); ALS_DATA is only
+ * meaningful after vcnl4040_als_config(), otherwise use vcnl4040_read_proximity_start().
  *
- * @param devAddr The I2C address of the device.
- * @param regAddr The register address to read from.
- * @param length The number of bytes to read.
- * @param data Pointer to the buffer to store the read data.
- * @param timeout The timeout period for the read operation.
- * @return true if the read operation was successful, otherwise false.
+ * @param callback Called from the TWI interrupt when the read finished, may be NULL.
+ * @param p_context Passed to the callback.
+ * @return NRF_SUCCESS, or NRF_ERROR_BUSY if the previous combined read is still running.
  */
-bool VCN4040_readBytes(uint8_t devAddr, uint8_t regAddr, uint8_t length, uint8_t *data, uint16_t timeout);
+ret_code_t vcnl4040_read_sample_start(i2c_bus_callback_t callback, void *p_context);
+
+/**
+ * @brief Returns the result of the last combined read.
+ *
+ * @param p_sample Receives the record.
+ * @return true if the last combined read succeeded, otherwise false.
+ */
+bool vcnl4040_sample_get(vcnl4040_sample_t *p_sample);
+
+/**
+ * @brief Enables interrupt driven proximity detection.
+ *
+ * Programs the thresholds and the interrupt persistence, enables the close/away interrupt
+ * and senses the INT pin through GPIOTE. When the pin is asserted, INT_FLAG is read in the
+ * background (which releases the pin) and the handler receives the event, so the bus is
+ * only used when the proximity state changes. If the bus queue has no room for the read,
+ * it is retried every VCNL4040_INT_RETRY_MS while the pin stays asserted. Must be called
+ * from thread mode after vcnl4040_init() and app_timer_init().
+ *
+ * @param away_threshold PS_DATA below which the object is reported away.
+ * @param close_threshold PS_DATA above which the object is reported close, at least away_threshold.
+ * @param persistence Consecutive samples beyond a threshold before an event (1..4).
+ * @param handler Event handler, may be NULL.
+ * @return NRF_SUCCESS, NRF_ERROR_INVALID_PARAM, or an error code from the bus, app_timer or GPIOTE driver.
+ */
+ret_code_t vcnl4040_proximity_int_enable(uint16_t away_threshold, uint16_t close_threshold, uint8_t persistence, vcnl4040_evt_handler_t handler);
+
+/**
+ * @brief Returns the proximity state tracked by the interrupt driven mode.
+ *
+ * @return true after a close event (or if the object was close when the mode was enabled).
+ */
+bool vcnl4040_is_close(void);
+
+/**
+ * @brief Initializes the TWI (I2C) interface for the VCNL4040 sensor.
+ *
+ * This function sets up the TWI interface for communication with the VCNL4040 sensor.
+ */
+void VCN4040_TWI_initialize(void);
 
 #endif // _VCNL4040_H_
@@ -0,0 +1,102 @@
+#include "VCNL4040_Filter.h"
+
+/**
+ * @brief Initializes a filter.
+ *
+ * @param p_filter Filter to initialize.
+ * @param shift Smoothing strength (0..VCNL4040_FILTER_MAX_SHIFT), every step doubles the time constant.
+ * @param away_threshold Smoothed value below which the object is reported away.
+ * @param close_threshold Smoothed value above which the object is reported close, at least away_threshold.
+ * @return true on success, false if a parameter is out of range.
+ */
+bool vcnl4040_filter_init(vcnl4040_filter_t *p_filter, uint8_t shift, uint16_t away_threshold, uint16_t close_threshold) {
+  if ((shift > VCNL4040_FILTER_MAX_SHIFT) || (away_threshold > close_threshold)) {
+    return false;
+  }
+  p_filter->shift = shift;
+  p_filter->away_threshold = away_threshold;
+  p_filter->close_threshold = close_threshold;
+  p_filter->close = false;
+  vcnl4040_filter_reset(p_filter);
+  return true;
+}
+
+/**
+ * @brief Feeds a proximity sample into the filter.
+ *
+ * @param p_filter Filter.
+ * @param proximity Raw PS_DATA counts.
+ * @return true if the close/away decision changed with this sample.
+ */
+bool vcnl4040_filter_update(vcnl4040_filter_t *p_filter, uint16_t proximity) {
+  uint16_t value;
+  bool was_close = p_filter->close;
+
+  if (!p_filter->primed) {
+    p_filter->accumulator = (uint32_t)proximity << p_filter->shift; // Start at the first sample instead of ramping up from 0
+    p_filter->primed = true;
+  } else {
+    p_filter->accumulator -= p_filter->accumulator >> p_filter->shift; // acc = acc - acc / 2^shift + x, i.e.
+    p_filter->accumulator += proximity;                                // y += (x - y) / 2^shift with y = acc / 2^shift
+  }
+  value = vcnl4040_filter_value(p_filter);
+
+  if (value > p_filter->close_threshold) {
+    p_filter->close = true;
+  } else if (value < p_filter->away_threshold) {
+    p_filter->close = false;
+  } // Between the thresholds the previous decision is kept
+  return p_filter->close != was_close;
+}
+
+/**
+ * @brief Discards the filter history, the next sample restarts the filter.
+ *
+ * @param p_filter Filter.
+ */
+void vcnl4040_filter_reset(vcnl4040_filter_t *p_filter) {
+  p_filter->accumulator = 0;
+  p_filter->primed = false;
+}
+
+/**
+ * @brief Returns the smoothed proximity value.
+ *
+ * @param p_filter Filter.
+ * @return Smoothed PS_DATA counts.
+ */
+uint16_t vcnl4040_filter_value(vcnl4040_filter_t const *p_filter) {
+  return p_filter->accumulator >> p_filter->shift;
+}
+
+/**
+ * @brief Returns the close/away decision.
+ *
+ * @param p_filter Filter.
+ * @return true if the object is close.
+ */
+bool vcnl4040_filter_is_close(vcnl4040_filter_t const *p_filter) {
+  return p_filter->close;
+}
+
+/**
+ * @brief Checks whether the filter has been fed since the last init or reset.
+ *
+ * @param p_filter Filter.
+ * @return true once the first sample initialized the value.
+ */
+bool vcnl4040_filter_is_primed(vcnl4040_filter_t const *p_filter) {
+  return p_filter->primed;
+}
+
+/**
+ * @brief Checks whether further samples of the current value would leave the decision unchanged.
+ *
+ * @param p_filter Filter.
+ * @return true if the filter has been fed and the smoothed value lies outside the hysteresis band.
+ */
+bool vcnl4040_filter_is_settled(vcnl4040_filter_t const *p_filter) {
+  uint16_t value = vcnl4040_filter_value(p_filter);
+
+  return p_filter->primed && ((value > p_filter->close_threshold) || (value < p_filter->away_threshold));
+}
@@ -0,0 +1,97 @@
+#ifndef _VCNL4040_FILTER_H_
+#define _VCNL4040_FILTER_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @file VCNL4040_Filter.h
+ * @brief Proximity signal conditioning: integer IIR smoothing and a hysteresis decision.
+ *
+ * The filter keeps the full 16-bit PS_DATA range. The smoothed value is
+ * y += (x - y) / 2^shift, computed on an accumulator scaled by 2^shift so no fraction is lost
+ * between samples. The close/away decision compares the smoothed value against two thresholds,
+ * so noise around a single threshold does not toggle the state.
+ *
+ * The filter does not touch the bus; it is fed with samples from vcnl4040_sample_get(),
+ * vcnl4040_proximity_get() or read_proximity() and can run in any context, one instance per
+ * consumer. vcnl4040_filter_is_settled() tells the caller when it can stop sampling.
+ */
+
+#define VCNL4040_FILTER_MAX_SHIFT 8 ///< Strongest smoothing, about 256 samples time constant
+
+/**
+ * @brief Filter state. Treat as opaque, use the functions below.
+ */
+typedef struct {
+  uint32_t accumulator;     /**< Smoothed value scaled by 2^shift */
+  uint16_t away_threshold;  /**< Smoothed value below which the state becomes away */
+  uint16_t close_threshold; /**< Smoothed value above which the state becomes close */
+  uint8_t shift;            /**< Smoothing strength, 0 disables the IIR */
+  bool primed;              /**< Set once the first sample initialized the accumulator */
+  bool close;               /**< Current decision */
+} vcnl4040_filter_t;
+
+/**
+ * @brief Initializes a filter.
+ *
+ * @param p_filter Filter to initialize.
+ * @param shift Smoothing strength (0..VCNL4040_FILTER_MAX_SHIFT), every step doubles the time constant.
+ * @param away_threshold Smoothed value below which the object is reported away.
+ * @param close_threshold Smoothed value above which the object is reported close, at least away_threshold.
+ * @return true on success, false if a parameter is out of range.
+ */
+bool vcnl4040_filter_init(vcnl4040_filter_t *p_filter, uint8_t shift, uint16_t away_threshold, uint16_t close_threshold);
+
+/**
+ * @brief Feeds a proximity sample into the filter.
+ *
+ * The first sample after vcnl4040_filter_init() or vcnl4040_filter_reset() sets the smoothed
+ * value directly, so the filter does not ramp up from zero.
+ *
+ * @param p_filter Filter.
+ * @param proximity Raw PS_DATA counts.
+ * @return true if the close/away decision changed with this sample.
+ */
+bool vcnl4040_filter_update(vcnl4040_filter_t *p_filter, uint16_t proximity);
+
+/**
+ * @brief Discards the filter history, the next sample restarts the filter.
+ *
+ * @param p_filter Filter.
+ */
+void vcnl4040_filter_reset(vcnl4040_filter_t *p_filter);
+
+/**
+ * @brief Returns the smoothed proximity value.
+ *
+ * @param p_filter Filter.
+ * @return Smoothed PS_DATA counts.
+ */
+uint16_t vcnl4040_filter_value(vcnl4040_filter_t const *p_filter);
+
+/**
+ * @brief Returns the close/away decision.
+ *
+ * @param p_filter Filter.
+ * @return true if the object is close.
+ */
+bool vcnl4040_filter_is_close(vcnl4040_filter_t const *p_filter);
+
+/**
+ * @brief Checks whether the filter has been fed since the last init or reset.
+ *
+ * @param p_filter Filter.
+ * @return true once the first sample initialized the value.
+ */
+bool vcnl4040_filter_is_primed(vcnl4040_filter_t const *p_filter);
+
+/**
+ * @brief Checks whether further samples of the current value would leave the decision unchanged.
+ *
+ * @param p_filter Filter.
+ * @return true if the filter has been fed and the smoothed value lies outside the hysteresis band.
+ */
+bool vcnl4040_filter_is_settled(vcnl4040_filter_t const *p_filter);
+
+#endif // _VCNL4040_FILTER_H_
@@ -1,109 +1,433 @@
 #include "WS2812B.h"
+#include <string.h>
 
 /**
- * @brief Delays execution for a specified number of ticks.
+ * @brief Gamma 2.8 curve, X(output level) for the input levels 0..255.
+ */
+#define WS2812B_GAMMA_LEVELS(X) \
+  X(0) X(0) X(0) X(0) X(0) X(0) X(0) X(0) X(0) X(0) X(0) X(0) X(0) X(0) X(0) X(0) \
+  X(0) X(0) X(0) X(0) X(0) X(0) X(0) X(0) X(0) X(0) X(0) X(0) X(1) X(1) X(1) X(1) \
+  X(1) X(1) X(1) X(1) X(1) X(1) X(1) X(1) X(1) X(2) X(2) X(2) X(2) X(2) X(2) X(2) \
+  X(2) X(3) X(3) X(3) X(3) X(3) X(3) X(3) X(4) X(4) X(4) X(4) X(4) X(5) X(5) X(5) \
+  X(5) X(6) X(6) X(6) X(6) X(7) X(7) X(7) X(7) X(8) X(8) X(8) X(9) X(9) X(9) X(10) \
+  X(10) X(10) X(11) X(11) X(11) X(12) X(12) X(13) X(13) X(13) X(14) X(14) X(15) X(15) X(16) X(16) \
+  X(17) X(17) X(18) X(18) X(19) X(19) X(20) X(20) X(21) X(21) X(22) X(22) X(23) X(24) X(24) X(25) \
+  X(25) X(26) X(27) X(27) X(28) X(29) X(29) X(30) X(31) X(32) X(32) X(33) X(34) X(35) X(35) X(36) \
+  X(37) X(38) X(39) X(39) X(40) X(41) X(42) X(43) X(44) X(45) X(46) X(47) X(48) X(49) X(50) X(50) \
+  X(51) X(52) X(54) X(55) X(56) X(57) X(58) X(59) X(60) X(61) X(62) X(63) X(64) X(66) X(67) X(68) \
+  X(69) X(70) X(72) X(73) X(74) X(75) X(77) X(78) X(79) X(81) X(82) X(83) X(85) X(86) X(87) X(89) \
+  X(90) X(92) X(93) X(95) X(96) X(98) X(99) X(101) X(102) X(104) X(105) X(107) X(109) X(110) X(112) X(114) \
+  X(115) X(117) X(119) X(120) X(122) X(124) X(126) X(127) X(129) X(131) X(133) X(135) X(137) X(138) X(140) X(142) \
+  X(144) X(146) X(148) X(150) X(152) X(154) X(156) X(158) X(160) X(162) X(164) X(167) X(169) X(171) X(173) X(175) \
+  X(177) X(180) X(182) X(184) X(186) X(189) X(191) X(193) X(196) X(198) X(200) X(203) X(205) X(208) X(210) X(213) \
+  X(215) X(218) X(220) X(223) X(225) X(228) X(231) X(233) X(236) X(239) X(241) X(244) X(247) X(249) X(252) X(255)
+
+/**
+ * @brief Identity, X(level) for the levels 0..255.
+ */
+#define WS2812B_LINEAR_4(X, v) X(v) X(v + 1) X(v + 2) X(v + 3)
+#define WS2812B_LINEAR_16(X, v) WS2812B_LINEAR_4(X, v) WS2812B_LINEAR_4(X, v + 4) WS2812B_LINEAR_4(X, v + 8) WS2812B_LINEAR_4(X, v + 12)
+#define WS2812B_LINEAR_64(X, v) WS2812B_LINEAR_16(X, v) WS2812B_LINEAR_16(X, v + 16) WS2812B_LINEAR_16(X, v + 32) WS2812B_LINEAR_16(X, v + 48)
+#define WS2812B_LINEAR_LEVELS(X) WS2812B_LINEAR_64(X, 0) WS2812B_LINEAR_64(X, 64) WS2812B_LINEAR_64(X, 128) WS2812B_LINEAR_64(X, 192)
+
+#define WS2812B_BIT(v, b) ((((v) >> (b)) & 1) ? WS2812B_PWM_T1H : WS2812B_PWM_T0H) ///< PWM compare value of bit b of v
+#define WS2812B_SYMBOL(v) {WS2812B_BIT(v, 7), WS2812B_BIT(v, 6), WS2812B_BIT(v, 5), WS2812B_BIT(v, 4), \
+                           WS2812B_BIT(v, 3), WS2812B_BIT(v, 2), WS2812B_BIT(v, 1), WS2812B_BIT(v, 0)},
+
+#define WS2812B_LEVEL(v) v, ///< Level as array element
+
+/**
+ * @brief PWM compare values of every colour level, most significant bit first.
  *
- * This function uses a loop of no-operation instructions to create a delay for the given number of ticks.
+ * Generated by the preprocessor (4 KB flash), encoding an LED is three copies of 16 bytes.
+ */
+static const uint16_t m_symbols[256][8] = {WS2812B_LINEAR_LEVELS(WS2812B_SYMBOL)};
+
+/**
+ * @brief Output level of every frame buffer level at full brightness.
+ */
+static const uint8_t m_gamma[256] = {
+#if WS2812B_GAMMA_ENABLED
+    WS2812B_GAMMA_LEVELS(WS2812B_LEVEL)
+#else
+    WS2812B_LINEAR_LEVELS(WS2812B_LEVEL)
+#endif
+};
+
+static const uint8_t m_channel_order[3] = WS2812B_CHANNEL_ORDER; // Frame buffer channel sent first, second and third
+
+static const nrf_drv_pwm_t m_pwm = NRF_DRV_PWM_INSTANCE(WS2812B_PWM_INSTANCE); // PWM generating the data signal
+
+static uint8_t m_pixels[MAX_LEDs_in_STRIP][3];                  // Frame buffer, RGB per LED
+static uint16_t m_dirty_first = MAX_LEDs_in_STRIP;              // First LED changed since the last show (MAX_LEDs_in_STRIP: none)
+static uint16_t m_dirty_last;                                   // Last LED changed since the last show
+static uint16_t m_halves[2][WS2812B_STREAM_LEDS * PACKET_SIZE]; // Ping-pong buffers of encoded data (must live in RAM for EasyDMA)
+static bool m_half_is_reset[2];                                 // Set if a half holds only low periods
+static uint16_t m_stream_next;                                  // Next LED to encode
+static uint16_t m_stream_end;                                   // LED after the last one sent by the running refresh
+static volatile bool m_streaming = false;                       // Set while a refresh is running
+static uint8_t m_levels[256];                                   // Output level of every frame buffer level: brightness, then gamma
+static uint8_t m_levels_brightness;                             // Brightness m_levels was built for
+static uint8_t m_brightness;                                    // Brightness requested by ws2812b_set_brightness
+static uint16_t m_budget_ma;                                    // Current budget, 0 if unlimited
+static uint32_t m_current_ua;                                   // Estimated current of the last frame sent
+
+/**
+ * @brief Adds an LED to the dirty range.
  *
- * @param ticks The number of ticks to delay.
+ * @param index Index of the LED (0-based).
  */
-void nrf_delay_us_ticks(uint32_t ticks) {
-  while (ticks--) {
-    __NOP(); // This will burn some cycles
+static void ws2812b_mark_dirty(uint16_t index) {
+  if (m_dirty_first == MAX_LEDs_in_STRIP) { // Range was empty
+    m_dirty_first = index;
+    m_dirty_last = index;
+  } else if (index < m_dirty_first) {
+    m_dirty_first = index;
+  } else if (index > m_dirty_last) {
+    m_dirty_last = index;
   }
 }
 
 /**
- * @brief Initializes the GPIO pin for the WS2812B LED strip.
+ * @brief Builds the level table for a brightness.
+ *
+ * The frame buffer level is scaled before the gamma curve, so dimming is perceptually even.
  *
- * This function configures the specified pin as an output and sets it low initially.
+ * @param brightness Brightness, 255 is full brightness.
  */
-void gpio_init(void) {
-  NRF_GPIO->DIRSET = (1 << WS2812B_PIN); // Configure the pin as output
-  NRF_GPIO->OUTCLR = (1 << WS2812B_PIN); // Set the pin low initially
+static void ws2812b_build_levels(uint8_t brightness) {
+  for (uint16_t i = 0; i < 256; i++) {
+    m_levels[i] = m_gamma[(i * (brightness + 1)) >> 8]; // 8.8 fixed point scale, exact at 0 and 255
+  }
+  m_levels_brightness = brightness;
 }
 
 /**
- * @brief Sends a high signal to the WS2812B LED strip.
+ * @brief Estimates the current the strip draws while showing the frame buffer.
  *
- * This function sets the specified pin high, waits for a long period, and then sets it low, waits for a short period.
+ * @param brightness Brightness the frame is encoded with.
+ * @return Current in uA.
  */
-void send_high(void) {
-  NRF_GPIO->OUTSET = (1 << WS2812B_PIN); // Set the pin high
-  nrf_delay_us_ticks(2);                 // Wait ~800 ns
-  NRF_GPIO->OUTCLR = (1 << WS2812B_PIN); // Set the pin low
-  nrf_delay_us_ticks(0);                 // Wait ~450 ns
+static uint32_t ws2812b_estimate_ua(uint8_t brightness) {
+  uint32_t level_sum = 0;
+
+  for (uint16_t i = 0; i < MAX_LEDs_in_STRIP; i++) {
+    for (uint8_t c = 0; c < 3; c++) {
+      level_sum += m_gamma[(m_pixels[i][c] * (brightness + 1)) >> 8]; // Output level, as in ws2812b_build_levels
+    }
+  }
+  return (uint32_t)(((uint64_t)level_sum * WS2812B_CHANNEL_MA * 1000) / 255) + MAX_LEDs_in_STRIP * WS2812B_LED_IDLE_UA;
 }
 
 /**
- * @brief Sends a low signal to the WS2812B LED strip.
+ * @brief Limits the brightness of the next frame to the current budget.
  *
- * This function sets the specified pin high, waits for a short period, and then sets it low, waits for a long period.
+ * The estimate grows with the brightness, so the highest brightness that fits is found by a
+ * binary search. A frame within the budget costs one pass over the frame buffer.
+ *
+ * @param brightness Requested brightness.
+ * @return Highest brightness up to the requested one whose estimate fits the budget.
  */
-void send_low(void) {
-  NRF_GPIO->OUTSET = (1 << WS2812B_PIN); // Set the pin high
-  nrf_delay_us_ticks(0);                 // Wait ~400 ns
-  NRF_GPIO->OUTCLR = (1 << WS2812B_PIN); // Set the pin low
-  nrf_delay_us_ticks(1);                 // Wait ~850 ns
+static uint8_t ws2812b_limit_brightness(uint8_t brightness) {
+  uint32_t budget_ua = m_budget_ma * 1000u;
+  uint8_t low = 0;
+  uint8_t high = brightness;
+
+  m_current_ua = ws2812b_estimate_ua(brightness);
+  if ((m_budget_ma == 0) || (m_current_ua <= budget_ua)) {
+    return brightness;
+  }
+  while (low < high) {
+    uint8_t mid = (uint8_t)((low + high + 1) / 2);
+    if (ws2812b_estimate_ua(mid) <= budget_ua) {
+      low = mid;
+    } else {
+      high = mid - 1;
+    }
+  }
+  m_current_ua = ws2812b_estimate_ua(low); // Above the budget only if the idle current alone is
+  return low;
 }
+
 /**
- * @brief Turns off a specified number of LEDs on the WS2812B LED strip.
+ * @brief Encodes the next LEDs of the running refresh into a half buffer.
  *
- * This function sends low signals to turn off the specified number of LEDs.
+ * The part of the half not needed for LEDs is filled with low periods, which latch the data
+ * once the last LED was sent.
  *
- * @param number_of_leds The number of LEDs to turn off.
+ * @param half Half buffer to fill.
  */
-void switch_off_LEDs(uint8_t number_of_leds) {
-  for (uint8_t j = 0; j < number_of_leds; j++) { // Loop through each LED to turn off
-    for (uint8_t i = 0; i < PACKET_SIZE; i++) {  // Send the low signal for each packet size
-      send_low();                                // Send low signal to the LED
-    }                                            //
-    nrf_delay_us(PACKET_DELAY);                  // Delay between packets
+static void ws2812b_fill_half(uint8_t half) {
+  uint16_t *p_word = m_halves[half];
+  uint16_t *p_end = p_word + WS2812B_STREAM_LEDS * PACKET_SIZE;
+
+  m_half_is_reset[half] = (m_stream_next == m_stream_end);
+  for (uint8_t led = 0; (led < WS2812B_STREAM_LEDS) && (m_stream_next < m_stream_end); led++) {
+    uint8_t const *p_pixel = m_pixels[m_stream_next++];
+    for (uint8_t c = 0; c < 3; c++) {
+      memcpy(p_word, m_symbols[m_levels[p_pixel[m_channel_order[c]]]], sizeof(m_symbols[0])); // 8 compare values per colour
+      p_word += 8;
+    }
+  }
+  while (p_word < p_end) {
+    *p_word++ = WS2812B_PWM_RESET;
+  }
+}
+
+/**
+ * @brief PWM event handler refilling the half buffer that has just been played.
+ *
+ * END_SEQn is signalled once EasyDMA read the last value of half n, while the other half is
+ * being played. A half holding only low periods ends the refresh: by then the data has been
+ * followed by at least WS2812B_STREAM_LEDS * PACKET_SIZE low periods.
+ *
+ * @param event_type PWM event.
+ */
+static void ws2812b_pwm_handler(nrf_drv_pwm_evt_type_t event_type) {
+  uint8_t half;
+
+  if (event_type == NRF_DRV_PWM_EVT_END_SEQ0) {
+    half = 0;
+  } else if (event_type == NRF_DRV_PWM_EVT_END_SEQ1) {
+    half = 1;
+  } else {
+    if (event_type == NRF_DRV_PWM_EVT_STOPPED) {
+      m_streaming = false;
+    }
+    return;
+  }
+  if (m_half_is_reset[half]) {
+    (void)nrf_drv_pwm_stop(&m_pwm, false); // The other half holds low periods as well, stop at the end of the current period
+  } else {
+    ws2812b_fill_half(half);
   }
 }
 
 /**
  * @brief Initializes the WS2812B LED strip.
  *
- * This function initializes the GPIO pin and turns off all LEDs on the strip.
+ * This function initializes the PWM peripheral and turns off all LEDs on the strip.
  */
 void WS2812B_Init(void) {
-  gpio_init();                        // Initialize the GPIO pin
-  switch_off_LEDs(MAX_LEDs_in_STRIP); // Turn off all LEDs on the strip
-  nrf_delay_ms(50);                   // Delay for 50 milliseconds to ensure all LEDs are off
+  nrf_drv_pwm_config_t const config = {
+      .output_pins = {WS2812B_PIN, NRF_DRV_PWM_PIN_NOT_USED, NRF_DRV_PWM_PIN_NOT_USED, NRF_DRV_PWM_PIN_NOT_USED}, // Data line, idle low
+      .irq_priority = WS2812B_IRQ_PRIORITY,
+      .base_clock = NRF_PWM_CLK_16MHz, // 62.5 ns resolution
+      .count_mode = NRF_PWM_MODE_UP,
+      .top_value = WS2812B_PWM_TOP,
+      .load_mode = NRF_PWM_LOAD_COMMON, // One compare value per period
+      .step_mode = NRF_PWM_STEP_AUTO};
+
+  m_brightness = WS2812B_DEFAULT_BRIGHTNESS;
+  m_budget_ma = WS2812B_CURRENT_BUDGET_MA;
+  ws2812b_build_levels(m_brightness);
+  APP_ERROR_CHECK(nrf_drv_pwm_init(&m_pwm, &config, ws2812b_pwm_handler));
+  ws2812b_clear();       // Turn off all LEDs on the strip
+  ws2812b_mark_dirty(0); // Send the whole strip once, its state is unknown after power up
+  ws2812b_mark_dirty(MAX_LEDs_in_STRIP - 1);
+  APP_ERROR_CHECK(ws2812b_show());
+}
+
+/**
+ * @brief Sets the colour of one LED in the frame buffer.
+ *
+ * @param index Index of the LED (0-based).
+ * @param rgb An array containing the RGB values.
+ */
+void ws2812b_set_pixel(uint16_t index, uint8_t const rgb[3]) {
+  uint8_t *p_pixel;
+
+  if (index >= MAX_LEDs_in_STRIP) {
+    return;
+  }
+  p_pixel = m_pixels[index];
+  if ((p_pixel[0] != rgb[0]) || (p_pixel[1] != rgb[1]) || (p_pixel[2] != rgb[2])) {
+    p_pixel[0] = rgb[0];
+    p_pixel[1] = rgb[1];
+    p_pixel[2] = rgb[2];
+    ws2812b_mark_dirty(index);
+  }
 }
 
 /**
- * @brief Sets the color of a single LED on the WS2812B LED strip.
+ * @brief Reads the colour of one LED from the frame buffer.
  *
- * This function sends the RGB color data to a single LED.
+ * @param index Index of the LED (0-based).
+ * @param rgb Receives the RGB values.
+ */
+void ws2812b_get_pixel(uint16_t index, uint8_t rgb[3]) {
+  if (index >= MAX_LEDs_in_STRIP) {
+    return;
+  }
+  rgb[0] = m_pixels[index][0];
+  rgb[1] = m_pixels[index][1];
+  rgb[2] = m_pixels[index][2];
+}
+
+/**
+ * @brief Sets all LEDs in the frame buffer to the same colour.
  *
  * @param rgb An array containing the RGB values.
  */
-void set_LED(uint8_t rgb[3]) {
-  uint8_t curr_val;
-  for (uint8_t j = 0; j < 3; j++) {                              // Loop through RGB values
-    curr_val = (j == 0) ? rgb[1] : ((j == 1) ? rgb[0] : rgb[2]); // Assign the current color value (GRB format)
-    for (uint8_t i = 0; i < 8; i++) {                            // Loop through each bit of the current color value
-      if (curr_val & (1 << (7 - i)))                             // Check if the bit is 1
-        send_high();                                             // Send high signal for bit 1
-      else                                                       //
-        send_low();                                              // Send low signal for bit 0
-    }
+void ws2812b_fill(uint8_t const rgb[3]) {
+  for (uint16_t i = 0; i < MAX_LEDs_in_STRIP; i++) {
+    ws2812b_set_pixel(i, rgb);
   }
-  nrf_delay_us(PACKET_DELAY); // Delay between packets
+}
+
+/**
+ * @brief Sets all LEDs in the frame buffer to off.
+ */
+void ws2812b_clear(void) {
+  uint8_t const off[3] = {0, 0, 0};
+  ws2812b_fill(off);
+}
+
+/**
+ * @brief Sets the brightness of the whole strip.
+ *
+ * The level table is rebuilt by the next ws2812b_show(), so a refresh in progress is not
+ * affected. Marks the whole strip dirty, the frame buffer is not changed.
+ *
+ * @param brightness Brightness, 0 is off and 255 is full brightness.
+ */
+void ws2812b_set_brightness(uint8_t brightness) {
+  if (brightness == m_brightness) {
+    return;
+  }
+  m_brightness = brightness;
+  ws2812b_mark_dirty(0);
+  ws2812b_mark_dirty(MAX_LEDs_in_STRIP - 1);
+}
+
+/**
+ * @brief Returns the brightness of the strip.
+ *
+ * @return Brightness, 0 is off and 255 is full brightness.
+ */
+uint8_t ws2812b_get_brightness(void) {
+  return m_brightness;
+}
+
+/**
+ * @brief Sets the current budget of the strip.
+ *
+ * Marks the whole strip dirty, the next ws2812b_show() applies the budget.
+ *
+ * @param budget_ma Current the strip may draw in mA, 0 removes the limit.
+ */
+void ws2812b_set_current_budget(uint16_t budget_ma) {
+  if (budget_ma == m_budget_ma) {
+    return;
+  }
+  m_budget_ma = budget_ma;
+  ws2812b_mark_dirty(0);
+  ws2812b_mark_dirty(MAX_LEDs_in_STRIP - 1);
+}
+
+/**
+ * @brief Returns the estimated current of the frame sent by the last ws2812b_show().
+ *
+ * @return Current in mA, after the brightness was limited to the budget.
+ */
+uint16_t ws2812b_get_current_ma(void) {
+  return (uint16_t)((m_current_ua + 999) / 1000);
+}
+
+/**
+ * @brief Sends the changed part of the frame buffer to the strip.
+ *
+ * Fills both half buffers and starts a looped playback of them; the PWM handler refills each
+ * half after it was played until the LEDs up to the last changed one and the latch period were
+ * sent. The LEDs behind the dirty range receive nothing and keep their colour, unless the
+ * current budget changes the brightness: then the whole strip is sent with the new levels.
+ *
+ * @return NRF_SUCCESS (also if nothing changed), or NRF_ERROR_BUSY if the previous refresh is
+ *         still running.
+ */
+ret_code_t ws2812b_show(void) {
+  nrf_pwm_sequence_t seq[2];
+  uint8_t brightness;
+
+  if (!ws2812b_is_dirty()) {
+    return NRF_SUCCESS;
+  }
+  if (ws2812b_is_busy()) {
+    return NRF_ERROR_BUSY; // The half buffers are in use
+  }
+  brightness = ws2812b_limit_brightness(m_brightness);
+  if (brightness != m_levels_brightness) {
+    ws2812b_build_levels(brightness);
+    m_dirty_last = MAX_LEDs_in_STRIP - 1; // Every LED changes level, also those behind the changed ones
+  }
+  m_stream_next = 0;
+  m_stream_end = m_dirty_last + 1; // Up to the last changed LED
+  m_dirty_first = MAX_LEDs_in_STRIP;
+  ws2812b_fill_half(0);
+  ws2812b_fill_half(1);
+
+  for (uint8_t half = 0; half < 2; half++) {
+    seq[half].values.p_common = m_halves[half];
+    seq[half].length = WS2812B_STREAM_LEDS * PACKET_SIZE;
+    seq[half].repeats = 0;
+    seq[half].end_delay = 0;
+  }
+  m_streaming = true;
+  (void)nrf_drv_pwm_complex_playback(&m_pwm, &seq[0], &seq[1], 1,
+      NRF_DRV_PWM_FLAG_LOOP | NRF_DRV_PWM_FLAG_SIGNAL_END_SEQ0 | NRF_DRV_PWM_FLAG_SIGNAL_END_SEQ1 | NRF_DRV_PWM_FLAG_NO_EVT_FINISHED); // Plays the halves alternately until the handler stops it
+  return NRF_SUCCESS;
+}
+
+/**
+ * @brief Checks whether pixels changed since the last ws2812b_show().
+ *
+ * @return true if the strip does not show the frame buffer.
+ */
+bool ws2812b_is_dirty(void) {
+  return m_dirty_first != MAX_LEDs_in_STRIP;
+}
+
+/**
+ * @brief Checks whether a refresh is running.
+ *
+ * @return true while the PWM is sending the strip data.
+ */
+bool ws2812b_is_busy(void) {
+  return m_streaming;
+}
+
+/**
+ * @brief Turns off a specified number of LEDs on the WS2812B LED strip.
+ *
+ * This function turns off the first number_of_leds LEDs and updates the strip.
+ *
+ * @param number_of_leds The number of LEDs to turn off.
+ * @return Result of ws2812b_show().
+ */
+ret_code_t switch_off_LEDs(uint8_t number_of_leds) {
+  uint8_t const off[3] = {0, 0, 0};
+
+  for (uint8_t j = 0; j < number_of_leds; j++) {
+    ws2812b_set_pixel(j, off);
+  }
+  return ws2812b_show();
 }
 
 /**
  * @brief Sets the color of a specific LED on the WS2812B LED strip.
  *
- * This function sets the color of the specified LED and turns off the rest.
+ * This function sets the color of the specified LED, turns off the rest and updates the strip.
+ * Only LEDs whose colour changed are sent.
  *
  * @param rgb An array containing the RGB values.
  * @param led_number The index of the LED to set (1-based index).
+ * @return Result of ws2812b_show().
  */
-void set_one_LED(uint8_t rgb[3], uint8_t led_number) {
-  switch_off_LEDs(led_number - 1);                 // Turn off LEDs before the specified LED
-  set_LED(rgb);                                    // Set the color of the specified LED
-  switch_off_LEDs(MAX_LEDs_in_STRIP - led_number); // Turn off LEDs after the specified LED
+ret_code_t set_one_LED(uint8_t rgb[3], uint8_t led_number) {
+  uint8_t const off[3] = {0, 0, 0};
+
+  for (uint16_t i = 0; i < MAX_LEDs_in_STRIP; i++) {
+    ws2812b_set_pixel(i, (i == led_number - 1) ? rgb : off); // Only changed pixels become dirty
+  }
+  return ws2812b_show();
 }
@@ -1,78 +1,204 @@
 #ifndef _WS2812B_H_
 #define _WS2812B_H_
 
-#include "nrf.h"       // Include Nordic Semiconductor's hardware definitions
-#include "nrf_delay.h" // Include Nordic Semiconductor's delay functions
+#include "app_error.h"         // Include Nordic Semiconductor's error codes
+#include "app_util_platform.h" // Include Nordic Semiconductor's interrupt priorities
+#include "nrf.h"               // Include Nordic Semiconductor's hardware definitions
+#include "nrf_drv_pwm.h"       // Include Nordic Semiconductor's PWM driver
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @file WS2812B.h
+ * @brief WS2812B LED strip driven by the PWM peripheral.
+ *
+ * Every bit of the strip is one PWM period of 1.25 us (16 MHz / WS2812B_PWM_TOP) whose duty
+ * cycle encodes a 0 or a 1. The colours are encoded into PWM compare values which EasyDMA
+ * plays back on its own, followed by low periods latching the data, so the bit timing is not
+ * disturbed by SoftDevice interrupts. Requires PWM_ENABLED and PWM0_ENABLED in sdk_config.h.
+ *
+ * The strip is streamed through two half buffers of WS2812B_STREAM_LEDS LEDs each: while one
+ * half is played the PWM interrupt encodes the next LEDs into the other one, so the RAM needed
+ * is 3 bytes per LED plus a fixed 2 * WS2812B_STREAM_LEDS * 48 bytes, independent of the strip
+ * length. Each half takes WS2812B_STREAM_LEDS * 30 us to play, the PWM interrupt must be served
+ * within that time (SoftDevice radio events included) or the strip shows stale data until the
+ * next refresh.
+ *
+ * The application draws into a pixel frame buffer (ws2812b_set_pixel, ws2812b_fill) which can
+ * be changed at any time, also while a refresh is running. Pixels whose colour actually changed
+ * are tracked as a dirty range; ws2812b_show() sends the strip up to the last changed LED in one
+ * transfer (the LEDs behind it keep their colour), or nothing at all if no pixel changed.
+ *
+ * Brightness and gamma correction are applied while encoding through a 256 entry level table,
+ * so a fade only changes the brightness and the frame buffer keeps the full colour levels.
+ *
+ * Each ws2812b_show() estimates the current the strip will draw from the frame buffer (every
+ * colour channel draws WS2812B_CHANNEL_MA at full output level, every LED WS2812B_LED_IDLE_UA
+ * on top) and lowers the brightness of that frame until the estimate fits the current budget,
+ * so a white frame cannot brown out the supply.
+ */
 
 // Define constants for WS2812B LED strip
-#define WS2812B_PIN 17       ///< GPIO pin connected to the WS2812B data line
+#define WS2812B_PIN 17 ///< GPIO pin connected to the WS2812B data line
+#define PACKET_SIZE 24 ///< Number of bits per LED (8 bits for each color: R, G, B)
+
+#ifndef MAX_LEDs_in_STRIP
 #define MAX_LEDs_in_STRIP 12 ///< Maximum number of LEDs in the strip
-#define PACKET_SIZE 24       ///< Number of bits per LED (8 bits for each color: R, G, B)
-#define PACKET_DELAY 10      ///< Delay between packets in microseconds
+#endif
+
+#ifndef WS2812B_STREAM_LEDS
+#define WS2812B_STREAM_LEDS 8 ///< LEDs encoded per half buffer; a half of low periods latches the data (30 us per LED, 240 us for 8), so at least 2 for the 50 us the LEDs need
+#endif
+
+#ifndef WS2812B_IRQ_PRIORITY
+#define WS2812B_IRQ_PRIORITY APP_IRQ_PRIORITY_HIGH ///< PWM interrupt refilling the half buffers
+#endif
+
+#define WS2812B_PWM_INSTANCE 0         ///< PWM instance driving the data line
+#define WS2812B_PWM_TOP 20             ///< 16 MHz / 20 = 800 kHz bit rate
+#define WS2812B_PWM_T0H (0x8000 | 6)   ///< 0 bit: 375 ns high, POLARITY bit set so the period starts high
+#define WS2812B_PWM_T1H (0x8000 | 13)  ///< 1 bit: 812 ns high
+#define WS2812B_PWM_RESET (0x8000 | 0) ///< Period kept low
+
+#ifndef WS2812B_GAMMA_ENABLED
+#define WS2812B_GAMMA_ENABLED 1 ///< Apply gamma 2.8 correction to the frame buffer colours when encoding
+#endif
+
+#ifndef WS2812B_DEFAULT_BRIGHTNESS
+#define WS2812B_DEFAULT_BRIGHTNESS 255 ///< Brightness set by WS2812B_Init
+#endif
+
+#ifndef WS2812B_CURRENT_BUDGET_MA
+#define WS2812B_CURRENT_BUDGET_MA 300 ///< Current the strip may draw, set by WS2812B_Init (0: no limit)
+#endif
+
+#define WS2812B_CHANNEL_MA 20    ///< Current of one colour channel at full output level
+#define WS2812B_LED_IDLE_UA 1000 ///< Current of one LED with all channels off
+
+#ifndef WS2812B_CHANNEL_ORDER
+#define WS2812B_CHANNEL_ORDER {1, 0, 2} ///< Frame buffer channels (0 red, 1 green, 2 blue) in the order the LEDs expect: GRB
+#endif
+
+/**
+ * @brief Initializes the WS2812B LED strip.
+ *
+ * This function initializes the PWM peripheral and turns off all LEDs on the strip.
+ */
+void WS2812B_Init(void);
 
 /**
- * @brief Delays execution for a specified number of ticks.
+ * @brief Sets the colour of one LED in the frame buffer.
  *
- * This function uses a loop of no-operation instructions to create a delay for the given number of ticks.
+ * The strip is updated by the next ws2812b_show(). Setting the colour the LED already has
+ * does not mark it dirty.
  *
- * @param ticks The number of ticks to delay.
+ * @param index Index of the LED (0-based).
+ * @param rgb An array containing the RGB values.
  */
-void nrf_delay_us_ticks(uint32_t ticks);
+void ws2812b_set_pixel(uint16_t index, uint8_t const rgb[3]);
 
 /**
- * @brief Initializes the GPIO pin for the WS2812B LED strip.
+ * @brief Reads the colour of one LED from the frame buffer.
  *
- * This function configures the specified pin as an output and sets it low initially.
+ * @param index Index of the LED (0-based).
+ * @param rgb Receives the RGB values.
  */
-void gpio_init(void);
+void ws2812b_get_pixel(uint16_t index, uint8_t rgb[3]);
 
 /**
- * @brief Sends a high signal to the WS2812B LED strip.
+ * @brief Sets all LEDs in the frame buffer to the same colour.
  *
- * This function sets the specified pin high, waits for a short period, and then sets it low.
+ * @param rgb An array containing the RGB values.
  */
-void send_high(void);
+void ws2812b_fill(uint8_t const rgb[3]);
 
 /**
- * @brief Sends a low signal to the WS2812B LED strip.
+ * @brief Sets all LEDs in the frame buffer to off.
+ */
+void ws2812b_clear(void);
+
+/**
+ * @brief Sets the brightness of the whole strip.
+ *
+ * Takes effect with the next ws2812b_show(), the frame buffer is not changed.
  *
- * This function sets the specified pin high, waits for a short period, and then sets it low.
+ * @param brightness Brightness, 0 is off and 255 is full brightness.
  */
-void send_low(void);
+void ws2812b_set_brightness(uint8_t brightness);
 
 /**
- * @brief Turns off a specified number of LEDs on the WS2812B LED strip.
+ * @brief Returns the brightness of the strip.
  *
- * This function sends low signals to turn off the specified number of LEDs.
+ * @return Brightness, 0 is off and 255 is full brightness.
+ */
+uint8_t ws2812b_get_brightness(void);
+
+/**
+ * @brief Sets the current budget of the strip.
  *
- * @param number_of_leds The number of LEDs to turn off.
+ * Takes effect with the next ws2812b_show(), which sends the whole strip.
+ *
+ * @param budget_ma Current the strip may draw in mA, 0 removes the limit.
  */
-void switch_off_LEDs(uint8_t number_of_leds);
+void ws2812b_set_current_budget(uint16_t budget_ma);
 
 /**
- * @brief Initializes the WS2812B LED strip.
+ * @brief Returns the estimated current of the frame sent by the last ws2812b_show().
  *
- * This function initializes the GPIO pin and turns off all LEDs on the strip.
+ * @return Current in mA, after the brightness was limited to the budget.
  */
-void WS2812B_Init(void);
+uint16_t ws2812b_get_current_ma(void);
 
 /**
- * @brief Sets the color of a specific LED on the WS2812B LED strip.
+ * @brief Sends the changed part of the frame buffer to the strip.
  *
- * This function sets the color of the specified LED and turns off the rest.
+ * Starts one transfer covering the LEDs up to the last changed one, or the whole strip if the
+ * current budget changes the brightness of the frame. Returns immediately, the
+ * transfer is streamed from the PWM interrupt and takes about
+ * (last changed LED + 1 + 2 * WS2812B_STREAM_LEDS) * 30 us.
  *
- * @param rgb An array containing the RGB values.
- * @param led_number The index of the LED to set (1-based index).
+ * @return NRF_SUCCESS (also if nothing changed), or NRF_ERROR_BUSY if the previous refresh is
+ *         still running; the changes are kept and sent by a later call.
+ */
+ret_code_t ws2812b_show(void);
+
+/**
+ * @brief Checks whether pixels changed since the last ws2812b_show().
+ *
+ * @return true if the strip does not show the frame buffer.
+ */
+bool ws2812b_is_dirty(void);
+
+/**
+ * @brief Checks whether a refresh is running.
+ *
+ * @return true while the PWM is sending the buffer.
+ */
+bool ws2812b_is_busy(void);
+
+/**
+ * @brief Turns off a specified number of LEDs on the WS2812B LED strip.
+ *
+ * This function turns off the first number_of_leds LEDs and updates the strip with
+ * ws2812b_show(), without waiting for a running refresh.
+ *
+ * @param number_of_leds The number of LEDs to turn off.
+ * @return NRF_SUCCESS, or NRF_ERROR_BUSY if the previous refresh is still running; the change is
+ *         kept and sent by a later ws2812b_show().
  */
-void set_one_LED(uint8_t rgb[3], uint8_t led_number);
+ret_code_t switch_off_LEDs(uint8_t number_of_leds);
 
 /**
- * @brief Sets the color of a single LED on the WS2812B LED strip.
+ * @brief Sets the color of a specific LED on the WS2812B LED strip.
  *
- * This function sends the RGB color data to a single LED.
+ * This function sets the color of the specified LED, turns off the rest and updates the strip
+ * with ws2812b_show(), without waiting for a running refresh.
  *
  * @param rgb An array containing the RGB values.
+ * @param led_number The index of the LED to set (1-based index).
+ * @return NRF_SUCCESS, or NRF_ERROR_BUSY if the previous refresh is still running; the change is
+ *         kept and sent by a later ws2812b_show().
  */
-void set_LED(uint8_t rgb[3]);
+ret_code_t set_one_LED(uint8_t rgb[3], uint8_t led_number);
 
 #endif // _WS2812B_H_
@@ -0,0 +1,145 @@
+#include "WS2812B_Anim.h"
+
+APP_TIMER_DEF(m_frame_timer); // Renders one frame per expiry
+
+static ws2812b_anim_t m_anim;           // Running animation
+static uint32_t m_frame;                // Frames rendered since the animation started
+static volatile uint8_t m_input;        // Input level of the REACTIVE effect
+static uint16_t m_blend;                // REACTIVE: displayed level in 8.8 fixed point, follows m_input
+static volatile bool m_running = false; // Set while the frame timer runs
+
+/**
+ * @brief Renders the frame of the running animation.
+ *
+ * @param time_ms Time since the animation started.
+ */
+static void anim_render(uint32_t time_ms) {
+  uint8_t const off[3] = {0, 0, 0};
+  uint32_t phase;
+  int32_t step;
+  uint8_t rgb[3];
+
+  switch (m_anim.effect) {
+  case WS2812B_ANIM_SOLID:
+    ws2812b_fill(m_anim.color);
+    ws2812b_set_brightness(m_anim.brightness);
+    break;
+
+  case WS2812B_ANIM_CHASE:
+    phase = time_ms % m_anim.period_ms;
+    for (uint16_t i = 0; i < MAX_LEDs_in_STRIP; i++) {
+      ws2812b_set_pixel(i, (i == phase * MAX_LEDs_in_STRIP / m_anim.period_ms) ? m_anim.color : off); // Only the LEDs that change are sent
+    }
+    ws2812b_set_brightness(m_anim.brightness);
+    break;
+
+  case WS2812B_ANIM_BREATHE:
+    phase = (time_ms % m_anim.period_ms) * 512 / m_anim.period_ms; // 0..511 over one period
+    if (phase > 255) {
+      phase = 511 - phase; // Triangle, gamma correction makes it look smooth
+    }
+    ws2812b_fill(m_anim.color);
+    ws2812b_set_brightness(phase * m_anim.brightness / 255); // A fade is a brightness change, the frame buffer stays the same
+    break;
+
+  case WS2812B_ANIM_REACTIVE:
+    step = (int32_t)(m_input << 8) - m_blend;
+    m_blend += ((step > -4) && (step < 4)) ? step : step / 4; // First order lag of about 4 frames, the last counts are taken at once
+    for (uint8_t c = 0; c < 3; c++) {
+      rgb[c] = m_anim.color[c] + (((int16_t)m_anim.color2[c] - m_anim.color[c]) * (m_blend >> 8)) / 255;
+    }
+    ws2812b_fill(rgb);
+    ws2812b_set_brightness(m_anim.brightness);
+    break;
+
+  default:
+    ws2812b_clear();
+    break;
+  }
+}
+
+/**
+ * @brief app_timer handler rendering and sending one frame.
+ *
+ * @param p_context Unused.
+ */
+static void anim_frame_handler(void *p_context) {
+  anim_render(m_frame * WS2812B_ANIM_FRAME_MS);
+  m_frame++;
+  (void)ws2812b_show(); // NRF_ERROR_BUSY only if the previous frame is still being sent, the changes go out with the next frame
+}
+
+/**
+ * @brief Creates the frame timer.
+ *
+ * @return NRF_SUCCESS, or an error code from app_timer.
+ */
+ret_code_t ws2812b_anim_init(void) {
+  return app_timer_create(&m_frame_timer, APP_TIMER_MODE_REPEATED, anim_frame_handler);
+}
+
+/**
+ * @brief Starts an animation, replacing the running one.
+ *
+ * @param p_anim Animation, copied by the engine.
+ * @return NRF_SUCCESS, NRF_ERROR_INVALID_PARAM if a period is missing, or an error code from app_timer.
+ */
+ret_code_t ws2812b_anim_start(ws2812b_anim_t const *p_anim) {
+  ret_code_t err_code;
+
+  if (((p_anim->effect == WS2812B_ANIM_CHASE) || (p_anim->effect == WS2812B_ANIM_BREATHE)) && (p_anim->period_ms == 0)) {
+    return NRF_ERROR_INVALID_PARAM;
+  }
+  ws2812b_anim_stop();
+  m_anim = *p_anim;
+  m_frame = 0;
+  m_blend = m_input << 8;   // Start at the current input instead of fading in
+  anim_frame_handler(NULL); // First frame now
+
+  err_code = app_timer_start(m_frame_timer, APP_TIMER_TICKS(WS2812B_ANIM_FRAME_MS), NULL);
+  if (err_code == NRF_SUCCESS) {
+    m_running = true;
+  }
+  return err_code;
+}
+
+/**
+ * @brief Stops the animation, the LEDs keep the last frame.
+ */
+void ws2812b_anim_stop(void) {
+  if (m_running) {
+    (void)app_timer_stop(m_frame_timer);
+    m_running = false;
+  }
+}
+
+/**
+ * @brief Changes the colour of the running animation.
+ *
+ * @param rgb An array containing the RGB values, used from the next frame.
+ */
+void ws2812b_anim_set_color(uint8_t const rgb[3]) {
+  CRITICAL_REGION_ENTER();
+  m_anim.color[0] = rgb[0]; // Consistent colour, the frame handler may interrupt
+  m_anim.color[1] = rgb[1];
+  m_anim.color[2] = rgb[2];
+  CRITICAL_REGION_EXIT();
+}
+
+/**
+ * @brief Sets the input level of the REACTIVE effect.
+ *
+ * @param level 0 shows color, 255 shows color2.
+ */
+void ws2812b_anim_set_input(uint8_t level) {
+  m_input = level;
+}
+
+/**
+ * @brief Checks whether an animation is running.
+ *
+ * @return true if the frame timer is running.
+ */
+bool ws2812b_anim_is_running(void) {
+  return m_running;
+}
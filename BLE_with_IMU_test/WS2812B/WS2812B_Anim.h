@@ -0,0 +1,91 @@
+#ifndef _WS2812B_ANIM_H_
+#define _WS2812B_ANIM_H_
+
+#include "WS2812B.h"
+#include "app_timer.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @file WS2812B_Anim.h
+ * @brief LED animations rendered from an app_timer at a fixed frame rate.
+ *
+ * Every WS2812B_ANIM_FRAME_MS the app_timer handler renders the current effect into the
+ * WS2812B frame buffer and starts ws2812b_show(), so animation timing does not depend on the
+ * main loop and the strip refresh itself runs on PWM and EasyDMA. While an animation runs the
+ * engine owns the frame buffer and the brightness; the application only changes the effect,
+ * its colours or the reactive input through the functions below.
+ *
+ * app_timer must be initialized before ws2812b_anim_init() is called.
+ */
+
+#define WS2812B_ANIM_FRAME_MS 20 ///< Frame period (50 frames per second)
+
+/**
+ * @brief Animation effects.
+ */
+typedef enum {
+  WS2812B_ANIM_OFF = 0, /**< All LEDs off */
+  WS2812B_ANIM_SOLID,   /**< All LEDs in color */
+  WS2812B_ANIM_CHASE,   /**< One LED in color moving along the strip, once per period */
+  WS2812B_ANIM_BREATHE, /**< All LEDs in color, brightness rising and falling once per period */
+  WS2812B_ANIM_REACTIVE /**< All LEDs blending from color to color2 with the input level (ws2812b_anim_set_input) */
+} ws2812b_anim_effect_t;
+
+/**
+ * @brief Animation description.
+ */
+typedef struct {
+  ws2812b_anim_effect_t effect; /**< Effect */
+  uint8_t color[3];             /**< RGB colour of the effect */
+  uint8_t color2[3];            /**< REACTIVE: RGB colour at the highest input level */
+  uint16_t period_ms;           /**< CHASE, BREATHE: duration of one cycle */
+  uint8_t brightness;           /**< Strip brightness, peak brightness of BREATHE */
+} ws2812b_anim_t;
+
+/**
+ * @brief Creates the frame timer.
+ *
+ * WS2812B_Init() must have been called before.
+ *
+ * @return NRF_SUCCESS, or an error code from app_timer.
+ */
+ret_code_t ws2812b_anim_init(void);
+
+/**
+ * @brief Starts an animation, replacing the running one.
+ *
+ * @param p_anim Animation, copied by the engine.
+ * @return NRF_SUCCESS, NRF_ERROR_INVALID_PARAM if a period is missing, or an error code from app_timer.
+ */
+ret_code_t ws2812b_anim_start(ws2812b_anim_t const *p_anim);
+
+/**
+ * @brief Stops the animation, the LEDs keep the last frame.
+ */
+void ws2812b_anim_stop(void);
+
+/**
+ * @brief Changes the colour of the running animation.
+ *
+ * @param rgb An array containing the RGB values, used from the next frame.
+ */
+void ws2812b_anim_set_color(uint8_t const rgb[3]);
+
+/**
+ * @brief Sets the input level of the REACTIVE effect.
+ *
+ * The displayed colour follows the level smoothly, so a noisy input does not flicker.
+ *
+ * @param level 0 shows color, 255 shows color2.
+ */
+void ws2812b_anim_set_input(uint8_t level);
+
+/**
+ * @brief Checks whether an animation is running.
+ *
+ * @return true if the frame timer is running.
+ */
+bool ws2812b_anim_is_running(void);
+
+#endif // _WS2812B_ANIM_H_
@@ -0,0 +1,52 @@
+#ifndef _BENCH_H_
+#define _BENCH_H_
+
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+/**
+ * @file bench.h
+ * @brief Check bookkeeping and host timing shared by the bench programs.
+ *
+ * Each bench is a program of its own and includes this header once, from the file holding
+ * its main().
+ */
+
+static uint32_t m_checks;   // Checks executed
+static uint32_t m_failures; // Checks failed
+
+/**
+ * @brief Records the result of a check and prints failed checks.
+ */
+#define CHECK(cond)                                          \
+  do {                                                       \
+    m_checks++;                                              \
+    if (!(cond)) {                                           \
+      m_failures++;                                          \
+      printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+    }                                                        \
+  } while (0)
+
+/**
+ * @brief Returns the host monotonic time.
+ *
+ * @return Time in nanoseconds.
+ */
+static inline uint64_t bench_host_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+/**
+ * @brief Prints the check summary.
+ *
+ * @return Exit status of the bench: 0 if every check passed, otherwise 1.
+ */
+static inline int bench_result(void) {
+  printf("%u checks, %u failed\n", m_checks, m_failures);
+  return (m_failures == 0) ? 0 : 1;
+}
+
+#endif // _BENCH_H_
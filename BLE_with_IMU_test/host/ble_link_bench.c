@@ -0,0 +1,73 @@
+#include "ICM20948_Sampler.h"
+#include "Sample_Batch.h"
+#include "Sample_Frame.h"
+#include "bench.h"
+#include "ble_link_model.h"
+#include <stdio.h>
+
+/**
+ * @file ble_link_bench.c
+ * @brief Notification throughput of the connection settings, from the air-time model of ble_link_model.c.
+ *
+ * Compares the settings the firmware used before the throughput profile (1 Mbps PHY, 20 ms
+ * interval, 7.5 ms event length, one queued notification) with the profile of Ble_UART.h and
+ * sdk_config.h, one change at a time, against the data rate of the IMU sample stream. The
+ * low-power profile used while the device is still must carry the decimated stream; its
+ * interval is too long for the SAMPLE_BATCH_LATENCY_US deadline of the full one, which switches
+ * back to the low-latency profile. Exits with a non-zero status if a check fails.
+ */
+
+#define BENCH_SAMPLE_RATE (1000000 / IMU_SAMPLER_MIN_PERIOD_US) // IMU samples per second (IMU_SAMPLE_PERIOD_US in main.c)
+#define BENCH_STILL_SAMPLE_RATE 10                               // IMU samples per second while still (STILL_SAMPLE_PERIOD_MS in main.c)
+
+/**
+ * @brief A named set of connection parameters.
+ */
+typedef struct {
+  char const *p_name;       ///< Description
+  ble_link_params_t params; ///< Connection parameters
+} bench_scenario_t;
+
+static bench_scenario_t const m_scenarios[] = {
+    {"before: 1M PHY, 20 ms, 7.5 ms event, queue 1", {1, 251, 247, 20000, 7500, false, 1}},
+    {"+ 2M PHY", {2, 251, 247, 20000, 7500, false, 1}},
+    {"+ HVN TX queue 10", {2, 251, 247, 20000, 7500, false, 10}},
+    {"+ 15 ms event length, extension", {2, 251, 247, 20000, 15000, true, 10}},
+    {"+ 7.5 ms interval (profile, minimum)", {2, 251, 247, 7500, 15000, true, 10}},
+    {"profile at the 15 ms maximum interval", {2, 251, 247, 15000, 15000, true, 10}},
+    {"profile at the default MTU 23, data length 27", {2, 27, 23, 7500, 15000, true, 10}},
+    {"low-power profile at the 200 ms maximum", {2, 251, 247, 200000, 15000, true, 10}},
+};
+
+#define BENCH_SCENARIOS (sizeof(m_scenarios) / sizeof(m_scenarios[0]))
+
+int main(void) {
+  ble_link_result_t results[BENCH_SCENARIOS];
+  uint32_t stream_kbps = BENCH_SAMPLE_RATE * SAMPLE_FRAME_SIZE(SAMPLE_FRAME_ACCEL_GYRO_LEN) * 8 / 1000;
+  uint32_t still_bps = BENCH_STILL_SAMPLE_RATE * SAMPLE_FRAME_SIZE(SAMPLE_FRAME_ACCEL_GYRO_LEN) * 8;
+
+  CHECK(ble_link_pdu_us(1, 27) == 296); // 37 bytes at 1 Mbps
+  CHECK(ble_link_pdu_us(1, 251) == 2088);
+  CHECK(ble_link_pdu_us(2, 251) == 1048);
+
+  for (uint8_t i = 0; i < BENCH_SCENARIOS; i++) {
+    ble_link_model_evaluate(&m_scenarios[i].params, &results[i]);
+    printf("%-48s %5u kbps, %2u PDUs per event, %4u notifications/s\n", m_scenarios[i].p_name,
+        results[i].kbps, results[i].pdus_per_event, results[i].notifications_per_s);
+  }
+  printf("IMU stream at %u samples/s needs %u kbps, %u bps while still\n", BENCH_SAMPLE_RATE, stream_kbps, still_bps);
+
+  CHECK(results[0].pdus_per_event == 1);                              // The queue of one notification limits every event
+  CHECK(results[0].notifications_per_s < BENCH_SAMPLE_RATE);          // The old firmware sent a notification per sample
+  CHECK(results[4].kbps > 10 * results[0].kbps);                      // The profile at the minimum interval
+  CHECK(results[5].pdus_per_event == 10);                             // The queue fills a 15 ms event
+  CHECK(results[5].kbps > stream_kbps * 5);                           // Headroom at the maximum interval
+  CHECK(results[6].pdus_per_notification == 1);                       // 27 byte packets
+  CHECK(results[7].kbps * 1000 > still_bps);                          // The low-power profile carries the decimated stream
+  CHECK(m_scenarios[7].params.interval_us > SAMPLE_BATCH_LATENCY_US); // but not within the deadline of the full one
+  for (uint8_t i = 1; i <= 4; i++) { // Every change of the profile helps
+    CHECK(results[i].kbps >= results[i - 1].kbps);
+  }
+
+  return bench_result();
+}
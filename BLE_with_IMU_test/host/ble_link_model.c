@@ -0,0 +1,48 @@
+#include "ble_link_model.h"
+#include <string.h>
+
+#define BLE_LINK_PDU_OVERHEAD 9 // Access address, header and CRC bytes
+#define BLE_LINK_ATT_OVERHEAD 3 // Opcode and handle of a notification
+#define BLE_LINK_L2CAP_HEADER 4 // Length and channel ID
+
+/**
+ * @brief Returns the air time of one link layer PDU.
+ *
+ * @param phy_mbps PHY, 1 or 2 Mbps.
+ * @param payload Payload bytes.
+ * @return Air time in microseconds.
+ */
+uint32_t ble_link_pdu_us(uint8_t phy_mbps, uint16_t payload) {
+  uint32_t bytes = phy_mbps + BLE_LINK_PDU_OVERHEAD + payload; // The preamble is one byte per Mbps
+
+  return bytes * 8 / phy_mbps;
+}
+
+/**
+ * @brief Computes the notification throughput of a connection.
+ *
+ * @param p_params Connection parameters.
+ * @param p_result Receives the throughput figures.
+ */
+void ble_link_model_evaluate(ble_link_params_t const *p_params, ble_link_result_t *p_result) {
+  uint32_t l2cap = p_params->att_mtu + BLE_LINK_L2CAP_HEADER;
+  uint32_t event_us = p_params->event_extension ? p_params->interval_us : p_params->event_length_us;
+
+  memset(p_result, 0, sizeof(*p_result));
+  if (event_us > p_params->interval_us) {
+    event_us = p_params->interval_us;
+  }
+  p_result->notification_len = p_params->att_mtu - BLE_LINK_ATT_OVERHEAD;
+  p_result->pdus_per_notification = (l2cap + p_params->data_length - 1) / p_params->data_length;
+  p_result->exchange_us = ble_link_pdu_us(p_params->phy_mbps, 0) + BLE_LINK_T_IFS_US +
+                          ble_link_pdu_us(p_params->phy_mbps, p_params->data_length) + BLE_LINK_T_IFS_US;
+
+  uint32_t pdus = event_us / p_result->exchange_us;
+  uint32_t queued = (uint32_t)p_params->hvn_queue * p_result->pdus_per_notification;
+  p_result->pdus_per_event = (pdus < queued) ? pdus : queued;
+
+  uint64_t pdus_per_s = (uint64_t)p_result->pdus_per_event * 1000000 / p_params->interval_us;
+  p_result->notifications_per_s = (uint32_t)(pdus_per_s / p_result->pdus_per_notification);
+  p_result->kbps = (uint32_t)((uint64_t)p_result->pdus_per_event * p_result->notification_len * 8 * 1000 /
+                              ((uint64_t)p_result->pdus_per_notification * p_params->interval_us));
+}
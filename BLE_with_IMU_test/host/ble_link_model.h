@@ -0,0 +1,70 @@
+#ifndef _BLE_LINK_MODEL_H_
+#define _BLE_LINK_MODEL_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @file ble_link_model.h
+ * @brief Air-time model of notification throughput on one BLE connection.
+ *
+ * A notification of att_mtu - 3 bytes travels as an L2CAP packet of att_mtu + 4 bytes, split
+ * into link layer PDUs of at most data_length bytes. Every PDU of the peripheral answers an
+ * empty PDU of the central, each exchange taking
+ *
+ *   empty PDU + T_IFS + data PDU + T_IFS
+ *
+ * with a PDU lasting (preamble + access address 4 + header 2 + payload + CRC 3) bytes at the
+ * PHY rate (preamble 1 byte at 1 Mbps, 2 bytes at 2 Mbps). A connection event lasts the
+ * configured event length, or the whole connection interval with event length extension,
+ * and carries as many exchanges as fit, but no more notifications than the SoftDevice queue
+ * holds: the application refills it on BLE_GATTS_EVT_HVN_TX_COMPLETE, which arrives after the
+ * event. Retransmissions and other links are not modelled, so the figures are upper bounds
+ * for a clean channel.
+ */
+
+#define BLE_LINK_T_IFS_US 150 ///< Inter frame space
+
+/**
+ * @brief Parameters of a connection.
+ */
+typedef struct {
+  uint8_t phy_mbps;         ///< PHY, 1 or 2 Mbps
+  uint16_t data_length;     ///< Link layer payload, 27 .. 251 bytes
+  uint16_t att_mtu;         ///< ATT MTU, 23 .. 247 bytes
+  uint32_t interval_us;     ///< Connection interval
+  uint32_t event_length_us; ///< Time set aside per connection event (NRF_SDH_BLE_GAP_EVENT_LENGTH)
+  bool event_extension;     ///< Events run on up to the next interval while data is pending
+  uint8_t hvn_queue;        ///< Notifications the SoftDevice holds (hvn_tx_queue_size)
+} ble_link_params_t;
+
+/**
+ * @brief Throughput figures of a connection.
+ */
+typedef struct {
+  uint16_t notification_len;      ///< Application bytes per notification
+  uint8_t pdus_per_notification;  ///< Link layer PDUs per notification
+  uint32_t exchange_us;           ///< Air time of one full-length PDU exchange
+  uint32_t pdus_per_event;        ///< PDUs sent per connection event
+  uint32_t notifications_per_s;   ///< Notifications per second
+  uint32_t kbps;                  ///< Application data rate in kbit/s
+} ble_link_result_t;
+
+/**
+ * @brief Returns the air time of one link layer PDU.
+ *
+ * @param phy_mbps PHY, 1 or 2 Mbps.
+ * @param payload Payload bytes.
+ * @return Air time in microseconds.
+ */
+uint32_t ble_link_pdu_us(uint8_t phy_mbps, uint16_t payload);
+
+/**
+ * @brief Computes the notification throughput of a connection.
+ *
+ * @param p_params Connection parameters.
+ * @param p_result Receives the throughput figures.
+ */
+void ble_link_model_evaluate(ble_link_params_t const *p_params, ble_link_result_t *p_result);
+
+#endif // _BLE_LINK_MODEL_H_
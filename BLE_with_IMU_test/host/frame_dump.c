@@ -0,0 +1,116 @@
+#include "sample_decoder.h"
+#include <ctype.h>
+#include <stdio.h>
+#include <string.h>
+
+/**
+ * @file frame_dump.c
+ * @brief Decodes a recorded BLE UART stream of sample frames (Sample_Frame.h) into CSV.
+ *
+ * Reads the stream from stdin, either as raw bytes or, with --hex, as hexadecimal text as
+ * copied from a BLE terminal log (whitespace, '-' and ':' between bytes are ignored). Writes
+ * one line per frame, and one accel_gyro line per sample of a SAMPLE_FRAME_ACCEL_GYRO_BLOCK frame
+ * (all with the sequence number of the block), to stdout:
+ *
+ *   sequence,timestamp_us,accel_gyro,ax,ay,az,gx,gy,gz
+ *   sequence,timestamp_us,proximity,counts,close
+ *   sequence,timestamp_us,quaternion,w,x,y,z
+ *   sequence,timestamp_us,load_cell,counts
+ *
+ * and the decoder counters to stderr.
+ */
+
+/**
+ * @brief Prints a frame as a CSV line, signature of sample_decoder_handler_t.
+ *
+ * @param p_context Unused.
+ * @param p_frame Received frame.
+ */
+static void dump_frame(void *p_context, sample_decoder_frame_t const *p_frame) {
+  sample_decoder_imu_t samples[SAMPLE_DECODER_BLOCK_MAX];
+  int16_t accel[3], gyro[3];
+  int16_t quaternion[4];
+  uint16_t proximity;
+  int32_t counts;
+  bool close;
+  uint8_t count = sample_decoder_accel_gyro_block(p_frame, samples, SAMPLE_DECODER_BLOCK_MAX);
+
+  for (uint8_t i = 0; i < count; i++) {
+    sample_decoder_imu_t const *p_sample = &samples[i];
+
+    printf("%u,%u,accel_gyro,%d,%d,%d,%d,%d,%d\n", p_frame->sequence, p_sample->timestamp_us, p_sample->accel[0],
+        p_sample->accel[1], p_sample->accel[2], p_sample->gyro[0], p_sample->gyro[1], p_sample->gyro[2]);
+  }
+  if (count > 0) {
+    return;
+  }
+  printf("%u,%u,", p_frame->sequence, p_frame->timestamp_us);
+  if (sample_decoder_accel_gyro(p_frame, accel, gyro)) {
+    printf("accel_gyro,%d,%d,%d,%d,%d,%d\n", accel[0], accel[1], accel[2], gyro[0], gyro[1], gyro[2]);
+  } else if (sample_decoder_proximity(p_frame, &proximity, &close)) {
+    printf("proximity,%u,%u\n", proximity, close);
+  } else if (sample_decoder_quaternion(p_frame, quaternion)) {
+    printf("quaternion,%.4f,%.4f,%.4f,%.4f\n", quaternion[0] / (double)SAMPLE_FRAME_QUATERNION_ONE,
+        quaternion[1] / (double)SAMPLE_FRAME_QUATERNION_ONE, quaternion[2] / (double)SAMPLE_FRAME_QUATERNION_ONE,
+        quaternion[3] / (double)SAMPLE_FRAME_QUATERNION_ONE);
+  } else if (sample_decoder_load_cell(p_frame, &counts)) {
+    printf("load_cell,%d\n", counts);
+  } else {
+    printf("type%u,%u bytes\n", p_frame->type, p_frame->length);
+  }
+}
+
+/**
+ * @brief Converts a hexadecimal digit.
+ *
+ * @param c Character.
+ * @return Value of the digit, -1 if c is none.
+ */
+static int dump_hex_digit(int c) {
+  if (isdigit(c)) {
+    return c - '0';
+  }
+  c = tolower(c);
+  return ((c >= 'a') && (c <= 'f')) ? c - 'a' + 10 : -1;
+}
+
+int main(int argc, char **argv) {
+  sample_decoder_t decoder;
+  sample_decoder_stats_t const *p_stats;
+  bool hex = false;
+  int high = -1;
+  int c;
+
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--hex") == 0) {
+      hex = true;
+    } else {
+      fprintf(stderr, "usage: %s [--hex] < stream\n", argv[0]);
+      return 2;
+    }
+  }
+
+  sample_decoder_init(&decoder, dump_frame, NULL);
+  while ((c = getchar()) != EOF) {
+    uint8_t byte = (uint8_t)c;
+
+    if (hex) {
+      int digit = dump_hex_digit(c);
+      if (digit < 0) {
+        continue;
+      }
+      if (high < 0) {
+        high = digit;
+        continue;
+      }
+      byte = (uint8_t)((high << 4) | digit);
+      high = -1;
+    }
+    sample_decoder_feed(&decoder, &byte, 1);
+  }
+
+  p_stats = sample_decoder_stats_get(&decoder);
+  fprintf(stderr, "%u frames, %u lost, %u CRC errors, %u bytes skipped\n",
+      p_stats->frames, p_stats->lost, p_stats->crc_errors, p_stats->skipped);
+  return 0;
+}
@@ -0,0 +1,113 @@
+#include "app_timer.h"
+#include "host_sim.h"
+
+#define HOST_APP_TIMER_MAX 16 // Timers that can be created
+
+static app_timer_t *m_timers[HOST_APP_TIMER_MAX]; // Created timers
+static uint8_t m_timer_count;                     // Number of created timers
+static bool m_late_stop;                          // app_timer_stop leaves the pending timeout in place
+
+/**
+ * @brief Converts app_timer ticks to simulated microseconds, rounding up.
+ *
+ * @param ticks RTC ticks.
+ * @return Microseconds.
+ */
+static uint64_t ticks_to_us(uint32_t ticks) {
+  return ((uint64_t)ticks * 1000000 + APP_TIMER_CLOCK_FREQ - 1) / APP_TIMER_CLOCK_FREQ;
+}
+
+ret_code_t app_timer_init(void) {
+  m_timer_count = 0;
+  return NRF_SUCCESS;
+}
+
+ret_code_t app_timer_create(app_timer_id_t const *p_timer_id, app_timer_mode_t mode, app_timer_timeout_handler_t timeout_handler) {
+  app_timer_t *p_timer = *p_timer_id;
+
+  if (timeout_handler == NULL) {
+    return NRF_ERROR_INVALID_PARAM;
+  }
+  if (m_timer_count == HOST_APP_TIMER_MAX) {
+    return NRF_ERROR_NO_MEM;
+  }
+  p_timer->handler = timeout_handler;
+  p_timer->mode = mode;
+  p_timer->active = false;
+  p_timer->late = false;
+  m_timers[m_timer_count++] = p_timer;
+  return NRF_SUCCESS;
+}
+
+ret_code_t app_timer_start(app_timer_id_t timer_id, uint32_t timeout_ticks, void *p_context) {
+  if ((timer_id->handler == NULL) || (timeout_ticks < APP_TIMER_MIN_TIMEOUT_TICKS)) {
+    return NRF_ERROR_INVALID_PARAM;
+  }
+  timer_id->ticks = timeout_ticks;
+  timer_id->expiry_us = host_sim_now_us() + ticks_to_us(timeout_ticks);
+  timer_id->p_context = p_context;
+  timer_id->active = true;
+  return NRF_SUCCESS;
+}
+
+ret_code_t app_timer_stop(app_timer_id_t timer_id) {
+  if (m_late_stop && timer_id->active) { // The timeout is already queued and still delivered
+    timer_id->late_expiry_us = timer_id->expiry_us;
+    timer_id->p_late_context = timer_id->p_context;
+    timer_id->late = true;
+  }
+  timer_id->active = false;
+  return NRF_SUCCESS;
+}
+
+uint32_t app_timer_cnt_get(void) {
+  return (uint32_t)((host_sim_now_us() * APP_TIMER_CLOCK_FREQ / 1000000) & 0xFFFFFF); // 24-bit RTC counter
+}
+
+void host_app_timer_late_stop(bool enable) {
+  m_late_stop = enable;
+}
+
+/**
+ * @brief Returns the expiry time of the earliest running timer.
+ *
+ * @return Time in microseconds, UINT64_MAX if no timer is running.
+ */
+uint64_t host_app_timer_next_due(void) {
+  uint64_t due = UINT64_MAX;
+
+  for (uint8_t i = 0; i < m_timer_count; i++) {
+    if (m_timers[i]->active && (m_timers[i]->expiry_us < due)) {
+      due = m_timers[i]->expiry_us;
+    }
+    if (m_timers[i]->late && (m_timers[i]->late_expiry_us < due)) {
+      due = m_timers[i]->late_expiry_us;
+    }
+  }
+  return due;
+}
+
+/**
+ * @brief Calls the handlers of the timers that expired.
+ *
+ * @param now_us Current simulated time.
+ */
+void host_app_timer_run_due(uint64_t now_us) {
+  for (uint8_t i = 0; i < m_timer_count; i++) {
+    app_timer_t *p_timer = m_timers[i];
+
+    if (p_timer->late && (p_timer->late_expiry_us <= now_us)) {
+      p_timer->late = false;
+      p_timer->handler(p_timer->p_late_context);
+    }
+    if (!p_timer->active || (p_timer->expiry_us > now_us)) {
+      continue;
+    }
+    if (p_timer->mode == APP_TIMER_MODE_REPEATED) {
+      p_timer->expiry_us += ticks_to_us(p_timer->ticks);
+    } else {
+      p_timer->active = false;
+    }
+    p_timer->handler(p_timer->p_context); // May restart the timer
+  }
+}
@@ -0,0 +1,112 @@
+#include "nrf_drv_gpiote.h"
+#include <string.h>
+
+/**
+ * @brief State of one simulated input pin.
+ */
+typedef struct {
+  bool in_use;                          // Configured with nrf_drv_gpiote_in_init
+  bool enabled;                         // Event enabled
+  bool driven;                          // Driven by a device model
+  bool level;                           // Level set by the device model
+  nrf_drv_gpiote_in_config_t config;    // Sense and pull configuration
+  nrf_drv_gpiote_evt_handler_t handler; // Event handler
+} gpiote_pin_t;
+
+static bool m_initialized;                       // nrf_drv_gpiote_init was called
+static gpiote_pin_t m_pins[HOST_GPIO_PIN_COUNT]; // Simulated input pins
+
+/**
+ * @brief Returns the level of a pin: the driven level, or the level of its pull resistor.
+ *
+ * @param p_pin Pin state.
+ * @return Pin level.
+ */
+static bool gpiote_level(gpiote_pin_t const *p_pin) {
+  return p_pin->driven ? p_pin->level : (p_pin->config.pull == NRF_GPIO_PIN_PULLUP);
+}
+
+/**
+ * @brief Calls the handler of a pin if a level change matches its sense.
+ *
+ * @param pin Pin number.
+ * @param before Level before the change.
+ */
+static void gpiote_edge(uint32_t pin, bool before) {
+  gpiote_pin_t *p_pin = &m_pins[pin];
+  bool after = gpiote_level(p_pin);
+  nrf_gpiote_polarity_t edge = after ? NRF_GPIOTE_POLARITY_LOTOHI : NRF_GPIOTE_POLARITY_HITOLO;
+
+  if ((before == after) || !p_pin->in_use || !p_pin->enabled || (p_pin->handler == NULL)) {
+    return;
+  }
+  if ((p_pin->config.sense == edge) || (p_pin->config.sense == NRF_GPIOTE_POLARITY_TOGGLE)) {
+    p_pin->handler(pin, edge);
+  }
+}
+
+bool nrf_drv_gpiote_is_init(void) {
+  return m_initialized;
+}
+
+ret_code_t nrf_drv_gpiote_init(void) {
+  if (m_initialized) {
+    return NRF_ERROR_MODULE_ALREADY_INITIALIZED;
+  }
+  m_initialized = true;
+  return NRF_SUCCESS;
+}
+
+ret_code_t nrf_drv_gpiote_in_init(nrf_drv_gpiote_pin_t pin, nrf_drv_gpiote_in_config_t const *p_config, nrf_drv_gpiote_evt_handler_t evt_handler) {
+  if (m_pins[pin].in_use) {
+    return NRF_ERROR_INVALID_STATE;
+  }
+  m_pins[pin].in_use = true;
+  m_pins[pin].enabled = false;
+  m_pins[pin].config = *p_config;
+  m_pins[pin].handler = evt_handler;
+  return NRF_SUCCESS;
+}
+
+void nrf_drv_gpiote_in_uninit(nrf_drv_gpiote_pin_t pin) {
+  m_pins[pin].in_use = false;
+  m_pins[pin].enabled = false;
+}
+
+void nrf_drv_gpiote_in_event_enable(nrf_drv_gpiote_pin_t pin, bool int_enable) {
+  m_pins[pin].enabled = int_enable;
+}
+
+void nrf_drv_gpiote_in_event_disable(nrf_drv_gpiote_pin_t pin) {
+  m_pins[pin].enabled = false;
+}
+
+bool nrf_drv_gpiote_in_is_set(nrf_drv_gpiote_pin_t pin) {
+  return gpiote_level(&m_pins[pin]);
+}
+
+/**
+ * @brief Drives an input pin from a device model.
+ *
+ * @param pin Pin number.
+ * @param level New level.
+ */
+void host_gpiote_input_set(uint32_t pin, bool level) {
+  bool before = gpiote_level(&m_pins[pin]);
+
+  m_pins[pin].driven = true;
+  m_pins[pin].level = level;
+  gpiote_edge(pin, before);
+}
+
+/**
+ * @brief Releases an input pin, which then follows its pull resistor.
+ *
+ * @param pin Pin number.
+ */
+void host_gpiote_input_release(uint32_t pin) {
+  bool before = gpiote_level(&m_pins[pin]);
+
+  m_pins[pin].driven = false;
+  gpiote_edge(pin, before);
+}
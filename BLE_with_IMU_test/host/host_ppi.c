@@ -0,0 +1,110 @@
+#include "host_ppi.h"
+#include "nrf_drv_ppi.h"
+#include <stdbool.h>
+#include <string.h>
+
+/**
+ * @brief State of one simulated PPI channel.
+ */
+typedef struct {
+  bool allocated; // Taken with nrf_drv_ppi_channel_alloc
+  bool enabled;   // Events are routed
+  uint32_t eep;   // Event token
+  uint32_t tep;   // Task token
+  uint32_t fork;  // Fork task token, 0 if none
+} ppi_channel_t;
+
+static ppi_channel_t m_channels[HOST_PPI_CHANNEL_COUNT]; // Simulated channels
+static bool m_initialized;                               // nrf_drv_ppi_init was called
+
+/**
+ * @brief Triggers a task through the hook of its peripheral.
+ *
+ * @param task Task token, 0 does nothing.
+ */
+static void ppi_task(uint32_t task) {
+  uint8_t periph = HOST_PPI_PERIPH(task);
+
+  if ((periph >= HOST_PPI_PERIPH_TIMER) && (periph < HOST_PPI_PERIPH_TWI)) {
+    host_timer_task(periph - HOST_PPI_PERIPH_TIMER, HOST_PPI_INDEX(task));
+  } else if (periph >= HOST_PPI_PERIPH_TWI) {
+    host_twi_task(periph - HOST_PPI_PERIPH_TWI, HOST_PPI_INDEX(task));
+  }
+}
+
+ret_code_t nrf_drv_ppi_init(void) {
+  if (m_initialized) {
+    return NRF_ERROR_MODULE_ALREADY_INITIALIZED;
+  }
+  m_initialized = true;
+  return NRF_SUCCESS;
+}
+
+ret_code_t nrf_drv_ppi_channel_alloc(nrf_ppi_channel_t *p_channel) {
+  for (uint8_t i = 0; i < HOST_PPI_CHANNEL_COUNT; i++) {
+    if (!m_channels[i].allocated) {
+      memset(&m_channels[i], 0, sizeof(m_channels[i]));
+      m_channels[i].allocated = true;
+      *p_channel = i;
+      return NRF_SUCCESS;
+    }
+  }
+  return NRF_ERROR_NO_MEM;
+}
+
+ret_code_t nrf_drv_ppi_channel_assign(nrf_ppi_channel_t channel, uint32_t eep, uint32_t tep) {
+  if ((channel >= HOST_PPI_CHANNEL_COUNT) || !m_channels[channel].allocated) {
+    return NRF_ERROR_INVALID_STATE;
+  }
+  m_channels[channel].eep = eep;
+  m_channels[channel].tep = tep;
+  return NRF_SUCCESS;
+}
+
+ret_code_t nrf_drv_ppi_channel_fork_assign(nrf_ppi_channel_t channel, uint32_t fork_tep) {
+  if ((channel >= HOST_PPI_CHANNEL_COUNT) || !m_channels[channel].allocated) {
+    return NRF_ERROR_INVALID_STATE;
+  }
+  m_channels[channel].fork = fork_tep;
+  return NRF_SUCCESS;
+}
+
+ret_code_t nrf_drv_ppi_channel_enable(nrf_ppi_channel_t channel) {
+  if ((channel >= HOST_PPI_CHANNEL_COUNT) || !m_channels[channel].allocated) {
+    return NRF_ERROR_INVALID_STATE;
+  }
+  m_channels[channel].enabled = true;
+  return NRF_SUCCESS;
+}
+
+ret_code_t nrf_drv_ppi_channel_disable(nrf_ppi_channel_t channel) {
+  if ((channel >= HOST_PPI_CHANNEL_COUNT) || !m_channels[channel].allocated) {
+    return NRF_ERROR_INVALID_STATE;
+  }
+  m_channels[channel].enabled = false;
+  return NRF_SUCCESS;
+}
+
+/**
+ * @brief Clears the channels and their allocation.
+ */
+void host_ppi_reset(void) {
+  memset(m_channels, 0, sizeof(m_channels));
+  m_initialized = false;
+}
+
+/**
+ * @brief Triggers the tasks of the enabled channels listening to an event.
+ *
+ * @param event Event token.
+ */
+void host_ppi_event(uint32_t event) {
+  for (uint8_t i = 0; i < HOST_PPI_CHANNEL_COUNT; i++) {
+    ppi_channel_t const *p_channel = &m_channels[i];
+
+    if (p_channel->enabled && (p_channel->eep == event)) {
+      ppi_task(p_channel->tep);
+      ppi_task(p_channel->fork);
+    }
+  }
+}
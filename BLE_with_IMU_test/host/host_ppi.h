@@ -0,0 +1,52 @@
+#ifndef _HOST_PPI_H_
+#define _HOST_PPI_H_
+
+#include <stdint.h>
+
+/**
+ * @file host_ppi.h
+ * @brief Event routing between the simulated peripherals through the PPI channels of host_ppi.c.
+ *
+ * The address getters of the host drivers return tokens built with HOST_PPI_ADDR instead of
+ * register addresses. A peripheral raising an event calls host_ppi_event(), which triggers the
+ * tasks of the enabled channels listening to it through the peripheral's task hook.
+ */
+
+#define HOST_PPI_PERIPH_TIMER 0x01 ///< TIMER instances, the instance index is added
+#define HOST_PPI_PERIPH_TWI 0x10   ///< TWI instances, the instance index is added
+#define HOST_PPI_EVENT 0x80        ///< Set in the index of an event, clear for a task
+
+#define HOST_PPI_ADDR(periph, index) (((uint32_t)(periph) << 8) | (index)) ///< Token of a task or event
+#define HOST_PPI_PERIPH(addr) ((uint8_t)((addr) >> 8))                      ///< Peripheral of a token
+#define HOST_PPI_INDEX(addr) ((uint8_t)(addr))                              ///< Task or event index of a token
+
+#define HOST_TWI_TASK_START 0                       ///< TWI task index: start the held transfer (STARTTX/STARTRX)
+#define HOST_TWI_EVENT_STOPPED (HOST_PPI_EVENT | 0) ///< TWI event index: STOPPED
+
+/**
+ * @brief Clears the channels and their allocation.
+ */
+void host_ppi_reset(void);
+
+/**
+ * @brief Triggers the tasks of the enabled channels listening to an event.
+ *
+ * @param event Event token.
+ */
+void host_ppi_event(uint32_t event);
+
+/**
+ * @brief Stops and uninitializes all simulated TIMER instances (host_timer.c).
+ */
+void host_timer_reset(void);
+
+/**
+ * @brief Task hooks, implemented by host_timer.c and host_twi.c.
+ *
+ * @param instance Instance index.
+ * @param task Task index.
+ */
+void host_timer_task(uint8_t instance, uint8_t task);
+void host_twi_task(uint8_t instance, uint8_t task);
+
+#endif // _HOST_PPI_H_
@@ -0,0 +1,436 @@
+#include "host_pwm.h"
+#include "host_sim.h"
+#include <string.h>
+
+#define PWM_BASE_TICK_PS 62500 // Period of the 16 MHz base clock
+#define PWM_MAX_PENDING 8      // Handler calls waiting for the interrupt latency to pass
+#define PS_PER_US 1000000ull
+
+/**
+ * @brief Handler call waiting for its time.
+ */
+typedef struct {
+  uint64_t due_ps;              // Time the handler is called
+  nrf_drv_pwm_evt_type_t event; // Event passed to the handler
+} pwm_pending_t;
+
+/**
+ * @brief State of one simulated PWM instance.
+ */
+typedef struct {
+  bool initialized;                       // nrf_drv_pwm_init was called
+  nrf_drv_pwm_handler_t handler;          // Driver event handler
+  uint64_t tick_ps;                       // Period of the base clock
+  uint16_t top;                           // COUNTERTOP, ticks per PWM period
+  bool inverted;                          // First output pin inverted
+  bool running;                           // A playback is in progress
+  nrf_pwm_sequence_t seq[2];              // Sequences of the playback
+  uint32_t flags;                         // Flags of the playback
+  uint32_t seq_left;                      // Sequences still to play, unused with NRF_DRV_PWM_FLAG_LOOP
+  uint8_t cur;                            // Sequence being played
+  uint64_t seq_start_ps;                  // Start of the sequence being played
+  uint32_t seq_periods;                   // Periods of the sequence being played
+  uint32_t emitted;                       // Periods of the sequence already output
+  uint64_t start_ps;                      // Start of the playback
+  uint64_t stop_ps;                       // End of the period a stop was requested in, UINT64_MAX if none
+  uint64_t idle_since_ps;                 // End of the last playback
+  pwm_pending_t pending[PWM_MAX_PENDING]; // Handler calls waiting for the latency to pass
+  uint8_t pending_count;                  // Entries in pending
+  uint32_t latency_us;                    // Interrupt latency
+  host_pwm_sink_t sink;                   // Waveform sink of the first output pin
+  void *p_sink_context;                   // Context of the sink
+  host_pwm_stats_t stats;                 // Counters
+} pwm_instance_t;
+
+static pwm_instance_t m_pwm[HOST_PWM_INSTANCE_COUNT]; // Simulated instances
+static bool m_in_event;                               // Set while host_pwm_run_due calls a handler
+static uint64_t m_event_ps;                           // Time of the event being handled
+
+/**
+ * @brief Returns the current time with sub-microsecond resolution.
+ *
+ * Inside a handler this is the time of the event, which can lie before the simulated time
+ * when the handler is delivered at microsecond resolution.
+ *
+ * @return Time in picoseconds.
+ */
+static uint64_t pwm_now_ps(void) {
+  return m_in_event ? m_event_ps : host_sim_now_us() * PS_PER_US;
+}
+
+/**
+ * @brief Passes a stretch of constant level to the sink.
+ *
+ * @param p_pwm Instance.
+ * @param level Level before pin inversion.
+ * @param duration_ps Duration, nothing is passed for 0.
+ */
+static void pwm_output(pwm_instance_t *p_pwm, bool level, uint64_t duration_ps) {
+  if ((p_pwm->sink != NULL) && (duration_ps > 0)) {
+    p_pwm->sink(p_pwm->p_sink_context, level != p_pwm->inverted, duration_ps);
+  }
+}
+
+/**
+ * @brief Returns the end of the sequence being played.
+ *
+ * @param p_pwm Instance.
+ * @return Time in picoseconds.
+ */
+static uint64_t pwm_seq_end(pwm_instance_t const *p_pwm) {
+  return p_pwm->seq_start_ps + (uint64_t)p_pwm->seq_periods * p_pwm->top * p_pwm->tick_ps;
+}
+
+/**
+ * @brief Returns the end of the PWM period running at a time.
+ *
+ * @param p_pwm Instance.
+ * @param t_ps Time.
+ * @return Time in picoseconds, t_ps if a period starts at t_ps, the start of the sequence
+ *         for an earlier time.
+ */
+static uint64_t pwm_period_end(pwm_instance_t const *p_pwm, uint64_t t_ps) {
+  uint64_t period_ps = (uint64_t)p_pwm->top * p_pwm->tick_ps;
+  uint64_t periods;
+
+  if (t_ps <= p_pwm->seq_start_ps) {
+    return p_pwm->seq_start_ps;
+  }
+  periods = (t_ps - p_pwm->seq_start_ps + period_ps - 1) / period_ps;
+  return p_pwm->seq_start_ps + periods * period_ps;
+}
+
+/**
+ * @brief Outputs the periods of the sequence being played that start before a time.
+ *
+ * Each compare value is read from the sequence buffer now, so a value written by the driver
+ * after its period started is not seen. In the common load mode bit 15 of a value selects
+ * the polarity: set, the period starts high and falls at the compare value; cleared, it
+ * starts low and rises at the compare value.
+ *
+ * @param p_pwm Instance.
+ * @param t_ps Time up to which the output is generated.
+ */
+static void pwm_emit_until(pwm_instance_t *p_pwm, uint64_t t_ps) {
+  nrf_pwm_sequence_t const *p_seq = &p_pwm->seq[p_pwm->cur];
+  uint32_t periods;
+
+  if (!p_pwm->running || (t_ps <= p_pwm->seq_start_ps)) {
+    return;
+  }
+  periods = (uint32_t)((pwm_period_end(p_pwm, t_ps) - p_pwm->seq_start_ps) / ((uint64_t)p_pwm->top * p_pwm->tick_ps));
+  if (periods > p_pwm->seq_periods) {
+    periods = p_pwm->seq_periods;
+  }
+  for (; p_pwm->emitted < periods; p_pwm->emitted++) {
+    uint32_t index = p_pwm->emitted / (p_seq->repeats + 1); // Values are held for repeats + 1 periods, the last one during end_delay
+    uint16_t value = p_seq->values.p_common[(index < p_seq->length) ? index : (p_seq->length - 1u)];
+    uint16_t compare = value & 0x7FFF;
+    bool first = (value & 0x8000) != 0;
+
+    if (compare > p_pwm->top) {
+      compare = p_pwm->top;
+    }
+    pwm_output(p_pwm, first, compare * p_pwm->tick_ps);
+    pwm_output(p_pwm, !first, (p_pwm->top - compare) * p_pwm->tick_ps);
+    p_pwm->stats.periods++;
+  }
+}
+
+/**
+ * @brief Starts playing one of the two sequences.
+ *
+ * @param p_pwm Instance.
+ * @param index Sequence index.
+ * @param t_ps Start time.
+ */
+static void pwm_seq_begin(pwm_instance_t *p_pwm, uint8_t index, uint64_t t_ps) {
+  nrf_pwm_sequence_t const *p_seq = &p_pwm->seq[index];
+
+  p_pwm->cur = index;
+  p_pwm->seq_start_ps = t_ps;
+  p_pwm->seq_periods = p_seq->length * (p_seq->repeats + 1) + p_seq->end_delay;
+  p_pwm->emitted = 0;
+}
+
+/**
+ * @brief Queues a handler call, delayed by the interrupt latency.
+ *
+ * @param p_pwm Instance.
+ * @param event Event passed to the handler.
+ * @param t_ps Time of the event.
+ */
+static void pwm_signal(pwm_instance_t *p_pwm, nrf_drv_pwm_evt_type_t event, uint64_t t_ps) {
+  if ((p_pwm->handler == NULL) || (p_pwm->pending_count == PWM_MAX_PENDING)) {
+    return;
+  }
+  p_pwm->pending[p_pwm->pending_count].due_ps = t_ps + p_pwm->latency_us * PS_PER_US;
+  p_pwm->pending[p_pwm->pending_count].event = event;
+  p_pwm->pending_count++;
+}
+
+/**
+ * @brief Ends the playback, the output returns to the idle level.
+ *
+ * @param p_pwm Instance.
+ * @param t_ps End of the last period output.
+ * @param signal_stopped Queue a STOPPED event.
+ */
+static void pwm_halt(pwm_instance_t *p_pwm, uint64_t t_ps, bool signal_stopped) {
+  pwm_emit_until(p_pwm, t_ps);
+  p_pwm->running = false;
+  p_pwm->stop_ps = UINT64_MAX;
+  p_pwm->idle_since_ps = t_ps;
+  p_pwm->stats.busy_ps += t_ps - p_pwm->start_ps;
+  if (signal_stopped) {
+    pwm_signal(p_pwm, NRF_DRV_PWM_EVT_STOPPED, t_ps);
+  }
+}
+
+/**
+ * @brief Starts a playback of two sequences.
+ *
+ * A running playback is ended at the end of its current period first.
+ *
+ * @param p_pwm Instance.
+ * @param p_seq_0 First sequence.
+ * @param p_seq_1 Second sequence.
+ * @param sequences Sequences to play in total, alternating between the two.
+ * @param flags NRF_DRV_PWM_FLAG_* flags.
+ */
+static void pwm_playback(pwm_instance_t *p_pwm, nrf_pwm_sequence_t const *p_seq_0, nrf_pwm_sequence_t const *p_seq_1, uint32_t sequences, uint32_t flags) {
+  uint64_t now_ps = pwm_now_ps();
+
+  if (p_pwm->running) {
+    pwm_halt(p_pwm, pwm_period_end(p_pwm, now_ps), false);
+  }
+  if (now_ps < p_pwm->idle_since_ps) {
+    now_ps = p_pwm->idle_since_ps;
+  }
+  pwm_output(p_pwm, false, now_ps - p_pwm->idle_since_ps); // Idle level up to the start
+
+  p_pwm->seq[0] = *p_seq_0;
+  p_pwm->seq[1] = *p_seq_1;
+  p_pwm->flags = flags;
+  p_pwm->seq_left = sequences;
+  p_pwm->running = true;
+  p_pwm->start_ps = now_ps;
+  p_pwm->stop_ps = UINT64_MAX;
+  p_pwm->stats.playbacks++;
+  pwm_seq_begin(p_pwm, 0, now_ps);
+}
+
+/**
+ * @brief Ends the sequence being played and continues with the next one.
+ *
+ * @param p_pwm Instance.
+ */
+static void pwm_seq_complete(pwm_instance_t *p_pwm) {
+  uint64_t t_ps = pwm_seq_end(p_pwm);
+
+  pwm_emit_until(p_pwm, t_ps);
+  p_pwm->stats.sequences++;
+  if (p_pwm->flags & ((p_pwm->cur == 0) ? NRF_DRV_PWM_FLAG_SIGNAL_END_SEQ0 : NRF_DRV_PWM_FLAG_SIGNAL_END_SEQ1)) {
+    pwm_signal(p_pwm, (p_pwm->cur == 0) ? NRF_DRV_PWM_EVT_END_SEQ0 : NRF_DRV_PWM_EVT_END_SEQ1, t_ps);
+  }
+  if (!(p_pwm->flags & NRF_DRV_PWM_FLAG_LOOP) && (--p_pwm->seq_left == 0)) {
+    if (!(p_pwm->flags & NRF_DRV_PWM_FLAG_NO_EVT_FINISHED)) {
+      pwm_signal(p_pwm, NRF_DRV_PWM_EVT_FINISHED, t_ps);
+    }
+    pwm_halt(p_pwm, t_ps, (p_pwm->flags & NRF_DRV_PWM_FLAG_STOP) != 0); // Without STOP the hardware would keep the last value, modelled as idle
+    return;
+  }
+  pwm_seq_begin(p_pwm, p_pwm->cur ^ 1, t_ps);
+}
+
+ret_code_t nrf_drv_pwm_init(nrf_drv_pwm_t const *p_instance, nrf_drv_pwm_config_t const *p_config, nrf_drv_pwm_handler_t handler) {
+  pwm_instance_t *p_pwm = &m_pwm[p_instance->drv_inst_idx];
+  uint8_t pin = p_config->output_pins[0];
+
+  if (p_pwm->initialized) {
+    return NRF_ERROR_INVALID_STATE;
+  }
+  if ((p_config->count_mode != NRF_PWM_MODE_UP) || (p_config->load_mode != NRF_PWM_LOAD_COMMON) ||
+      (p_config->step_mode != NRF_PWM_STEP_AUTO)) {
+    return NRF_ERROR_NOT_SUPPORTED;
+  }
+  p_pwm->initialized = true;
+  p_pwm->handler = handler;
+  p_pwm->tick_ps = (uint64_t)PWM_BASE_TICK_PS << p_config->base_clock;
+  p_pwm->top = p_config->top_value;
+  p_pwm->inverted = (pin != NRF_DRV_PWM_PIN_NOT_USED) && (pin & NRF_DRV_PWM_PIN_INVERTED);
+  p_pwm->running = false;
+  p_pwm->stop_ps = UINT64_MAX;
+  p_pwm->idle_since_ps = host_sim_now_us() * PS_PER_US;
+  return NRF_SUCCESS;
+}
+
+void nrf_drv_pwm_uninit(nrf_drv_pwm_t const *p_instance) {
+  pwm_instance_t *p_pwm = &m_pwm[p_instance->drv_inst_idx];
+
+  if (p_pwm->running) {
+    pwm_halt(p_pwm, pwm_period_end(p_pwm, pwm_now_ps()), false);
+  }
+  p_pwm->initialized = false;
+  p_pwm->pending_count = 0;
+}
+
+uint32_t nrf_drv_pwm_simple_playback(nrf_drv_pwm_t const *p_instance, nrf_pwm_sequence_t const *p_sequence, uint16_t playback_count, uint32_t flags) {
+  pwm_instance_t *p_pwm = &m_pwm[p_instance->drv_inst_idx];
+
+  if (p_pwm->initialized && (playback_count > 0)) {
+    pwm_playback(p_pwm, p_sequence, p_sequence, playback_count, flags);
+  }
+  return 0;
+}
+
+uint32_t nrf_drv_pwm_complex_playback(nrf_drv_pwm_t const *p_instance, nrf_pwm_sequence_t const *p_sequence_0, nrf_pwm_sequence_t const *p_sequence_1, uint16_t playback_count, uint32_t flags) {
+  pwm_instance_t *p_pwm = &m_pwm[p_instance->drv_inst_idx];
+
+  if (p_pwm->initialized && (playback_count > 0)) {
+    pwm_playback(p_pwm, p_sequence_0, p_sequence_1, 2u * playback_count, flags);
+  }
+  return 0;
+}
+
+bool nrf_drv_pwm_stop(nrf_drv_pwm_t const *p_instance, bool wait_until_stopped) {
+  pwm_instance_t *p_pwm = &m_pwm[p_instance->drv_inst_idx];
+  uint64_t stop_ps;
+
+  if (!p_pwm->running) {
+    return true;
+  }
+  stop_ps = pwm_period_end(p_pwm, pwm_now_ps()); // The STOP task takes effect at the end of the current period
+  if (stop_ps < p_pwm->stop_ps) {
+    p_pwm->stop_ps = stop_ps;
+  }
+  if (wait_until_stopped) {
+    pwm_halt(p_pwm, p_pwm->stop_ps, true); // Busy-waiting is not simulated, the wait takes no time
+  }
+  return !p_pwm->running;
+}
+
+bool nrf_drv_pwm_is_stopped(nrf_drv_pwm_t const *p_instance) {
+  return !m_pwm[p_instance->drv_inst_idx].running;
+}
+
+/**
+ * @brief Returns the time of the next event of an instance.
+ *
+ * @param p_pwm Instance.
+ * @return Time in picoseconds, UINT64_MAX if nothing is pending.
+ */
+static uint64_t pwm_next_ps(pwm_instance_t const *p_pwm) {
+  uint64_t due = UINT64_MAX;
+
+  if (p_pwm->running) {
+    due = (p_pwm->stop_ps < pwm_seq_end(p_pwm)) ? p_pwm->stop_ps : pwm_seq_end(p_pwm);
+  }
+  for (uint8_t i = 0; i < p_pwm->pending_count; i++) {
+    if (p_pwm->pending[i].due_ps < due) {
+      due = p_pwm->pending[i].due_ps;
+    }
+  }
+  return due;
+}
+
+/**
+ * @brief Returns the time of the earliest sequence end, stop or handler call.
+ *
+ * @return Time in microseconds (rounded up), UINT64_MAX if nothing is pending.
+ */
+uint64_t host_pwm_next_due(void) {
+  uint64_t due = UINT64_MAX;
+
+  for (uint8_t i = 0; i < HOST_PWM_INSTANCE_COUNT; i++) {
+    uint64_t next = pwm_next_ps(&m_pwm[i]);
+    if (next != UINT64_MAX) {
+      next = (next + PS_PER_US - 1) / PS_PER_US;
+      if (next < due) {
+        due = next;
+      }
+    }
+  }
+  return due;
+}
+
+/**
+ * @brief Processes the sequence ends, stops and handler calls that are due, in time order.
+ *
+ * At the same time a stop comes before a sequence end, and the sequence end before the
+ * handler calls, so a handler sees the state following the event it reports.
+ *
+ * @param now_us Current simulated time.
+ */
+void host_pwm_run_due(uint64_t now_us) {
+  uint64_t now_ps = now_us * PS_PER_US;
+
+  for (uint8_t i = 0; i < HOST_PWM_INSTANCE_COUNT; i++) {
+    pwm_instance_t *p_pwm = &m_pwm[i];
+    uint64_t next;
+
+    while ((next = pwm_next_ps(p_pwm)) <= now_ps) {
+      if (p_pwm->running && (p_pwm->stop_ps == next)) {
+        pwm_halt(p_pwm, next, true);
+      } else if (p_pwm->running && (pwm_seq_end(p_pwm) == next)) {
+        pwm_seq_complete(p_pwm);
+      } else {
+        uint8_t first = 0;
+        for (uint8_t j = 1; j < p_pwm->pending_count; j++) {
+          if (p_pwm->pending[j].due_ps < p_pwm->pending[first].due_ps) {
+            first = j;
+          }
+        }
+        nrf_drv_pwm_evt_type_t event = p_pwm->pending[first].event;
+        memmove(&p_pwm->pending[first], &p_pwm->pending[first + 1], (p_pwm->pending_count - first - 1) * sizeof(pwm_pending_t)); // Keep the queue in order
+        p_pwm->pending_count--;
+
+        pwm_emit_until(p_pwm, next); // Periods started before the handler runs use the old buffer content
+        p_pwm->stats.events++;
+        m_in_event = true;
+        m_event_ps = next;
+        p_pwm->handler(event); // May refill a buffer, stop or start a playback
+        m_in_event = false;
+      }
+    }
+  }
+}
+
+/**
+ * @brief Stops all instances and clears their sinks, latencies and counters.
+ */
+void host_pwm_reset(void) {
+  memset(m_pwm, 0, sizeof(m_pwm));
+}
+
+/**
+ * @brief Connects a waveform sink to the first output pin of an instance.
+ *
+ * @param instance PWM instance index.
+ * @param sink Sink, NULL disconnects.
+ * @param p_context Passed to the sink.
+ */
+void host_pwm_sink_set(uint8_t instance, host_pwm_sink_t sink, void *p_context) {
+  m_pwm[instance].sink = sink;
+  m_pwm[instance].p_sink_context = p_context;
+}
+
+/**
+ * @brief Delays the driver's handler calls of an instance (interrupt latency).
+ *
+ * @param instance PWM instance index.
+ * @param latency_us Microseconds between an event and the handler call.
+ */
+void host_pwm_latency_set(uint8_t instance, uint32_t latency_us) {
+  m_pwm[instance].latency_us = latency_us;
+}
+
+/**
+ * @brief Returns the counters of an instance.
+ *
+ * @param instance PWM instance index.
+ * @return Pointer to the counters.
+ */
+host_pwm_stats_t const *host_pwm_stats_get(uint8_t instance) {
+  return &m_pwm[instance].stats;
+}
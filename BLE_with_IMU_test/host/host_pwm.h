@@ -0,0 +1,72 @@
+#ifndef _HOST_PWM_H_
+#define _HOST_PWM_H_
+
+#include "nrf_drv_pwm.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @file host_pwm.h
+ * @brief Simulated PWM peripherals implementing nrf_drv_pwm on the host.
+ *
+ * A playback runs in simulated time: every compare value lasts top_value base clock ticks
+ * and is read from the sequence buffer when its period starts, like EasyDMA does, so a buffer
+ * refilled too late is played with its old content. END_SEQn is signalled when sequence n
+ * was played completely and the driver's handler is called at that time plus the configured
+ * interrupt latency. The level of the first output pin is passed to an optional waveform
+ * sink, period by period, so a device model can decode the signal.
+ */
+
+/**
+ * @brief Receives the output waveform of a PWM instance.
+ *
+ * Called for every stretch of constant level, consecutive calls may have the same level.
+ *
+ * @param p_context Context passed to host_pwm_sink_set.
+ * @param level Output level.
+ * @param duration_ps Duration of the level in picoseconds.
+ */
+typedef void (*host_pwm_sink_t)(void *p_context, bool level, uint64_t duration_ps);
+
+/**
+ * @brief Counters of one simulated PWM instance.
+ */
+typedef struct {
+  uint32_t playbacks; ///< Playbacks started
+  uint32_t sequences; ///< Sequences played completely
+  uint32_t periods;   ///< PWM periods output
+  uint32_t events;    ///< Driver handler calls
+  uint64_t busy_ps;   ///< Simulated time the PWM was running
+} host_pwm_stats_t;
+
+/**
+ * @brief Stops all instances and clears their sinks, latencies and counters.
+ */
+void host_pwm_reset(void);
+
+/**
+ * @brief Connects a waveform sink to the first output pin of an instance.
+ *
+ * @param instance PWM instance index.
+ * @param sink Sink, NULL disconnects.
+ * @param p_context Passed to the sink.
+ */
+void host_pwm_sink_set(uint8_t instance, host_pwm_sink_t sink, void *p_context);
+
+/**
+ * @brief Delays the driver's handler calls of an instance (interrupt latency).
+ *
+ * @param instance PWM instance index.
+ * @param latency_us Microseconds between an event and the handler call.
+ */
+void host_pwm_latency_set(uint8_t instance, uint32_t latency_us);
+
+/**
+ * @brief Returns the counters of an instance.
+ *
+ * @param instance PWM instance index.
+ * @return Pointer to the counters.
+ */
+host_pwm_stats_t const *host_pwm_stats_get(uint8_t instance);
+
+#endif // _HOST_PWM_H_
@@ -0,0 +1,236 @@
+#include "host_sim.h"
+#include "nrf.h"
+
+static uint64_t m_now_us;         // Simulated time
+static uint32_t m_critical_depth; // Nesting depth of open critical regions
+static bool m_in_isr;             // Set while an event handler runs
+static bool m_event;              // Event register of WFE/SEV
+static uint64_t m_sleep_us;       // Simulated time spent in WFE
+static NRF_TIMER_Type m_timer1;   // Register image returned for NRF_TIMER1
+static uint32_t m_timer1_inten;   // TIMER1 interrupts enabled through INTENSET
+SCB_Type host_sim_scb;            // Register image returned for SCB
+
+/**
+ * @brief Returns the time of the earliest pending event.
+ *
+ * @return Time in microseconds, UINT64_MAX if nothing is pending.
+ */
+static uint64_t sim_next_due(void) {
+  uint64_t due = host_twi_next_due();
+  uint64_t timer = host_app_timer_next_due();
+  uint64_t pwm = host_pwm_next_due();
+  uint64_t compare = host_timer_next_due();
+
+  if (timer < due) {
+    due = timer;
+  }
+  if (compare < due) {
+    due = compare;
+  }
+  return (pwm < due) ? pwm : due;
+}
+
+/**
+ * @brief Delivers all events due at the current time, unless interrupts are masked.
+ */
+static void sim_dispatch(void) {
+  if ((m_critical_depth > 0) || m_in_isr) {
+    return;
+  }
+  m_in_isr = true;
+  while (sim_next_due() <= m_now_us) { // Handlers may schedule further events
+    host_twi_run_due(m_now_us);
+    host_app_timer_run_due(m_now_us);
+    host_pwm_run_due(m_now_us);
+    host_timer_run_due(m_now_us);
+    m_event = true; // Set by the exception return
+  }
+  m_in_isr = false;
+}
+
+/**
+ * @brief Resets the simulated clock to zero.
+ */
+void host_sim_reset(void) {
+  m_now_us = 0;
+  m_critical_depth = 0;
+  m_in_isr = false;
+  m_event = false;
+  m_sleep_us = 0;
+  m_timer1_inten = 0;
+}
+
+/**
+ * @brief Returns the current simulated time.
+ *
+ * @return Time in microseconds.
+ */
+uint64_t host_sim_now_us(void) {
+  return m_now_us;
+}
+
+/**
+ * @brief Advances the simulated time, delivering the events that become due on the way.
+ *
+ * @param us Microseconds to advance.
+ */
+void host_sim_advance_us(uint32_t us) {
+  uint64_t target = m_now_us + us;
+
+  for (;;) {
+    uint64_t due = sim_next_due();
+    if ((due > target) || (m_critical_depth > 0) || m_in_isr) {
+      break;
+    }
+    if (due > m_now_us) {
+      m_now_us = due;
+    }
+    sim_dispatch();
+  }
+  m_now_us = target;
+  sim_dispatch();
+}
+
+/**
+ * @brief Runs until no more events are pending or the limit is reached.
+ *
+ * @param limit_us Maximum simulated time to advance.
+ */
+void host_sim_run_until_idle(uint32_t limit_us) {
+  uint64_t limit = m_now_us + limit_us;
+
+  while (sim_next_due() <= limit) {
+    uint64_t due = sim_next_due();
+    host_sim_advance_us((due > m_now_us) ? (uint32_t)(due - m_now_us) : 0);
+  }
+}
+
+/**
+ * @brief Enters a critical region: simulated interrupts are deferred.
+ */
+void host_sim_critical_enter(void) {
+  m_critical_depth++;
+}
+
+/**
+ * @brief Leaves a critical region and delivers events that became due meanwhile.
+ */
+void host_sim_critical_exit(void) {
+  m_critical_depth--;
+  sim_dispatch();
+}
+
+/**
+ * @brief Checks whether code is running in a simulated interrupt.
+ *
+ * @return true inside an event handler.
+ */
+bool host_sim_in_isr(void) {
+  return m_in_isr;
+}
+
+/**
+ * @brief Checks whether code is running in a critical region.
+ *
+ * @return true between host_sim_critical_enter and the matching host_sim_critical_exit.
+ */
+bool host_sim_in_critical(void) {
+  return m_critical_depth > 0;
+}
+
+/**
+ * @brief Executes the TIMER1 task and interrupt enable writes made since the last access.
+ */
+static void sim_timer1_update(void) {
+  for (uint8_t i = 0; i < 6; i++) {
+    if (m_timer1.TASKS_CAPTURE[i] != 0) {
+      m_timer1.TASKS_CAPTURE[i] = 0;
+      m_timer1.CC[i] = (uint32_t)m_now_us;
+    }
+  }
+  m_timer1_inten = (m_timer1_inten | m_timer1.INTENSET) & ~m_timer1.INTENCLR;
+  m_timer1.INTENSET = 0;
+  m_timer1.INTENCLR = 0;
+}
+
+/**
+ * @brief Returns the time of the earliest enabled TIMER1 compare event.
+ *
+ * @return Time in microseconds, UINT64_MAX if no compare interrupt is enabled.
+ */
+static uint64_t sim_timer1_next_compare(void) {
+  uint64_t due = UINT64_MAX;
+
+  for (uint8_t i = 0; i < 6; i++) {
+    if ((m_timer1_inten & (TIMER_INTENSET_COMPARE0_Msk << i)) && (m_timer1.EVENTS_COMPARE[i] == 0)) {
+      uint64_t at = m_now_us + (uint32_t)(m_timer1.CC[i] - (uint32_t)m_now_us); // Next time the 32-bit counter matches
+      if (at < due) {
+        due = at;
+      }
+    }
+  }
+  return due;
+}
+
+/**
+ * @brief Backs __WFE: sleeps until the next simulated event unless the event register is set.
+ *
+ * Wakes up for TWI completions, app_timer timeouts, PWM events, TIMER compare events (host_timer.c)
+ * and TIMER1 compare events whose interrupt is enabled (INTENSET), and clears the event register.
+ */
+void host_sim_wfe(void) {
+  uint64_t wake;
+
+  if (!m_event) {
+    sim_timer1_update();
+    wake = sim_next_due();
+    uint64_t compare = sim_timer1_next_compare();
+    if (compare < wake) {
+      wake = compare;
+    }
+    if (wake == UINT64_MAX) {
+      wake = m_now_us + 1; // Nothing would ever wake the CPU, let the caller's loop go on
+    }
+    if (wake > m_now_us) {
+      m_sleep_us += wake - m_now_us;
+      host_sim_advance_us((uint32_t)(wake - m_now_us));
+    }
+    for (uint8_t i = 0; i < 6; i++) {
+      if ((m_timer1_inten & (TIMER_INTENSET_COMPARE0_Msk << i)) && (m_timer1.CC[i] == (uint32_t)m_now_us)) {
+        m_timer1.EVENTS_COMPARE[i] = 1;
+      }
+    }
+  }
+  m_event = false;
+}
+
+/**
+ * @brief Returns the simulated time the CPU spent sleeping in __WFE.
+ *
+ * @return Time in microseconds.
+ */
+uint64_t host_sim_sleep_us(void) {
+  return m_sleep_us;
+}
+
+/**
+ * @brief Backs __SEV: sets the event register.
+ */
+void host_sim_sev(void) {
+  m_event = true;
+}
+
+/**
+ * @brief Backs the NRF_TIMER1 macro of the host nrf.h.
+ *
+ * Advances the simulated time by HOST_SIM_TIMER_ACCESS_US, so busy-wait loops see a moving
+ * clock, and executes the writes of the previous access: a CAPTURE task followed by a CC
+ * read returns the current simulated time, CC values written by the firmware are kept.
+ *
+ * @return Pointer to the simulated TIMER1 registers.
+ */
+NRF_TIMER_Type *host_sim_timer1(void) {
+  host_sim_advance_us(HOST_SIM_TIMER_ACCESS_US);
+  sim_timer1_update();
+  return &m_timer1;
+}
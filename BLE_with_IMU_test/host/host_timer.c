@@ -0,0 +1,225 @@
+#include "host_ppi.h"
+#include "host_sim.h"
+#include "nrf_drv_timer.h"
+#include <string.h>
+
+/**
+ * @brief State of one simulated TIMER instance.
+ */
+typedef struct {
+  bool initialized;                  // nrf_drv_timer_init was called
+  bool running;                      // Started
+  nrf_timer_mode_t mode;             // Timer or counter
+  nrf_timer_event_handler_t handler; // Driver event handler
+  void *p_context;                   // Context of the event handler
+  uint32_t cc[HOST_TIMER_CC_COUNT];  // Capture/compare registers
+  uint32_t shorts;                   // Compare channels clearing the timer (nrf_timer_short_mask_t)
+  uint32_t inten;                    // Compare channels with the interrupt enabled
+  uint32_t count;                    // Counter value, in timer mode the value when it was stopped
+  uint64_t start_us;                 // Timer mode: time the counter value was 0 while running
+} timer_instance_t;
+
+static timer_instance_t m_timers[HOST_TIMER_INSTANCE_COUNT]; // Simulated instances
+
+/**
+ * @brief Returns the counter value of an instance.
+ *
+ * @param p_timer Instance.
+ * @return Counter value.
+ */
+static uint32_t timer_value(timer_instance_t const *p_timer) {
+  if ((p_timer->mode == NRF_TIMER_MODE_TIMER) && p_timer->running) {
+    return (uint32_t)(host_sim_now_us() - p_timer->start_us);
+  }
+  return p_timer->count;
+}
+
+/**
+ * @brief Raises a compare event: PPI, clear short and interrupt.
+ *
+ * @param instance Instance index.
+ * @param channel Compare channel.
+ */
+static void timer_compare(uint8_t instance, uint8_t channel) {
+  timer_instance_t *p_timer = &m_timers[instance];
+
+  if (p_timer->shorts & (1UL << channel)) {
+    if (p_timer->mode == NRF_TIMER_MODE_TIMER) {
+      p_timer->start_us += p_timer->cc[channel]; // Exactly one period later
+    } else {
+      p_timer->count = 0;
+    }
+  }
+  host_ppi_event(HOST_PPI_ADDR(HOST_PPI_PERIPH_TIMER + instance, HOST_PPI_EVENT | channel));
+  if ((p_timer->inten & (1UL << channel)) && (p_timer->handler != NULL)) {
+    p_timer->handler((nrf_timer_event_t)channel, p_timer->p_context);
+  }
+}
+
+ret_code_t nrf_drv_timer_init(nrf_drv_timer_t const *p_instance, nrf_drv_timer_config_t const *p_config, nrf_timer_event_handler_t timer_event_handler) {
+  timer_instance_t *p_timer = &m_timers[p_instance->instance_id];
+
+  if (p_timer->initialized) {
+    return NRF_ERROR_INVALID_STATE;
+  }
+  if ((p_instance->instance_id == 1) || ((p_config->mode == NRF_TIMER_MODE_TIMER) && (p_config->frequency != NRF_TIMER_FREQ_1MHz))) {
+    return NRF_ERROR_NOT_SUPPORTED;
+  }
+  memset(p_timer, 0, sizeof(*p_timer));
+  p_timer->initialized = true;
+  p_timer->mode = p_config->mode;
+  p_timer->handler = timer_event_handler;
+  p_timer->p_context = p_config->p_context;
+  return NRF_SUCCESS;
+}
+
+void nrf_drv_timer_enable(nrf_drv_timer_t const *p_instance) {
+  host_timer_task(p_instance->instance_id, NRF_TIMER_TASK_START);
+}
+
+void nrf_drv_timer_disable(nrf_drv_timer_t const *p_instance) {
+  host_timer_task(p_instance->instance_id, NRF_TIMER_TASK_STOP);
+}
+
+void nrf_drv_timer_clear(nrf_drv_timer_t const *p_instance) {
+  host_timer_task(p_instance->instance_id, NRF_TIMER_TASK_CLEAR);
+}
+
+uint32_t nrf_drv_timer_us_to_ticks(nrf_drv_timer_t const *p_instance, uint32_t time_us) {
+  return time_us; // 1 MHz
+}
+
+void nrf_drv_timer_compare(nrf_drv_timer_t const *p_instance, nrf_timer_cc_channel_t cc_channel, uint32_t cc_value, bool enable_int) {
+  timer_instance_t *p_timer = &m_timers[p_instance->instance_id];
+
+  p_timer->cc[cc_channel] = cc_value;
+  if (enable_int) {
+    p_timer->inten |= 1UL << cc_channel;
+  } else {
+    p_timer->inten &= ~(1UL << cc_channel);
+  }
+}
+
+void nrf_drv_timer_extended_compare(nrf_drv_timer_t const *p_instance, nrf_timer_cc_channel_t cc_channel, uint32_t cc_value,
+    nrf_timer_short_mask_t timer_short_mask, bool enable_int) {
+  timer_instance_t *p_timer = &m_timers[p_instance->instance_id];
+
+  nrf_drv_timer_compare(p_instance, cc_channel, cc_value, enable_int);
+  p_timer->shorts = (p_timer->shorts & ~(1UL << cc_channel)) | (uint32_t)timer_short_mask;
+}
+
+uint32_t nrf_drv_timer_capture(nrf_drv_timer_t const *p_instance, nrf_timer_cc_channel_t cc_channel) {
+  host_timer_task(p_instance->instance_id, NRF_TIMER_TASK_CAPTURE0 + cc_channel);
+  return m_timers[p_instance->instance_id].cc[cc_channel];
+}
+
+uint32_t nrf_drv_timer_capture_get(nrf_drv_timer_t const *p_instance, nrf_timer_cc_channel_t cc_channel) {
+  return m_timers[p_instance->instance_id].cc[cc_channel];
+}
+
+uint32_t nrf_drv_timer_task_address_get(nrf_drv_timer_t const *p_instance, nrf_timer_task_t timer_task) {
+  return HOST_PPI_ADDR(HOST_PPI_PERIPH_TIMER + p_instance->instance_id, timer_task);
+}
+
+uint32_t nrf_drv_timer_capture_task_address_get(nrf_drv_timer_t const *p_instance, uint32_t channel) {
+  return HOST_PPI_ADDR(HOST_PPI_PERIPH_TIMER + p_instance->instance_id, NRF_TIMER_TASK_CAPTURE0 + channel);
+}
+
+uint32_t nrf_drv_timer_compare_event_address_get(nrf_drv_timer_t const *p_instance, uint32_t channel) {
+  return HOST_PPI_ADDR(HOST_PPI_PERIPH_TIMER + p_instance->instance_id, HOST_PPI_EVENT | channel);
+}
+
+/**
+ * @brief Executes a task of an instance, triggered by the driver or through PPI.
+ *
+ * @param instance Instance index.
+ * @param task Task index (nrf_timer_task_t).
+ */
+void host_timer_task(uint8_t instance, uint8_t task) {
+  timer_instance_t *p_timer = &m_timers[instance];
+  uint64_t now_us = host_sim_now_us();
+
+  switch (task) {
+  case NRF_TIMER_TASK_START:
+    if (!p_timer->running) {
+      p_timer->start_us = now_us - p_timer->count; // Continues from the stopped value
+      p_timer->running = true;
+    }
+    break;
+
+  case NRF_TIMER_TASK_STOP:
+    p_timer->count = timer_value(p_timer);
+    p_timer->running = false;
+    break;
+
+  case NRF_TIMER_TASK_COUNT:
+    if (p_timer->running && (p_timer->mode == NRF_TIMER_MODE_COUNTER)) {
+      p_timer->count++;
+      for (uint8_t i = 0; i < HOST_TIMER_CC_COUNT; i++) {
+        if (p_timer->count == p_timer->cc[i]) {
+          timer_compare(instance, i);
+        }
+      }
+    }
+    break;
+
+  case NRF_TIMER_TASK_CLEAR:
+    p_timer->count = 0;
+    p_timer->start_us = now_us;
+    break;
+
+  default:
+    if ((task >= NRF_TIMER_TASK_CAPTURE0) && (task < NRF_TIMER_TASK_CAPTURE0 + HOST_TIMER_CC_COUNT)) {
+      p_timer->cc[task - NRF_TIMER_TASK_CAPTURE0] = timer_value(p_timer);
+    }
+    break;
+  }
+}
+
+/**
+ * @brief Returns the time of the earliest compare event of the running timer mode instances.
+ *
+ * @return Time in microseconds, UINT64_MAX if none is due.
+ */
+uint64_t host_timer_next_due(void) {
+  uint64_t due = UINT64_MAX;
+
+  for (uint8_t n = 0; n < HOST_TIMER_INSTANCE_COUNT; n++) {
+    timer_instance_t const *p_timer = &m_timers[n];
+
+    if (!p_timer->running || (p_timer->mode != NRF_TIMER_MODE_TIMER)) {
+      continue;
+    }
+    for (uint8_t i = 0; i < HOST_TIMER_CC_COUNT; i++) {
+      if ((p_timer->shorts & (1UL << i)) && (p_timer->cc[i] > 0) && (p_timer->start_us + p_timer->cc[i] < due)) {
+        due = p_timer->start_us + p_timer->cc[i];
+      }
+    }
+  }
+  return due;
+}
+
+/**
+ * @brief Raises the compare events that are due.
+ *
+ * @param now_us Current simulated time.
+ */
+void host_timer_run_due(uint64_t now_us) {
+  for (uint8_t n = 0; n < HOST_TIMER_INSTANCE_COUNT; n++) {
+    timer_instance_t *p_timer = &m_timers[n];
+
+    for (uint8_t i = 0; i < HOST_TIMER_CC_COUNT; i++) {
+      while (p_timer->running && (p_timer->mode == NRF_TIMER_MODE_TIMER) && (p_timer->shorts & (1UL << i)) &&
+             (p_timer->cc[i] > 0) && (p_timer->start_us + p_timer->cc[i] <= now_us)) {
+        timer_compare(n, i);
+      }
+    }
+  }
+}
+
+/**
+ * @brief Stops and uninitializes all instances.
+ */
+void host_timer_reset(void) {
+  memset(m_timers, 0, sizeof(m_timers));
+}
@@ -0,0 +1,425 @@
+#include "host_twi.h"
+#include "host_ppi.h"
+#include "host_sim.h"
+#include <string.h>
+
+#define TWI_START_STOP_CLOCKS 2 // START and STOP condition, in SCL periods
+#define TWI_BYTE_CLOCKS 9       // 8 data bits + ACK
+
+#define TWI_HELD_FLAGS (NRF_DRV_TWI_FLAG_HOLD_XFER | NRF_DRV_TWI_FLAG_REPEATED_XFER | NRF_DRV_TWI_FLAG_NO_XFER_EVT_HANDLER) // Simulated PPI transfer
+
+/**
+ * @brief Fault configuration of one device.
+ */
+typedef struct {
+  uint8_t address;         // Device the fault applies to
+  host_twi_fault_t fault;  // Fault injected into the next transfers
+  uint32_t count;          // Remaining transfers affected
+  host_twi_fault_t random; // Fault injected at random
+  uint16_t per_mille;      // Probability of the random fault
+} twi_fault_t;
+
+/**
+ * @brief State of one simulated TWI instance.
+ */
+typedef struct {
+  bool initialized;                                       // nrf_drv_twi_init was called
+  bool enabled;                                           // Peripheral enabled
+  nrf_drv_twi_evt_handler_t handler;                      // Driver event handler
+  void *p_context;                                        // Context of the event handler
+  uint32_t frequency;                                     // SCL frequency set by the driver
+  uint32_t frequency_override;                            // SCL frequency set by the test, 0 if none
+  uint32_t latency_us;                                    // Extra time per transfer
+  host_twi_device_t const *devices[HOST_TWI_MAX_DEVICES]; // Attached device models
+  twi_fault_t faults[HOST_TWI_MAX_DEVICES];               // Fault configuration per device
+  bool busy;                                              // A transfer is in progress
+  bool stuck;                                             // The transfer in progress never completes
+  bool held;                                              // A held transfer waits for the START task (desc)
+  uint32_t flags;                                         // Flags of the held transfer
+  uint64_t due_us;                                        // Completion time of the transfer in progress
+  nrf_drv_twi_xfer_desc_t desc;                           // Transfer in progress
+  nrf_drv_twi_evt_type_t result;                          // Event reported at completion
+  host_twi_stats_t stats;                                 // Counters
+} twi_instance_t;
+
+static twi_instance_t m_twi[HOST_TWI_INSTANCE_COUNT]; // Simulated instances
+static uint32_t m_random = 0x12345678;                // State of the fault random generator
+
+/**
+ * @brief Returns a pseudo random number (xorshift32), reproducible between runs.
+ *
+ * @return Random number.
+ */
+static uint32_t twi_random(void) {
+  m_random ^= m_random << 13;
+  m_random ^= m_random >> 17;
+  m_random ^= m_random << 5;
+  return m_random;
+}
+
+/**
+ * @brief Finds the device with an address on an instance.
+ *
+ * @param p_twi Instance to search.
+ * @param address 7-bit slave address.
+ * @return Device, or NULL if none is attached under that address.
+ */
+static host_twi_device_t const *twi_device(twi_instance_t *p_twi, uint8_t address) {
+  for (uint8_t i = 0; i < HOST_TWI_MAX_DEVICES; i++) {
+    if ((p_twi->devices[i] != NULL) && (p_twi->devices[i]->address == address)) {
+      return p_twi->devices[i];
+    }
+  }
+  return NULL;
+}
+
+/**
+ * @brief Finds or allocates the fault configuration of a device.
+ *
+ * @param p_twi Instance to search.
+ * @param address 7-bit slave address.
+ * @return Fault configuration, or NULL if all entries are in use.
+ */
+static twi_fault_t *twi_fault(twi_instance_t *p_twi, uint8_t address) {
+  twi_fault_t *p_free = NULL;
+
+  for (uint8_t i = 0; i < HOST_TWI_MAX_DEVICES; i++) {
+    twi_fault_t *p_fault = &p_twi->faults[i];
+    if (((p_fault->count > 0) || (p_fault->per_mille > 0)) && (p_fault->address == address)) {
+      return p_fault;
+    }
+    if ((p_free == NULL) && (p_fault->count == 0) && (p_fault->per_mille == 0)) {
+      p_free = p_fault;
+    }
+  }
+  if (p_free != NULL) {
+    memset(p_free, 0, sizeof(*p_free));
+    p_free->address = address;
+  }
+  return p_free;
+}
+
+/**
+ * @brief Returns the fault to apply to the next transfer to a device and consumes it.
+ *
+ * @param p_twi Instance of the transfer.
+ * @param address 7-bit slave address.
+ * @return Fault, or HOST_TWI_FAULT_NONE.
+ */
+static host_twi_fault_t twi_fault_take(twi_instance_t *p_twi, uint8_t address) {
+  for (uint8_t i = 0; i < HOST_TWI_MAX_DEVICES; i++) {
+    twi_fault_t *p_fault = &p_twi->faults[i];
+    if (p_fault->address != address) {
+      continue;
+    }
+    if (p_fault->count > 0) {
+      p_fault->count--;
+      return p_fault->fault;
+    }
+    if ((p_fault->per_mille > 0) && ((twi_random() % 1000) < p_fault->per_mille)) {
+      return p_fault->random;
+    }
+  }
+  return HOST_TWI_FAULT_NONE;
+}
+
+/**
+ * @brief Returns the time a transfer occupies the bus.
+ *
+ * @param p_twi Instance of the transfer.
+ * @param p_desc Transfer.
+ * @return Duration in microseconds.
+ */
+static uint32_t twi_duration_us(twi_instance_t const *p_twi, nrf_drv_twi_xfer_desc_t const *p_desc) {
+  uint32_t frequency = (p_twi->frequency_override != 0) ? p_twi->frequency_override : p_twi->frequency;
+  uint32_t clocks = TWI_START_STOP_CLOCKS + TWI_BYTE_CLOCKS * (1 + p_desc->primary_length); // Address + first part
+  if ((p_desc->type == NRF_DRV_TWI_XFER_TXRX) || (p_desc->type == NRF_DRV_TWI_XFER_TXTX)) {
+    clocks += 1 + TWI_BYTE_CLOCKS * (1 + p_desc->secondary_length); // Repeated START, address + second part
+  }
+  return (uint32_t)(((uint64_t)clocks * 1000000 + frequency - 1) / frequency) + p_twi->latency_us;
+}
+
+/**
+ * @brief Moves the data of a completed transfer between the driver buffers and the device model.
+ *
+ * @param p_twi Instance of the transfer.
+ * @return Event to report.
+ */
+static nrf_drv_twi_evt_type_t twi_execute(twi_instance_t *p_twi) {
+  nrf_drv_twi_xfer_desc_t const *p_desc = &p_twi->desc;
+  host_twi_device_t const *p_device = twi_device(p_twi, p_desc->address);
+
+  if (p_device == NULL) {
+    return NRF_DRV_TWI_EVT_ADDRESS_NACK;
+  }
+  switch (p_desc->type) {
+  case NRF_DRV_TWI_XFER_TX:
+    p_device->write(p_device->p_model, p_desc->p_primary_buf, p_desc->primary_length);
+    break;
+
+  case NRF_DRV_TWI_XFER_RX:
+    p_device->read(p_device->p_model, p_desc->p_primary_buf, p_desc->primary_length);
+    break;
+
+  case NRF_DRV_TWI_XFER_TXRX:
+    p_device->write(p_device->p_model, p_desc->p_primary_buf, p_desc->primary_length);
+    p_device->read(p_device->p_model, p_desc->p_secondary_buf, p_desc->secondary_length);
+    break;
+
+  case NRF_DRV_TWI_XFER_TXTX:
+    p_device->write(p_device->p_model, p_desc->p_primary_buf, p_desc->primary_length);
+    p_device->write(p_device->p_model, p_desc->p_secondary_buf, p_desc->secondary_length);
+    break;
+  }
+  return NRF_DRV_TWI_EVT_DONE;
+}
+
+/**
+ * @brief Starts the transfer in desc: schedules its completion and applies injected faults.
+ *
+ * @param p_twi Instance of the transfer.
+ */
+static void twi_start(twi_instance_t *p_twi) {
+  uint32_t duration = twi_duration_us(p_twi, &p_twi->desc);
+
+  p_twi->busy = true;
+  p_twi->stuck = false;
+  p_twi->due_us = host_sim_now_us() + duration;
+  p_twi->stats.transfers++;
+  p_twi->stats.bytes += p_twi->desc.primary_length + p_twi->desc.secondary_length;
+  p_twi->stats.busy_us += duration;
+
+  switch (twi_fault_take(p_twi, p_twi->desc.address)) {
+  case HOST_TWI_FAULT_ADDRESS_NACK:
+    p_twi->result = NRF_DRV_TWI_EVT_ADDRESS_NACK;
+    p_twi->stats.faults++;
+    break;
+
+  case HOST_TWI_FAULT_DATA_NACK:
+    p_twi->result = NRF_DRV_TWI_EVT_DATA_NACK;
+    p_twi->stats.faults++;
+    break;
+
+  case HOST_TWI_FAULT_STUCK:
+    p_twi->stuck = true;
+    p_twi->stats.faults++;
+    break;
+
+  default:
+    p_twi->result = NRF_DRV_TWI_EVT_DONE; // Decided by the model at completion
+    break;
+  }
+}
+
+ret_code_t nrf_drv_twi_init(nrf_drv_twi_t const *p_instance, nrf_drv_twi_config_t const *p_config,
+    nrf_drv_twi_evt_handler_t event_handler, void *p_context) {
+  twi_instance_t *p_twi = &m_twi[p_instance->inst_idx];
+
+  if (p_twi->initialized) {
+    return NRF_ERROR_INVALID_STATE;
+  }
+  if (event_handler == NULL) {
+    return NRF_ERROR_NOT_SUPPORTED; // Blocking mode is not simulated
+  }
+  p_twi->initialized = true;
+  p_twi->handler = event_handler;
+  p_twi->p_context = p_context;
+  p_twi->frequency = p_config->frequency;
+  return NRF_SUCCESS;
+}
+
+void nrf_drv_twi_enable(nrf_drv_twi_t const *p_instance) {
+  m_twi[p_instance->inst_idx].enabled = true;
+}
+
+void nrf_drv_twi_disable(nrf_drv_twi_t const *p_instance) {
+  twi_instance_t *p_twi = &m_twi[p_instance->inst_idx];
+
+  p_twi->enabled = false;
+  p_twi->busy = false; // Disabling aborts the transfer in progress without an event
+  p_twi->stuck = false;
+  p_twi->held = false;
+}
+
+ret_code_t nrf_drv_twi_xfer(nrf_drv_twi_t const *p_instance, nrf_drv_twi_xfer_desc_t const *p_xfer_desc, uint32_t flags) {
+  twi_instance_t *p_twi = &m_twi[p_instance->inst_idx];
+
+  if (!p_twi->initialized || !p_twi->enabled) {
+    return NRF_ERROR_INVALID_STATE;
+  }
+  if ((flags != 0) && ((flags & ~NRF_DRV_TWI_FLAG_RX_POSTINC) != TWI_HELD_FLAGS)) {
+    return NRF_ERROR_NOT_SUPPORTED;
+  }
+  if (p_twi->busy) {
+    return NRF_ERROR_BUSY;
+  }
+
+  p_twi->desc = *p_xfer_desc;
+  p_twi->held = (flags != 0);
+  p_twi->flags = flags;
+  if (!p_twi->held) {
+    twi_start(p_twi);
+  }
+  return NRF_SUCCESS;
+}
+
+bool nrf_drv_twi_is_busy(nrf_drv_twi_t const *p_instance) {
+  return m_twi[p_instance->inst_idx].busy;
+}
+
+uint32_t nrf_drv_twi_start_task_get(nrf_drv_twi_t const *p_instance, nrf_drv_twi_xfer_type_t xfer_type) {
+  return HOST_PPI_ADDR(HOST_PPI_PERIPH_TWI + p_instance->inst_idx, HOST_TWI_TASK_START);
+}
+
+uint32_t nrf_drv_twi_stopped_event_get(nrf_drv_twi_t const *p_instance) {
+  return HOST_PPI_ADDR(HOST_PPI_PERIPH_TWI + p_instance->inst_idx, HOST_TWI_EVENT_STOPPED);
+}
+
+/**
+ * @brief Executes a task of an instance triggered through PPI.
+ *
+ * START begins the held transfer unless the peripheral is disabled or still transferring.
+ *
+ * @param instance Instance index.
+ * @param task Task index (HOST_TWI_TASK_START).
+ */
+void host_twi_task(uint8_t instance, uint8_t task) {
+  twi_instance_t *p_twi = &m_twi[instance];
+
+  if ((task == HOST_TWI_TASK_START) && p_twi->enabled && p_twi->held && !p_twi->busy) {
+    twi_start(p_twi);
+  }
+}
+
+/**
+ * @brief Returns the completion time of the earliest transfer in progress.
+ *
+ * @return Time in microseconds, UINT64_MAX if no transfer will complete.
+ */
+uint64_t host_twi_next_due(void) {
+  uint64_t due = UINT64_MAX;
+
+  for (uint8_t i = 0; i < HOST_TWI_INSTANCE_COUNT; i++) {
+    if (m_twi[i].busy && !m_twi[i].stuck && (m_twi[i].due_us < due)) {
+      due = m_twi[i].due_us;
+    }
+  }
+  return due;
+}
+
+/**
+ * @brief Completes the transfers that are due, raises STOPPED and calls the driver's event handler.
+ *
+ * A held transfer stays armed for the next START task and calls no handler; with RX_POSTINC
+ * the receive pointer moves on by one transfer.
+ *
+ * @param now_us Current simulated time.
+ */
+void host_twi_run_due(uint64_t now_us) {
+  for (uint8_t i = 0; i < HOST_TWI_INSTANCE_COUNT; i++) {
+    twi_instance_t *p_twi = &m_twi[i];
+    nrf_drv_twi_evt_t event;
+    bool held;
+
+    if (!p_twi->busy || p_twi->stuck || (p_twi->due_us > now_us)) {
+      continue;
+    }
+    event.type = (p_twi->result == NRF_DRV_TWI_EVT_DONE) ? twi_execute(p_twi) : p_twi->result;
+    event.xfer_desc = p_twi->desc;
+    p_twi->busy = false;
+    held = p_twi->held;
+    if (held && (p_twi->flags & NRF_DRV_TWI_FLAG_RX_POSTINC)) {
+      p_twi->desc.p_secondary_buf += p_twi->desc.secondary_length;
+    }
+    host_ppi_event(HOST_PPI_ADDR(HOST_PPI_PERIPH_TWI + i, HOST_TWI_EVENT_STOPPED)); // May re-arm a held transfer
+    if (!held) {
+      p_twi->handler(&event, p_twi->p_context); // May start the next transfer
+    }
+  }
+}
+
+/**
+ * @brief Detaches all devices, clears faults and counters of all instances.
+ */
+void host_twi_reset(void) {
+  memset(m_twi, 0, sizeof(m_twi));
+}
+
+/**
+ * @brief Attaches a device model to a bus instance.
+ *
+ * @param instance TWI instance index.
+ * @param p_device Device description, must stay valid while attached.
+ */
+void host_twi_attach(uint8_t instance, host_twi_device_t const *p_device) {
+  for (uint8_t i = 0; i < HOST_TWI_MAX_DEVICES; i++) {
+    if (m_twi[instance].devices[i] == NULL) {
+      m_twi[instance].devices[i] = p_device;
+      return;
+    }
+  }
+}
+
+/**
+ * @brief Adds a fixed latency to every transfer of a bus (driver and interrupt overhead).
+ *
+ * @param instance TWI instance index.
+ * @param latency_us Extra microseconds per transfer.
+ */
+void host_twi_latency_set(uint8_t instance, uint32_t latency_us) {
+  m_twi[instance].latency_us = latency_us;
+}
+
+/**
+ * @brief Overrides the bus frequency configured by the driver.
+ *
+ * @param instance TWI instance index.
+ * @param frequency_hz SCL frequency, 0 uses the frequency passed to nrf_drv_twi_init.
+ */
+void host_twi_frequency_set(uint8_t instance, uint32_t frequency_hz) {
+  m_twi[instance].frequency_override = frequency_hz;
+}
+
+/**
+ * @brief Makes the next transfers to a device fail.
+ *
+ * @param instance TWI instance index.
+ * @param address 7-bit slave address.
+ * @param fault Fault to inject.
+ * @param count Number of transfers affected.
+ */
+void host_twi_fault_inject(uint8_t instance, uint8_t address, host_twi_fault_t fault, uint32_t count) {
+  twi_fault_t *p_fault = twi_fault(&m_twi[instance], address);
+
+  if (p_fault != NULL) {
+    p_fault->fault = fault;
+    p_fault->count = (fault == HOST_TWI_FAULT_NONE) ? 0 : count;
+  }
+}
+
+/**
+ * @brief Makes transfers to a device fail at random.
+ *
+ * @param instance TWI instance index.
+ * @param address 7-bit slave address.
+ * @param fault Fault to inject, HOST_TWI_FAULT_NONE disables random faults.
+ * @param per_mille Probability of a fault per transfer in 1/1000.
+ */
+void host_twi_fault_rate(uint8_t instance, uint8_t address, host_twi_fault_t fault, uint16_t per_mille) {
+  twi_fault_t *p_fault = twi_fault(&m_twi[instance], address);
+
+  if (p_fault != NULL) {
+    p_fault->random = fault;
+    p_fault->per_mille = (fault == HOST_TWI_FAULT_NONE) ? 0 : per_mille;
+  }
+}
+
+/**
+ * @brief Returns the counters of a bus.
+ *
+ * @param instance TWI instance index.
+ * @return Pointer to the counters.
+ */
+host_twi_stats_t const *host_twi_stats_get(uint8_t instance) {
+  return &m_twi[instance].stats;
+}
@@ -0,0 +1,108 @@
+#ifndef _HOST_TWI_H_
+#define _HOST_TWI_H_
+
+#include "nrf_drv_twi.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @file host_twi.h
+ * @brief Simulated TWI buses implementing nrf_drv_twi on the host.
+ *
+ * Device models attach to a bus instance under their 7-bit address. A transfer takes the
+ * time the bytes need on the wire at the configured bus frequency (9 clocks per byte
+ * including ACK, plus START/STOP) and the configured extra latency; the model is accessed
+ * and the driver's event handler called once that simulated time has passed.
+ */
+
+#define HOST_TWI_MAX_DEVICES 4 ///< Devices that can be attached to one bus
+
+/**
+ * @brief Register-level device model attached to a simulated bus.
+ */
+typedef struct {
+  uint8_t address;                                                    ///< 7-bit slave address
+  void *p_model;                                                      ///< Model state passed to the callbacks
+  void (*write)(void *p_model, uint8_t const *p_data, size_t length); ///< Bytes written by the master in one transfer
+  void (*read)(void *p_model, uint8_t *p_data, size_t length);        ///< Bytes read by the master in one transfer
+} host_twi_device_t;
+
+/**
+ * @brief Faults that can be injected into transfers to one device.
+ */
+typedef enum {
+  HOST_TWI_FAULT_NONE,         ///< Normal operation
+  HOST_TWI_FAULT_ADDRESS_NACK, ///< The device does not acknowledge its address
+  HOST_TWI_FAULT_DATA_NACK,    ///< The device does not acknowledge a data byte
+  HOST_TWI_FAULT_STUCK         ///< The transfer never completes (SCL held low)
+} host_twi_fault_t;
+
+/**
+ * @brief Counters of one simulated bus.
+ */
+typedef struct {
+  uint32_t transfers; ///< Transfers started
+  uint32_t bytes;     ///< Data bytes moved, excluding address bytes
+  uint32_t faults;    ///< Transfers affected by an injected fault
+  uint64_t busy_us;   ///< Simulated time the bus was busy
+} host_twi_stats_t;
+
+/**
+ * @brief Detaches all devices, clears faults and counters of all instances.
+ */
+void host_twi_reset(void);
+
+/**
+ * @brief Attaches a device model to a bus instance.
+ *
+ * @param instance TWI instance index.
+ * @param p_device Device description, must stay valid while attached.
+ */
+void host_twi_attach(uint8_t instance, host_twi_device_t const *p_device);
+
+/**
+ * @brief Adds a fixed latency to every transfer of a bus (driver and interrupt overhead).
+ *
+ * @param instance TWI instance index.
+ * @param latency_us Extra microseconds per transfer.
+ */
+void host_twi_latency_set(uint8_t instance, uint32_t latency_us);
+
+/**
+ * @brief Overrides the bus frequency configured by the driver.
+ *
+ * @param instance TWI instance index.
+ * @param frequency_hz SCL frequency, 0 uses the frequency passed to nrf_drv_twi_init.
+ */
+void host_twi_frequency_set(uint8_t instance, uint32_t frequency_hz);
+
+/**
+ * @brief Makes the next transfers to a device fail.
+ *
+ * @param instance TWI instance index.
+ * @param address 7-bit slave address.
+ * @param fault Fault to inject.
+ * @param count Number of transfers affected.
+ */
+void host_twi_fault_inject(uint8_t instance, uint8_t address, host_twi_fault_t fault, uint32_t count);
+
+/**
+ * @brief Makes transfers to a device fail at random.
+ *
+ * @param instance TWI instance index.
+ * @param address 7-bit slave address.
+ * @param fault Fault to inject, HOST_TWI_FAULT_NONE disables random faults.
+ * @param per_mille Probability of a fault per transfer in 1/1000.
+ */
+void host_twi_fault_rate(uint8_t instance, uint8_t address, host_twi_fault_t fault, uint16_t per_mille);
+
+/**
+ * @brief Returns the counters of a bus.
+ *
+ * @param instance TWI instance index.
+ * @return Pointer to the counters.
+ */
+host_twi_stats_t const *host_twi_stats_get(uint8_t instance);
+
+#endif // _HOST_TWI_H_
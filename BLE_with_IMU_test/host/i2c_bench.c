@@ -0,0 +1,588 @@
+#include "I2C_Bus.h"
+#include "I2C_Script.h"
+#include "I2Cdev.h"
+#include "ICM20948.h"
+#include "ICM20948_Sampler.h"
+#include "VCNL4040.h"
+#include "VCNL4040_Filter.h"
+#include "bench.h"
+#include "host_ppi.h"
+#include "host_sim.h"
+#include "host_twi.h"
+#include "icm20948_model.h"
+#include "vcnl4040_model.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @file i2c_bench.c
+ * @brief Regression checks and throughput benchmark of the sensor drivers on the simulated buses.
+ *
+ * Runs the unmodified I2C_Bus, I2C_Script, I2Cdev, ICM20948 (including the TIMER/PPI sampler of
+ * ICM20948_Sampler.c) and VCNL4040 sources against the register models of host_twi.c and exits
+ * with a non-zero status if any check fails, so it can be used as a CI step ("make -C host check").
+ *
+ * Options:
+ *   --speed <Hz>      Override the SCL frequency of both buses
+ *   --latency <us>    Extra latency per transfer (driver and interrupt overhead)
+ *   --reads <n>       Reads per throughput measurement
+ *   --verbose         Print the driver log output
+ */
+
+#define BENCH_DEFAULT_READS 2000
+
+static icm20948_model_t m_imu;  // IMU model on TWI0
+static vcnl4040_model_t m_prox; // Proximity sensor model on TWI1
+bool host_log_enabled = false;  // Enables the driver log output (nrf_log.h)
+
+/**
+ * @brief Checks the ICM20948 driver: connection test, initialization and sample decoding.
+ */
+static void test_icm20948(void) {
+  int16_t accel_in[3] = {1000, -2000, 16384};
+  int16_t gyro_in[3] = {-1, 32767, -32768};
+  int16_t accel[3], gyro[3];
+
+  CHECK(testConnection());
+  CHECK(icm20948_model_sleeping(&m_imu));
+  CHECK(initializeIMU());
+  CHECK(!icm20948_model_sleeping(&m_imu));
+  CHECK(icm20948_model_reg(&m_imu, 0, ICM20948_REG_PWR_MGMT_1) == 0x01);
+  CHECK(icm20948_model_reg(&m_imu, 0, 0x14) == 0x10);
+  CHECK(icm20948_model_reg(&m_imu, 0, 0x15) == 0x10);
+
+  icm20948_model_set_motion(&m_imu, accel_in, gyro_in);
+  readAccelGyroData(accel, gyro);
+  CHECK(memcmp(accel, accel_in, sizeof(accel)) == 0);
+  CHECK(memcmp(gyro, gyro_in, sizeof(gyro)) == 0);
+}
+
+/**
+ * @brief Checks register banks and the FIFO through the I2Cdev helpers.
+ */
+static void test_icm20948_fifo(void) {
+  uint8_t value = 0;
+  uint8_t count[2];
+  uint8_t sample[12];
+  int16_t accel[3], gyro[3];
+  int16_t accel_in[3] = {-300, 200, -100};
+  int16_t gyro_in[3] = {10, -20, 30};
+
+  CHECK(writeByte(ICM20948_ADDRESS, ICM20948_REG_BANK_SEL, 2 << 4));    // Bank 2
+  CHECK(writeByte(ICM20948_ADDRESS, ICM20948_REG_GYRO_SMPLRT_DIV, 10)); // 102 Hz
+  CHECK(readByte(ICM20948_ADDRESS, ICM20948_REG_GYRO_SMPLRT_DIV, &value, 10) && (value == 10));
+  CHECK(readByte(ICM20948_ADDRESS, ICM20948_REG_BANK_SEL, &value, 10) && (value == (2 << 4)));
+  CHECK(writeByte(ICM20948_ADDRESS, ICM20948_REG_BANK_SEL, 0)); // Bank 0
+  CHECK(readByte(ICM20948_ADDRESS, WHO_AM_I_REG, &value, 10) && (value == WHO_AM_I_EXPECTED));
+
+  icm20948_model_set_motion(&m_imu, accel_in, gyro_in);
+  CHECK(writeByte(ICM20948_ADDRESS, ICM20948_REG_FIFO_RST, 0x1F)); // Reset the FIFO
+  CHECK(writeByte(ICM20948_ADDRESS, ICM20948_REG_FIFO_RST, 0x00));
+  CHECK(writeByte(ICM20948_ADDRESS, ICM20948_REG_FIFO_EN_2, 0x1E)); // Accelerometer and gyroscope
+  CHECK(writeBit(ICM20948_ADDRESS, ICM20948_REG_USER_CTRL, 6, 1));  // FIFO_EN
+  host_sim_advance_us(50000);                                       // About 5 samples
+  CHECK(readBytes(ICM20948_ADDRESS, ICM20948_REG_FIFO_COUNTH, 2, count, 10));
+  CHECK((((count[0] << 8) | count[1]) / sizeof(sample)) >= 4);
+  CHECK(readBytes(ICM20948_ADDRESS, ICM20948_REG_FIFO_R_W, sizeof(sample), sample, 10));
+  decodeAccelGyroData(sample, accel, gyro);
+  CHECK(memcmp(accel, accel_in, sizeof(accel)) == 0);
+  CHECK(memcmp(gyro, gyro_in, sizeof(gyro)) == 0);
+  CHECK(writeByte(ICM20948_ADDRESS, ICM20948_REG_USER_CTRL, 0x00));
+}
+
+/**
+ * @brief Checks a register script with read-modify-write and poll operations: DEVICE_RESET
+ *        followed by a wake-up, as the datasheet recommends.
+ */
+static void test_script(void) {
+  static const i2c_script_op_t reset_script[] = {
+      I2C_SCRIPT_RMW8(ICM20948_REG_PWR_MGMT_1, 0x80, 0x80),     // DEVICE_RESET
+      I2C_SCRIPT_POLL8(ICM20948_REG_PWR_MGMT_1, 0x80, 0x00, 5), // Wait until the reset finished
+      I2C_SCRIPT_RMW8(ICM20948_REG_PWR_MGMT_1, 0x40, 0x00),     // Clear SLEEP
+      I2C_SCRIPT_END()};
+
+  CHECK(i2c_script_perform(I2CDEV_BUS, ICM20948_ADDRESS, reset_script, 100) == NRF_SUCCESS);
+  CHECK(!icm20948_model_sleeping(&m_imu));
+  CHECK(icm20948_model_reg(&m_imu, 0, 0x14) == 0x00); // Reset to default
+  CHECK(initializeIMU());
+}
+
+/**
+ * @brief Checks the VCNL4040 driver: configuration, blocking and background reads.
+ */
+static void test_vcnl4040(void) {
+  CHECK(vcnl4040_init() == NRF_SUCCESS);
+  CHECK(vcnl4040_model_reg(&m_prox, VCNL4040_CMD_PS_CONF1_2) == 0x0080); // LSB first, PS_SD cleared
+
+  vcnl4040_model_set_proximity(&m_prox, 0x1234);
+  CHECK(read_proximity() == 0x1234);
+
+  vcnl4040_model_set_proximity(&m_prox, 0x0042);
+  CHECK(vcnl4040_read_proximity_start(NULL, NULL) == NRF_SUCCESS);
+  CHECK(vcnl4040_read_proximity_start(NULL, NULL) == NRF_ERROR_BUSY);
+  CHECK(i2c_bus_wait_idle(VCNL4040_BUS, 10) == NRF_SUCCESS);
+  CHECK(vcnl4040_proximity_get() == 0x0042);
+}
+
+static vcnl4040_evt_t m_prox_events[8]; // Events received by prox_event_handler
+static uint8_t m_prox_event_count;      // Number of entries in m_prox_events
+
+/**
+ * @brief Records proximity events.
+ *
+ * @param event Proximity event.
+ */
+static void prox_event_handler(vcnl4040_evt_t event) {
+  if (m_prox_event_count < sizeof(m_prox_events) / sizeof(m_prox_events[0])) {
+    m_prox_events[m_prox_event_count++] = event;
+  }
+}
+
+/**
+ * @brief Feeds proximity samples into the model and lets the interrupt read complete.
+ *
+ * @param proximity Proximity counts.
+ * @param samples Number of sensor samples with that value.
+ */
+static void prox_samples(uint16_t proximity, uint8_t samples) {
+  for (uint8_t i = 0; i < samples; i++) {
+    vcnl4040_model_set_proximity(&m_prox, proximity);
+    CHECK(i2c_bus_wait_idle(VCNL4040_BUS, 10) == NRF_SUCCESS);
+  }
+}
+
+static uint8_t m_prox_filler_reg = VCNL4040_PS_DATA_REG; // Register read by m_prox_filler
+static uint8_t m_prox_filler_rx[2];                      // Result of m_prox_filler, unused
+static const i2c_bus_xfer_t m_prox_filler_xfer = {
+    .dev_addr = VCNL4040_ADDRESS,
+    .p_tx = &m_prox_filler_reg,
+    .tx_len = 1,
+    .p_rx = m_prox_filler_rx,
+    .rx_len = sizeof(m_prox_filler_rx)};
+static const i2c_bus_transaction_t m_prox_filler = { // Fills the TWI1 queue
+    .p_xfers = &m_prox_filler_xfer,
+    .xfer_count = 1};
+
+/**
+ * @brief Checks the interrupt driven proximity mode: thresholds, persistence and events.
+ */
+static void test_vcnl4040_int(void) {
+  i2c_bus_dev_stats_t const *p_stats;
+  uint32_t transactions;
+
+  vcnl4040_model_int_connect(&m_prox, VCNL4040_INT_PIN);
+  prox_samples(10, 1);
+  CHECK(vcnl4040_proximity_int_enable(80, 100, 2, prox_event_handler) == NRF_SUCCESS);
+  CHECK(vcnl4040_model_reg(&m_prox, VCNL4040_CMD_PS_THDL) == 80);
+  CHECK(vcnl4040_model_reg(&m_prox, VCNL4040_CMD_PS_THDH) == 100);
+  CHECK(vcnl4040_model_reg(&m_prox, VCNL4040_CMD_PS_CONF1_2) == 0x0390); // PS_INT close/away, PS_PERS 2, PS_CONF1 kept
+  CHECK(i2c_bus_wait_idle(VCNL4040_BUS, 10) == NRF_SUCCESS);
+  CHECK(!vcnl4040_is_close());
+
+  prox_samples(10, 2); // Settles the sensor's own state, it saw a close object before
+  m_prox_event_count = 0;
+  p_stats = i2c_bus_stats_get(VCNL4040_BUS, 0);
+  transactions = p_stats->transactions;
+  prox_samples(50, 10); // Below the close threshold: no bus traffic
+  prox_samples(150, 1); // One sample is not enough with persistence 2
+  CHECK(p_stats->transactions == transactions);
+  CHECK(m_prox_event_count == 0);
+
+  prox_samples(150, 1);
+  CHECK(m_prox_event_count == 1 && m_prox_events[0] == VCNL4040_EVT_CLOSE);
+  CHECK(vcnl4040_is_close());
+  CHECK(vcnl4040_proximity_get() == 150);
+  CHECK(vcnl4040_model_int_pin(&m_prox)); // INT released by the flag read
+
+  prox_samples(90, 5); // Inside the hysteresis
+  CHECK(m_prox_event_count == 1);
+  prox_samples(20, 2);
+  CHECK(m_prox_event_count == 2 && m_prox_events[1] == VCNL4040_EVT_AWAY);
+  CHECK(!vcnl4040_is_close());
+  CHECK(p_stats->transactions == transactions + 2); // One read per state change
+
+  for (uint8_t i = 0; i <= I2C_BUS_QUEUE_SIZE; i++) { // One active, the rest queued
+    CHECK(i2c_bus_schedule(VCNL4040_BUS, &m_prox_filler) == NRF_SUCCESS);
+  }
+  CHECK(i2c_bus_schedule(VCNL4040_BUS, &m_prox_filler) == NRF_ERROR_NO_MEM);
+  vcnl4040_model_set_proximity(&m_prox, 150);
+  vcnl4040_model_set_proximity(&m_prox, 150); // INT asserted while the queue is full
+  CHECK(!vcnl4040_model_int_pin(&m_prox));
+  CHECK(i2c_bus_wait_idle(VCNL4040_BUS, 10) == NRF_SUCCESS);
+  host_sim_advance_us(VCNL4040_INT_RETRY_MS * 1000 + 100);
+  CHECK(i2c_bus_wait_idle(VCNL4040_BUS, 10) == NRF_SUCCESS);
+  CHECK(m_prox_event_count == 3 && m_prox_events[2] == VCNL4040_EVT_CLOSE); // The read was retried
+  CHECK(vcnl4040_model_int_pin(&m_prox));
+
+  CHECK(vcnl4040_proximity_int_enable(100, 80, 2, prox_event_handler) == NRF_ERROR_INVALID_PARAM);
+}
+
+/**
+ * @brief Checks the proximity filter: IIR step response, hysteresis and the 16-bit range.
+ */
+static void test_vcnl4040_filter(void) {
+  vcnl4040_filter_t filter;
+  uint8_t changes = 0;
+
+  CHECK(!vcnl4040_filter_init(&filter, 2, 100, 80));
+  CHECK(!vcnl4040_filter_init(&filter, VCNL4040_FILTER_MAX_SHIFT + 1, 80, 100));
+  CHECK(vcnl4040_filter_init(&filter, 2, 80, 100));
+
+  CHECK(!vcnl4040_filter_is_settled(&filter)); // Not fed yet
+  CHECK(!vcnl4040_filter_is_primed(&filter));
+  CHECK(!vcnl4040_filter_update(&filter, 50)); // First sample sets the value directly
+  CHECK(vcnl4040_filter_value(&filter) == 50);
+  CHECK(vcnl4040_filter_is_primed(&filter));
+  CHECK(vcnl4040_filter_is_settled(&filter));
+  CHECK(!vcnl4040_filter_update(&filter, 200));
+  CHECK(vcnl4040_filter_value(&filter) == 87); // 50 + (200 - 50) / 4
+  CHECK(!vcnl4040_filter_is_settled(&filter)); // Between the thresholds
+  CHECK(vcnl4040_filter_update(&filter, 200)); // 115: close
+  CHECK(vcnl4040_filter_is_close(&filter));
+  CHECK(vcnl4040_filter_is_settled(&filter));
+  CHECK(!vcnl4040_filter_update(&filter, 20)); // 92: between the thresholds, still close
+  CHECK(vcnl4040_filter_update(&filter, 20));  // 74: away
+  CHECK(!vcnl4040_filter_is_close(&filter));
+
+  CHECK(vcnl4040_filter_init(&filter, 3, 80, 100));
+  vcnl4040_filter_update(&filter, 85);
+  for (uint8_t i = 0; i < 100; i++) { // Raw noise crossing both thresholds
+    changes += vcnl4040_filter_update(&filter, (i & 1) ? 105 : 65);
+  }
+  CHECK(changes == 0);
+  changes += vcnl4040_filter_update(&filter, 180); // A single spike is smoothed out
+  CHECK(changes == 0);
+
+  CHECK(vcnl4040_filter_init(&filter, VCNL4040_FILTER_MAX_SHIFT, 1000, 60000));
+  vcnl4040_filter_update(&filter, 65535);
+  for (uint16_t i = 0; i < 1000; i++) {
+    vcnl4040_filter_update(&filter, 65535);
+  }
+  CHECK(vcnl4040_filter_value(&filter) == 65535); // No overflow, no truncation to 8 bits
+  CHECK(vcnl4040_filter_is_close(&filter));
+}
+
+/**
+ * @brief Checks the proximity presets: register encoding and that the interrupt setup is kept.
+ */
+static void test_vcnl4040_profiles(void) {
+  vcnl4040_ps_config_t high_response = VCNL4040_PS_CONFIG_HIGH_RESPONSE;
+  vcnl4040_ps_config_t low_power = VCNL4040_PS_CONFIG_LOW_POWER;
+  vcnl4040_ps_config_t standard = VCNL4040_PS_CONFIG_DEFAULT;
+
+  CHECK(vcnl4040_ps_config(&high_response) == NRF_SUCCESS);
+  CHECK(vcnl4040_model_reg(&m_prox, VCNL4040_CMD_PS_CONF1_2) == 0x0B14); // Duty 1/40, IT 2T, PS_HD, PS_INT/PS_PERS kept
+  CHECK(vcnl4040_model_reg(&m_prox, VCNL4040_CMD_PS_CONF3_MS) == 0x0220); // 2 pulses, 100 mA
+  CHECK(vcnl4040_ps_config(&low_power) == NRF_SUCCESS);
+  CHECK(vcnl4040_model_reg(&m_prox, VCNL4040_CMD_PS_CONF1_2) == 0x03D0);
+  CHECK(vcnl4040_model_reg(&m_prox, VCNL4040_CMD_PS_CONF3_MS) == 0x0000);
+  CHECK(vcnl4040_ps_config(&standard) == NRF_SUCCESS);
+  CHECK(vcnl4040_model_reg(&m_prox, VCNL4040_CMD_PS_CONF1_2) == 0x0390); // Same as written by vcnl4040_init
+  CHECK(i2c_bus_wait_idle(VCNL4040_BUS, 10) == NRF_SUCCESS);
+}
+
+/**
+ * @brief Checks the ambient light configuration and the combined proximity and ALS read.
+ */
+static void test_vcnl4040_als(void) {
+  i2c_bus_dev_stats_t const *p_stats;
+  uint32_t transactions;
+  vcnl4040_sample_t sample;
+
+  vcnl4040_model_set_ambient(&m_prox, 1000);
+  CHECK(vcnl4040_model_reg(&m_prox, VCNL4040_CMD_ALS_DATA) == 0); // Shut down after reset
+  CHECK(vcnl4040_als_config(VCNL4040_ALS_IT_320MS) == NRF_SUCCESS);
+  CHECK(vcnl4040_model_reg(&m_prox, VCNL4040_CMD_ALS_CONF) == 0x0080); // ALS_IT 320 ms, ALS_SD cleared
+
+  vcnl4040_model_set_ambient(&m_prox, 1000);
+  vcnl4040_model_set_proximity(&m_prox, 20);
+  CHECK(i2c_bus_wait_idle(VCNL4040_BUS, 10) == NRF_SUCCESS);
+  p_stats = i2c_bus_stats_get(VCNL4040_BUS, 0);
+  transactions = p_stats->transactions;
+  CHECK(vcnl4040_read_sample_start(NULL, NULL) == NRF_SUCCESS);
+  CHECK(vcnl4040_read_sample_start(NULL, NULL) == NRF_ERROR_BUSY);
+  CHECK(i2c_bus_wait_idle(VCNL4040_BUS, 10) == NRF_SUCCESS);
+  CHECK(p_stats->transactions == transactions + 1); // Both channels in one transaction
+  CHECK(vcnl4040_sample_get(&sample));
+  CHECK(sample.proximity == 20);
+  CHECK(sample.ambient == 1000);
+  CHECK(sample.timestamp_us != 0);
+  CHECK(vcnl4040_als_to_millilux(sample.ambient) == 25000); // 0.025 lux per count
+
+  CHECK(vcnl4040_als_config(VCNL4040_ALS_IT_640MS) == NRF_SUCCESS);
+  CHECK(vcnl4040_als_to_millilux(3) == 37); // 37.5 mlx rounded down
+  CHECK(vcnl4040_als_config(VCNL4040_ALS_IT_80MS) == NRF_SUCCESS);
+  CHECK(vcnl4040_als_to_millilux(65535) == 6553500);
+}
+
+/**
+ * @brief Checks that the proximity read in the background overlaps the IMU read.
+ */
+static void test_parallel(void) {
+  int16_t accel[3], gyro[3];
+  uint64_t start;
+  uint64_t serial_us, parallel_us;
+
+  start = host_sim_now_us();
+  readAccelGyroData(accel, gyro);
+  (void)read_proximity();
+  serial_us = host_sim_now_us() - start;
+
+  start = host_sim_now_us();
+  CHECK(vcnl4040_read_proximity_start(NULL, NULL) == NRF_SUCCESS);
+  readAccelGyroData(accel, gyro);
+  CHECK(i2c_bus_wait_idle(VCNL4040_BUS, 10) == NRF_SUCCESS);
+  parallel_us = host_sim_now_us() - start;
+
+  printf("IMU + proximity: serial %llu us, parallel %llu us\n", (unsigned long long)serial_us, (unsigned long long)parallel_us);
+  CHECK(parallel_us < serial_us);
+}
+
+/**
+ * @brief Checks how the drivers report injected bus faults.
+ */
+static void test_faults(void) {
+  static const i2c_script_op_t wake_script[] = {
+      I2C_SCRIPT_RMW8(ICM20948_REG_PWR_MGMT_1, 0x40, 0x00), // Clear SLEEP
+      I2C_SCRIPT_END()};
+  static const i2c_script_op_t delay_script[] = {
+      I2C_SCRIPT_DELAY_MS(10),
+      I2C_SCRIPT_RMW8(ICM20948_REG_PWR_MGMT_1, 0x40, 0x00),
+      I2C_SCRIPT_END()};
+  i2c_bus_dev_stats_t const *p_stats;
+  uint32_t nacks, timeouts;
+  uint8_t value;
+
+  i2c_bus_stats_reset();
+  host_twi_fault_inject(0, ICM20948_ADDRESS, HOST_TWI_FAULT_ADDRESS_NACK, 1);
+  CHECK(!testConnection());
+  CHECK(testConnection());
+  p_stats = i2c_bus_stats_get(I2CDEV_BUS, 0);
+  nacks = (p_stats != NULL) ? p_stats->nacks : 0;
+  CHECK(nacks == 1);
+
+  host_twi_fault_inject(0, ICM20948_ADDRESS, HOST_TWI_FAULT_DATA_NACK, 1);
+  CHECK(!writeByte(ICM20948_ADDRESS, 0x14, 0x10));
+
+  host_twi_fault_inject(0, ICM20948_ADDRESS, HOST_TWI_FAULT_STUCK, 1);
+  CHECK(!readByte(ICM20948_ADDRESS, WHO_AM_I_REG, &value, 5));
+  CHECK(testConnection()); // The bus recovers after the timeout
+  p_stats = i2c_bus_stats_get(I2CDEV_BUS, 0);
+  timeouts = (p_stats != NULL) ? p_stats->timeouts : 0;
+  CHECK(timeouts == 1);
+#if I2C_BUS_WAIT_SLEEP
+  CHECK(i2c_bus_wait_stats_get()->spins == 0); // Thread mode callers always sleep
+#endif
+
+  host_twi_fault_inject(1, VCNL4040_ADDRESS, HOST_TWI_FAULT_ADDRESS_NACK, 1);
+  CHECK(read_proximity() == 0xFFFF);
+
+  host_twi_fault_inject(0, ICM20948_ADDRESS, HOST_TWI_FAULT_STUCK, 1);
+  CHECK(i2c_script_perform(I2CDEV_BUS, ICM20948_ADDRESS, wake_script, 5) == NRF_ERROR_TIMEOUT);
+  CHECK(!i2c_script_is_running(I2CDEV_BUS)); // The stuck transaction was cancelled
+  CHECK(i2c_script_perform(I2CDEV_BUS, ICM20948_ADDRESS, wake_script, 5) == NRF_SUCCESS);
+  CHECK(i2c_script_perform(I2CDEV_BUS, ICM20948_ADDRESS, delay_script, 5) == NRF_ERROR_TIMEOUT);
+  CHECK(!i2c_script_is_running(I2CDEV_BUS)); // The delay timer was stopped
+  CHECK(i2c_script_perform(I2CDEV_BUS, ICM20948_ADDRESS, wake_script, 5) == NRF_SUCCESS);
+  host_sim_advance_us(20000); // Past the end of the aborted delay
+  CHECK(!i2c_script_is_running(I2CDEV_BUS));
+
+  host_app_timer_late_stop(true); // The timeout of the aborted delay is still delivered
+  CHECK(i2c_script_perform(I2CDEV_BUS, ICM20948_ADDRESS, delay_script, 5) == NRF_ERROR_TIMEOUT);
+  host_app_timer_late_stop(false);
+  CHECK(i2c_script_run(I2CDEV_BUS, ICM20948_ADDRESS, delay_script, NULL, NULL) == NRF_SUCCESS);
+  host_sim_advance_us(6000); // Past the end of the aborted delay
+  CHECK(i2c_script_is_running(I2CDEV_BUS)); // The new delay was not cut short
+  host_sim_advance_us(6000);
+  CHECK(!i2c_script_is_running(I2CDEV_BUS));
+}
+
+static uint8_t const *m_sampler_raw; // Last buffer received by sampler_handler
+static uint16_t m_sampler_count;     // Samples in m_sampler_raw
+static uint8_t m_sampler_calls;      // Number of sampler_handler calls
+
+/**
+ * @brief Stores a sample buffer, signature of imu_sampler_handler_t.
+ *
+ * @param p_raw Raw samples.
+ * @param sample_count Number of samples.
+ */
+static void sampler_handler(uint8_t const *p_raw, uint16_t sample_count) {
+  m_sampler_raw = p_raw;
+  m_sampler_count = sample_count;
+  m_sampler_calls++;
+}
+
+/**
+ * @brief Checks that the sampled buffer holds the model's motion values.
+ *
+ * @param accel_in Expected accelerometer values.
+ * @param gyro_in Expected gyroscope values.
+ * @return true if every sample matches.
+ */
+static bool sampler_buffer_matches(int16_t const accel_in[3], int16_t const gyro_in[3]) {
+  int16_t accel[3], gyro[3];
+
+  for (uint16_t i = 0; i < m_sampler_count; i++) {
+    decodeAccelGyroData(m_sampler_raw + i * IMU_SAMPLER_SAMPLE_SIZE, accel, gyro);
+    if ((memcmp(accel, accel_in, sizeof(accel)) != 0) || (memcmp(gyro, gyro_in, sizeof(gyro)) != 0)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * @brief Checks the autonomous IMU sampler: full buffers without CPU involvement per sample,
+ * a stop that waits for the transfer in flight and a stop that resets a stuck bus.
+ */
+static void test_imu_sampler(void) {
+  int16_t accel_in[3] = {123, -456, 789};
+  int16_t gyro_in[3] = {-10, 20, -30};
+  int16_t accel[3], gyro[3];
+  uint32_t transfers;
+  uint64_t start;
+
+  icm20948_model_set_motion(&m_imu, accel_in, gyro_in);
+  CHECK(imu_sampler_start() == NRF_ERROR_INVALID_STATE); // Not initialized
+  CHECK(imu_sampler_init(IMU_SAMPLER_MIN_PERIOD_US / 2, sampler_handler) == NRF_ERROR_INVALID_PARAM);
+  CHECK(imu_sampler_init(IMU_SAMPLER_MIN_PERIOD_US, sampler_handler) == NRF_SUCCESS);
+
+  transfers = host_twi_stats_get(0)->transfers;
+  CHECK(imu_sampler_start() == NRF_SUCCESS);
+  CHECK(imu_sampler_is_running());
+  CHECK(imu_sampler_start() == NRF_ERROR_INVALID_STATE);
+  host_sim_advance_us((IMU_SAMPLER_BUFFER_SAMPLES + 1) * IMU_SAMPLER_MIN_PERIOD_US - 100); // Just before the next trigger
+  CHECK(host_twi_stats_get(0)->transfers - transfers == IMU_SAMPLER_BUFFER_SAMPLES);
+  CHECK((m_sampler_calls == 1) && (m_sampler_count == IMU_SAMPLER_BUFFER_SAMPLES)); // One interrupt per buffer
+  CHECK(sampler_buffer_matches(accel_in, gyro_in));
+
+  host_sim_advance_us(2 * IMU_SAMPLER_MIN_PERIOD_US + 150); // Third transfer of the next buffer in flight
+  CHECK(nrf_drv_twi_is_busy(i2c_bus_twi_get(I2CDEV_BUS)));
+  start = host_sim_now_us();
+  imu_sampler_stop();
+  CHECK(host_sim_now_us() - start < IMU_SAMPLER_MIN_PERIOD_US); // Returns once that transfer is stopped
+  CHECK(!imu_sampler_is_running());
+  CHECK(!nrf_drv_twi_is_busy(i2c_bus_twi_get(I2CDEV_BUS)));
+  CHECK((m_sampler_calls == 2) && (m_sampler_count == 3)); // The completed transfer is counted
+  CHECK(sampler_buffer_matches(accel_in, gyro_in));
+  readAccelGyroData(accel, gyro); // The bus layer owns TWI0 again
+  CHECK(memcmp(accel, accel_in, sizeof(accel)) == 0);
+  CHECK(memcmp(gyro, gyro_in, sizeof(gyro)) == 0);
+
+  host_twi_fault_inject(0, ICM20948_ADDRESS, HOST_TWI_FAULT_STUCK, 1);
+  CHECK(imu_sampler_start() == NRF_SUCCESS);
+  host_sim_advance_us(2 * IMU_SAMPLER_MIN_PERIOD_US); // The first transfer never stops
+  start = host_sim_now_us();
+  imu_sampler_stop();
+  CHECK(host_sim_now_us() - start >= IMU_SAMPLER_STOP_TIMEOUT_US);
+  CHECK(!nrf_drv_twi_is_busy(i2c_bus_twi_get(I2CDEV_BUS)));
+  CHECK(m_sampler_calls == 2); // Nothing was sampled
+  CHECK(testConnection());     // The bus recovers after the reset
+}
+
+/**
+ * @brief Measures the simulated bus time and the host time per IMU sample read.
+ *
+ * @param reads Number of reads.
+ */
+static void bench_throughput(uint32_t reads) {
+  int16_t accel[3], gyro[3];
+  uint64_t sim_start = host_sim_now_us();
+  uint64_t sleep_start = host_sim_sleep_us();
+  uint64_t host_start = bench_host_ns();
+
+  for (uint32_t i = 0; i < reads; i++) {
+    readAccelGyroData(accel, gyro);
+  }
+  uint64_t sim_us = host_sim_now_us() - sim_start;
+  uint64_t host_ns = bench_host_ns() - host_start;
+  uint64_t sleep_us = host_sim_sleep_us() - sleep_start;
+
+  printf("readAccelGyroData: %u reads, %.1f us simulated per read (%.0f samples/s), %.0f ns host per read\n",
+      reads, (double)sim_us / reads, reads * 1e6 / sim_us, (double)host_ns / reads);
+  printf("CPU asleep %.1f %% of the time while reading\n", 100.0 * sleep_us / sim_us);
+#if I2C_BUS_WAIT_SLEEP
+  CHECK(sleep_us * 10 > sim_us * 9); // The blocking read sleeps for the transfer time
+#endif
+
+  sim_start = host_sim_now_us();
+  for (uint32_t i = 0; i < reads; i++) {
+    CHECK(vcnl4040_read_proximity_start(NULL, NULL) == NRF_SUCCESS);
+    readAccelGyroData(accel, gyro);
+    CHECK(i2c_bus_wait_idle(VCNL4040_BUS, 10) == NRF_SUCCESS);
+  }
+  sim_us = host_sim_now_us() - sim_start;
+  printf("IMU + proximity in parallel: %.1f us simulated per pair\n", (double)sim_us / reads);
+}
+
+/**
+ * @brief Prints the per-device statistics of the bus layer.
+ */
+static void bench_print_stats(void) {
+  char line[160];
+
+  i2c_bus_wait_stats_format(line, sizeof(line));
+  fputs(line, stdout);
+
+  for (uint8_t bus = 0; bus < I2C_BUS_COUNT; bus++) {
+    for (uint8_t i = 0; i < I2C_BUS_STATS_DEVICES; i++) {
+      if (i2c_bus_stats_format((i2c_bus_id_t)bus, i, line, sizeof(line)) > 0) {
+        fputs(line, stdout);
+      }
+    }
+  }
+}
+
+int main(int argc, char **argv) {
+  uint32_t speed = 0;
+  uint32_t latency = 0;
+  uint32_t reads = BENCH_DEFAULT_READS;
+
+  for (int i = 1; i < argc; i++) {
+    if ((strcmp(argv[i], "--speed") == 0) && (i + 1 < argc)) {
+      speed = strtoul(argv[++i], NULL, 0);
+    } else if ((strcmp(argv[i], "--latency") == 0) && (i + 1 < argc)) {
+      latency = strtoul(argv[++i], NULL, 0);
+    } else if ((strcmp(argv[i], "--reads") == 0) && (i + 1 < argc)) {
+      reads = strtoul(argv[++i], NULL, 0);
+    } else if (strcmp(argv[i], "--verbose") == 0) {
+      host_log_enabled = true;
+    } else {
+      fprintf(stderr, "usage: %s [--speed Hz] [--latency us] [--reads n] [--verbose]\n", argv[0]);
+      return 2;
+    }
+  }
+
+  host_sim_reset();
+  host_twi_reset();
+  host_timer_reset();
+  host_ppi_reset();
+  icm20948_model_init(&m_imu, 0, ICM20948_ADDRESS);
+  vcnl4040_model_init(&m_prox, 1);
+  for (uint8_t instance = 0; instance < HOST_TWI_INSTANCE_COUNT; instance++) {
+    host_twi_frequency_set(instance, speed);
+    host_twi_latency_set(instance, latency);
+  }
+
+  APP_ERROR_CHECK(app_timer_init());
+  TWI_initialize();
+  VCN4040_TWI_initialize();
+
+  test_icm20948();
+  test_icm20948_fifo();
+  test_script();
+  test_vcnl4040();
+  test_vcnl4040_int();
+  test_vcnl4040_profiles();
+  test_vcnl4040_filter();
+  test_vcnl4040_als();
+  test_parallel();
+  test_faults();
+  test_imu_sampler();
+  bench_throughput(reads);
+  bench_print_stats();
+
+  return bench_result();
+}
@@ -0,0 +1,294 @@
+#include "icm20948_model.h"
+#include "host_sim.h"
+#include <string.h>
+
+#define PWR_MGMT_1_DEVICE_RESET 0x80 // Bit 7
+#define PWR_MGMT_1_SLEEP 0x40        // Bit 6
+#define USER_CTRL_FIFO_EN 0x40       // Bit 6
+#define FIFO_EN_2_ACCEL 0x10         // Bit 4
+#define FIFO_EN_2_GYRO_Z 0x08        // Bit 3
+#define FIFO_EN_2_GYRO_Y 0x04        // Bit 2
+#define FIFO_EN_2_GYRO_X 0x02        // Bit 1
+#define FIFO_EN_2_TEMP 0x01          // Bit 0
+#define FIFO_MODE_SNAPSHOT 0x01      // Bit 0
+#define INT_STATUS_2_FIFO_OVERFLOW 0x01
+#define GYRO_BASE_RATE_HZ 1125
+
+/**
+ * @brief Loads the register reset values.
+ *
+ * @param p_model Model state.
+ */
+static void model_reset(icm20948_model_t *p_model) {
+  memset(p_model->regs, 0, sizeof(p_model->regs));
+  p_model->regs[0][ICM20948_REG_WHO_AM_I] = 0xEA;
+  p_model->regs[0][ICM20948_REG_PWR_MGMT_1] = 0x41; // Sleeping, auto clock select
+  p_model->regs[2][0x01] = 0x01;                    // GYRO_CONFIG_1
+  p_model->regs[2][0x14] = 0x01;                    // ACCEL_CONFIG
+  p_model->bank = 0;
+  p_model->pointer = 0;
+  p_model->fifo_head = 0;
+  p_model->fifo_count = 0;
+  p_model->fifo_time_us = host_sim_now_us();
+}
+
+/**
+ * @brief Checks whether the device is sleeping (PWR_MGMT_1.SLEEP).
+ *
+ * @param p_model Model state.
+ * @return true if the device is sleeping.
+ */
+bool icm20948_model_sleeping(icm20948_model_t const *p_model) {
+  return (p_model->regs[0][ICM20948_REG_PWR_MGMT_1] & PWR_MGMT_1_SLEEP) != 0;
+}
+
+/**
+ * @brief Appends a byte to the FIFO, honouring stream and snapshot mode.
+ *
+ * @param p_model Model state.
+ * @param byte Byte to append.
+ */
+static void fifo_push(icm20948_model_t *p_model, uint8_t byte) {
+  if (p_model->fifo_count == ICM20948_MODEL_FIFO_SIZE) {
+    p_model->regs[0][ICM20948_REG_INT_STATUS_2] |= INT_STATUS_2_FIFO_OVERFLOW;
+    if (p_model->regs[0][ICM20948_REG_FIFO_MODE] & FIFO_MODE_SNAPSHOT) {
+      return; // Snapshot: stop writing when full
+    }
+    p_model->fifo_head = (p_model->fifo_head + 1) % ICM20948_MODEL_FIFO_SIZE; // Stream: drop the oldest byte
+    p_model->fifo_count--;
+  }
+  p_model->fifo[(p_model->fifo_head + p_model->fifo_count) % ICM20948_MODEL_FIFO_SIZE] = byte;
+  p_model->fifo_count++;
+}
+
+/**
+ * @brief Appends a big-endian 16-bit value to the FIFO.
+ *
+ * @param p_model Model state.
+ * @param value Value to append.
+ */
+static void fifo_push16(icm20948_model_t *p_model, int16_t value) {
+  fifo_push(p_model, (uint16_t)value >> 8);
+  fifo_push(p_model, value & 0xFF);
+}
+
+/**
+ * @brief Brings the FIFO up to the current simulated time.
+ *
+ * @param p_model Model state.
+ */
+static void fifo_update(icm20948_model_t *p_model) {
+  uint64_t now = host_sim_now_us();
+  uint64_t period = (1000000ULL * (1 + p_model->regs[2][ICM20948_REG_GYRO_SMPLRT_DIV])) / GYRO_BASE_RATE_HZ;
+  uint8_t enabled = p_model->regs[0][ICM20948_REG_FIFO_EN_2];
+
+  if (icm20948_model_sleeping(p_model) || !(p_model->regs[0][ICM20948_REG_USER_CTRL] & USER_CTRL_FIFO_EN) || (enabled == 0)) {
+    p_model->fifo_time_us = now;
+    return;
+  }
+  while (p_model->fifo_time_us + period <= now) {
+    p_model->fifo_time_us += period;
+    if (enabled & FIFO_EN_2_ACCEL) { // Sample order: accel, gyro, temperature
+      for (uint8_t axis = 0; axis < 3; axis++) {
+        fifo_push16(p_model, p_model->accel[axis]);
+      }
+    }
+    if (enabled & FIFO_EN_2_GYRO_X) {
+      fifo_push16(p_model, p_model->gyro[0]);
+    }
+    if (enabled & FIFO_EN_2_GYRO_Y) {
+      fifo_push16(p_model, p_model->gyro[1]);
+    }
+    if (enabled & FIFO_EN_2_GYRO_Z) {
+      fifo_push16(p_model, p_model->gyro[2]);
+    }
+    if (enabled & FIFO_EN_2_TEMP) {
+      fifo_push16(p_model, p_model->temp);
+    }
+  }
+}
+
+/**
+ * @brief Returns the value of a register as seen by a bus read.
+ *
+ * @param p_model Model state.
+ * @param reg Register address in the selected bank.
+ * @return Register value.
+ */
+static uint8_t model_read_reg(icm20948_model_t *p_model, uint8_t reg) {
+  if (reg == ICM20948_REG_BANK_SEL) {
+    return p_model->bank << 4;
+  }
+  if (p_model->bank != 0) {
+    return p_model->regs[p_model->bank][reg];
+  }
+
+  if ((reg >= ICM20948_REG_ACCEL_XOUT_H) && (reg < ICM20948_REG_TEMP_OUT_H + 2)) { // Sensor outputs, big-endian
+    int16_t outputs[7] = {p_model->accel[0], p_model->accel[1], p_model->accel[2],
+        p_model->gyro[0], p_model->gyro[1], p_model->gyro[2], p_model->temp};
+    uint8_t index = reg - ICM20948_REG_ACCEL_XOUT_H;
+    uint16_t value = icm20948_model_sleeping(p_model) ? 0 : (uint16_t)outputs[index / 2];
+    return (index & 1) ? (value & 0xFF) : (value >> 8);
+  }
+  if ((reg == ICM20948_REG_PWR_MGMT_1) && (host_sim_now_us() >= p_model->reset_until_us)) {
+    p_model->regs[0][reg] &= ~PWR_MGMT_1_DEVICE_RESET; // Self-clearing
+  }
+  if (reg == ICM20948_REG_INT_STATUS_2) {
+    uint8_t value = p_model->regs[0][reg];
+    p_model->regs[0][reg] = 0; // Cleared on read
+    return value;
+  }
+  if ((reg == ICM20948_REG_FIFO_COUNTH) || (reg == ICM20948_REG_FIFO_COUNTH + 1)) {
+    fifo_update(p_model);
+    return (reg == ICM20948_REG_FIFO_COUNTH) ? (p_model->fifo_count >> 8) : (p_model->fifo_count & 0xFF);
+  }
+  if (reg == ICM20948_REG_FIFO_R_W) {
+    uint8_t value = 0xFF; // Reading an empty FIFO returns 0xFF
+    fifo_update(p_model);
+    if (p_model->fifo_count > 0) {
+      value = p_model->fifo[p_model->fifo_head];
+      p_model->fifo_head = (p_model->fifo_head + 1) % ICM20948_MODEL_FIFO_SIZE;
+      p_model->fifo_count--;
+    }
+    return value;
+  }
+  return p_model->regs[0][reg];
+}
+
+/**
+ * @brief Applies a bus write to a register.
+ *
+ * @param p_model Model state.
+ * @param reg Register address in the selected bank.
+ * @param value Written value.
+ */
+static void model_write_reg(icm20948_model_t *p_model, uint8_t reg, uint8_t value) {
+  if (reg == ICM20948_REG_BANK_SEL) {
+    p_model->bank = (value >> 4) & 0x03;
+    return;
+  }
+  if (p_model->bank != 0) {
+    p_model->regs[p_model->bank][reg] = value;
+    return;
+  }
+
+  switch (reg) {
+  case ICM20948_REG_WHO_AM_I: // Read-only registers
+  case ICM20948_REG_FIFO_COUNTH:
+  case ICM20948_REG_FIFO_COUNTH + 1:
+    break;
+
+  case ICM20948_REG_PWR_MGMT_1:
+    if (value & PWR_MGMT_1_DEVICE_RESET) {
+      model_reset(p_model);
+      p_model->regs[0][reg] |= PWR_MGMT_1_DEVICE_RESET;
+      p_model->reset_until_us = host_sim_now_us() + ICM20948_MODEL_RESET_TIME_US;
+    } else {
+      fifo_update(p_model); // Samples up to now were taken in the old power state
+      p_model->regs[0][reg] = value;
+    }
+    break;
+
+  case ICM20948_REG_FIFO_RST:
+    if (value & 0x1F) {
+      p_model->fifo_head = 0;
+      p_model->fifo_count = 0;
+      p_model->fifo_time_us = host_sim_now_us();
+    }
+    p_model->regs[0][reg] = value;
+    break;
+
+  case ICM20948_REG_FIFO_R_W:
+    fifo_push(p_model, value);
+    break;
+
+  case ICM20948_REG_USER_CTRL:
+  case ICM20948_REG_FIFO_EN_2:
+    fifo_update(p_model); // Apply the new configuration from now on
+    p_model->regs[0][reg] = value;
+    break;
+
+  default:
+    if ((reg >= ICM20948_REG_ACCEL_XOUT_H) && (reg < ICM20948_REG_TEMP_OUT_H + 2)) {
+      break; // Sensor outputs are read-only
+    }
+    p_model->regs[0][reg] = value;
+    break;
+  }
+}
+
+/**
+ * @brief Bus write callback: the first byte sets the register pointer, the rest are written
+ *        to consecutive registers.
+ */
+static void model_bus_write(void *p_context, uint8_t const *p_data, size_t length) {
+  icm20948_model_t *p_model = (icm20948_model_t *)p_context;
+
+  if (length == 0) {
+    return;
+  }
+  p_model->pointer = p_data[0] & 0x7F;
+  for (size_t i = 1; i < length; i++) {
+    model_write_reg(p_model, p_model->pointer, p_data[i]);
+    if (p_model->pointer != ICM20948_REG_FIFO_R_W) {
+      p_model->pointer = (p_model->pointer + 1) & 0x7F;
+    }
+  }
+}
+
+/**
+ * @brief Bus read callback: reads consecutive registers, FIFO_R_W does not advance the pointer.
+ */
+static void model_bus_read(void *p_context, uint8_t *p_data, size_t length) {
+  icm20948_model_t *p_model = (icm20948_model_t *)p_context;
+
+  for (size_t i = 0; i < length; i++) {
+    p_data[i] = model_read_reg(p_model, p_model->pointer);
+    if ((p_model->pointer != ICM20948_REG_FIFO_R_W) || (p_model->bank != 0)) {
+      p_model->pointer = (p_model->pointer + 1) & 0x7F;
+    }
+  }
+}
+
+/**
+ * @brief Initializes the model with reset values and attaches it to a bus.
+ *
+ * @param p_model Model state.
+ * @param instance TWI instance the device is connected to.
+ * @param address 7-bit slave address (0x68 or 0x69 depending on AD0).
+ */
+void icm20948_model_init(icm20948_model_t *p_model, uint8_t instance, uint8_t address) {
+  memset(p_model, 0, sizeof(*p_model));
+  model_reset(p_model);
+  p_model->temp = 0x0A00; // Some room temperature reading
+  p_model->device.address = address;
+  p_model->device.p_model = p_model;
+  p_model->device.write = model_bus_write;
+  p_model->device.read = model_bus_read;
+  host_twi_attach(instance, &p_model->device);
+}
+
+/**
+ * @brief Sets the values reported by the output registers and stored in the FIFO.
+ *
+ * @param p_model Model state.
+ * @param accel Accelerometer X, Y, Z.
+ * @param gyro Gyroscope X, Y, Z.
+ */
+void icm20948_model_set_motion(icm20948_model_t *p_model, int16_t const accel[3], int16_t const gyro[3]) {
+  fifo_update(p_model); // Samples up to now keep the previous values
+  memcpy(p_model->accel, accel, sizeof(p_model->accel));
+  memcpy(p_model->gyro, gyro, sizeof(p_model->gyro));
+}
+
+/**
+ * @brief Returns a register of a bank as currently stored in the model.
+ *
+ * @param p_model Model state.
+ * @param bank User bank.
+ * @param reg Register address.
+ * @return Register value.
+ */
+uint8_t icm20948_model_reg(icm20948_model_t *p_model, uint8_t bank, uint8_t reg) {
+  return p_model->regs[bank & 0x03][reg & 0x7F];
+}
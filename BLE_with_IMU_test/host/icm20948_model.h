@@ -0,0 +1,93 @@
+#ifndef _ICM20948_MODEL_H_
+#define _ICM20948_MODEL_H_
+
+#include "host_twi.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @file icm20948_model.h
+ * @brief Register-level model of the ICM-20948 for the simulated TWI bus.
+ *
+ * Models the four user banks selected through REG_BANK_SEL, the auto-incrementing register
+ * pointer, reset values, sleep mode and DEVICE_RESET, the accelerometer/gyroscope/temperature
+ * output registers and the 512 byte FIFO filled at the gyroscope sample rate
+ * (1125 Hz / (1 + GYRO_SMPLRT_DIV)) in stream or snapshot mode.
+ */
+
+#define ICM20948_MODEL_BANKS 4            ///< User banks 0..3
+#define ICM20948_MODEL_BANK_SIZE 128      ///< Registers per bank
+#define ICM20948_MODEL_FIFO_SIZE 512      ///< FIFO size in bytes
+#define ICM20948_MODEL_RESET_TIME_US 1000 ///< Time DEVICE_RESET stays set after a reset
+
+/* Register addresses used by the model, bank 0 unless noted otherwise */
+#define ICM20948_REG_WHO_AM_I 0x00
+#define ICM20948_REG_USER_CTRL 0x03
+#define ICM20948_REG_PWR_MGMT_1 0x06
+#define ICM20948_REG_PWR_MGMT_2 0x07
+#define ICM20948_REG_INT_STATUS_2 0x1B
+#define ICM20948_REG_ACCEL_XOUT_H 0x2D
+#define ICM20948_REG_TEMP_OUT_H 0x39
+#define ICM20948_REG_FIFO_EN_2 0x67
+#define ICM20948_REG_FIFO_RST 0x68
+#define ICM20948_REG_FIFO_MODE 0x69
+#define ICM20948_REG_FIFO_COUNTH 0x70
+#define ICM20948_REG_FIFO_R_W 0x72
+#define ICM20948_REG_GYRO_SMPLRT_DIV 0x00 ///< Bank 2
+#define ICM20948_REG_BANK_SEL 0x7F        ///< All banks
+
+/**
+ * @brief State of one ICM-20948.
+ */
+typedef struct {
+  host_twi_device_t device;                                     ///< Bus attachment
+  uint8_t regs[ICM20948_MODEL_BANKS][ICM20948_MODEL_BANK_SIZE]; ///< Register file
+  uint8_t bank;                                                 ///< Selected user bank
+  uint8_t pointer;                                              ///< Register pointer
+  int16_t accel[3];                                             ///< Current accelerometer output
+  int16_t gyro[3];                                              ///< Current gyroscope output
+  int16_t temp;                                                 ///< Current temperature output
+  uint8_t fifo[ICM20948_MODEL_FIFO_SIZE];                       ///< FIFO contents
+  uint16_t fifo_head;                                           ///< Index of the oldest FIFO byte
+  uint16_t fifo_count;                                          ///< Bytes in the FIFO
+  uint64_t fifo_time_us;                                        ///< Time of the last FIFO sample
+  uint64_t reset_until_us;                                      ///< End of a DEVICE_RESET
+} icm20948_model_t;
+
+/**
+ * @brief Initializes the model with reset values and attaches it to a bus.
+ *
+ * @param p_model Model state.
+ * @param instance TWI instance the device is connected to.
+ * @param address 7-bit slave address (0x68 or 0x69 depending on AD0).
+ */
+void icm20948_model_init(icm20948_model_t *p_model, uint8_t instance, uint8_t address);
+
+/**
+ * @brief Sets the values reported by the output registers and stored in the FIFO.
+ *
+ * @param p_model Model state.
+ * @param accel Accelerometer X, Y, Z.
+ * @param gyro Gyroscope X, Y, Z.
+ */
+void icm20948_model_set_motion(icm20948_model_t *p_model, int16_t const accel[3], int16_t const gyro[3]);
+
+/**
+ * @brief Returns a register of a bank as currently stored in the model.
+ *
+ * @param p_model Model state.
+ * @param bank User bank.
+ * @param reg Register address.
+ * @return Register value.
+ */
+uint8_t icm20948_model_reg(icm20948_model_t *p_model, uint8_t bank, uint8_t reg);
+
+/**
+ * @brief Checks whether the device is sleeping (PWR_MGMT_1.SLEEP).
+ *
+ * @param p_model Model state.
+ * @return true if the device is sleeping.
+ */
+bool icm20948_model_sleeping(icm20948_model_t const *p_model);
+
+#endif // _ICM20948_MODEL_H_
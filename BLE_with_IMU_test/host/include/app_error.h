@@ -0,0 +1,46 @@
+#ifndef _HOST_APP_ERROR_H_
+#define _HOST_APP_ERROR_H_
+
+/**
+ * @file app_error.h
+ * @brief Host replacement for the SDK error codes and error handler.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+typedef uint32_t ret_code_t;
+
+#define NRF_SUCCESS 0
+#define NRF_ERROR_INTERNAL 3
+#define NRF_ERROR_NO_MEM 4
+#define NRF_ERROR_NOT_FOUND 5
+#define NRF_ERROR_NOT_SUPPORTED 6
+#define NRF_ERROR_INVALID_PARAM 7
+#define NRF_ERROR_INVALID_STATE 8
+#define NRF_ERROR_INVALID_LENGTH 9
+#define NRF_ERROR_DATA_SIZE 12
+#define NRF_ERROR_TIMEOUT 13
+#define NRF_ERROR_BUSY 17
+#define NRF_ERROR_RESOURCES 19
+#define NRF_ERROR_MODULE_ALREADY_INITIALIZED 0x8005
+#define NRF_ERROR_DRV_TWI_ERR_OVERRUN 0x8200
+#define NRF_ERROR_DRV_TWI_ERR_ANACK 0x8201
+#define NRF_ERROR_DRV_TWI_ERR_DNACK 0x8202
+
+#define APP_ERROR_HANDLER(err_code)                                                         \
+  do {                                                                                      \
+    fprintf(stderr, "%s:%d: error 0x%lX\n", __FILE__, __LINE__, (unsigned long)(err_code)); \
+    abort();                                                                                \
+  } while (0)
+
+#define APP_ERROR_CHECK(err_code)               \
+  do {                                          \
+    const uint32_t local_err_code = (err_code); \
+    if (local_err_code != NRF_SUCCESS) {        \
+      APP_ERROR_HANDLER(local_err_code);        \
+    }                                           \
+  } while (0)
+
+#endif // _HOST_APP_ERROR_H_
@@ -0,0 +1,48 @@
+#ifndef _HOST_APP_TIMER_H_
+#define _HOST_APP_TIMER_H_
+
+/**
+ * @file app_timer.h
+ * @brief Host replacement for app_timer, running on the simulated clock of host_sim.c.
+ */
+
+#include "app_error.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#define APP_TIMER_CLOCK_FREQ 32768
+#define APP_TIMER_MIN_TIMEOUT_TICKS 5
+#define APP_TIMER_TICKS(ms) ((uint32_t)(((uint64_t)(ms) * APP_TIMER_CLOCK_FREQ) / 1000))
+
+typedef void (*app_timer_timeout_handler_t)(void *p_context);
+
+typedef enum {
+  APP_TIMER_MODE_SINGLE_SHOT,
+  APP_TIMER_MODE_REPEATED
+} app_timer_mode_t;
+
+typedef struct {
+  app_timer_timeout_handler_t handler; ///< Timeout handler
+  app_timer_mode_t mode;               ///< Single shot or repeated
+  uint32_t ticks;                      ///< Period of a repeated timer
+  uint64_t expiry_us;                  ///< Simulated time of the next timeout
+  void *p_context;                     ///< Passed to the handler
+  bool active;                         ///< Set while the timer is running
+  uint64_t late_expiry_us;             ///< Time of the timeout left pending by a late stop
+  void *p_late_context;                ///< Context of the timeout left pending by a late stop
+  bool late;                           ///< Set while a timeout left pending by a late stop is due
+} app_timer_t;
+
+typedef app_timer_t *app_timer_id_t;
+
+#define APP_TIMER_DEF(timer_id)             \
+  static app_timer_t timer_id##_data = {0}; \
+  static const app_timer_id_t timer_id = &timer_id##_data
+
+ret_code_t app_timer_init(void);
+ret_code_t app_timer_create(app_timer_id_t const *p_timer_id, app_timer_mode_t mode, app_timer_timeout_handler_t timeout_handler);
+ret_code_t app_timer_start(app_timer_id_t timer_id, uint32_t timeout_ticks, void *p_context);
+ret_code_t app_timer_stop(app_timer_id_t timer_id);
+uint32_t app_timer_cnt_get(void);
+
+#endif // _HOST_APP_TIMER_H_
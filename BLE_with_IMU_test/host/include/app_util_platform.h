@@ -0,0 +1,37 @@
+#ifndef _HOST_APP_UTIL_PLATFORM_H_
+#define _HOST_APP_UTIL_PLATFORM_H_
+
+/**
+ * @file app_util_platform.h
+ * @brief Host replacement for the SDK platform utilities.
+ *
+ * Critical regions defer the simulated interrupts of host_sim.c instead of masking IRQs.
+ */
+
+#include "host_sim.h"
+#include <stdint.h>
+
+#define APP_IRQ_PRIORITY_HIGH 2
+#define APP_IRQ_PRIORITY_MID 4
+#define APP_IRQ_PRIORITY_LOW 6
+#define APP_IRQ_PRIORITY_LOWEST 7
+
+#define CRITICAL_REGION_ENTER() \
+  {                             \
+    host_sim_critical_enter();
+
+#define CRITICAL_REGION_EXIT()  \
+  host_sim_critical_exit();     \
+  }
+
+#ifndef MIN
+#define MIN(a, b) ((a) < (b) ? (a) : (b))
+#endif
+#ifndef MAX
+#define MAX(a, b) ((a) < (b) ? (b) : (a))
+#endif
+#define UNUSED_VARIABLE(x) (void)(x)
+#define UNUSED_PARAMETER(x) (void)(x)
+#define ARRAY_SIZE(arr) (sizeof(arr) / sizeof((arr)[0]))
+
+#endif // _HOST_APP_UTIL_PLATFORM_H_
@@ -0,0 +1,9 @@
+#ifndef _HOST_BOARDS_H_
+#define _HOST_BOARDS_H_
+
+/**
+ * @file boards.h
+ * @brief Host replacement for the board definitions (no LEDs or buttons are simulated).
+ */
+
+#endif // _HOST_BOARDS_H_
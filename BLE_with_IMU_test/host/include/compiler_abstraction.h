@@ -0,0 +1,13 @@
+#ifndef _HOST_COMPILER_ABSTRACTION_H_
+#define _HOST_COMPILER_ABSTRACTION_H_
+
+/**
+ * @file compiler_abstraction.h
+ * @brief Host replacement for the SDK compiler abstraction.
+ */
+
+#define __STATIC_INLINE static inline
+#define __WEAK __attribute__((weak))
+#define __ALIGN(n) __attribute__((aligned(n)))
+
+#endif // _HOST_COMPILER_ABSTRACTION_H_
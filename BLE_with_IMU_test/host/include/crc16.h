@@ -0,0 +1,21 @@
+#ifndef _HOST_CRC16_H_
+#define _HOST_CRC16_H_
+
+/**
+ * @file crc16.h
+ * @brief Host replacement for the SDK CRC-16 library, implemented in host_crc16.c with the same algorithm.
+ */
+
+#include <stdint.h>
+
+/**
+ * @brief Computes the CRC-16/CCITT of a block, as crc16_compute of the SDK.
+ *
+ * @param p_data Data.
+ * @param size Length of the data.
+ * @param p_crc Previous CRC to continue from, NULL to start with 0xFFFF.
+ * @return CRC of the data.
+ */
+uint16_t crc16_compute(uint8_t const *p_data, uint32_t size, uint16_t const *p_crc);
+
+#endif // _HOST_CRC16_H_
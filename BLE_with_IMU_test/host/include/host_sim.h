@@ -0,0 +1,117 @@
+#ifndef _HOST_SIM_H_
+#define _HOST_SIM_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @file host_sim.h
+ * @brief Simulated time and interrupt context for running the sensor drivers on a PC.
+ *
+ * Time only advances when the firmware waits: every access to NRF_TIMER1 costs
+ * HOST_SIM_TIMER_ACCESS_US of simulated CPU time, nrf_delay_* advance it by the requested
+ * amount and __WFE skips to the next event. Whenever time advances, due events (TWI transfer
+ * completions, app_timer timeouts, PWM sequence ends, TIMER compares) are delivered by calling their handlers
+ * as if they were interrupts: never while a critical region is open and never nested inside
+ * another simulated interrupt.
+ */
+
+#define HOST_SIM_TIMER_ACCESS_US 1 ///< Simulated cost of one TIMER1 access (one busy-wait loop iteration)
+
+/**
+ * @brief Resets the simulated clock to zero.
+ */
+void host_sim_reset(void);
+
+/**
+ * @brief Returns the current simulated time.
+ *
+ * @return Time in microseconds.
+ */
+uint64_t host_sim_now_us(void);
+
+/**
+ * @brief Advances the simulated time, delivering the events that become due on the way.
+ *
+ * @param us Microseconds to advance.
+ */
+void host_sim_advance_us(uint32_t us);
+
+/**
+ * @brief Runs until no more events are pending or the limit is reached.
+ *
+ * @param limit_us Maximum simulated time to advance.
+ */
+void host_sim_run_until_idle(uint32_t limit_us);
+
+/**
+ * @brief Enters a critical region: simulated interrupts are deferred.
+ */
+void host_sim_critical_enter(void);
+
+/**
+ * @brief Leaves a critical region and delivers events that became due meanwhile.
+ */
+void host_sim_critical_exit(void);
+
+/**
+ * @brief Checks whether code is running in a simulated interrupt.
+ *
+ * @return true inside an event handler.
+ */
+bool host_sim_in_isr(void);
+
+/**
+ * @brief Checks whether code is running in a critical region.
+ *
+ * @return true between host_sim_critical_enter and the matching host_sim_critical_exit.
+ */
+bool host_sim_in_critical(void);
+
+/**
+ * @brief Backs __WFE: sleeps until the next simulated event unless the event register is set.
+ *
+ * Wakes up for TWI completions, app_timer timeouts, PWM events, TIMER compare events (host_timer.c)
+ * and TIMER1 compare events whose interrupt is enabled (INTENSET), and clears the event register.
+ */
+void host_sim_wfe(void);
+
+/**
+ * @brief Returns the simulated time the CPU spent sleeping in __WFE.
+ *
+ * @return Time in microseconds.
+ */
+uint64_t host_sim_sleep_us(void);
+
+/**
+ * @brief Backs __SEV: sets the event register.
+ */
+void host_sim_sev(void);
+
+/**
+ * @brief Event source hooks, implemented by host_twi.c, host_app_timer.c, host_pwm.c and host_timer.c.
+ *
+ * next_due returns UINT64_MAX if the source has no pending event, run_due delivers all
+ * events of the source that are due at the given time.
+ */
+uint64_t host_twi_next_due(void);
+void host_twi_run_due(uint64_t now_us);
+uint64_t host_app_timer_next_due(void);
+void host_app_timer_run_due(uint64_t now_us);
+
+/**
+ * @brief Makes app_timer_stop leave the pending timeout of a running timer in place.
+ *
+ * Models a timeout that was already queued when the timer was stopped: the handler is
+ * still called once, with the old context, at the old expiry time.
+ *
+ * @param enable true to delay the stops of the following app_timer_stop calls.
+ */
+void host_app_timer_late_stop(bool enable);
+
+uint64_t host_pwm_next_due(void);
+void host_pwm_run_due(uint64_t now_us);
+uint64_t host_timer_next_due(void);
+void host_timer_run_due(uint64_t now_us);
+
+#endif // _HOST_SIM_H_
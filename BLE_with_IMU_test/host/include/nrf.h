@@ -0,0 +1,58 @@
+#ifndef _HOST_NRF_H_
+#define _HOST_NRF_H_
+
+/**
+ * @file nrf.h
+ * @brief Host replacement for the nRF52 register definitions used by the drivers.
+ *
+ * NRF_TIMER1 is backed by the simulated clock: every access lets pending simulated interrupts
+ * run and executes the CAPTURE and INTENSET/INTENCLR writes of the previous access, so a
+ * capture followed by a CC read returns the current simulated time. __WFE sleeps until the
+ * next simulated event, including an enabled TIMER1 compare.
+ */
+
+#include "host_sim.h"
+#include <stdint.h>
+
+typedef struct {
+  volatile uint32_t TASKS_START;
+  volatile uint32_t TASKS_STOP;
+  volatile uint32_t TASKS_COUNT;
+  volatile uint32_t TASKS_CLEAR;
+  volatile uint32_t TASKS_CAPTURE[6];
+  volatile uint32_t EVENTS_COMPARE[6];
+  volatile uint32_t INTENSET;
+  volatile uint32_t INTENCLR;
+  volatile uint32_t MODE;
+  volatile uint32_t BITMODE;
+  volatile uint32_t PRESCALER;
+  volatile uint32_t CC[6];
+} NRF_TIMER_Type;
+
+#define TIMER_MODE_MODE_Timer 0
+#define TIMER_BITMODE_BITMODE_32Bit 3
+#define TIMER_BITMODE_BITMODE_Pos 0
+#define TIMER_INTENSET_COMPARE0_Msk (1UL << 16)
+
+typedef struct {
+  volatile uint32_t SCR;
+} SCB_Type;
+
+#define SCB_SCR_SEVONPEND_Msk (1UL << 4)
+
+typedef enum {
+  TIMER1_IRQn = 9
+} IRQn_Type;
+
+NRF_TIMER_Type *host_sim_timer1(void);
+#define NRF_TIMER1 (host_sim_timer1())
+
+extern SCB_Type host_sim_scb;
+#define SCB (&host_sim_scb)
+
+#define __WFE() host_sim_wfe()
+#define __SEV() host_sim_sev()
+#define __get_IPSR() (host_sim_in_isr() ? 16u : 0u)
+#define NVIC_ClearPendingIRQ(irq) ((void)(irq))
+
+#endif // _HOST_NRF_H_
@@ -0,0 +1,14 @@
+#ifndef _HOST_NRF_DELAY_H_
+#define _HOST_NRF_DELAY_H_
+
+/**
+ * @file nrf_delay.h
+ * @brief Host replacement for the busy-wait delays: they advance the simulated clock.
+ */
+
+#include "host_sim.h"
+
+#define nrf_delay_us(us) host_sim_advance_us(us)
+#define nrf_delay_ms(ms) host_sim_advance_us((uint32_t)(ms) * 1000)
+
+#endif // _HOST_NRF_DELAY_H_
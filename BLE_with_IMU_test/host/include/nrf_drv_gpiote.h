@@ -0,0 +1,68 @@
+#ifndef _HOST_NRF_DRV_GPIOTE_H_
+#define _HOST_NRF_DRV_GPIOTE_H_
+
+/**
+ * @file nrf_drv_gpiote.h
+ * @brief Host replacement for the legacy GPIOTE driver input API, implemented in host_gpiote.c.
+ *
+ * Input pins are driven by the device models through host_gpiote_input_set(); an edge
+ * matching the configured sense calls the pin's handler.
+ */
+
+#include "app_error.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#define HOST_GPIO_PIN_COUNT 32 ///< P0.00 .. P0.31
+
+typedef uint32_t nrf_drv_gpiote_pin_t;
+
+typedef enum {
+  NRF_GPIOTE_POLARITY_LOTOHI = 1,
+  NRF_GPIOTE_POLARITY_HITOLO,
+  NRF_GPIOTE_POLARITY_TOGGLE
+} nrf_gpiote_polarity_t;
+
+typedef enum {
+  NRF_GPIO_PIN_NOPULL,
+  NRF_GPIO_PIN_PULLDOWN,
+  NRF_GPIO_PIN_PULLUP = 3
+} nrf_gpio_pin_pull_t;
+
+typedef struct {
+  nrf_gpiote_polarity_t sense; ///< Edge that calls the handler
+  nrf_gpio_pin_pull_t pull;    ///< Level of an undriven pin
+  bool is_watcher;
+  bool hi_accuracy;
+  bool skip_gpio_setup;
+} nrf_drv_gpiote_in_config_t;
+
+typedef void (*nrf_drv_gpiote_evt_handler_t)(nrf_drv_gpiote_pin_t pin, nrf_gpiote_polarity_t action);
+
+#define GPIOTE_CONFIG_IN_SENSE_HITOLO(hi_accu) \
+  {.sense = NRF_GPIOTE_POLARITY_HITOLO, .pull = NRF_GPIO_PIN_NOPULL, .is_watcher = false, .hi_accuracy = (hi_accu), .skip_gpio_setup = false}
+
+bool nrf_drv_gpiote_is_init(void);
+ret_code_t nrf_drv_gpiote_init(void);
+ret_code_t nrf_drv_gpiote_in_init(nrf_drv_gpiote_pin_t pin, nrf_drv_gpiote_in_config_t const *p_config, nrf_drv_gpiote_evt_handler_t evt_handler);
+void nrf_drv_gpiote_in_uninit(nrf_drv_gpiote_pin_t pin);
+void nrf_drv_gpiote_in_event_enable(nrf_drv_gpiote_pin_t pin, bool int_enable);
+void nrf_drv_gpiote_in_event_disable(nrf_drv_gpiote_pin_t pin);
+bool nrf_drv_gpiote_in_is_set(nrf_drv_gpiote_pin_t pin);
+
+/**
+ * @brief Drives an input pin from a device model.
+ *
+ * @param pin Pin number.
+ * @param level New level.
+ */
+void host_gpiote_input_set(uint32_t pin, bool level);
+
+/**
+ * @brief Releases an input pin, which then follows its pull resistor.
+ *
+ * @param pin Pin number.
+ */
+void host_gpiote_input_release(uint32_t pin);
+
+#endif // _HOST_NRF_DRV_GPIOTE_H_
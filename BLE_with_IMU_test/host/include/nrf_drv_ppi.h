@@ -0,0 +1,26 @@
+#ifndef _HOST_NRF_DRV_PPI_H_
+#define _HOST_NRF_DRV_PPI_H_
+
+/**
+ * @file nrf_drv_ppi.h
+ * @brief Host replacement for the legacy PPI driver API, implemented by host_ppi.c.
+ *
+ * Event and task "addresses" are tokens of host_ppi.h instead of register addresses; an enabled
+ * channel triggers its task and fork task whenever a simulated peripheral raises its event.
+ */
+
+#include "app_error.h"
+#include <stdint.h>
+
+#define HOST_PPI_CHANNEL_COUNT 20 ///< Programmable channels, as on the nRF52832
+
+typedef uint8_t nrf_ppi_channel_t;
+
+ret_code_t nrf_drv_ppi_init(void);
+ret_code_t nrf_drv_ppi_channel_alloc(nrf_ppi_channel_t *p_channel);
+ret_code_t nrf_drv_ppi_channel_assign(nrf_ppi_channel_t channel, uint32_t eep, uint32_t tep);
+ret_code_t nrf_drv_ppi_channel_fork_assign(nrf_ppi_channel_t channel, uint32_t fork_tep);
+ret_code_t nrf_drv_ppi_channel_enable(nrf_ppi_channel_t channel);
+ret_code_t nrf_drv_ppi_channel_disable(nrf_ppi_channel_t channel);
+
+#endif // _HOST_NRF_DRV_PPI_H_
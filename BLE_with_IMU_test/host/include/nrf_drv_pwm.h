@@ -0,0 +1,98 @@
+#ifndef _HOST_NRF_DRV_PWM_H_
+#define _HOST_NRF_DRV_PWM_H_
+
+/**
+ * @file nrf_drv_pwm.h
+ * @brief Host replacement for the legacy PWM driver API, implemented by the simulated PWM in host_pwm.c.
+ *
+ * Only the up counter and the common load mode (one compare value per period, as used by
+ * WS2812B.c) are supported, other modes are rejected with NRF_ERROR_NOT_SUPPORTED.
+ */
+
+#include "app_error.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#define HOST_PWM_INSTANCE_COUNT 3 ///< PWM0 .. PWM2, as on the nRF52832
+
+typedef struct {
+  uint8_t drv_inst_idx; ///< Index of the simulated instance
+} nrf_drv_pwm_t;
+
+#define NRF_DRV_PWM_INSTANCE(id) {.drv_inst_idx = (id)}
+
+#define NRF_DRV_PWM_CHANNEL_COUNT 4
+#define NRF_DRV_PWM_PIN_NOT_USED 0xFF
+#define NRF_DRV_PWM_PIN_INVERTED 0x80
+
+typedef enum {
+  NRF_PWM_CLK_16MHz = 0,
+  NRF_PWM_CLK_8MHz,
+  NRF_PWM_CLK_4MHz,
+  NRF_PWM_CLK_2MHz,
+  NRF_PWM_CLK_1MHz,
+  NRF_PWM_CLK_500kHz,
+  NRF_PWM_CLK_250kHz,
+  NRF_PWM_CLK_125kHz
+} nrf_pwm_clk_t;
+
+typedef enum {
+  NRF_PWM_MODE_UP,
+  NRF_PWM_MODE_UP_AND_DOWN
+} nrf_pwm_mode_t;
+
+typedef enum {
+  NRF_PWM_LOAD_COMMON,
+  NRF_PWM_LOAD_GROUPED,
+  NRF_PWM_LOAD_INDIVIDUAL,
+  NRF_PWM_LOAD_WAVE_FORM
+} nrf_pwm_dec_load_t;
+
+typedef enum {
+  NRF_PWM_STEP_AUTO,
+  NRF_PWM_STEP_TRIGGERED
+} nrf_pwm_dec_step_t;
+
+typedef struct {
+  uint8_t output_pins[NRF_DRV_PWM_CHANNEL_COUNT];
+  uint8_t irq_priority;
+  nrf_pwm_clk_t base_clock;
+  nrf_pwm_mode_t count_mode;
+  uint16_t top_value;
+  nrf_pwm_dec_load_t load_mode;
+  nrf_pwm_dec_step_t step_mode;
+} nrf_drv_pwm_config_t;
+
+typedef struct {
+  union {
+    uint16_t const *p_common;
+    void const *p_raw;
+  } values;
+  uint16_t length;
+  uint32_t repeats;
+  uint32_t end_delay;
+} nrf_pwm_sequence_t;
+
+typedef enum {
+  NRF_DRV_PWM_EVT_FINISHED,
+  NRF_DRV_PWM_EVT_END_SEQ0,
+  NRF_DRV_PWM_EVT_END_SEQ1,
+  NRF_DRV_PWM_EVT_STOPPED
+} nrf_drv_pwm_evt_type_t;
+
+typedef void (*nrf_drv_pwm_handler_t)(nrf_drv_pwm_evt_type_t event_type);
+
+#define NRF_DRV_PWM_FLAG_STOP 0x01
+#define NRF_DRV_PWM_FLAG_LOOP 0x02
+#define NRF_DRV_PWM_FLAG_SIGNAL_END_SEQ0 0x04
+#define NRF_DRV_PWM_FLAG_SIGNAL_END_SEQ1 0x08
+#define NRF_DRV_PWM_FLAG_NO_EVT_FINISHED 0x10
+
+ret_code_t nrf_drv_pwm_init(nrf_drv_pwm_t const *p_instance, nrf_drv_pwm_config_t const *p_config, nrf_drv_pwm_handler_t handler);
+void nrf_drv_pwm_uninit(nrf_drv_pwm_t const *p_instance);
+uint32_t nrf_drv_pwm_simple_playback(nrf_drv_pwm_t const *p_instance, nrf_pwm_sequence_t const *p_sequence, uint16_t playback_count, uint32_t flags);
+uint32_t nrf_drv_pwm_complex_playback(nrf_drv_pwm_t const *p_instance, nrf_pwm_sequence_t const *p_sequence_0, nrf_pwm_sequence_t const *p_sequence_1, uint16_t playback_count, uint32_t flags);
+bool nrf_drv_pwm_stop(nrf_drv_pwm_t const *p_instance, bool wait_until_stopped);
+bool nrf_drv_pwm_is_stopped(nrf_drv_pwm_t const *p_instance);
+
+#endif // _HOST_NRF_DRV_PWM_H_
@@ -0,0 +1,108 @@
+#ifndef _HOST_NRF_DRV_TIMER_H_
+#define _HOST_NRF_DRV_TIMER_H_
+
+/**
+ * @file nrf_drv_timer.h
+ * @brief Host replacement for the legacy TIMER driver API, implemented by the simulated TIMERs in host_timer.c.
+ *
+ * Timer mode runs at 1 MHz only and a compare event in timer mode needs the clear short of its
+ * channel (a periodic clock, as used by ICM20948_Sampler.c). Counter mode counts the COUNT task
+ * triggered through PPI. TIMER1 is the micros() timer of host_sim.c and cannot be used here.
+ */
+
+#include "app_error.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#define HOST_TIMER_INSTANCE_COUNT 5 ///< TIMER0 .. TIMER4, as on the nRF52832
+#define HOST_TIMER_CC_COUNT 6       ///< Capture/compare channels per instance
+
+typedef struct {
+  uint8_t instance_id; ///< Index of the simulated instance
+} nrf_drv_timer_t;
+
+#define NRF_DRV_TIMER_INSTANCE(id) {.instance_id = (id)}
+
+typedef enum {
+  NRF_TIMER_FREQ_16MHz = 0,
+  NRF_TIMER_FREQ_1MHz = 4,
+  NRF_TIMER_FREQ_31250Hz = 9
+} nrf_timer_frequency_t;
+
+typedef enum {
+  NRF_TIMER_MODE_TIMER = 0,
+  NRF_TIMER_MODE_COUNTER = 1
+} nrf_timer_mode_t;
+
+typedef enum {
+  NRF_TIMER_BIT_WIDTH_16 = 0,
+  NRF_TIMER_BIT_WIDTH_32 = 3
+} nrf_timer_bit_width_t;
+
+typedef enum {
+  NRF_TIMER_CC_CHANNEL0 = 0,
+  NRF_TIMER_CC_CHANNEL1,
+  NRF_TIMER_CC_CHANNEL2,
+  NRF_TIMER_CC_CHANNEL3,
+  NRF_TIMER_CC_CHANNEL4,
+  NRF_TIMER_CC_CHANNEL5
+} nrf_timer_cc_channel_t;
+
+typedef enum {
+  NRF_TIMER_TASK_START = 0,
+  NRF_TIMER_TASK_STOP,
+  NRF_TIMER_TASK_COUNT,
+  NRF_TIMER_TASK_CLEAR,
+  NRF_TIMER_TASK_CAPTURE0,
+  NRF_TIMER_TASK_CAPTURE1,
+  NRF_TIMER_TASK_CAPTURE2,
+  NRF_TIMER_TASK_CAPTURE3,
+  NRF_TIMER_TASK_CAPTURE4,
+  NRF_TIMER_TASK_CAPTURE5
+} nrf_timer_task_t;
+
+typedef enum {
+  NRF_TIMER_EVENT_COMPARE0 = 0,
+  NRF_TIMER_EVENT_COMPARE1,
+  NRF_TIMER_EVENT_COMPARE2,
+  NRF_TIMER_EVENT_COMPARE3,
+  NRF_TIMER_EVENT_COMPARE4,
+  NRF_TIMER_EVENT_COMPARE5
+} nrf_timer_event_t;
+
+typedef enum {
+  NRF_TIMER_SHORT_COMPARE0_CLEAR_MASK = 1UL << 0,
+  NRF_TIMER_SHORT_COMPARE1_CLEAR_MASK = 1UL << 1,
+  NRF_TIMER_SHORT_COMPARE2_CLEAR_MASK = 1UL << 2,
+  NRF_TIMER_SHORT_COMPARE3_CLEAR_MASK = 1UL << 3,
+  NRF_TIMER_SHORT_COMPARE4_CLEAR_MASK = 1UL << 4,
+  NRF_TIMER_SHORT_COMPARE5_CLEAR_MASK = 1UL << 5
+} nrf_timer_short_mask_t;
+
+typedef struct {
+  nrf_timer_frequency_t frequency;
+  nrf_timer_mode_t mode;
+  nrf_timer_bit_width_t bit_width;
+  uint8_t interrupt_priority;
+  void *p_context;
+} nrf_drv_timer_config_t;
+
+#define NRF_DRV_TIMER_DEFAULT_CONFIG {.frequency = NRF_TIMER_FREQ_1MHz, .mode = NRF_TIMER_MODE_TIMER, .bit_width = NRF_TIMER_BIT_WIDTH_32, .interrupt_priority = 6, .p_context = NULL}
+
+typedef void (*nrf_timer_event_handler_t)(nrf_timer_event_t event_type, void *p_context);
+
+ret_code_t nrf_drv_timer_init(nrf_drv_timer_t const *p_instance, nrf_drv_timer_config_t const *p_config, nrf_timer_event_handler_t timer_event_handler);
+void nrf_drv_timer_enable(nrf_drv_timer_t const *p_instance);
+void nrf_drv_timer_disable(nrf_drv_timer_t const *p_instance);
+void nrf_drv_timer_clear(nrf_drv_timer_t const *p_instance);
+uint32_t nrf_drv_timer_us_to_ticks(nrf_drv_timer_t const *p_instance, uint32_t time_us);
+void nrf_drv_timer_compare(nrf_drv_timer_t const *p_instance, nrf_timer_cc_channel_t cc_channel, uint32_t cc_value, bool enable_int);
+void nrf_drv_timer_extended_compare(nrf_drv_timer_t const *p_instance, nrf_timer_cc_channel_t cc_channel, uint32_t cc_value,
+    nrf_timer_short_mask_t timer_short_mask, bool enable_int);
+uint32_t nrf_drv_timer_capture(nrf_drv_timer_t const *p_instance, nrf_timer_cc_channel_t cc_channel);
+uint32_t nrf_drv_timer_capture_get(nrf_drv_timer_t const *p_instance, nrf_timer_cc_channel_t cc_channel);
+uint32_t nrf_drv_timer_task_address_get(nrf_drv_timer_t const *p_instance, nrf_timer_task_t timer_task);
+uint32_t nrf_drv_timer_capture_task_address_get(nrf_drv_timer_t const *p_instance, uint32_t channel);
+uint32_t nrf_drv_timer_compare_event_address_get(nrf_drv_timer_t const *p_instance, uint32_t channel);
+
+#endif // _HOST_NRF_DRV_TIMER_H_
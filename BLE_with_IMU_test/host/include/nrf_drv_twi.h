@@ -0,0 +1,90 @@
+#ifndef _HOST_NRF_DRV_TWI_H_
+#define _HOST_NRF_DRV_TWI_H_
+
+/**
+ * @file nrf_drv_twi.h
+ * @brief Host replacement for the legacy TWI driver API, implemented by the simulated bus in host_twi.c.
+ *
+ * Only the non-blocking (event handler) mode used by I2C_Bus.c is supported. Of the PPI oriented
+ * flags only the combination used by ICM20948_Sampler.c is simulated: a held, repeated transfer
+ * without event handler (HOLD_XFER | REPEATED_XFER | NO_XFER_EVT_HANDLER, optionally RX_POSTINC)
+ * started by the START task through PPI. Other flags are rejected with NRF_ERROR_NOT_SUPPORTED.
+ */
+
+#include "app_error.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define HOST_TWI_INSTANCE_COUNT 2 ///< TWI0 and TWI1, as on the nRF52832
+
+typedef struct {
+  uint8_t inst_idx; ///< Index of the simulated instance
+} nrf_drv_twi_t;
+
+#define NRF_DRV_TWI_INSTANCE(id) {.inst_idx = (id)}
+
+typedef enum {
+  NRF_DRV_TWI_FREQ_100K = 100000,
+  NRF_DRV_TWI_FREQ_250K = 250000,
+  NRF_DRV_TWI_FREQ_400K = 400000
+} nrf_drv_twi_frequency_t;
+
+typedef struct {
+  uint32_t scl;
+  uint32_t sda;
+  nrf_drv_twi_frequency_t frequency;
+  uint8_t interrupt_priority;
+  bool clear_bus_init;
+  bool hold_bus_uninit;
+} nrf_drv_twi_config_t;
+
+typedef enum {
+  NRF_DRV_TWI_XFER_TX,
+  NRF_DRV_TWI_XFER_RX,
+  NRF_DRV_TWI_XFER_TXRX,
+  NRF_DRV_TWI_XFER_TXTX
+} nrf_drv_twi_xfer_type_t;
+
+typedef struct {
+  nrf_drv_twi_xfer_type_t type;
+  uint8_t address;
+  size_t primary_length;
+  size_t secondary_length;
+  uint8_t *p_primary_buf;
+  uint8_t *p_secondary_buf;
+} nrf_drv_twi_xfer_desc_t;
+
+#define NRF_DRV_TWI_XFER_DESC_TXRX(addr, p_tx, tx_len, p_rx, rx_len) \
+  {.type = NRF_DRV_TWI_XFER_TXRX, .address = (addr), .primary_length = (tx_len), .secondary_length = (rx_len), .p_primary_buf = (p_tx), .p_secondary_buf = (p_rx)}
+
+typedef enum {
+  NRF_DRV_TWI_EVT_DONE,
+  NRF_DRV_TWI_EVT_ADDRESS_NACK,
+  NRF_DRV_TWI_EVT_DATA_NACK
+} nrf_drv_twi_evt_type_t;
+
+typedef struct {
+  nrf_drv_twi_evt_type_t type;
+  nrf_drv_twi_xfer_desc_t xfer_desc;
+} nrf_drv_twi_evt_t;
+
+typedef void (*nrf_drv_twi_evt_handler_t)(nrf_drv_twi_evt_t const *p_event, void *p_context);
+
+#define NRF_DRV_TWI_FLAG_TX_POSTINC (1UL << 0)
+#define NRF_DRV_TWI_FLAG_RX_POSTINC (1UL << 1)
+#define NRF_DRV_TWI_FLAG_NO_XFER_EVT_HANDLER (1UL << 2)
+#define NRF_DRV_TWI_FLAG_REPEATED_XFER (1UL << 3)
+#define NRF_DRV_TWI_FLAG_HOLD_XFER (1UL << 4)
+#define NRF_DRV_TWI_FLAG_TX_NO_STOP (1UL << 5)
+
+ret_code_t nrf_drv_twi_init(nrf_drv_twi_t const *p_instance, nrf_drv_twi_config_t const *p_config,
+    nrf_drv_twi_evt_handler_t event_handler, void *p_context);
+void nrf_drv_twi_enable(nrf_drv_twi_t const *p_instance);
+void nrf_drv_twi_disable(nrf_drv_twi_t const *p_instance);
+ret_code_t nrf_drv_twi_xfer(nrf_drv_twi_t const *p_instance, nrf_drv_twi_xfer_desc_t const *p_xfer_desc, uint32_t flags);
+bool nrf_drv_twi_is_busy(nrf_drv_twi_t const *p_instance);
+uint32_t nrf_drv_twi_start_task_get(nrf_drv_twi_t const *p_instance, nrf_drv_twi_xfer_type_t xfer_type);
+uint32_t nrf_drv_twi_stopped_event_get(nrf_drv_twi_t const *p_instance);
+
+#endif // _HOST_NRF_DRV_TWI_H_
@@ -0,0 +1,32 @@
+#ifndef _HOST_NRF_LOG_H_
+#define _HOST_NRF_LOG_H_
+
+/**
+ * @file nrf_log.h
+ * @brief Host replacement for the nrf_log macros, printing to stdout when host_log_enabled is set.
+ */
+
+#include <stdbool.h>
+#include <stdio.h>
+
+extern bool host_log_enabled;
+
+#define HOST_LOG(...)       \
+  do {                      \
+    if (host_log_enabled) { \
+      printf(__VA_ARGS__);  \
+      printf("\n");         \
+    }                       \
+  } while (0)
+
+#define NRF_LOG_ERROR(...) HOST_LOG(__VA_ARGS__)
+#define NRF_LOG_WARNING(...) HOST_LOG(__VA_ARGS__)
+#define NRF_LOG_INFO(...) HOST_LOG(__VA_ARGS__)
+#define NRF_LOG_DEBUG(...) HOST_LOG(__VA_ARGS__)
+#define NRF_LOG_RAW_INFO(...) HOST_LOG(__VA_ARGS__)
+#define NRF_LOG_HEXDUMP_DEBUG(p_data, len) ((void)(p_data), (void)(len))
+#define NRF_LOG_FLUSH() fflush(stdout)
+#define NRF_LOG_PROCESS() false
+#define nrf_log_push(p_str) (p_str)
+
+#endif // _HOST_NRF_LOG_H_
@@ -0,0 +1,11 @@
+#ifndef _HOST_NRF_LOG_CTRL_H_
+#define _HOST_NRF_LOG_CTRL_H_
+
+/**
+ * @file nrf_log_ctrl.h
+ * @brief Host replacement, see nrf_log.h.
+ */
+
+#include "nrf_log.h"
+
+#endif // _HOST_NRF_LOG_CTRL_H_
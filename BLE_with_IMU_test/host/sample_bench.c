@@ -0,0 +1,702 @@
+#include "Sample_Batch.h"
+#include "Sample_Codec.h"
+#include "Sample_Frame.h"
+#include "Tx_Queue.h"
+#include "app_util_platform.h"
+#include "bench.h"
+#include "sample_decoder.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @file sample_bench.c
+ * @brief Regression checks and benchmark of the sample stream sent over BLE.
+ *
+ * Checks the sample frames of Sample_Frame.c, their batching into notifications by
+ * Sample_Batch.c, their compression by Sample_Codec.c and the TX queue of Tx_Queue.c against the
+ * decoder of sample_decoder.c and exits with a non-zero status if any check fails, so it can be
+ * used as a CI step ("make -C host check").
+ *
+ * Options:
+ *   --samples <n>     Samples per measurement
+ */
+
+#define BENCH_DEFAULT_SAMPLES 2000
+
+static sample_decoder_frame_t m_frames[4]; // Frames received by frame_handler
+static uint8_t m_frame_count;              // Number of entries in m_frames
+
+/**
+ * @brief Stores a decoded frame, signature of sample_decoder_handler_t.
+ *
+ * @param p_context Unused.
+ * @param p_frame Received frame.
+ */
+static void frame_handler(void *p_context, sample_decoder_frame_t const *p_frame) {
+  if (m_frame_count < 4) {
+    m_frames[m_frame_count] = *p_frame;
+  }
+  m_frame_count++;
+}
+
+/**
+ * @brief Checks the sample frames: a sample survives encoding and decoding, every type counts
+ * its own sequence, interleaved text and corrupted frames are skipped and missing frames are
+ * counted.
+ */
+static void test_sample_frame(void) {
+  int16_t accel_in[3] = {-32768, 1, 4096};
+  int16_t gyro_in[3] = {32767, -300, 0};
+  int16_t quaternion_in[4] = {SAMPLE_FRAME_QUATERNION_ONE, -1, -SAMPLE_FRAME_QUATERNION_ONE, 8192};
+  int16_t accel[3], gyro[3];
+  int16_t quaternion[4];
+  uint8_t stream[4 * SAMPLE_FRAME_MAX_SIZE + 16];
+  uint16_t length = 0;
+  uint16_t proximity;
+  int32_t counts;
+  bool close;
+  sample_decoder_t decoder;
+  sample_decoder_stats_t const *p_stats;
+
+  CHECK(sample_frame_accel_gyro(&stream[length], 0x12345678, accel_in, gyro_in) == SAMPLE_FRAME_SIZE(SAMPLE_FRAME_ACCEL_GYRO_LEN));
+  length += SAMPLE_FRAME_SIZE(SAMPLE_FRAME_ACCEL_GYRO_LEN);
+  memcpy(&stream[length], "stats\n", 6); // Text reply between the frames
+  length += 6;
+  length += sample_frame_proximity(&stream[length], 0xFFFFFFFF, 0xBEEF, true);
+  length += sample_frame_quaternion(&stream[length], 7, quaternion_in);
+  length += sample_frame_load_cell(&stream[length], 8, -8388608);
+  CHECK(sample_frame_encode(stream, SAMPLE_FRAME_ACCEL_GYRO, 0, stream, SAMPLE_FRAME_MAX_PAYLOAD + 1) == 0);
+  CHECK(sample_frame_encode(stream, SAMPLE_FRAME_TYPES, 0, stream, 1) == 0);
+
+  sample_decoder_init(&decoder, frame_handler, NULL);
+  p_stats = sample_decoder_stats_get(&decoder);
+  m_frame_count = 0;
+  for (uint16_t i = 0; i < length; i += 5) { // Received in pieces not aligned to the frames
+    sample_decoder_feed(&decoder, &stream[i], MIN(5, length - i));
+  }
+  CHECK(m_frame_count == 4);
+  CHECK(p_stats->frames == 4);
+  CHECK(p_stats->skipped == 6);
+  CHECK((p_stats->crc_errors == 0) && (p_stats->lost == 0)); // Sequences of different types do not mix
+  CHECK(m_frames[0].timestamp_us == 0x12345678);
+  CHECK(sample_decoder_accel_gyro(&m_frames[0], accel, gyro));
+  CHECK(memcmp(accel, accel_in, sizeof(accel)) == 0);
+  CHECK(memcmp(gyro, gyro_in, sizeof(gyro)) == 0);
+  CHECK(!sample_decoder_proximity(&m_frames[0], &proximity, &close));
+  CHECK(sample_decoder_proximity(&m_frames[1], &proximity, &close));
+  CHECK((proximity == 0xBEEF) && close);
+  CHECK(m_frames[1].timestamp_us == 0xFFFFFFFF);
+  CHECK(sample_decoder_quaternion(&m_frames[2], quaternion));
+  CHECK(memcmp(quaternion, quaternion_in, sizeof(quaternion)) == 0);
+  CHECK(sample_decoder_load_cell(&m_frames[3], &counts) && (counts == -8388608));
+  CHECK(!sample_decoder_load_cell(&m_frames[2], &counts));
+
+  length = 0; // A corrupted frame between two good ones
+  for (uint8_t i = 0; i < 3; i++) {
+    length += sample_frame_accel_gyro(&stream[length], i, accel, gyro);
+  }
+  stream[SAMPLE_FRAME_SIZE(SAMPLE_FRAME_ACCEL_GYRO_LEN) + SAMPLE_FRAME_HEADER_SIZE] ^= 0x01;
+  m_frame_count = 0;
+  sample_decoder_feed(&decoder, stream, length);
+  CHECK(m_frame_count == 2);
+  CHECK(p_stats->crc_errors >= 1);
+  CHECK(p_stats->lost == 1);
+  CHECK(m_frames[1].timestamp_us == 2);
+}
+
+static sample_decoder_t m_batch_decoder; // Receives the notifications of batch_send
+static uint16_t m_batch_lengths[8];      // Lengths of the notifications sent by batch_send
+static uint32_t m_batch_count;           // Number of notifications sent by batch_send
+static uint16_t m_batch_longest;         // Longest notification sent by batch_send
+
+/**
+ * @brief Records a notification and decodes it, signature of sample_batch_send_t.
+ *
+ * @param p_data Notification data.
+ * @param length Number of bytes.
+ */
+static void batch_send(uint8_t *p_data, uint16_t length) {
+  if (m_batch_count < 8) {
+    m_batch_lengths[m_batch_count] = length;
+  }
+  m_batch_count++;
+  if (length > m_batch_longest) {
+    m_batch_longest = length;
+  }
+  sample_decoder_feed(&m_batch_decoder, p_data, length);
+}
+
+/**
+ * @brief Checks the batching of sample frames: notifications are filled up to the capacity
+ * without splitting frames, the latency deadline sends a partial batch and all frames arrive.
+ */
+static void test_sample_batch(void) {
+  int16_t accel[3] = {1, 2, 3}, gyro[3] = {4, 5, 6};
+  uint8_t frames[2 * SAMPLE_FRAME_MAX_SIZE];
+  uint16_t imu = SAMPLE_FRAME_SIZE(SAMPLE_FRAME_ACCEL_GYRO_LEN);
+  uint16_t pair = imu + SAMPLE_FRAME_SIZE(SAMPLE_FRAME_PROXIMITY_LEN);
+  sample_batch_t batch;
+  sample_batch_stats_t const *p_stats;
+  sample_decoder_stats_t const *p_decoded;
+
+  sample_decoder_init(&m_batch_decoder, NULL, NULL);
+  p_decoded = sample_decoder_stats_get(&m_batch_decoder);
+  m_batch_count = 0;
+  sample_batch_init(&batch, batch_send, 20); // Default ATT MTU: a frame does not fit and is split
+  p_stats = sample_batch_stats_get(&batch);
+  sample_frame_accel_gyro(frames, 0, accel, gyro);
+  sample_batch_add(&batch, frames, imu, 0);
+  CHECK((m_batch_count == 2) && (m_batch_lengths[0] == 20) && (m_batch_lengths[1] == imu - 20));
+  CHECK(p_decoded->frames == 1); // Reassembled from both notifications
+
+  m_batch_count = 0;
+  sample_batch_capacity_set(&batch, 50);
+  for (uint8_t i = 0; i < 2; i++) { // Two frames fill 46 of 50 bytes, a third would not fit
+    sample_frame_accel_gyro(frames, i, accel, gyro);
+    sample_batch_add(&batch, frames, imu, i);
+  }
+  CHECK((m_batch_count == 1) && (m_batch_lengths[0] == 2 * imu));
+  sample_frame_accel_gyro(frames, 2, accel, gyro);
+  sample_batch_add(&batch, frames, imu, 2);
+  sample_frame_accel_gyro(frames, 3, accel, gyro); // A unit of two frames does not fit behind it
+  sample_frame_proximity(&frames[imu], 3, 100, false);
+  sample_batch_add(&batch, frames, pair, 3);
+  CHECK(m_batch_count == 3);
+  CHECK((m_batch_lengths[1] == imu) && (m_batch_lengths[2] == pair));
+
+  sample_frame_accel_gyro(frames, 4, accel, gyro);
+  sample_batch_add(&batch, frames, imu, 1000);
+  sample_batch_poll(&batch, 1000 + SAMPLE_BATCH_LATENCY_US - 1);
+  CHECK(m_batch_count == 3);
+  sample_batch_poll(&batch, 1000 + SAMPLE_BATCH_LATENCY_US);
+  CHECK((m_batch_count == 4) && (p_stats->deadlines == 1));
+
+  sample_batch_capacity_set(&batch, 1000);
+  CHECK(batch.capacity == SAMPLE_BATCH_MAX_LEN);
+  sample_frame_accel_gyro(frames, 5, accel, gyro);
+  sample_batch_add(&batch, frames, imu, 2000);
+  sample_batch_capacity_set(&batch, 20); // The waiting frame no longer fits
+  CHECK(m_batch_count == 5);
+  sample_batch_flush(&batch);
+  CHECK(m_batch_count == 5);
+
+  CHECK(p_stats->units == 7);
+  CHECK(p_stats->notifications == m_batch_count + 2); // Including the two of the default MTU
+  CHECK(p_decoded->frames == 8);
+  CHECK((p_decoded->lost == 0) && (p_decoded->crc_errors == 0) && (p_decoded->skipped == 0));
+  CHECK(p_stats->bytes == 6 * imu + pair);
+}
+
+static uint8_t m_tx_buffers;    // Free SoftDevice TX buffers seen by tx_send
+static ret_code_t m_tx_error;   // Error tx_send returns for every notification, NRF_SUCCESS for normal operation
+static uint8_t m_tx_sent[16];   // First byte of every notification accepted by tx_send
+static uint8_t m_tx_sent_count; // Number of entries in m_tx_sent
+static bool m_tx_channel_ok;    // Every notification arrived with the channel it was pushed for
+static bool m_tx_in_critical;   // tx_send was called in a critical region
+static void (*m_tx_isr)(void);  // Run once by the next tx_send, models the BLE event handler interrupting it
+static tx_queue_t m_tx_queue;   // Queue of test_tx_queue_reentry, used by the m_tx_isr functions
+
+/**
+ * @brief Models the SoftDevice accepting notifications, signature of tx_queue_send_t.
+ *
+ * @param channel Channel, tx_push uses the notification number modulo 3.
+ * @param p_data Notification data.
+ * @param length Number of bytes.
+ * @return NRF_ERROR_RESOURCES without free buffer, else m_tx_error.
+ */
+static ret_code_t tx_send(uint8_t channel, uint8_t *p_data, uint16_t length) {
+  ret_code_t err_code = m_tx_error;
+  void (*isr)(void) = m_tx_isr;
+
+  if (channel != p_data[0] % 3) {
+    m_tx_channel_ok = false;
+  }
+  m_tx_in_critical |= host_sim_in_critical();
+  if ((err_code == NRF_SUCCESS) && (m_tx_buffers == 0)) {
+    err_code = NRF_ERROR_RESOURCES;
+  } else if (err_code == NRF_SUCCESS) {
+    m_tx_buffers--;
+    if (m_tx_sent_count < sizeof(m_tx_sent)) {
+      m_tx_sent[m_tx_sent_count++] = p_data[0];
+    }
+  }
+  if (isr != NULL) { // After the SoftDevice decided, before the call returns
+    m_tx_isr = NULL;
+    isr();
+  }
+  return err_code;
+}
+
+/**
+ * @brief Pushes notifications numbered by their first byte.
+ *
+ * @param p_queue Queue.
+ * @param first Number of the first notification.
+ * @param count Notifications to push.
+ * @return Notifications the queue accepted.
+ */
+static uint8_t tx_push(tx_queue_t *p_queue, uint8_t first, uint8_t count) {
+  uint8_t data[20];
+  uint8_t accepted = 0;
+
+  for (uint8_t i = 0; i < count; i++) {
+    memset(data, first + i, sizeof(data));
+    accepted += tx_queue_push(p_queue, (first + i) % 3, data, sizeof(data));
+  }
+  return accepted;
+}
+
+/**
+ * @brief Checks the TX queue: sending in order and on the pushed channel while buffers are
+ * free, resuming on TX complete, both full-queue policies, send errors and the counters.
+ */
+static void test_tx_queue(void) {
+  static tx_queue_t queue;
+  tx_queue_stats_t const *p_stats = tx_queue_stats_get(&queue);
+  uint8_t data[TX_QUEUE_SLOT_LEN + 1] = {0};
+  char line[100];
+
+  tx_queue_init(&queue, tx_send, TX_QUEUE_DROP_NEWEST);
+  m_tx_channel_ok = true;
+  m_tx_error = NRF_SUCCESS;
+  m_tx_buffers = 2;
+  m_tx_sent_count = 0;
+  CHECK(tx_push(&queue, 0, 4) == 4); // Two sent at once, two wait
+  CHECK((m_tx_sent_count == 2) && (tx_queue_depth(&queue) == 2));
+  CHECK(tx_push(&queue, 4, TX_QUEUE_SLOTS) == TX_QUEUE_SLOTS - 2); // The newest two are dropped
+  CHECK((p_stats->dropped == 2) && (p_stats->max_depth == TX_QUEUE_SLOTS));
+  m_tx_buffers = 3; // BLE_GATTS_EVT_HVN_TX_COMPLETE
+  tx_queue_pump(&queue);
+  CHECK((m_tx_sent_count == 5) && (tx_queue_depth(&queue) == TX_QUEUE_SLOTS - 3));
+  m_tx_buffers = 100;
+  tx_queue_pump(&queue);
+  CHECK(m_tx_sent_count == TX_QUEUE_SLOTS + 2);
+  for (uint8_t i = 0; i < m_tx_sent_count; i++) {
+    CHECK(m_tx_sent[i] == i); // In order, without the dropped ones
+  }
+  CHECK((p_stats->sent == TX_QUEUE_SLOTS + 2) && (p_stats->busy == TX_QUEUE_SLOTS + 1));
+
+  tx_queue_init(&queue, tx_send, TX_QUEUE_OVERWRITE_OLDEST);
+  m_tx_buffers = 0;
+  m_tx_sent_count = 0;
+  CHECK(tx_push(&queue, 0, TX_QUEUE_SLOTS + 3) == TX_QUEUE_SLOTS + 3);
+  CHECK(p_stats->overwritten == 3);
+  m_tx_buffers = 100;
+  tx_queue_pump(&queue);
+  CHECK((m_tx_sent_count == TX_QUEUE_SLOTS) && (m_tx_sent[0] == 3)); // The oldest three were replaced
+  CHECK(m_tx_sent[TX_QUEUE_SLOTS - 1] == TX_QUEUE_SLOTS + 2);
+
+  CHECK(!tx_queue_push(&queue, 0, data, sizeof(data))); // Longer than a slot
+  m_tx_error = NRF_ERROR_INVALID_STATE;                 // Notifications disabled
+  CHECK(tx_push(&queue, 0, 2) == 2);
+  CHECK((p_stats->failed == 2) && (tx_queue_depth(&queue) == 0));
+  m_tx_error = NRF_SUCCESS;
+  m_tx_buffers = 0;
+  tx_push(&queue, 0, 2);
+  tx_queue_clear(&queue); // Disconnected
+  m_tx_buffers = 100;
+  tx_queue_pump(&queue);
+  CHECK(m_tx_sent_count == TX_QUEUE_SLOTS);
+  CHECK(m_tx_channel_ok); // Also for overwritten slots
+
+  CHECK(tx_queue_stats_format(&queue, line, sizeof(line)) == strlen(line));
+  CHECK(strcmp(line, "tx n=16 sent=8 drop=1 over=3 fail=2 busy=13 depth=8\n") == 0);
+}
+
+/**
+ * @brief Pushes notifications 1 and 2 into m_tx_queue, run from tx_send.
+ */
+static void tx_isr_push(void) {
+  tx_push(&m_tx_queue, 1, 2);
+}
+
+/**
+ * @brief Pushes notification 8 into m_tx_queue, run from tx_send.
+ */
+static void tx_isr_push_full(void) {
+  tx_push(&m_tx_queue, 8, 1);
+}
+
+/**
+ * @brief Frees a SoftDevice buffer and pumps m_tx_queue as on BLE_GATTS_EVT_HVN_TX_COMPLETE, run from tx_send.
+ */
+static void tx_isr_complete(void) {
+  m_tx_buffers = 1;
+  tx_queue_pump(&m_tx_queue);
+}
+
+/**
+ * @brief Clears m_tx_queue as on disconnection, run from tx_send.
+ */
+static void tx_isr_clear(void) {
+  tx_queue_clear(&m_tx_queue);
+}
+
+/**
+ * @brief Checks the TX queue called from the BLE event handler while the main loop is in the send
+ * function: the send function runs outside critical regions, notifications pushed meanwhile are
+ * sent in order by the running pump, a TX complete meanwhile resumes it, the notification being
+ * sent is not overwritten and a clear takes effect after it.
+ */
+static void test_tx_queue_reentry(void) {
+  tx_queue_stats_t const *p_stats = tx_queue_stats_get(&m_tx_queue);
+
+  tx_queue_init(&m_tx_queue, tx_send, TX_QUEUE_DROP_NEWEST);
+  m_tx_channel_ok = true;
+  m_tx_in_critical = false;
+  m_tx_error = NRF_SUCCESS;
+  m_tx_buffers = 100;
+  m_tx_sent_count = 0;
+  m_tx_isr = tx_isr_push;
+  CHECK(tx_push(&m_tx_queue, 0, 1) == 1);
+  CHECK((m_tx_sent_count == 3) && (m_tx_sent[1] == 1) && (m_tx_sent[2] == 2));
+  CHECK(tx_queue_depth(&m_tx_queue) == 0);
+
+  m_tx_buffers = 0; // Refused, then the buffer is freed before the send function returns
+  m_tx_sent_count = 0;
+  m_tx_isr = tx_isr_complete;
+  CHECK(tx_push(&m_tx_queue, 3, 1) == 1);
+  CHECK((m_tx_sent_count == 1) && (m_tx_sent[0] == 3) && (p_stats->busy == 1));
+  CHECK(tx_queue_depth(&m_tx_queue) == 0);
+
+  tx_queue_init(&m_tx_queue, tx_send, TX_QUEUE_OVERWRITE_OLDEST);
+  m_tx_buffers = 0;
+  m_tx_sent_count = 0;
+  CHECK(tx_push(&m_tx_queue, 0, TX_QUEUE_SLOTS) == TX_QUEUE_SLOTS);
+  m_tx_buffers = 100;
+  m_tx_isr = tx_isr_push_full; // While notification 0 is being sent
+  tx_queue_pump(&m_tx_queue);
+  CHECK((p_stats->dropped == 1) && (p_stats->overwritten == 0));
+  CHECK((m_tx_sent_count == TX_QUEUE_SLOTS) && (m_tx_sent[0] == 0) && (m_tx_sent[TX_QUEUE_SLOTS - 1] == TX_QUEUE_SLOTS - 1));
+
+  m_tx_buffers = 0;
+  m_tx_sent_count = 0;
+  tx_push(&m_tx_queue, 0, 4);
+  m_tx_buffers = 100;
+  m_tx_isr = tx_isr_clear;
+  tx_queue_pump(&m_tx_queue);
+  CHECK((m_tx_sent_count == 1) && (tx_queue_depth(&m_tx_queue) == 0)); // Only the one being sent
+  tx_push(&m_tx_queue, 4, 1);
+  CHECK((m_tx_sent_count == 2) && (m_tx_sent[1] == 4));
+
+  CHECK(m_tx_channel_ok);
+  CHECK(!m_tx_in_critical);
+}
+
+/**
+ * @brief Decodes the block frame of a codec.
+ *
+ * @param p_codec Encoder state, emptied.
+ * @param p_samples Receives the samples.
+ * @return Number of samples, 0 if the frame was not accepted.
+ */
+static uint8_t codec_roundtrip(sample_codec_t *p_codec, sample_decoder_imu_t *p_samples) {
+  uint8_t frame[SAMPLE_FRAME_MAX_SIZE];
+  sample_decoder_t decoder;
+
+  m_frame_count = 0;
+  sample_decoder_init(&decoder, frame_handler, NULL);
+  sample_decoder_feed(&decoder, frame, sample_codec_frame(p_codec, frame));
+  if (m_frame_count != 1) {
+    return 0;
+  }
+  return sample_decoder_accel_gyro_block(&m_frames[0], p_samples, SAMPLE_DECODER_BLOCK_MAX);
+}
+
+/**
+ * @brief Checks the IMU sample codec: samples survive compression bit for bit, also full-scale
+ * jumps and timestamp wraps, a full block refuses the next sample unchanged and malformed blocks
+ * are rejected.
+ */
+static void test_sample_codec(void) {
+  int16_t accel_in[4][3] = {{-32768, 0, 32767}, {32767, 1, -32768}, {32767, 1, -32768}, {0, -32768, 100}};
+  int16_t gyro_in[4][3] = {{0, -1, 1}, {-32768, 32767, 0}, {-32767, 32767, 5}, {32767, 0, -100}};
+  uint32_t time_in[4] = {0xFFFFFF00, 0xFFFFFFFF, 0x00000010, 0x80000000}; // Wraps, then a long gap
+  sample_decoder_imu_t samples[SAMPLE_DECODER_BLOCK_MAX];
+  uint8_t frame[SAMPLE_FRAME_MAX_SIZE];
+  sample_codec_t codec;
+  bool same = true;
+
+  sample_codec_reset(&codec);
+  CHECK(sample_codec_count(&codec) == 0);
+  CHECK(sample_codec_frame(&codec, frame) == 0);
+
+  for (uint8_t i = 0; i < 4; i++) {
+    CHECK(sample_codec_add(&codec, time_in[i], accel_in[i], gyro_in[i], SAMPLE_FRAME_MAX_PAYLOAD, time_in[i]));
+  }
+  CHECK(sample_codec_count(&codec) == 4);
+  CHECK(sample_codec_first_us(&codec) == time_in[0]);
+  CHECK(codec_roundtrip(&codec, samples) == 4);
+  CHECK(m_frames[0].type == SAMPLE_FRAME_ACCEL_GYRO_BLOCK);
+  CHECK(m_frames[0].timestamp_us == time_in[0]);
+  CHECK(m_frames[0].length <= 1 + 4 * SAMPLE_CODEC_SAMPLE_MAX);
+  for (uint8_t i = 0; i < 4; i++) {
+    same &= (samples[i].timestamp_us == time_in[i]);
+    same &= (memcmp(samples[i].accel, accel_in[i], sizeof(accel_in[i])) == 0);
+    same &= (memcmp(samples[i].gyro, gyro_in[i], sizeof(gyro_in[i])) == 0);
+  }
+  CHECK(same);
+  CHECK(sample_codec_count(&codec) == 0); // Emptied by sample_codec_frame
+
+  int16_t zero[3] = {0, 0, 0};
+  CHECK(sample_codec_add(&codec, 0, zero, zero, 20, 0));      // 1 + 6 bytes
+  CHECK(sample_codec_add(&codec, 100, zero, zero, 20, 100));  // 1 + 6 bytes
+  CHECK(!sample_codec_add(&codec, 200, zero, zero, 20, 200)); // 21 bytes would exceed the limit
+  CHECK(sample_codec_count(&codec) == 2);
+  CHECK(!sample_codec_add(&codec, 0, accel_in[0], gyro_in[0], 10, 0)); // Does not fit an empty block either
+  CHECK(codec_roundtrip(&codec, samples) == 2);
+  CHECK(samples[1].timestamp_us == 100);
+
+  uint16_t added = 0;
+  while ((added < 100) && sample_codec_add(&codec, added, zero, zero, SAMPLE_FRAME_MAX_PAYLOAD, added)) {
+    added++;
+  }
+  CHECK(added == SAMPLE_DECODER_BLOCK_MAX); // The fullest block fits the decoder
+  CHECK(codec_roundtrip(&codec, samples) == SAMPLE_DECODER_BLOCK_MAX);
+  CHECK(m_frame_count == 1);
+  CHECK(sample_frame_encode(frame, SAMPLE_FRAME_ACCEL_GYRO_BLOCK, 0, frame, SAMPLE_FRAME_MAX_PAYLOAD) == SAMPLE_BATCH_MAX_LEN);
+  CHECK(sample_codec_add(&codec, 0, zero, zero, 20, 0));
+  CHECK(sample_codec_add(&codec, 100, zero, zero, 20, 100));
+  CHECK(codec_roundtrip(&codec, samples) == 2);
+
+  sample_decoder_frame_t block = m_frames[0]; // Two samples of zeros
+  block.length = 3;
+  CHECK(sample_decoder_accel_gyro_block(&block, samples, SAMPLE_DECODER_BLOCK_MAX) == 0); // Truncated
+  block = m_frames[0];
+  block.payload[block.length++] = 0;
+  CHECK(sample_decoder_accel_gyro_block(&block, samples, SAMPLE_DECODER_BLOCK_MAX) == 0); // Trailing byte
+  CHECK(sample_decoder_accel_gyro_block(&m_frames[0], samples, 1) == 0);                  // More samples than room
+  CHECK(sample_decoder_accel_gyro_block(&m_frames[0], samples, 2) == 2);
+  block.type = SAMPLE_FRAME_ACCEL_GYRO;
+  CHECK(sample_decoder_accel_gyro_block(&block, samples, SAMPLE_DECODER_BLOCK_MAX) == 0);
+}
+
+/**
+ * @brief Checks the latency deadline of a block as transmitIMUdata() and transmitPoll() drive it:
+ * the sample timestamp is read after the loop's current time, yet a block is sent only once its
+ * first sample has waited SAMPLE_BATCH_LATENCY_US on the loop's clock, so it holds several samples.
+ */
+static void test_sample_codec_deadline(void) {
+  int16_t zero[3] = {0, 0, 0};
+  uint32_t period_us = 1389; // 720 samples/s
+  uint32_t blocks = 0;
+  uint32_t sent = 0;
+  uint8_t fewest = UINT8_MAX;
+  sample_codec_t codec;
+
+  sample_codec_reset(&codec);
+  CHECK(sample_codec_age_us(&codec, 12345) == 0); // Empty
+  for (uint32_t i = 0; i < 200; i++) {
+    uint32_t now_us = 0xFFFF0000 + i * period_us; // Wraps during the run
+    uint32_t timestamp_us = now_us + 150;          // micros() after the loop's current time
+
+    CHECK(sample_codec_add(&codec, timestamp_us, zero, zero, SAMPLE_FRAME_MAX_PAYLOAD, now_us));
+    if (sample_codec_age_us(&codec, now_us) >= SAMPLE_BATCH_LATENCY_US) { // transmitPoll
+      fewest = MIN(fewest, sample_codec_count(&codec));
+      sent += sample_codec_count(&codec);
+      blocks++;
+      sample_codec_reset(&codec);
+    }
+  }
+  CHECK(blocks > 0);
+  CHECK(fewest == (SAMPLE_BATCH_LATENCY_US + period_us - 1) / period_us + 1); // Not one sample per block
+  CHECK(sent + sample_codec_count(&codec) == 200);
+}
+
+/**
+ * @brief Compares the size and host time of an IMU sample sent as text and as a frame.
+ *
+ * @param samples Number of samples.
+ */
+static void bench_frames(uint32_t samples) {
+  int16_t accel[3] = {-1234, 567, 16384};
+  int16_t gyro[3] = {12, -345, 6789};
+  char text[100];
+  uint8_t frame[SAMPLE_FRAME_MAX_SIZE];
+  volatile uint32_t bytes = 0; // Keeps the formatting from being optimized away
+  uint64_t host_start = bench_host_ns();
+
+  for (uint32_t i = 0; i < samples; i++) {
+    bytes += sprintf(text, "Accel: X=%d, Y=%d, Z=%d\nGyro: X=%d, Y=%d, Z=%d\n\n", accel[0], accel[1], accel[2], gyro[0], gyro[1], gyro[2]);
+  }
+  uint64_t text_ns = bench_host_ns() - host_start;
+  uint32_t text_bytes = bytes / samples;
+  bytes = 0;
+  host_start = bench_host_ns();
+  for (uint32_t i = 0; i < samples; i++) {
+    bytes += sample_frame_accel_gyro(frame, i, accel, gyro);
+  }
+  uint64_t host_ns = bench_host_ns() - host_start;
+  printf("IMU sample as text: %u bytes, %.0f ns host; as frame: %u bytes, %.0f ns host\n",
+      text_bytes, (double)text_ns / samples, bytes / samples, (double)host_ns / samples);
+  CHECK(bytes / samples * 2 < text_bytes);
+}
+
+/**
+ * @brief Measures the samples per notification at 720 samples/s for the data lengths of several MTUs.
+ *
+ * @param samples Number of samples per data length.
+ */
+static void bench_batch(uint32_t samples) {
+  int16_t accel[3] = {-1234, 567, 16384};
+  int16_t gyro[3] = {12, -345, 6789};
+  uint8_t frame[SAMPLE_FRAME_MAX_SIZE];
+  uint16_t capacities[] = {20, 100, SAMPLE_BATCH_MAX_LEN};
+
+  for (uint8_t c = 0; c < 3; c++) {
+    sample_batch_t batch;
+    sample_batch_init(&batch, batch_send, capacities[c]);
+    sample_decoder_init(&m_batch_decoder, NULL, NULL);
+    m_batch_longest = 0;
+    for (uint32_t i = 0; i < samples; i++) {
+      sample_batch_add(&batch, frame, sample_frame_accel_gyro(frame, i * 1389, accel, gyro), i * 1389);
+    }
+    sample_batch_flush(&batch);
+    sample_batch_stats_t const *p_stats = sample_batch_stats_get(&batch);
+    printf("Data length %u: %.1f samples per notification, %u sent at the deadline\n",
+        capacities[c], (double)p_stats->units / p_stats->notifications, p_stats->deadlines);
+    CHECK(sample_decoder_stats_get(&m_batch_decoder)->frames == samples);
+    CHECK(m_batch_longest <= capacities[c]); // Longer notifications fail with NRF_ERROR_DATA_SIZE
+  }
+}
+
+static sample_decoder_imu_t *m_codec_expected; // Samples bench_codec encoded, in order
+static uint32_t m_codec_decoded;               // Samples codec_frame_handler decoded
+static bool m_codec_same;                      // Every decoded sample equals the encoded one
+
+/**
+ * @brief Decodes a block and compares it to the encoded samples, signature of sample_decoder_handler_t.
+ *
+ * @param p_context Unused.
+ * @param p_frame Received frame.
+ */
+static void codec_frame_handler(void *p_context, sample_decoder_frame_t const *p_frame) {
+  sample_decoder_imu_t samples[SAMPLE_DECODER_BLOCK_MAX];
+  uint8_t count = sample_decoder_accel_gyro_block(p_frame, samples, SAMPLE_DECODER_BLOCK_MAX);
+
+  m_codec_same &= (count > 0);
+  for (uint8_t i = 0; i < count; i++) {
+    m_codec_same &= (memcmp(&samples[i], &m_codec_expected[m_codec_decoded++], sizeof(samples[i])) == 0);
+  }
+}
+
+/**
+ * @brief Returns the next value of a deterministic pseudo random sequence.
+ *
+ * @param p_state Generator state.
+ * @return Random value.
+ */
+static uint32_t codec_random(uint32_t *p_state) {
+  *p_state = *p_state * 1664525u + 1013904223u;
+  return *p_state >> 8;
+}
+
+/**
+ * @brief Measures the compression of IMU samples into block frames for a device at rest, a
+ * moving device and random values (the worst case): bytes per sample, samples per notification
+ * of the largest data length and host time to encode and decode.
+ *
+ * @param samples Number of samples per signal.
+ */
+static void bench_codec(uint32_t samples) {
+  static char const *const names[] = {"still", "moving", "random"};
+  sample_decoder_imu_t *p_samples = malloc(samples * sizeof(*p_samples));
+  uint8_t *p_stream = malloc(samples * SAMPLE_FRAME_SIZE(1 + SAMPLE_CODEC_SAMPLE_MAX)); // Worst case, a block per sample
+  uint8_t plain = SAMPLE_FRAME_SIZE(SAMPLE_FRAME_ACCEL_GYRO_LEN);
+  uint8_t max_payload = SAMPLE_BATCH_MAX_LEN - SAMPLE_FRAME_SIZE(0);
+  double per_notification[3];
+  double ratio[3];
+
+  CHECK((p_samples != NULL) && (p_stream != NULL));
+  if ((p_samples == NULL) || (p_stream == NULL)) {
+    free(p_samples);
+    free(p_stream);
+    return;
+  }
+  for (uint8_t s = 0; s < 3; s++) {
+    uint32_t seed = 12345;
+    for (uint32_t i = 0; i < samples; i++) { // 720 samples/s, 1 g on Z, noise of a few counts
+      sample_decoder_imu_t *p_sample = &p_samples[i];
+      p_sample->timestamp_us = i * 1389 + codec_random(&seed) % 8;
+      for (uint8_t a = 0; a < 3; a++) {
+        int32_t noise = (int32_t)(codec_random(&seed) % 7) - 3;
+        int32_t motion = (s == 1) ? (int32_t)(4000 * sin(i / (20.0 + 7 * a))) : 0;
+        p_sample->accel[a] = (int16_t)(((a == 2) ? 16384 : 0) + motion + noise);
+        p_sample->gyro[a] = (int16_t)(motion / 2 + noise);
+        if (s == 2) {
+          p_sample->accel[a] = (int16_t)codec_random(&seed);
+          p_sample->gyro[a] = (int16_t)codec_random(&seed);
+        }
+      }
+    }
+
+    sample_codec_t codec;
+    sample_decoder_t decoder;
+    uint32_t frames = 0;
+    uint32_t bytes = 0;
+
+    sample_codec_reset(&codec);
+    uint64_t start = bench_host_ns();
+    for (uint32_t i = 0; i < samples; i++) {
+      sample_decoder_imu_t const *p_sample = &p_samples[i];
+      if (!sample_codec_add(&codec, p_sample->timestamp_us, p_sample->accel, p_sample->gyro, max_payload, p_sample->timestamp_us)) {
+        bytes += sample_codec_frame(&codec, &p_stream[bytes]); // Full, the sample starts the next block
+        frames++;
+        sample_codec_add(&codec, p_sample->timestamp_us, p_sample->accel, p_sample->gyro, max_payload, p_sample->timestamp_us);
+      }
+    }
+    bytes += sample_codec_frame(&codec, &p_stream[bytes]);
+    frames++;
+    uint64_t encode_ns = bench_host_ns() - start;
+
+    m_codec_expected = p_samples;
+    m_codec_decoded = 0;
+    m_codec_same = true;
+    sample_decoder_init(&decoder, codec_frame_handler, NULL);
+    start = bench_host_ns();
+    sample_decoder_feed(&decoder, p_stream, bytes); // Includes the CRC and the comparison
+    uint64_t decode_ns = bench_host_ns() - start;
+    per_notification[s] = (double)samples / frames;
+    ratio[s] = (double)plain * samples / bytes;
+    printf("Codec %s: %.1f bytes per sample (%.2fx), %.1f samples per %u byte notification (%u as frames), "
+           "%.0f ns host encode, %.0f ns decode per sample\n",
+        names[s], (double)bytes / samples, ratio[s], per_notification[s], SAMPLE_BATCH_MAX_LEN,
+        SAMPLE_BATCH_MAX_LEN / plain, (double)encode_ns / samples, (double)decode_ns / samples);
+    CHECK(m_codec_same && (m_codec_decoded == samples)); // Lossless
+    CHECK(sample_decoder_stats_get(&decoder)->frames == frames);
+  }
+  CHECK(ratio[0] > 2);
+  CHECK(per_notification[1] > SAMPLE_BATCH_MAX_LEN / plain);
+  CHECK(per_notification[2] >= SAMPLE_BATCH_MAX_LEN / plain); // Never worse than plain frames
+  free(p_samples);
+  free(p_stream);
+}
+
+int main(int argc, char **argv) {
+  uint32_t samples = BENCH_DEFAULT_SAMPLES;
+
+  for (int i = 1; i < argc; i++) {
+    if ((strcmp(argv[i], "--samples") == 0) && (i + 1 < argc)) {
+      samples = strtoul(argv[++i], NULL, 0);
+    } else {
+      fprintf(stderr, "usage: %s [--samples n]\n", argv[0]);
+      return 2;
+    }
+  }
+
+  host_sim_reset();
+
+  test_sample_frame();
+  test_sample_batch();
+  test_tx_queue();
+  test_tx_queue_reentry();
+  test_sample_codec();
+  test_sample_codec_deadline();
+  bench_frames(samples);
+  bench_batch(samples);
+  bench_codec(samples);
+
+  return bench_result();
+}
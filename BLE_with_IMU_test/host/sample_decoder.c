@@ -0,0 +1,273 @@
+#include "sample_decoder.h"
+#include "crc16.h"
+#include <string.h>
+
+/**
+ * @brief Reads a little-endian 16-bit value.
+ *
+ * @param p_src Source, 2 bytes.
+ * @return Value.
+ */
+static uint16_t decoder_get16(uint8_t const *p_src) {
+  return (uint16_t)(p_src[0] | (p_src[1] << 8));
+}
+
+/**
+ * @brief Drops bytes from the front of the buffer.
+ *
+ * @param p_decoder Decoder state.
+ * @param count Bytes to drop.
+ */
+static void decoder_drop(sample_decoder_t *p_decoder, uint16_t count) {
+  p_decoder->fill -= count;
+  memmove(p_decoder->buffer, &p_decoder->buffer[count], p_decoder->fill);
+}
+
+/**
+ * @brief Passes a frame whose CRC matched to the handler.
+ *
+ * @param p_decoder Decoder state.
+ */
+static void decoder_accept(sample_decoder_t *p_decoder) {
+  uint8_t const *p_buffer = p_decoder->buffer;
+  sample_decoder_frame_t frame;
+
+  frame.type = (sample_frame_type_t)p_buffer[1];
+  frame.length = p_buffer[2];
+  frame.sequence = decoder_get16(&p_buffer[3]);
+  frame.timestamp_us = decoder_get16(&p_buffer[5]) | ((uint32_t)decoder_get16(&p_buffer[7]) << 16);
+  memcpy(frame.payload, &p_buffer[SAMPLE_FRAME_HEADER_SIZE], frame.length);
+
+  if (frame.type < SAMPLE_FRAME_TYPES) { // Every type counts its own sequence
+    if (p_decoder->sequence_valid[frame.type]) {
+      p_decoder->stats.lost += (uint16_t)(frame.sequence - p_decoder->next_sequence[frame.type]);
+    }
+    p_decoder->next_sequence[frame.type] = frame.sequence + 1;
+    p_decoder->sequence_valid[frame.type] = true;
+  }
+  p_decoder->stats.frames++;
+  if (p_decoder->handler != NULL) {
+    p_decoder->handler(p_decoder->p_context, &frame);
+  }
+}
+
+/**
+ * @brief Consumes the buffered bytes as far as possible.
+ *
+ * @param p_decoder Decoder state.
+ */
+static void decoder_process(sample_decoder_t *p_decoder) {
+  while (p_decoder->fill > 0) {
+    uint8_t const *p_buffer = p_decoder->buffer;
+
+    if (p_buffer[0] != SAMPLE_FRAME_SYNC) {
+      p_decoder->stats.skipped++;
+      decoder_drop(p_decoder, 1);
+      continue;
+    }
+    if (p_decoder->fill < SAMPLE_FRAME_HEADER_SIZE) {
+      return;
+    }
+    uint8_t length = p_buffer[2];
+    if (length > SAMPLE_FRAME_MAX_PAYLOAD) {
+      p_decoder->stats.skipped++; // Not a frame start
+      decoder_drop(p_decoder, 1);
+      continue;
+    }
+    uint16_t size = SAMPLE_FRAME_SIZE(length);
+    if (p_decoder->fill < size) {
+      return;
+    }
+    uint16_t crc = crc16_compute(p_buffer, SAMPLE_FRAME_HEADER_SIZE + length, NULL);
+    if (crc != decoder_get16(&p_buffer[SAMPLE_FRAME_HEADER_SIZE + length])) {
+      p_decoder->stats.crc_errors++;
+      p_decoder->stats.skipped++;
+      decoder_drop(p_decoder, 1);
+      continue;
+    }
+    decoder_accept(p_decoder);
+    decoder_drop(p_decoder, size);
+  }
+}
+
+/**
+ * @brief Initializes a decoder.
+ *
+ * @param p_decoder Decoder state.
+ * @param handler Receives the accepted frames, may be NULL to only count them.
+ * @param p_context Passed to handler.
+ */
+void sample_decoder_init(sample_decoder_t *p_decoder, sample_decoder_handler_t handler, void *p_context) {
+  memset(p_decoder, 0, sizeof(*p_decoder));
+  p_decoder->handler = handler;
+  p_decoder->p_context = p_context;
+}
+
+/**
+ * @brief Feeds received bytes; the handler is called for every frame they complete.
+ *
+ * @param p_decoder Decoder state.
+ * @param p_data Received bytes.
+ * @param length Number of bytes.
+ */
+void sample_decoder_feed(sample_decoder_t *p_decoder, uint8_t const *p_data, size_t length) {
+  while (length > 0) {
+    size_t count = sizeof(p_decoder->buffer) - p_decoder->fill;
+
+    if (count > length) {
+      count = length;
+    }
+    memcpy(&p_decoder->buffer[p_decoder->fill], p_data, count);
+    p_decoder->fill += count;
+    p_data += count;
+    length -= count;
+    decoder_process(p_decoder);
+  }
+}
+
+/**
+ * @brief Extracts the sample of a SAMPLE_FRAME_ACCEL_GYRO frame.
+ *
+ * @param p_frame Received frame.
+ * @param accel Receives accelerometer X, Y, Z.
+ * @param gyro Receives gyroscope X, Y, Z.
+ * @return false if the frame is of another type or length.
+ */
+bool sample_decoder_accel_gyro(sample_decoder_frame_t const *p_frame, int16_t accel[3], int16_t gyro[3]) {
+  if ((p_frame->type != SAMPLE_FRAME_ACCEL_GYRO) || (p_frame->length != SAMPLE_FRAME_ACCEL_GYRO_LEN)) {
+    return false;
+  }
+  for (uint8_t i = 0; i < 3; i++) {
+    accel[i] = (int16_t)decoder_get16(&p_frame->payload[2 * i]);
+    gyro[i] = (int16_t)decoder_get16(&p_frame->payload[6 + 2 * i]);
+  }
+  return true;
+}
+
+/**
+ * @brief Extracts the sample of a SAMPLE_FRAME_PROXIMITY frame.
+ *
+ * @param p_frame Received frame.
+ * @param p_proximity Receives the filtered proximity counts.
+ * @param p_close Receives true if an object was close.
+ * @return false if the frame is of another type or length.
+ */
+bool sample_decoder_proximity(sample_decoder_frame_t const *p_frame, uint16_t *p_proximity, bool *p_close) {
+  if ((p_frame->type != SAMPLE_FRAME_PROXIMITY) || (p_frame->length != SAMPLE_FRAME_PROXIMITY_LEN)) {
+    return false;
+  }
+  *p_proximity = decoder_get16(&p_frame->payload[0]);
+  *p_close = p_frame->payload[2] != 0;
+  return true;
+}
+
+/**
+ * @brief Extracts the sample of a SAMPLE_FRAME_QUATERNION frame.
+ *
+ * @param p_frame Received frame.
+ * @param quaternion Receives W, X, Y, Z, scaled by SAMPLE_FRAME_QUATERNION_ONE.
+ * @return false if the frame is of another type or length.
+ */
+bool sample_decoder_quaternion(sample_decoder_frame_t const *p_frame, int16_t quaternion[4]) {
+  if ((p_frame->type != SAMPLE_FRAME_QUATERNION) || (p_frame->length != SAMPLE_FRAME_QUATERNION_LEN)) {
+    return false;
+  }
+  for (uint8_t i = 0; i < 4; i++) {
+    quaternion[i] = (int16_t)decoder_get16(&p_frame->payload[2 * i]);
+  }
+  return true;
+}
+
+/**
+ * @brief Extracts the sample of a SAMPLE_FRAME_LOAD_CELL frame.
+ *
+ * @param p_frame Received frame.
+ * @param p_counts Receives the raw load cell counts.
+ * @return false if the frame is of another type or length.
+ */
+bool sample_decoder_load_cell(sample_decoder_frame_t const *p_frame, int32_t *p_counts) {
+  if ((p_frame->type != SAMPLE_FRAME_LOAD_CELL) || (p_frame->length != SAMPLE_FRAME_LOAD_CELL_LEN)) {
+    return false;
+  }
+  *p_counts = (int32_t)(decoder_get16(&p_frame->payload[0]) | ((uint32_t)decoder_get16(&p_frame->payload[2]) << 16));
+  return true;
+}
+
+/**
+ * @brief Reads a varint of a block payload.
+ *
+ * @param p_frame Received frame.
+ * @param p_offset Offset of the varint, advanced past it.
+ * @param p_value Receives the value.
+ * @return false if the varint runs past the payload or exceeds 32 bits.
+ */
+static bool decoder_get_varint(sample_decoder_frame_t const *p_frame, uint8_t *p_offset, uint32_t *p_value) {
+  uint32_t value = 0;
+
+  for (uint8_t shift = 0; shift < 35; shift += 7) {
+    if (*p_offset >= p_frame->length) {
+      return false;
+    }
+    uint8_t byte = p_frame->payload[(*p_offset)++];
+    value |= (uint32_t)(byte & 0x7F) << shift;
+    if ((byte & 0x80) == 0) {
+      *p_value = value;
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ * @brief Decompresses the samples of a SAMPLE_FRAME_ACCEL_GYRO_BLOCK frame (Sample_Codec.h).
+ *
+ * @param p_frame Received frame.
+ * @param p_samples Receives the samples, in the order they were taken.
+ * @param max Number of elements of p_samples, SAMPLE_DECODER_BLOCK_MAX for any block.
+ * @return Number of samples, 0 if the frame is of another type, malformed or holds more than max.
+ */
+uint8_t sample_decoder_accel_gyro_block(sample_decoder_frame_t const *p_frame, sample_decoder_imu_t *p_samples, uint8_t max) {
+  int16_t last[6] = {0};
+  uint32_t timestamp_us = p_frame->timestamp_us;
+  uint8_t offset = 1;
+  uint8_t count;
+
+  if ((p_frame->type != SAMPLE_FRAME_ACCEL_GYRO_BLOCK) || (p_frame->length == 0)) {
+    return 0;
+  }
+  count = p_frame->payload[0];
+  if ((count == 0) || (count > max)) {
+    return 0;
+  }
+  for (uint8_t n = 0; n < count; n++) {
+    uint32_t value;
+
+    if (n > 0) {
+      if (!decoder_get_varint(p_frame, &offset, &value)) {
+        return 0;
+      }
+      timestamp_us += value;
+    }
+    for (uint8_t i = 0; i < 6; i++) {
+      if (!decoder_get_varint(p_frame, &offset, &value) || (value > UINT16_MAX)) {
+        return 0;
+      }
+      uint16_t delta = (uint16_t)((value >> 1) ^ (0U - (value & 1))); // Undo the zigzag mapping
+      last[i] = (int16_t)(uint16_t)(last[i] + delta);
+    }
+    p_samples[n].timestamp_us = timestamp_us;
+    memcpy(p_samples[n].accel, &last[0], sizeof(p_samples[n].accel));
+    memcpy(p_samples[n].gyro, &last[3], sizeof(p_samples[n].gyro));
+  }
+  return (offset == p_frame->length) ? count : 0; // Trailing bytes mean a malformed block
+}
+
+/**
+ * @brief Returns the counters of a decoder.
+ *
+ * @param p_decoder Decoder state.
+ * @return Pointer to the counters.
+ */
+sample_decoder_stats_t const *sample_decoder_stats_get(sample_decoder_t const *p_decoder) {
+  return &p_decoder->stats;
+}
@@ -0,0 +1,147 @@
+#ifndef _SAMPLE_DECODER_H_
+#define _SAMPLE_DECODER_H_
+
+#include "Sample_Frame.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @file sample_decoder.h
+ * @brief Receiver side of the binary sample frames of Sample_Frame.h.
+ *
+ * The decoder takes the BLE UART stream in pieces of any size (notifications, file reads) and
+ * reassembles the frames. A frame is accepted when it starts with SAMPLE_FRAME_SYNC, its
+ * length is valid and its CRC matches; otherwise the first byte is dropped and the search
+ * continues one byte later, so text replies and corrupted frames are skipped. Gaps in the
+ * sequence number of a type are counted as lost frames.
+ */
+
+/**
+ * @brief A received frame.
+ */
+typedef struct {
+  sample_frame_type_t type;                  ///< Sample type
+  uint16_t sequence;                         ///< Sequence number
+  uint32_t timestamp_us;                     ///< Time the sample was taken
+  uint8_t length;                            ///< Payload length
+  uint8_t payload[SAMPLE_FRAME_MAX_PAYLOAD]; ///< Payload
+} sample_decoder_frame_t;
+
+#define SAMPLE_DECODER_BLOCK_MAX (SAMPLE_FRAME_MAX_PAYLOAD / 7) ///< Most samples in a block, 7 bytes each without change
+
+/**
+ * @brief An accelerometer and gyroscope sample of a SAMPLE_FRAME_ACCEL_GYRO_BLOCK frame.
+ */
+typedef struct {
+  uint32_t timestamp_us; ///< Time the sample was taken
+  int16_t accel[3];      ///< Accelerometer X, Y, Z
+  int16_t gyro[3];       ///< Gyroscope X, Y, Z
+} sample_decoder_imu_t;
+
+/**
+ * @brief Called for every accepted frame.
+ *
+ * @param p_context Context given to sample_decoder_init.
+ * @param p_frame Received frame.
+ */
+typedef void (*sample_decoder_handler_t)(void *p_context, sample_decoder_frame_t const *p_frame);
+
+/**
+ * @brief Counters of the decoded stream.
+ */
+typedef struct {
+  uint32_t frames;     ///< Frames accepted
+  uint32_t crc_errors; ///< Candidate frames rejected by the CRC
+  uint32_t skipped;    ///< Bytes dropped while searching for a frame
+  uint32_t lost;       ///< Frames missing according to the sequence numbers
+} sample_decoder_stats_t;
+
+/**
+ * @brief State of one decoder.
+ */
+typedef struct {
+  uint8_t buffer[SAMPLE_FRAME_MAX_SIZE];      ///< Bytes of the frame being received
+  uint16_t fill;                              ///< Bytes in buffer
+  bool sequence_valid[SAMPLE_FRAME_TYPES];    ///< next_sequence of the type is known
+  uint16_t next_sequence[SAMPLE_FRAME_TYPES]; ///< Sequence number expected next, per type
+  sample_decoder_handler_t handler;           ///< Receives the accepted frames
+  void *p_context;                            ///< Passed to handler
+  sample_decoder_stats_t stats;               ///< Counters
+} sample_decoder_t;
+
+/**
+ * @brief Initializes a decoder.
+ *
+ * @param p_decoder Decoder state.
+ * @param handler Receives the accepted frames, may be NULL to only count them.
+ * @param p_context Passed to handler.
+ */
+void sample_decoder_init(sample_decoder_t *p_decoder, sample_decoder_handler_t handler, void *p_context);
+
+/**
+ * @brief Feeds received bytes; the handler is called for every frame they complete.
+ *
+ * @param p_decoder Decoder state.
+ * @param p_data Received bytes.
+ * @param length Number of bytes.
+ */
+void sample_decoder_feed(sample_decoder_t *p_decoder, uint8_t const *p_data, size_t length);
+
+/**
+ * @brief Extracts the sample of a SAMPLE_FRAME_ACCEL_GYRO frame.
+ *
+ * @param p_frame Received frame.
+ * @param accel Receives accelerometer X, Y, Z.
+ * @param gyro Receives gyroscope X, Y, Z.
+ * @return false if the frame is of another type or length.
+ */
+bool sample_decoder_accel_gyro(sample_decoder_frame_t const *p_frame, int16_t accel[3], int16_t gyro[3]);
+
+/**
+ * @brief Extracts the sample of a SAMPLE_FRAME_PROXIMITY frame.
+ *
+ * @param p_frame Received frame.
+ * @param p_proximity Receives the filtered proximity counts.
+ * @param p_close Receives true if an object was close.
+ * @return false if the frame is of another type or length.
+ */
+bool sample_decoder_proximity(sample_decoder_frame_t const *p_frame, uint16_t *p_proximity, bool *p_close);
+
+/**
+ * @brief Extracts the sample of a SAMPLE_FRAME_QUATERNION frame.
+ *
+ * @param p_frame Received frame.
+ * @param quaternion Receives W, X, Y, Z, scaled by SAMPLE_FRAME_QUATERNION_ONE.
+ * @return false if the frame is of another type or length.
+ */
+bool sample_decoder_quaternion(sample_decoder_frame_t const *p_frame, int16_t quaternion[4]);
+
+/**
+ * @brief Extracts the sample of a SAMPLE_FRAME_LOAD_CELL frame.
+ *
+ * @param p_frame Received frame.
+ * @param p_counts Receives the raw load cell counts.
+ * @return false if the frame is of another type or length.
+ */
+bool sample_decoder_load_cell(sample_decoder_frame_t const *p_frame, int32_t *p_counts);
+
+/**
+ * @brief Decompresses the samples of a SAMPLE_FRAME_ACCEL_GYRO_BLOCK frame (Sample_Codec.h).
+ *
+ * @param p_frame Received frame.
+ * @param p_samples Receives the samples, in the order they were taken.
+ * @param max Number of elements of p_samples, SAMPLE_DECODER_BLOCK_MAX for any block.
+ * @return Number of samples, 0 if the frame is of another type, malformed or holds more than max.
+ */
+uint8_t sample_decoder_accel_gyro_block(sample_decoder_frame_t const *p_frame, sample_decoder_imu_t *p_samples, uint8_t max);
+
+/**
+ * @brief Returns the counters of a decoder.
+ *
+ * @param p_decoder Decoder state.
+ * @return Pointer to the counters.
+ */
+sample_decoder_stats_t const *sample_decoder_stats_get(sample_decoder_t const *p_decoder);
+
+#endif // _SAMPLE_DECODER_H_
@@ -0,0 +1,193 @@
+#include "vcnl4040_model.h"
+#include "nrf_drv_gpiote.h"
+#include <string.h>
+
+#define VCNL4040_MODEL_ADDRESS 0x60
+
+#define PS_SD 0x0001      // PS_CONF1 bit 0, proximity sensor shut down
+#define PS_PERS_POS 4     // PS_CONF1 bits 5:4, persistence 1, 2, 3 or 4 samples
+#define PS_INT_POS 8      // PS_CONF2 bits 1:0 (register bits 9:8)
+#define PS_INT_CLOSE 0x1  // Interrupt when closer than PS_THDH
+#define PS_INT_AWAY 0x2   // Interrupt when further than PS_THDL
+#define ALS_SD 0x0001     // ALS_CONF bit 0, ambient light sensor shut down
+#define ALS_INT_EN 0x0002 // ALS_CONF bit 1
+#define INT_FLAG_PS_AWAY 0x0100
+#define INT_FLAG_PS_CLOSE 0x0200
+#define INT_FLAG_ALS_H 0x1000
+#define INT_FLAG_ALS_L 0x2000
+
+/**
+ * @brief Loads the register reset values.
+ *
+ * @param p_model Model state.
+ */
+static void model_reset(vcnl4040_model_t *p_model) {
+  memset(p_model->regs, 0, sizeof(p_model->regs));
+  p_model->regs[VCNL4040_CMD_ALS_CONF] = ALS_SD;
+  p_model->regs[VCNL4040_CMD_PS_CONF1_2] = PS_SD;
+  p_model->regs[VCNL4040_CMD_ID] = 0x0186;
+  p_model->close_count = 0;
+  p_model->away_count = 0;
+  p_model->closed = false;
+}
+
+/**
+ * @brief Drives the INT pin low while an interrupt flag is pending, releases it otherwise.
+ *
+ * @param p_model Model state.
+ */
+static void model_int_update(vcnl4040_model_t *p_model) {
+  if (p_model->int_pin < 0) {
+    return;
+  }
+  if (vcnl4040_model_int_pin(p_model)) {
+    host_gpiote_input_release(p_model->int_pin);
+  } else {
+    host_gpiote_input_set(p_model->int_pin, false);
+  }
+}
+
+/**
+ * @brief Bus write callback: command code followed by LSB and MSB.
+ */
+static void model_bus_write(void *p_context, uint8_t const *p_data, size_t length) {
+  vcnl4040_model_t *p_model = (vcnl4040_model_t *)p_context;
+
+  if (length == 0) {
+    return;
+  }
+  p_model->command = p_data[0];
+  if ((length < 3) || (p_model->command >= VCNL4040_MODEL_REGS)) {
+    return; // Command code only (read pointer) or invalid register
+  }
+  if ((p_model->command >= VCNL4040_CMD_PS_DATA) && (p_model->command <= VCNL4040_CMD_ID)) {
+    return; // Read-only registers
+  }
+  p_model->regs[p_model->command] = p_data[1] | (p_data[2] << 8);
+}
+
+/**
+ * @brief Bus read callback: LSB and MSB of the addressed register.
+ */
+static void model_bus_read(void *p_context, uint8_t *p_data, size_t length) {
+  vcnl4040_model_t *p_model = (vcnl4040_model_t *)p_context;
+  uint16_t value = (p_model->command < VCNL4040_MODEL_REGS) ? p_model->regs[p_model->command] : 0;
+
+  for (size_t i = 0; i < length; i++) {
+    p_data[i] = (i == 0) ? (value & 0xFF) : (i == 1) ? (value >> 8) : 0xFF;
+  }
+  if ((p_model->command == VCNL4040_CMD_INT_FLAG) && (length >= 2)) {
+    p_model->regs[VCNL4040_CMD_INT_FLAG] = 0; // Cleared by reading
+    model_int_update(p_model);
+  }
+}
+
+/**
+ * @brief Initializes the model with reset values and attaches it to a bus.
+ *
+ * @param p_model Model state.
+ * @param instance TWI instance the device is connected to.
+ */
+void vcnl4040_model_init(vcnl4040_model_t *p_model, uint8_t instance) {
+  memset(p_model, 0, sizeof(*p_model));
+  model_reset(p_model);
+  p_model->int_pin = -1;
+  p_model->device.address = VCNL4040_MODEL_ADDRESS;
+  p_model->device.p_model = p_model;
+  p_model->device.write = model_bus_write;
+  p_model->device.read = model_bus_read;
+  host_twi_attach(instance, &p_model->device);
+}
+
+/**
+ * @brief Connects the open drain INT pin to a simulated GPIO input (host_gpiote.c).
+ *
+ * @param p_model Model state.
+ * @param pin GPIO pin number.
+ */
+void vcnl4040_model_int_connect(vcnl4040_model_t *p_model, uint8_t pin) {
+  p_model->int_pin = pin;
+  model_int_update(p_model);
+}
+
+/**
+ * @brief Feeds a new proximity measurement into the model, as one sensor sample.
+ *
+ * The close/away events follow the datasheet: a state change is only reported after
+ * PS_PERS + 1 consecutive samples beyond the threshold.
+ *
+ * @param p_model Model state.
+ * @param proximity Proximity counts.
+ */
+void vcnl4040_model_set_proximity(vcnl4040_model_t *p_model, uint16_t proximity) {
+  uint16_t conf = p_model->regs[VCNL4040_CMD_PS_CONF1_2];
+  uint8_t persistence = ((conf >> PS_PERS_POS) & 0x3) + 1;
+  uint8_t ps_int = (conf >> PS_INT_POS) & 0x3;
+
+  p_model->proximity = proximity;
+  if (conf & PS_SD) {
+    return; // No measurements while shut down
+  }
+  p_model->regs[VCNL4040_CMD_PS_DATA] = proximity;
+
+  p_model->close_count = (proximity > p_model->regs[VCNL4040_CMD_PS_THDH]) ? p_model->close_count + 1 : 0;
+  p_model->away_count = (proximity < p_model->regs[VCNL4040_CMD_PS_THDL]) ? p_model->away_count + 1 : 0;
+  if (!p_model->closed && (p_model->close_count >= persistence)) {
+    p_model->closed = true;
+    if (ps_int & PS_INT_CLOSE) {
+      p_model->regs[VCNL4040_CMD_INT_FLAG] |= INT_FLAG_PS_CLOSE;
+    }
+  } else if (p_model->closed && (p_model->away_count >= persistence)) {
+    p_model->closed = false;
+    if (ps_int & PS_INT_AWAY) {
+      p_model->regs[VCNL4040_CMD_INT_FLAG] |= INT_FLAG_PS_AWAY;
+    }
+  }
+  model_int_update(p_model);
+}
+
+/**
+ * @brief Feeds a new ambient light measurement into the model.
+ *
+ * @param p_model Model state.
+ * @param ambient Ambient light counts.
+ */
+void vcnl4040_model_set_ambient(vcnl4040_model_t *p_model, uint16_t ambient) {
+  uint16_t conf = p_model->regs[VCNL4040_CMD_ALS_CONF];
+
+  p_model->ambient = ambient;
+  if (conf & ALS_SD) {
+    return;
+  }
+  p_model->regs[VCNL4040_CMD_ALS_DATA] = ambient;
+  p_model->regs[VCNL4040_CMD_WHITE_DATA] = ambient;
+  if (conf & ALS_INT_EN) {
+    if (ambient > p_model->regs[VCNL4040_CMD_ALS_THDH]) {
+      p_model->regs[VCNL4040_CMD_INT_FLAG] |= INT_FLAG_ALS_H;
+    } else if (ambient < p_model->regs[VCNL4040_CMD_ALS_THDL]) {
+      p_model->regs[VCNL4040_CMD_INT_FLAG] |= INT_FLAG_ALS_L;
+    }
+  }
+  model_int_update(p_model);
+}
+
+/**
+ * @brief Returns the level of the active-low INT pin.
+ *
+ * @param p_model Model state.
+ * @return false while an interrupt flag is pending.
+ */
+bool vcnl4040_model_int_pin(vcnl4040_model_t const *p_model) {
+  return (p_model->regs[VCNL4040_CMD_INT_FLAG] & 0xFF00) == 0;
+}
+
+/**
+ * @brief Returns a register as currently stored in the model.
+ *
+ * @param p_model Model state.
+ * @param command Command code.
+ * @return Register value.
+ */
+uint16_t vcnl4040_model_reg(vcnl4040_model_t const *p_model, uint8_t command) {
+  return (command < VCNL4040_MODEL_REGS) ? p_model->regs[command] : 0;
+}
@@ -0,0 +1,99 @@
+#ifndef _VCNL4040_MODEL_H_
+#define _VCNL4040_MODEL_H_
+
+#include "host_twi.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @file vcnl4040_model.h
+ * @brief Register-level model of the VCNL4040 for the simulated TWI bus.
+ *
+ * The VCNL4040 has 16-bit command registers transferred LSB first. The model keeps their
+ * reset values, honours the PS_SD/ALS_SD shutdown bits, evaluates the proximity thresholds
+ * (PS_INT close/away, PS_PERS persistence) and the ALS window, and drives the active-low
+ * INT pin; INT_FLAG is cleared by reading it.
+ */
+
+#define VCNL4040_MODEL_REGS 0x0D ///< Command codes 0x00..0x0C
+
+/* Command codes */
+#define VCNL4040_CMD_ALS_CONF 0x00
+#define VCNL4040_CMD_ALS_THDH 0x01
+#define VCNL4040_CMD_ALS_THDL 0x02
+#define VCNL4040_CMD_PS_CONF1_2 0x03
+#define VCNL4040_CMD_PS_CONF3_MS 0x04
+#define VCNL4040_CMD_PS_CANC 0x05
+#define VCNL4040_CMD_PS_THDL 0x06
+#define VCNL4040_CMD_PS_THDH 0x07
+#define VCNL4040_CMD_PS_DATA 0x08
+#define VCNL4040_CMD_ALS_DATA 0x09
+#define VCNL4040_CMD_WHITE_DATA 0x0A
+#define VCNL4040_CMD_INT_FLAG 0x0B
+#define VCNL4040_CMD_ID 0x0C
+
+/**
+ * @brief State of one VCNL4040.
+ */
+typedef struct {
+  host_twi_device_t device;           ///< Bus attachment
+  uint16_t regs[VCNL4040_MODEL_REGS]; ///< Register file
+  uint8_t command;                    ///< Command code of the last write
+  uint16_t proximity;                 ///< Proximity counts seen by the sensor
+  uint16_t ambient;                   ///< Ambient light counts seen by the sensor
+  uint8_t close_count;                ///< Consecutive samples above PS_THDH
+  uint8_t away_count;                 ///< Consecutive samples below PS_THDL
+  bool closed;                        ///< Last reported proximity state
+  int8_t int_pin;                     ///< GPIO the INT pin is connected to, -1 if none
+} vcnl4040_model_t;
+
+/**
+ * @brief Initializes the model with reset values and attaches it to a bus.
+ *
+ * @param p_model Model state.
+ * @param instance TWI instance the device is connected to.
+ */
+void vcnl4040_model_init(vcnl4040_model_t *p_model, uint8_t instance);
+
+/**
+ * @brief Connects the open drain INT pin to a simulated GPIO input (host_gpiote.c).
+ *
+ * @param p_model Model state.
+ * @param pin GPIO pin number.
+ */
+void vcnl4040_model_int_connect(vcnl4040_model_t *p_model, uint8_t pin);
+
+/**
+ * @brief Feeds a new proximity measurement into the model, as one sensor sample.
+ *
+ * @param p_model Model state.
+ * @param proximity Proximity counts.
+ */
+void vcnl4040_model_set_proximity(vcnl4040_model_t *p_model, uint16_t proximity);
+
+/**
+ * @brief Feeds a new ambient light measurement into the model.
+ *
+ * @param p_model Model state.
+ * @param ambient Ambient light counts.
+ */
+void vcnl4040_model_set_ambient(vcnl4040_model_t *p_model, uint16_t ambient);
+
+/**
+ * @brief Returns the level of the active-low INT pin.
+ *
+ * @param p_model Model state.
+ * @return false while an interrupt flag is pending.
+ */
+bool vcnl4040_model_int_pin(vcnl4040_model_t const *p_model);
+
+/**
+ * @brief Returns a register as currently stored in the model.
+ *
+ * @param p_model Model state.
+ * @param command Command code.
+ * @return Register value.
+ */
+uint16_t vcnl4040_model_reg(vcnl4040_model_t const *p_model, uint8_t command);
+
+#endif // _VCNL4040_MODEL_H_
@@ -0,0 +1,450 @@
+#include "WS2812B.h"
+#include "WS2812B_Anim.h"
+#include "bench.h"
+#include "host_pwm.h"
+#include "host_sim.h"
+#include "ws2812b_model.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @file ws2812b_bench.c
+ * @brief Waveform checks and throughput benchmark of the WS2812B driver on the simulated PWM.
+ *
+ * Runs the unmodified WS2812B and WS2812B_Anim sources against host_pwm.c, decodes the data
+ * line with the strip model of ws2812b_model.c and compares the colours the LEDs latched with
+ * the frame buffer. Every frame is checked against the WS2812B timing windows. Exits with a
+ * non-zero status if any check fails, so it can be used as a CI step ("make -C host check").
+ *
+ * Options:
+ *   --frames <n>      Full strip refreshes per throughput measurement
+ *   --latency <us>    PWM interrupt latency (SoftDevice and higher priority interrupts)
+ */
+
+#define BENCH_DEFAULT_FRAMES 200
+#define BENCH_IDLE_LIMIT_US 1000000 // Longest refresh waited for
+#define BENCH_HALF_US (WS2812B_STREAM_LEDS * PACKET_SIZE * 5 / 4) // Time to play one half buffer
+
+static ws2812b_model_t m_strip; // Strip model on the PWM output
+bool host_log_enabled = false;  // Enables the driver log output (nrf_log.h)
+
+/**
+ * @brief Returns the level an LED should show for a frame buffer level.
+ *
+ * Computed from the curve the driver's table was generated from: the brightness is applied
+ * in 8.8 fixed point, then gamma 2.8.
+ *
+ * @param level Frame buffer level.
+ * @param brightness Strip brightness.
+ * @return Expected output level.
+ */
+static uint8_t bench_expected(uint8_t level, uint8_t brightness) {
+  uint8_t scaled = (uint8_t)((level * (brightness + 1)) >> 8);
+#if WS2812B_GAMMA_ENABLED
+  return (uint8_t)(pow(scaled / 255.0, 2.8) * 255.0 + 0.5);
+#else
+  return scaled;
+#endif
+}
+
+/**
+ * @brief Counts the LEDs of the model not showing their frame buffer colour.
+ *
+ * @return Number of mismatching LEDs.
+ */
+static uint16_t bench_mismatches(void) {
+  uint8_t brightness = ws2812b_get_brightness();
+  uint16_t mismatches = 0;
+
+  for (uint16_t i = 0; i < MAX_LEDs_in_STRIP; i++) {
+    uint8_t pixel[3], shown[3];
+    ws2812b_get_pixel(i, pixel);
+    ws2812b_model_pixel(&m_strip, i, shown);
+    for (uint8_t c = 0; c < 3; c++) {
+      if (shown[c] != bench_expected(pixel[c], brightness)) {
+        mismatches++;
+        break;
+      }
+    }
+  }
+  return mismatches;
+}
+
+/**
+ * @brief Returns the timing violations and truncated frames the model has seen.
+ *
+ * @return Sum of the model's error counters.
+ */
+static uint32_t bench_violations(void) {
+  ws2812b_model_stats_t const *p_stats = ws2812b_model_stats_get(&m_strip);
+  return p_stats->high_errors + p_stats->period_errors + p_stats->truncated;
+}
+
+/**
+ * @brief Sends the frame buffer and waits until the refresh finished.
+ */
+static void bench_show(void) {
+  CHECK(ws2812b_show() == NRF_SUCCESS);
+  host_sim_run_until_idle(BENCH_IDLE_LIMIT_US);
+  CHECK(!ws2812b_is_busy());
+}
+
+/**
+ * @brief Fills the frame buffer with a pattern using every level.
+ *
+ * @param seed Varies the pattern between calls.
+ */
+static void bench_pattern(uint8_t seed) {
+  for (uint16_t i = 0; i < MAX_LEDs_in_STRIP; i++) {
+    uint8_t rgb[3] = {(uint8_t)(i * 7 + seed), (uint8_t)(255 - i - seed), (uint8_t)(i * 3 + 2 * seed)};
+    ws2812b_set_pixel(i, rgb);
+  }
+}
+
+/**
+ * @brief Checks that the strip model decodes a hand-made signal and flags timing violations.
+ */
+static void test_model(void) {
+  static ws2812b_model_t strip; // Separate from the strip on the PWM
+  ws2812b_model_stats_t const *p_stats = ws2812b_model_stats_get(&strip);
+  uint8_t shown[3];
+
+  ws2812b_model_init(&strip, 2);
+  for (uint8_t bit = 0; bit < 24; bit++) { // G 0x80, R 0x01, B 0x00
+    bool one = (bit == 0) || (bit == 15);
+    ws2812b_model_signal(&strip, true, (one ? 800 : 400) * 1000ull);
+    ws2812b_model_signal(&strip, false, (one ? 450 : 850) * 1000ull);
+  }
+  ws2812b_model_signal(&strip, false, 50000 * 1000ull);
+  ws2812b_model_pixel(&strip, 0, shown);
+  CHECK(shown[0] == 0x01 && shown[1] == 0x80 && shown[2] == 0x00);
+  CHECK(p_stats->frames == 1 && p_stats->leds == 1);
+  CHECK(ws2812b_model_timing_ok(&strip));
+
+  ws2812b_model_signal(&strip, true, 1100 * 1000ull); // Too long for T1H, still a 1
+  ws2812b_model_signal(&strip, false, 400 * 1000ull);
+  ws2812b_model_signal(&strip, true, 400 * 1000ull); // Decoded at the next rising edge
+  CHECK(p_stats->high_errors == 1);
+  ws2812b_model_signal(&strip, false, 10000 * 1000ull); // Gap shorter than a reset
+  ws2812b_model_signal(&strip, true, 400 * 1000ull);
+  CHECK(p_stats->period_errors == 1);
+  ws2812b_model_signal(&strip, false, 60000 * 1000ull); // Latch after 3 bits
+  CHECK(p_stats->truncated == 1);
+  CHECK(p_stats->frames == 2 && p_stats->bits == 27);
+  ws2812b_model_pixel(&strip, 0, shown);
+  CHECK(shown[0] == 0x01 && shown[1] == 0x80); // The incomplete colour is not shown
+  CHECK(!ws2812b_model_timing_ok(&strip));
+}
+
+/**
+ * @brief Checks the refresh sent by WS2812B_Init: the whole strip off, within the timing windows.
+ */
+static void test_init(void) {
+  ws2812b_model_stats_t const *p_stats = ws2812b_model_stats_get(&m_strip);
+
+  CHECK(p_stats->frames == 1);
+  CHECK(p_stats->leds == MAX_LEDs_in_STRIP);
+  CHECK(p_stats->bits == MAX_LEDs_in_STRIP * PACKET_SIZE);
+  CHECK(bench_mismatches() == 0);
+  CHECK(ws2812b_model_timing_ok(&m_strip));
+  CHECK(nrf_drv_pwm_is_stopped(&(nrf_drv_pwm_t)NRF_DRV_PWM_INSTANCE(WS2812B_PWM_INSTANCE)));
+}
+
+/**
+ * @brief Checks that every LED latches its frame buffer colour through gamma and channel order.
+ */
+static void test_pixels(void) {
+  uint32_t violations = bench_violations();
+  ws2812b_model_stats_t const *p_stats = ws2812b_model_stats_get(&m_strip);
+  uint32_t frames = p_stats->frames;
+  uint8_t shown[3];
+
+  bench_pattern(0);
+  bench_show();
+  CHECK(p_stats->frames == frames + 1);
+  CHECK(bench_mismatches() == 0);
+
+  uint8_t const red[3] = {255, 0, 0};
+  ws2812b_set_pixel(0, red);
+  bench_show();
+  ws2812b_model_pixel(&m_strip, 0, shown);
+  CHECK(shown[0] == 255 && shown[1] == 0 && shown[2] == 0); // Sent as G, R, B
+  CHECK(bench_violations() == violations);
+}
+
+/**
+ * @brief Checks the dirty range: nothing is sent without a change, a change sends the prefix up
+ *        to the last changed LED and the LEDs behind it keep their colour.
+ */
+static void test_dirty(void) {
+  uint32_t violations = bench_violations();
+  ws2812b_model_stats_t const *p_stats = ws2812b_model_stats_get(&m_strip);
+  host_pwm_stats_t const *p_pwm = host_pwm_stats_get(WS2812B_PWM_INSTANCE);
+  uint32_t frames = p_stats->frames;
+  uint32_t leds = p_stats->leds;
+  uint32_t playbacks = p_pwm->playbacks;
+  uint8_t const white[3] = {255, 255, 255};
+
+  bench_show(); // Nothing changed
+  CHECK(p_stats->frames == frames);
+  CHECK(p_pwm->playbacks == playbacks);
+
+  ws2812b_set_pixel(2, white);
+  bench_show();
+  CHECK(p_stats->frames == frames + 1);
+  CHECK(p_stats->leds == leds + 3); // LEDs 0..2
+  CHECK(bench_mismatches() == 0);
+
+  ws2812b_set_pixel(2, white); // Same colour, not dirty
+  CHECK(!ws2812b_is_dirty());
+  CHECK(bench_violations() == violations);
+}
+
+/**
+ * @brief Checks that the legacy functions do not wait for a running refresh: they return
+ *        NRF_ERROR_BUSY and keep the change for the next ws2812b_show().
+ */
+static void test_legacy(void) {
+  uint32_t violations = bench_violations();
+  uint8_t before[3];
+  uint8_t shown[3];
+  uint8_t red[3] = {255, 0, 0};
+  uint8_t const green[3] = {0, 255, 0};
+
+  ws2812b_set_pixel(MAX_LEDs_in_STRIP - 1, green);
+  CHECK(ws2812b_show() == NRF_SUCCESS); // Whole strip, still running below
+  ws2812b_model_pixel(&m_strip, 0, before);
+  CHECK(set_one_LED(red, 1) == NRF_ERROR_BUSY);
+  CHECK(switch_off_LEDs(2) == NRF_ERROR_BUSY);
+  CHECK(ws2812b_is_dirty());
+  host_sim_run_until_idle(BENCH_IDLE_LIMIT_US);
+  ws2812b_model_pixel(&m_strip, 0, shown);
+  CHECK(memcmp(shown, before, 3) == 0); // Kept, not sent by the running refresh
+
+  CHECK(set_one_LED(red, 1) == NRF_SUCCESS);
+  host_sim_run_until_idle(BENCH_IDLE_LIMIT_US);
+  CHECK(!ws2812b_is_busy());
+  CHECK(!ws2812b_is_dirty());
+  CHECK(bench_mismatches() == 0);
+  CHECK(bench_violations() == violations);
+}
+
+/**
+ * @brief Checks that a brightness change resends the whole strip with scaled levels.
+ */
+static void test_brightness(void) {
+  uint32_t violations = bench_violations();
+  ws2812b_model_stats_t const *p_stats = ws2812b_model_stats_get(&m_strip);
+  uint32_t leds = p_stats->leds;
+
+  bench_pattern(5);
+  ws2812b_set_brightness(100);
+  bench_show();
+  CHECK(p_stats->leds == leds + MAX_LEDs_in_STRIP);
+  CHECK(bench_mismatches() == 0);
+
+  ws2812b_set_brightness(255);
+  bench_show();
+  CHECK(bench_mismatches() == 0);
+  CHECK(bench_violations() == violations);
+}
+
+/**
+ * @brief Returns the current the LEDs of the model draw with the colours they show.
+ *
+ * @return Current in mA, same model as the driver's estimate.
+ */
+static uint32_t bench_strip_ma(void) {
+  uint32_t level_sum = 0;
+
+  for (uint16_t i = 0; i < MAX_LEDs_in_STRIP; i++) {
+    uint8_t shown[3];
+    ws2812b_model_pixel(&m_strip, i, shown);
+    level_sum += shown[0] + shown[1] + shown[2];
+  }
+  return (uint32_t)(((uint64_t)level_sum * WS2812B_CHANNEL_MA * 1000 / 255 + MAX_LEDs_in_STRIP * WS2812B_LED_IDLE_UA + 999) / 1000);
+}
+
+/**
+ * @brief Checks the current budget: a white strip is dimmed to fit it, a frame within the budget
+ *        keeps its brightness, and the LEDs behind the dirty range follow a brightness change.
+ */
+static void test_current(void) {
+  uint32_t violations = bench_violations();
+  ws2812b_model_stats_t const *p_stats = ws2812b_model_stats_get(&m_strip);
+  uint8_t const white[3] = {255, 255, 255};
+  uint8_t const off[3] = {0, 0, 0};
+  uint8_t shown[3];
+  uint32_t leds;
+
+  ws2812b_fill(white);
+  ws2812b_set_current_budget(500);
+  bench_show();
+  CHECK(ws2812b_get_current_ma() <= 500);
+  CHECK(ws2812b_get_current_ma() >= 450); // The highest brightness that fits
+  CHECK(bench_strip_ma() == ws2812b_get_current_ma());
+  ws2812b_model_pixel(&m_strip, MAX_LEDs_in_STRIP - 1, shown);
+  CHECK(shown[0] > 0 && shown[0] < 255 && shown[0] == shown[1] && shown[1] == shown[2]);
+
+  for (uint16_t i = 1; i < MAX_LEDs_in_STRIP; i++) {
+    ws2812b_set_pixel(i, off);
+  }
+  bench_show(); // LED 0 alone fits, back to full brightness
+  ws2812b_model_pixel(&m_strip, 0, shown);
+  CHECK(shown[0] == 255 && shown[1] == 255 && shown[2] == 255);
+  CHECK(bench_mismatches() == 0);
+
+  leds = p_stats->leds;
+  ws2812b_set_pixel(1, white);
+  bench_show(); // Still within the budget, only the dirty range is sent
+  CHECK(p_stats->leds == leds + 2);
+  CHECK(bench_mismatches() == 0);
+  CHECK(bench_strip_ma() == ws2812b_get_current_ma());
+
+  ws2812b_set_current_budget(0);
+  bench_show();
+  CHECK(bench_mismatches() == 0);
+  CHECK(bench_violations() == violations);
+}
+
+/**
+ * @brief Checks the refill deadline of the half buffers.
+ *
+ * A PWM interrupt latency below the time one half takes to play is tolerated; above it a half
+ * is played again before it was refilled and the strip shows stale colours, which the model
+ * has to detect.
+ */
+static void test_latency(void) {
+  uint32_t violations = bench_violations();
+
+  host_pwm_latency_set(WS2812B_PWM_INSTANCE, BENCH_HALF_US - 10);
+  bench_pattern(11);
+  bench_show();
+  CHECK(bench_mismatches() == 0);
+  CHECK(bench_violations() == violations);
+
+  host_pwm_latency_set(WS2812B_PWM_INSTANCE, BENCH_HALF_US + 50);
+  bench_pattern(23);
+  bench_show();
+  CHECK(bench_mismatches() > 0); // Underrun, the stream also ends out of step (truncated frames)
+  violations = bench_violations();
+
+  host_pwm_latency_set(WS2812B_PWM_INSTANCE, 0);
+  bench_pattern(37);
+  bench_show();
+  CHECK(bench_mismatches() == 0); // Recovered with the next refresh
+  CHECK(bench_violations() == violations);
+}
+
+/**
+ * @brief Checks the chase animation: one frame per WS2812B_ANIM_FRAME_MS, one LED lit, and
+ *        that the reactive effect reaches its target color.
+ */
+static void test_anim(void) {
+  uint32_t violations = bench_violations();
+  ws2812b_model_stats_t const *p_stats = ws2812b_model_stats_get(&m_strip);
+  ws2812b_anim_t const chase = {.effect = WS2812B_ANIM_CHASE, .color = {0, 0, 255}, .period_ms = 1000, .brightness = 255};
+  ws2812b_anim_t const reactive = {.effect = WS2812B_ANIM_REACTIVE, .color = {255, 0, 0}, .color2 = {0, 0, 255}, .brightness = 255};
+  uint32_t frames = p_stats->frames;
+  uint16_t lit = 0;
+  uint8_t shown[3];
+
+  CHECK(ws2812b_anim_init() == NRF_SUCCESS);
+  CHECK(ws2812b_anim_start(&chase) == NRF_SUCCESS);
+  host_sim_advance_us(1000000);
+  ws2812b_anim_stop();
+  host_sim_run_until_idle(BENCH_IDLE_LIMIT_US);
+
+  CHECK(p_stats->frames - frames >= 1000 / WS2812B_ANIM_FRAME_MS);
+  CHECK(bench_mismatches() == 0);
+  for (uint16_t i = 0; i < MAX_LEDs_in_STRIP; i++) {
+    ws2812b_model_pixel(&m_strip, i, shown);
+    lit += (shown[2] == 255);
+  }
+  CHECK(lit == 1);
+
+  ws2812b_anim_set_input(0);
+  CHECK(ws2812b_anim_start(&reactive) == NRF_SUCCESS);
+  ws2812b_anim_set_input(255);
+  host_sim_advance_us(1000000); // Far more than the lag of about 4 frames
+  ws2812b_anim_stop();
+  host_sim_run_until_idle(BENCH_IDLE_LIMIT_US);
+  ws2812b_model_pixel(&m_strip, 0, shown);
+  CHECK(shown[0] == 0 && shown[2] == 255); // Settled on color2, not a few counts short
+  CHECK(bench_violations() == violations);
+}
+
+/**
+ * @brief Measures full strip refreshes: throughput on the wire and of the driver, which adds
+ *        the latch and the low halves played before it stops, and the PWM interrupts per frame.
+ *
+ * @param frames Refreshes to run.
+ */
+static void bench_throughput(uint32_t frames) {
+  uint32_t violations = bench_violations();
+  ws2812b_model_stats_t before = *ws2812b_model_stats_get(&m_strip);
+  host_pwm_stats_t pwm_before = *host_pwm_stats_get(WS2812B_PWM_INSTANCE);
+  ws2812b_model_stats_t const *p_stats = ws2812b_model_stats_get(&m_strip);
+  host_pwm_stats_t const *p_pwm = host_pwm_stats_get(WS2812B_PWM_INSTANCE);
+  uint64_t host_ns = bench_host_ns();
+
+  for (uint32_t i = 0; i < frames; i++) {
+    bench_pattern((uint8_t)i);
+    ws2812b_set_pixel(MAX_LEDs_in_STRIP - 1, (uint8_t[3]){(uint8_t)i, 1, 2}); // The whole strip is dirty
+    bench_show();
+  }
+  host_ns = bench_host_ns() - host_ns;
+  CHECK(p_stats->frames == before.frames + frames);
+  CHECK(bench_violations() == violations);
+
+  uint32_t leds = p_stats->leds - before.leds;
+  uint64_t wire_ps = p_stats->frame_ps - before.frame_ps;
+  uint64_t busy_ps = p_pwm->busy_ps - pwm_before.busy_ps;
+  printf("WS2812B %u LEDs: %u frames, %.1f us on the wire per frame (%.0f LEDs/s), %.1f us PWM busy per frame (%.0f LEDs/s)\n",
+      MAX_LEDs_in_STRIP, frames, wire_ps / 1e6 / frames, leds * 1e12 / wire_ps, busy_ps / 1e6 / frames, leds * 1e12 / busy_ps);
+  printf("%.1f PWM interrupts per frame, %.0f ns host per frame\n",
+      (double)(p_pwm->events - pwm_before.events) / frames, (double)host_ns / frames);
+}
+
+int main(int argc, char **argv) {
+  uint32_t frames = BENCH_DEFAULT_FRAMES;
+  uint32_t latency = 0;
+
+  for (int i = 1; i < argc; i++) {
+    if ((strcmp(argv[i], "--frames") == 0) && (i + 1 < argc)) {
+      frames = strtoul(argv[++i], NULL, 0);
+    } else if ((strcmp(argv[i], "--latency") == 0) && (i + 1 < argc)) {
+      latency = strtoul(argv[++i], NULL, 0);
+    } else {
+      fprintf(stderr, "usage: %s [--frames n] [--latency us]\n", argv[0]);
+      return 2;
+    }
+  }
+
+  host_sim_reset();
+  host_pwm_reset();
+  ws2812b_model_init(&m_strip, MAX_LEDs_in_STRIP);
+  host_pwm_sink_set(WS2812B_PWM_INSTANCE, ws2812b_model_signal, &m_strip);
+
+  APP_ERROR_CHECK(app_timer_init());
+  WS2812B_Init();
+  host_sim_run_until_idle(BENCH_IDLE_LIMIT_US);
+  ws2812b_set_current_budget(0); // Checked by test_current, the other tests compare full brightness levels
+  host_sim_run_until_idle(BENCH_IDLE_LIMIT_US);
+
+  test_model();
+  test_init();
+  test_pixels();
+  test_dirty();
+  test_legacy();
+  test_brightness();
+  test_current();
+  test_latency();
+  test_anim();
+  host_pwm_latency_set(WS2812B_PWM_INSTANCE, latency);
+  bench_throughput(frames);
+
+  return bench_result();
+}
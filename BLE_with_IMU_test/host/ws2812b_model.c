@@ -0,0 +1,165 @@
+#include "ws2812b_model.h"
+#include <string.h>
+
+#define PS_PER_NS 1000ull
+
+/**
+ * @brief Checks whether a duration lies in a window.
+ *
+ * @param duration_ps Duration in picoseconds.
+ * @param min_ns Lower limit in nanoseconds.
+ * @param max_ns Upper limit in nanoseconds.
+ * @return true if min_ns <= duration <= max_ns.
+ */
+static bool model_within(uint64_t duration_ps, uint32_t min_ns, uint32_t max_ns) {
+  return (duration_ps >= min_ns * PS_PER_NS) && (duration_ps <= max_ns * PS_PER_NS);
+}
+
+/**
+ * @brief Latches the received colours into the LEDs and ends the frame.
+ *
+ * @param p_model Model state.
+ * @param last_fall_ps Falling edge of the last bit.
+ */
+static void model_latch(ws2812b_model_t *p_model, uint64_t last_fall_ps) {
+  uint32_t leds = p_model->frame_bits / 24;
+
+  if (leds > p_model->led_count) {
+    leds = p_model->led_count; // Passed on by the last LED
+  }
+  for (uint32_t i = 0; i < leds; i++) {
+    p_model->leds[i][0] = p_model->shift[i][1]; // Received as GRB
+    p_model->leds[i][1] = p_model->shift[i][0];
+    p_model->leds[i][2] = p_model->shift[i][2];
+  }
+  if ((p_model->frame_bits % 24) != 0) {
+    p_model->stats.truncated++; // The LED receiving the incomplete colour keeps its old one
+  }
+  p_model->stats.frames++;
+  p_model->stats.leds += leds;
+  p_model->stats.frame_ps += last_fall_ps + WS2812B_MODEL_RESET_NS * PS_PER_NS - p_model->frame_start_ps;
+  p_model->frame_bits = 0;
+}
+
+/**
+ * @brief Decodes a bit once its low time is known.
+ *
+ * @param p_model Model state.
+ * @param low_ps Low time following the high pulse, a reset if at least WS2812B_MODEL_RESET_NS.
+ */
+static void model_bit(ws2812b_model_t *p_model, uint64_t low_ps) {
+  uint64_t high_ps = p_model->high_ps;
+  bool reset = low_ps >= WS2812B_MODEL_RESET_NS * PS_PER_NS;
+  uint32_t n = p_model->frame_bits;
+
+  if (!model_within(high_ps, WS2812B_MODEL_T0H_MIN_NS, WS2812B_MODEL_T0H_MAX_NS) &&
+      !model_within(high_ps, WS2812B_MODEL_T1H_MIN_NS, WS2812B_MODEL_T1H_MAX_NS)) {
+    p_model->stats.high_errors++;
+  }
+  if (!reset && !model_within(high_ps + low_ps, WS2812B_MODEL_BIT_MIN_NS, WS2812B_MODEL_BIT_MAX_NS)) {
+    p_model->stats.period_errors++;
+  }
+  if (n < p_model->led_count * 24u) {
+    uint8_t *p_byte = &p_model->shift[n / 24][(n % 24) / 8];
+    *p_byte = (uint8_t)((*p_byte << 1) | (high_ps >= WS2812B_MODEL_THRESHOLD_NS * PS_PER_NS)); // Most significant bit first
+  }
+  p_model->frame_bits++;
+  p_model->stats.bits++;
+  p_model->bit_pending = false;
+  if (reset) {
+    model_latch(p_model, p_model->now_ps - p_model->level_ps);
+  }
+}
+
+/**
+ * @brief Initializes the model: all LEDs off, data line low.
+ *
+ * @param p_model Model state.
+ * @param led_count LEDs of the strip, at most WS2812B_MODEL_MAX_LEDS.
+ */
+void ws2812b_model_init(ws2812b_model_t *p_model, uint16_t led_count) {
+  memset(p_model, 0, sizeof(*p_model));
+  p_model->led_count = (led_count < WS2812B_MODEL_MAX_LEDS) ? led_count : WS2812B_MODEL_MAX_LEDS;
+}
+
+/**
+ * @brief Consumes a stretch of the data signal, signature of host_pwm_sink_t.
+ *
+ * A rising edge starts a bit (and a frame after a reset), the falling edge fixes its high
+ * time, and the next rising edge or a low time reaching the reset length decodes it.
+ *
+ * @param p_context Model state (ws2812b_model_t).
+ * @param level Level of the data line.
+ * @param duration_ps Duration of the level in picoseconds.
+ */
+void ws2812b_model_signal(void *p_context, bool level, uint64_t duration_ps) {
+  ws2812b_model_t *p_model = p_context;
+
+  if (duration_ps == 0) {
+    return;
+  }
+  if (level != p_model->level) {
+    if (level) { // Rising edge
+      if (p_model->bit_pending) {
+        model_bit(p_model, p_model->level_ps);
+      }
+      if (p_model->frame_bits == 0) {
+        p_model->frame_start_ps = p_model->now_ps;
+      }
+    } else { // Falling edge
+      p_model->high_ps = p_model->level_ps;
+      p_model->bit_pending = true;
+    }
+    p_model->level = level;
+    p_model->level_ps = 0;
+  }
+  p_model->level_ps += duration_ps;
+  p_model->now_ps += duration_ps;
+  if (!level && p_model->bit_pending && (p_model->level_ps >= WS2812B_MODEL_RESET_NS * PS_PER_NS)) {
+    model_bit(p_model, p_model->level_ps); // Last bit of the frame, latches
+  }
+}
+
+/**
+ * @brief Returns the colour an LED shows.
+ *
+ * @param p_model Model state.
+ * @param index Index of the LED (0-based).
+ * @param rgb Receives the RGB levels.
+ */
+void ws2812b_model_pixel(ws2812b_model_t const *p_model, uint16_t index, uint8_t rgb[3]) {
+  memcpy(rgb, p_model->leds[index], 3);
+}
+
+/**
+ * @brief Checks whether the signal followed the datasheet timing.
+ *
+ * @param p_model Model state.
+ * @return true if no timing violation and no truncated frame was seen.
+ */
+bool ws2812b_model_timing_ok(ws2812b_model_t const *p_model) {
+  return (p_model->stats.high_errors == 0) && (p_model->stats.period_errors == 0) && (p_model->stats.truncated == 0);
+}
+
+/**
+ * @brief Returns the LED throughput of the latched frames.
+ *
+ * @param p_model Model state.
+ * @return LEDs per second, 0 before the first frame.
+ */
+uint32_t ws2812b_model_leds_per_s(ws2812b_model_t const *p_model) {
+  if (p_model->stats.frame_ps == 0) {
+    return 0;
+  }
+  return (uint32_t)(p_model->stats.leds * 1000000000000ull / p_model->stats.frame_ps);
+}
+
+/**
+ * @brief Returns the counters of the model.
+ *
+ * @param p_model Model state.
+ * @return Pointer to the counters.
+ */
+ws2812b_model_stats_t const *ws2812b_model_stats_get(ws2812b_model_t const *p_model) {
+  return &p_model->stats;
+}
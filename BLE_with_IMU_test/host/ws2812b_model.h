@@ -0,0 +1,116 @@
+#ifndef _WS2812B_MODEL_H_
+#define _WS2812B_MODEL_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @file ws2812b_model.h
+ * @brief Waveform-level model of a WS2812B strip, decoding and checking the data signal.
+ *
+ * The model consumes the level of the data line as stretches of constant level (a
+ * host_pwm_sink_t, or any GPIO toggle trace) and works like the LEDs do: every high pulse is
+ * one bit, classified by its width, the bits are shifted into the LEDs 24 at a time in GRB
+ * order and a low time of at least WS2812B_MODEL_RESET_NS latches them. The LEDs behind the
+ * received data keep their colour.
+ *
+ * Each bit is checked against the datasheet windows below: the high time must lie in the T0H
+ * or T1H window and the bit period (high + low) in the bit window unless the low time is a
+ * reset. Violations are counted; a bit with an invalid high time is still decoded by the
+ * threshold between the windows, as a real LED would. A frame whose length is not a multiple of
+ * 24 bits counts as truncated. The time from the first rising edge of a frame to the end of
+ * its minimum reset is accumulated to give the LED throughput of the signal.
+ */
+
+#define WS2812B_MODEL_MAX_LEDS 1024 ///< LEDs of the modelled strip at most
+
+#define WS2812B_MODEL_T0H_MIN_NS 250   ///< Shortest 0 bit high time (0.40 us - 150 ns)
+#define WS2812B_MODEL_T0H_MAX_NS 550   ///< Longest 0 bit high time (0.40 us + 150 ns)
+#define WS2812B_MODEL_T1H_MIN_NS 650   ///< Shortest 1 bit high time (0.80 us - 150 ns)
+#define WS2812B_MODEL_T1H_MAX_NS 950   ///< Longest 1 bit high time (0.80 us + 150 ns)
+#define WS2812B_MODEL_BIT_MIN_NS 650   ///< Shortest bit period (1.25 us - 600 ns)
+#define WS2812B_MODEL_BIT_MAX_NS 1850  ///< Longest bit period (1.25 us + 600 ns)
+#define WS2812B_MODEL_RESET_NS 50000   ///< Low time latching the data
+#define WS2812B_MODEL_THRESHOLD_NS 600 ///< High time separating 0 and 1 bits
+
+/**
+ * @brief Counters of the decoded signal.
+ */
+typedef struct {
+  uint32_t frames;        ///< Frames latched
+  uint32_t leds;          ///< LED colours latched, over all frames
+  uint32_t bits;          ///< Bits received
+  uint32_t high_errors;   ///< Bits with a high time outside the T0H and T1H windows
+  uint32_t period_errors; ///< Bits with a period outside the bit window
+  uint32_t truncated;     ///< Frames not ending on an LED boundary
+  uint64_t frame_ps;      ///< Time of the latched frames: first rising edge to end of the minimum reset
+} ws2812b_model_stats_t;
+
+/**
+ * @brief State of one WS2812B strip.
+ */
+typedef struct {
+  uint16_t led_count;                       ///< LEDs of the strip
+  uint8_t leds[WS2812B_MODEL_MAX_LEDS][3];  ///< Colour shown by every LED, RGB
+  uint8_t shift[WS2812B_MODEL_MAX_LEDS][3]; ///< Colours received in the current frame, wire (GRB) order
+  uint32_t frame_bits;                      ///< Bits received in the current frame
+  bool level;                               ///< Current level of the data line
+  uint64_t level_ps;                        ///< Time the data line has had this level
+  uint64_t high_ps;                         ///< High time of the bit waiting for its low time
+  bool bit_pending;                         ///< A high pulse was received, its low time is running
+  uint64_t now_ps;                          ///< Total duration of the signal consumed
+  uint64_t frame_start_ps;                  ///< First rising edge of the current frame
+  ws2812b_model_stats_t stats;              ///< Counters
+} ws2812b_model_t;
+
+/**
+ * @brief Initializes the model: all LEDs off, data line low.
+ *
+ * @param p_model Model state.
+ * @param led_count LEDs of the strip, at most WS2812B_MODEL_MAX_LEDS.
+ */
+void ws2812b_model_init(ws2812b_model_t *p_model, uint16_t led_count);
+
+/**
+ * @brief Consumes a stretch of the data signal, signature of host_pwm_sink_t.
+ *
+ * @param p_context Model state (ws2812b_model_t).
+ * @param level Level of the data line.
+ * @param duration_ps Duration of the level in picoseconds.
+ */
+void ws2812b_model_signal(void *p_context, bool level, uint64_t duration_ps);
+
+/**
+ * @brief Returns the colour an LED shows.
+ *
+ * @param p_model Model state.
+ * @param index Index of the LED (0-based).
+ * @param rgb Receives the RGB levels.
+ */
+void ws2812b_model_pixel(ws2812b_model_t const *p_model, uint16_t index, uint8_t rgb[3]);
+
+/**
+ * @brief Checks whether the signal followed the datasheet timing.
+ *
+ * @param p_model Model state.
+ * @return true if no timing violation and no truncated frame was seen.
+ */
+bool ws2812b_model_timing_ok(ws2812b_model_t const *p_model);
+
+/**
+ * @brief Returns the LED throughput of the latched frames.
+ *
+ * @param p_model Model state.
+ * @return LEDs per second, 0 before the first frame.
+ */
+uint32_t ws2812b_model_leds_per_s(ws2812b_model_t const *p_model);
+
+/**
+ * @brief Returns the counters of the model.
+ *
+ * @param p_model Model state.
+ * @return Pointer to the counters.
+ */
+ws2812b_model_stats_t const *ws2812b_model_stats_get(ws2812b_model_t const *p_model);
+
+#endif // _WS2812B_MODEL_H_
@@ -9,26 +9,72 @@
 #include "Ble_UART.h"
 #include "I2Cdev.h"
 #include "ICM20948.h"
+#include "ICM20948_Sampler.h"
+#include "MadgwickAHRS.h"
+#include "Sample_Frame.h"
 #include "VCNL4040.h"
+#include "VCNL4040_Filter.h"
 #include "WS2812B.h"
+#include "WS2812B_Anim.h"
 #include "math.h"
 #include "nrf_log.h"
 #include "nrf_log_ctrl.h"
 #include "nrf_log_default_backends.h"
+#include "stdio.h"
+#include "stdlib.h"
+#include "string.h"
+
+/* Private defines -----------------------------------------------------------*/
+
+#define PROX_CLOSE_THRESHOLD 100                       // Proximity count above which an object is reported close
+#define PROX_AWAY_THRESHOLD 80                         // Proximity count below which it is reported away again (hysteresis)
+#define PROX_PERSISTENCE 2                             // Consecutive sensor samples beyond a threshold before an event
+#define PROX_PS_CONFIG VCNL4040_PS_CONFIG_DEFAULT      // Proximity profile, the thresholds above are calibrated for it
+#define PROX_FILTER_SHIFT 2                            // IIR smoothing of the proximity value, time constant of about 2^shift samples
+#define PROX_SAMPLE_PERIOD_MS 200                      // Proximity sample period while the filter disagrees with the sensor state
+#define LED_CHASE_PERIOD_MS 1200                       // One LED moving along the strip every 100 ms
+#define LED_BRIGHTNESS 255                             // Brightness of the LED strip
+#define MOTION_GYRO_THRESHOLD 200                      // Raw gyroscope counts on any axis counted as motion
+#define MOTION_ACCEL_THRESHOLD 400                     // Raw accelerometer change between two samples counted as motion
+#define MOTION_IDLE_MS 3000                            // Time without motion after which the device is still
+#define IMU_SAMPLE_PERIOD_US IMU_SAMPLER_MIN_PERIOD_US // Period of the autonomous IMU sampling, the fastest ICM20948_Sampler.h allows
+#define IMU_BUFFER_QUEUE 2                             // Handed over buffers waiting: a full one and the partial one of imu_sampler_stop()
+#define STILL_SAMPLE_PERIOD_MS 100                     // IMU sample period while still, full rate while moving
+#define GYRO_COUNTS_PER_DPS 131.0f                     // ICM-20948 gyroscope sensitivity at its reset full scale of +-250 dps
+#define ORIENTATION_MAX_STEP_MS 100                    // Longer gaps between IMU samples (stream resumed) are not integrated
 
 /* Private variables ---------------------------------------------------------*/
 
+typedef struct {
+  uint8_t const *p_raw; // Raw samples of the IMU sampler
+  uint16_t count;       // Samples in p_raw
+  uint32_t time;        // Time the last sample of p_raw was taken
+} imu_buffer_t;
+
 int16_t accelData[3], gyroData[3];          // Array to store accelerometer and gyroscope data in X, Y, Z axes
 uint8_t data_array[100];                    // Buffer to hold a collection of data
 uint8_t ble_rcv_data[BLE_NUS_MAX_DATA_LEN]; // Buffer to hold received BLE data, maximum length defined by BLE_NUS_MAX_DATA_LEN
 uint8_t rgb[] = {0, 0, 0};                  // Array to store RGB values, initialized to {0, 0, 0}
 uint8_t ble_index;                          // Index variable for BLE recieved character
+volatile bool prox_changed = false;         // Set by the proximity event handler
+volatile bool prox_sample_ready = false;    // Set when a background proximity read completed
+vcnl4040_filter_t prox_filter;              // Smoothing and close/away decision of the proximity value
+imu_buffer_t imu_queue[IMU_BUFFER_QUEUE];   // Sample buffers handed over by the IMU sampler, oldest first
+volatile uint8_t imu_queued = 0;            // Entries in imu_queue
+volatile uint32_t imu_overruns = 0;         // Buffers re-armed by the sampler before the main loop copied them
+volatile uint32_t imu_samples_lost = 0;     // Samples of those buffers
 
 /* Private function prototypes -----------------------------------------------*/
 void timer1_init(void);
 uint32_t micros(void);
-void led_strip(void);
 void printAccelGyroData(void);
+bool updateMotion(uint32_t current_time);
+void updateOrientation(uint32_t current_time, int16_t quaternion[4]);
+void processIMUSample(uint32_t sample_time, uint32_t current_time, bool imu_stream, bool quaternion_stream);
+void imuSamplerHandler(uint8_t const *p_raw, uint16_t sample_count);
+void printI2CStats(void);
+void proximityEventHandler(vcnl4040_evt_t event);
+void proximitySampleHandler(ret_code_t result, void *p_context);
 
 /* Private user functions ---------------------------------------------------------*/
 /**
@@ -70,43 +116,191 @@ uint32_t micros(void) {
 }
 
 /**
- * @brief Updates the LED strip by setting one LED at a time.
+ * @brief Reads and prints accelerometer and gyroscope data.
  *
- * This function updates the LED strip by incrementing the current LED position.
- * When the end of the strip is reached, it wraps around to the beginning.
- * It uses a static variable to keep track of the current LED being set.
- * The `set_one_LED` function is called to set the color of the current LED using the `rgb` array.
+ * This function performs the following steps:
+ * - Reads accelerometer and gyroscope data into `accelData` and `gyroData` arrays.
+ * - Logs the accelerometer and gyroscope data using `NRF_LOG_INFO`.
+ * - Flushes the log buffer to ensure all log messages are output.
  *
  * @param None
  * @return None
  */
-void led_strip(void) {
-  static int current_LED = 0;                       // Static variable to keep track of the current LED
-  current_LED = (current_LED < MAX_LEDs_in_STRIP) ? // Increment the current LED position
-                    ++current_LED
-                                                  : 0; // Wrap around to the beginning if end is reached
-  set_one_LED(rgb, current_LED);                       // Set the color of the current LED
+void printAccelGyroData(void) {
+  readAccelGyroData(accelData, gyroData);                                            // Read accelerometer and gyroscope data
+  NRF_LOG_INFO("Accel: X=%d, Y=%d, Z=%d", accelData[0], accelData[1], accelData[2]); // Log accelerometer data
+  NRF_LOG_INFO("Gyro: X=%d, Y=%d, Z=%d", gyroData[0], gyroData[1], gyroData[2]);     // Log gyroscope data
+  NRF_LOG_FLUSH();                                                                   // Flush the log buffer
 }
 
 /**
- * @brief Reads and prints accelerometer and gyroscope data.
+ * @brief Decides from the latest IMU sample whether the device is moving.
  *
- * This function performs the following steps:
- * - Reads accelerometer and gyroscope data into `accelData` and `gyroData` arrays.
- * - Formats the read data into a string and stores it in the `data_array`.
- * - Logs the accelerometer and gyroscope data using `NRF_LOG_INFO`.
- * - Flushes the log buffer to ensure all log messages are output.
+ * A sample is motion if any gyroscope axis exceeds MOTION_GYRO_THRESHOLD or any accelerometer
+ * axis changed by more than MOTION_ACCEL_THRESHOLD since the previous sample. The device counts
+ * as moving until MOTION_IDLE_MS passed without motion.
+ *
+ * @param current_time Time of the sample in microseconds.
+ * @return true while the device is moving.
+ */
+bool updateMotion(uint32_t current_time) {
+  static int16_t last_accel[3]; // Accelerometer data of the previous sample
+  static uint32_t motion_time;  // Time of the last sample with motion
+  static bool moving = true;    // Start moving so the stream begins at full rate
+
+  for (uint8_t i = 0; i < 3; i++) {
+    if ((abs(gyroData[i]) > MOTION_GYRO_THRESHOLD) || (abs(accelData[i] - last_accel[i]) > MOTION_ACCEL_THRESHOLD)) {
+      motion_time = current_time;
+      moving = true;
+    }
+    last_accel[i] = accelData[i];
+  }
+  if (moving && (current_time - motion_time >= 1000 * MOTION_IDLE_MS)) {
+    moving = false;
+  }
+  return moving;
+}
+
+/**
+ * @brief Updates the orientation estimate with the latest IMU sample.
+ *
+ * Runs the Madgwick filter (MadgwickAHRS.h) on `accelData` and `gyroData`, integrating over the
+ * time since the previous update. Only called while the quaternion stream is subscribed.
+ *
+ * @param current_time Time of the sample in microseconds.
+ * @param quaternion Receives the orientation W, X, Y, Z, scaled by SAMPLE_FRAME_QUATERNION_ONE.
+ */
+void updateOrientation(uint32_t current_time, int16_t quaternion[4]) {
+  static uint32_t last_time;   // Time of the previous update
+  static bool started = false; // last_time is valid
+  uint32_t step = current_time - last_time;
+
+  if (started && (step < 1000 * ORIENTATION_MAX_STEP_MS)) {
+    invSampleFreq = step * 1e-6f; // The loop rate varies with the bus and BLE load
+  }
+  last_time = current_time;
+  started = true;
+  MadgwickAHRSupdateIMU(gyroData[0] / GYRO_COUNTS_PER_DPS, gyroData[1] / GYRO_COUNTS_PER_DPS, gyroData[2] / GYRO_COUNTS_PER_DPS,
+      accelData[0], accelData[1], accelData[2]); // Accelerometer scale does not matter, it is normalised
+
+  quaternion[0] = (int16_t)lrintf(q0 * SAMPLE_FRAME_QUATERNION_ONE);
+  quaternion[1] = (int16_t)lrintf(q1 * SAMPLE_FRAME_QUATERNION_ONE);
+  quaternion[2] = (int16_t)lrintf(q2 * SAMPLE_FRAME_QUATERNION_ONE);
+  quaternion[3] = (int16_t)lrintf(q3 * SAMPLE_FRAME_QUATERNION_ONE);
+}
+
+/**
+ * @brief Processes one IMU sample in `accelData` and `gyroData`.
+ *
+ * Updates the motion state and the orientation, then sends the sample on the subscribed
+ * streams at full rate while moving and every STILL_SAMPLE_PERIOD_MS while still.
+ *
+ * @param sample_time Time the sample was taken in microseconds.
+ * @param current_time Time of the main loop iteration in microseconds.
+ * @param imu_stream The IMU stream is subscribed.
+ * @param quaternion_stream The quaternion stream is subscribed.
+ */
+void processIMUSample(uint32_t sample_time, uint32_t current_time, bool imu_stream, bool quaternion_stream) {
+  static uint32_t imu_time; // Time of the last IMU sample sent
+  int16_t quaternion[4];
+  bool moving = updateMotion(sample_time); // Motion selects the sample rate and the connection profile
+  ble_uart_motion_set(moving);
+
+  if (quaternion_stream) { // The filter needs every sample, also while still
+    updateOrientation(sample_time, quaternion);
+  }
+  if (moving || (sample_time - imu_time >= 1000 * STILL_SAMPLE_PERIOD_MS)) { // Full rate while moving, decimated while still
+    imu_time = sample_time;
+    if (imu_stream) {                                                  // Compressed into the IMU block, sent via Bluetooth
+      transmitIMUdata(sample_time, accelData, gyroData, current_time); //
+    }
+    if (quaternion_stream) {
+      uint8_t frame[SAMPLE_FRAME_SIZE(SAMPLE_FRAME_QUATERNION_LEN)];
+      transmitSensorData(BLE_SENSOR_QUATERNION, frame, sample_frame_quaternion(frame, sample_time, quaternion), current_time);
+    }
+  }
+}
+
+/**
+ * @brief Handles a sample buffer of the IMU sampler.
+ *
+ * Called from the counter TIMER interrupt for every full buffer, and by imu_sampler_stop()
+ * for the partial one; the samples are processed in the main loop. A full buffer is only valid
+ * until the next one is full, the sampler then re-arms it: a buffer the main loop has not
+ * copied by then is dropped and counted in imu_overruns (reported by printI2CStats).
+ *
+ * @param p_raw Raw samples, see decodeAccelGyroData.
+ * @param sample_count Number of samples in the buffer.
+ * @return None
+ */
+void imuSamplerHandler(uint8_t const *p_raw, uint16_t sample_count) {
+  if (imu_sampler_is_running()) { // A full buffer: the sampler has just re-armed the other one, a buffer still waiting is overwritten
+    for (uint8_t i = 0; i < imu_queued; i++) {
+      imu_samples_lost += imu_queue[i].count;
+    }
+    imu_overruns += imu_queued;
+    imu_queued = 0;
+  }
+  if (imu_queued < IMU_BUFFER_QUEUE) { // The partial buffer of imu_sampler_stop() queues behind the full one
+    imu_queue[imu_queued].p_raw = p_raw;
+    imu_queue[imu_queued].count = sample_count;
+    imu_queue[imu_queued].time = i2c_bus_time_us(); // micros() is not interrupt safe
+    imu_queued++;
+  }
+}
+
+/**
+ * @brief Reports the I2C bus statistics.
+ *
+ * This function writes the per-device transaction counters and latency histograms of both
+ * I2C buses to the log (RTT) and sends them over BLE UART, one device per line, followed by
+ * the counters of the BLE TX queue and the IMU sample buffers the main loop was too late for.
+ * transmitData splits lines longer than the negotiated data length into several notifications.
  *
  * @param None
  * @return None
  */
-void printAccelGyroData(void) {
-  readAccelGyroData(accelData, gyroData);                                               // Read accelerometer and gyroscope data
-  sprintf((char *)data_array, "Accel: X=%d, Y=%d, Z=%d\nGyro: X=%d, Y=%d, Z=%d\n\n",    //
-      accelData[0], accelData[1], accelData[2], gyroData[0], gyroData[1], gyroData[2]); // Prepare the data to be transfered via Bluetooth UART
-  NRF_LOG_INFO("Accel: X=%d, Y=%d, Z=%d", accelData[0], accelData[1], accelData[2]);    // Log accelerometer data
-  NRF_LOG_INFO("Gyro: X=%d, Y=%d, Z=%d", gyroData[0], gyroData[1], gyroData[2]);        // Log gyroscope data
-  NRF_LOG_FLUSH();                                                                      // Flush the log buffer
+void printI2CStats(void) {
+  char stats[160];                                    // Buffer for the statistics of one device
+  i2c_bus_stats_log();                                // Log the statistics over RTT
+  for (uint8_t bus = 0; bus < I2C_BUS_COUNT; bus++) { // Send the statistics of every device via Bluetooth
+    for (uint8_t i = 0; i2c_bus_stats_format(bus, i, stats, sizeof(stats)) > 0; i++) {
+      transmitData((uint8_t *)stats, strlen(stats)); // One line per device
+    }
+  }
+  i2c_bus_wait_stats_format(stats, sizeof(stats)); // Sleep and wake-up figures of the blocking I2C calls
+  transmitData((uint8_t *)stats, strlen(stats));   //
+  transmitStatsFormat(stats, sizeof(stats));       // Queued, sent and dropped notifications
+  transmitData((uint8_t *)stats, strlen(stats));   //
+  snprintf(stats, sizeof(stats), "imu overruns=%lu lost=%lu\n", (unsigned long)imu_overruns, (unsigned long)imu_samples_lost);
+  transmitData((uint8_t *)stats, strlen(stats)); // Sample buffers the main loop was too late for
+}
+
+/**
+ * @brief Handles proximity events of the VCNL4040.
+ *
+ * Called from the TWI interrupt when the sensor reports that an object came close or moved
+ * away; the main loop then feeds PS_DATA, read together with the interrupt flags, into the
+ * filter and samples the sensor until the filtered state has settled on the new state.
+ *
+ * @param event Close or away event.
+ * @return None
+ */
+void proximityEventHandler(vcnl4040_evt_t event) {
+  prox_changed = true; // Sample now instead of waiting for the next sample period
+}
+
+/**
+ * @brief Completion handler of the background proximity read.
+ *
+ * Called from the TWI interrupt; the sample is filtered in the main loop.
+ *
+ * @param result Result of the bus transaction.
+ * @param p_context Unused.
+ * @return None
+ */
+void proximitySampleHandler(ret_code_t result, void *p_context) {
+  prox_sample_ready = (result == NRF_SUCCESS); // Failed reads are retried with the next sample period
 }
 
 /* Main code ---------------------------------------------------------*/
@@ -115,11 +309,23 @@ int main(void) {
   timer1_init();                // Initialise timer 1
   TWI_initialize();             // Initialise two wire interface (I2C)
   VCN4040_TWI_initialize();     // Initialise VCN4040's I2C (used since in PCB, it is connected to different bus)
-  vcnl4040_init();              // Initialise VCNL4040 Proximity Sensor
   WS2812B_Init();               // Initialise RGB LED
   NRF_GPIO->DIRSET = (1 << 31); // Configure the PCB LED pin as output
   NRF_GPIO->OUTCLR = (1 << 31); // Set the PCB LED pin low initially
 
+  ret_code_t err_code = vcnl4040_init(); // Initialise VCNL4040 Proximity Sensor
+  APP_ERROR_CHECK(err_code);
+  vcnl4040_ps_config_t ps_config = PROX_PS_CONFIG;
+  err_code = vcnl4040_ps_config(&ps_config); // Duty ratio, pulses and LED current of the deployment
+  APP_ERROR_CHECK(err_code);
+  err_code = vcnl4040_proximity_int_enable(PROX_AWAY_THRESHOLD, PROX_CLOSE_THRESHOLD, PROX_PERSISTENCE, proximityEventHandler); // Proximity changes are reported through Prox_INT
+  APP_ERROR_CHECK(err_code);
+  vcnl4040_filter_init(&prox_filter, PROX_FILTER_SHIFT, PROX_AWAY_THRESHOLD, PROX_CLOSE_THRESHOLD); // Same hysteresis as the sensor interrupt
+
+  ws2812b_anim_t led_anim = {.effect = WS2812B_ANIM_CHASE, .period_ms = LED_CHASE_PERIOD_MS, .brightness = LED_BRIGHTNESS};
+  APP_ERROR_CHECK(ws2812b_anim_init());
+  APP_ERROR_CHECK(ws2812b_anim_start(&led_anim)); // The strip is rendered from app_timer, independent of the main loop
+
   NRF_LOG_INFO("Debug logging for UART over RTT started."); // Log a message indicating that debug logging for UART over RTT has started
 
   bool imu_connected = false; // Flag to track the connection status of the IMU
@@ -131,48 +337,93 @@ int main(void) {
   } else                               //
     strcat(data_array, "Hell World!"); // Append error message to data_array if the connection test fails
 
+  if (imu_connected) {
+    err_code = imu_sampler_init(IMU_SAMPLE_PERIOD_US, imuSamplerHandler); // Samples are read by TIMER, PPI and TWIM without the CPU
+    APP_ERROR_CHECK(err_code);
+  }
+
   nrf_delay_ms(300); // Delay for initialisation
 
-  // Variables to manage timing and refresh rate
-  uint32_t prev_time = 0;         // Variable to store the previous time value
-  uint32_t current_time;          // Variable to store the current time value
-  uint16_t refresh_rate_ms = 100; // Refresh rate in milliseconds (100 ms)
+  // Variables to manage timing
+  uint32_t current_time;  // Variable to store the current time value
+  uint32_t prox_time = 0; // Time of the last proximity sample
 
   /* Main loop code ---------------------------------------------------------*/
   while (1) {
-    NRF_GPIO->OUTSET = (1 << 31);                             // Set GPIO pin PCB Red LED high inidicating code is running
-    current_time = micros();                                  // Get the current time in microseconds
-    if (current_time - prev_time >= 1000 * refresh_rate_ms) { // Check if the refresh period has elapsed
-      led_strip();                                            // Update the LED strip
-      prev_time = current_time;                               // Update the previous time
-    }                                                         //
-    if (prev_time > (uint32_t)pow(2, 31))                     // Prevent overflow of the previous time variable
-      prev_time = 0;
-
-    if (ble_rcv_data[ble_index - 1] == '\n') { // Check if the last received BLE character is a newline
-      rgb[0] = 255;                            // Set RGB values to white
-      rgb[1] = 255;                            //
-      rgb[2] = 255;                            //
-      ble_index = 0;                           // Reset the BLE index
+    NRF_GPIO->OUTSET = (1 << 31); // Set GPIO pin PCB Red LED high inidicating code is running
+    current_time = micros();      // Get the current time in microseconds
+
+    if (ble_rcv_data[ble_index - 1] == '\n') {              // Check if the last received BLE character is a newline
+      if (strncmp((char *)ble_rcv_data, "stats", 5) == 0) { // "stats" command: report the I2C bus statistics
+        printI2CStats();                                    //
+      } else {                                              //
+        rgb[0] = 255;                                       // Set RGB values to white
+        rgb[1] = 255;                                       //
+        rgb[2] = 255;                                       //
+      }                                                     //
+      ble_index = 0;                                        // Reset the BLE index
     }
 
-    if (imu_connected) {                    // If the IMU is connected, read and process data
-      printAccelGyroData();                 // Print accelerometer and gyroscope data
-      char prox[20];                        // Buffer for proximity data
-      uint8_t proximity = read_proximity(); // Read proximity value
-
-      if (proximity > 100) { // Set RGB values based on proximity value
-        rgb[0] = 0;          //
-        rgb[1] = 0;          //
-        rgb[2] = 255;        // Set RGB LED to blue if proximity is greater than 100
-      } else {               //
-        rgb[0] = 0;          //
-        rgb[1] = 255;        //
-        rgb[2] = 0;          // Set RGB LED to green if proximity is 100 or less
+    bool prox_report = false; // Set if the filtered proximity state changed
+    if (prox_changed) {       // Feed PS_DATA of the interrupt read into the filter
+      prox_changed = false;
+      prox_report = vcnl4040_filter_update(&prox_filter, vcnl4040_proximity_get());
+    }
+    bool prox_settled = vcnl4040_filter_is_primed(&prox_filter) && (vcnl4040_filter_is_close(&prox_filter) == vcnl4040_is_close());
+    if (!prox_settled && (current_time - prox_time >= 1000 * PROX_SAMPLE_PERIOD_MS)) {  // Sample only while the filter catches up with the sensor; once both agree,
+      if (vcnl4040_read_proximity_start(proximitySampleHandler, NULL) == NRF_SUCCESS) { // even inside the hysteresis band, only a sensor event causes TWI1 traffic
+        prox_time = current_time;                                                       //
+      }
+    }
+    if (prox_sample_ready) { // Feed the completed read into the filter
+      prox_sample_ready = false;
+      prox_report |= vcnl4040_filter_update(&prox_filter, vcnl4040_proximity_get());
+    }
+
+    if (imu_connected) {                                                       // If the IMU is connected, read and process data
+      bool imu_stream = ble_uart_stream_enabled(BLE_SENSOR_IMU);               // Streams nobody receives are not produced
+      bool quaternion_stream = ble_uart_stream_enabled(BLE_SENSOR_QUATERNION); //
+      bool close = vcnl4040_filter_is_close(&prox_filter);                     // Filtered proximity state
+
+      if ((imu_stream || quaternion_stream) && !imu_sampler_is_running()) { // The IMU is only sampled for a stream
+        err_code = imu_sampler_start();                                     // TWI0 then samples on its own
+        if (err_code != NRF_ERROR_BUSY) {                                   // Retried next iteration while TWI0 is busy
+          APP_ERROR_CHECK(err_code);                                        //
+        }
+      } else if (!imu_stream && !quaternion_stream && imu_sampler_is_running()) {
+        imu_sampler_stop(); // Hands over the partial buffer
+      }
+      while (imu_queued > 0) { // Process the buffers handed over by the sampler, all of them before it may be restarted
+        static uint8_t raw[IMU_SAMPLER_BUFFER_SAMPLES * IMU_SAMPLER_SAMPLE_SIZE];
+        imu_buffer_t buffer;
+        CRITICAL_REGION_ENTER(); // Copied before the sampler can re-arm the buffer
+        buffer = imu_queue[0];
+        memcpy(raw, buffer.p_raw, buffer.count * IMU_SAMPLER_SAMPLE_SIZE);
+        imu_queue[0] = imu_queue[1];
+        imu_queued--;
+        CRITICAL_REGION_EXIT();
+        for (uint16_t i = 0; i < buffer.count; i++) {
+          decodeAccelGyroData(raw + i * IMU_SAMPLER_SAMPLE_SIZE, accelData, gyroData);
+          processIMUSample(buffer.time - (buffer.count - 1 - i) * IMU_SAMPLE_PERIOD_US, current_time, imu_stream, quaternion_stream);
+        }
+      }
+
+      if (close) {    // Set RGB values based on proximity state
+        rgb[0] = 0;   //
+        rgb[1] = 0;   //
+        rgb[2] = 255; // Set RGB LED to blue if an object is close
+      } else {        //
+        rgb[0] = 0;   //
+        rgb[1] = 255; //
+        rgb[2] = 0;   // Set RGB LED to green if it is away
+      }
+      if (prox_report && ble_uart_stream_enabled(BLE_SENSOR_PROXIMITY)) {                                            // Send the new proximity state
+        uint8_t frame[SAMPLE_FRAME_SIZE(SAMPLE_FRAME_PROXIMITY_LEN)];                                                // Frame with the state and the full 16-bit filtered value
+        uint16_t frame_length = sample_frame_proximity(frame, micros(), vcnl4040_filter_value(&prox_filter), close); //
+        transmitSensorData(BLE_SENSOR_PROXIMITY, frame, frame_length, current_time);                                 //
       }
-      sprintf(prox, "Prox: %li\n", proximity); // Format and append proximity data to data_array
-      strcat(data_array, prox);                //
-      transmitIMUdata();                       // Transmit the IMU data via BLE UART
+      transmitPoll(current_time); // Send the IMU data whose latency deadline passed
     }
+    ws2812b_anim_set_color(rgb); // Used by the animation from the next frame
   }
 }